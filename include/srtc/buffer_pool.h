@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace srtc
+{
+
+// Memory for ByteBuffer, in a few size classes from small to the largest UDP datagram.
+//
+// Freed blocks are kept on per-thread lists (and so per event loop) and reused, so a thread which keeps
+// sending or receiving packets does not go to the global allocator in the steady state. A block can be
+// freed on a different thread than it was allocated on, then it's kept by the freeing thread. Larger
+// buffers, and blocks which don't fit into the lists, are allocated and freed as usual.
+
+class BufferPool
+{
+public:
+    static constexpr size_t kClassCount = 4;
+    static constexpr size_t kMaxClassSize = 64 * 1024;
+
+    // Returns a block of at least the size, which is updated with the size of the block
+    static uint8_t* allocate(size_t& size);
+
+    // The size is what allocate() returned, or what was passed to it
+    static void release(uint8_t* ptr, size_t size);
+
+    // The actual size of a block allocated for the size
+    [[nodiscard]] static size_t getBlockSize(size_t size);
+
+    // For the calling thread, and so shared by all the connections on a network thread. Connection listeners
+    // run on the network thread, so they can get it there.
+    struct Stats {
+        uint64_t hit_count;
+        uint64_t miss_count;
+        size_t cached_bytes;
+    };
+
+    [[nodiscard]] static Stats getStats();
+};
+
+} // namespace srtc
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "srtc/byte_buffer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace srtc
+{
+
+// An encoded frame shared by the RTP packets it's split into. The packets refer to their parts of it instead
+// of having copies, and the frame is freed when the last of them is.
+using SharedBuffer = std::shared_ptr<const ByteBuffer>;
+
+// A part of a shared buffer, which it keeps alive
+
+class BufferSlice
+{
+public:
+    BufferSlice();
+    // The data has to be inside the buffer
+    BufferSlice(const SharedBuffer& buf, const uint8_t* data, size_t size);
+
+    [[nodiscard]] bool empty() const;
+    [[nodiscard]] const uint8_t* data() const;
+    [[nodiscard]] size_t size() const;
+
+private:
+    SharedBuffer mBuf;
+    const uint8_t* mData;
+    size_t mSize;
+};
+
+// Pieces of data in different places, to be read one after another as if they were one buffer
+
+class ByteGather
+{
+public:
+    static constexpr size_t kMaxCount = 6;
+    static constexpr size_t kMaxCopySize = 4;
+
+    ByteGather();
+
+    ByteGather(const ByteGather& other) = delete;
+    ByteGather& operator=(const ByteGather& other) = delete;
+
+    void clear();
+
+    // The data is not copied and has to stay valid while the gather is used
+    void add(const uint8_t* data, size_t size);
+    // The data is copied into the gather, for small values such as an RTX original sequence number
+    void addCopy(const uint8_t* data, size_t size);
+
+    [[nodiscard]] size_t count() const;
+    [[nodiscard]] const uint8_t* data(size_t index) const;
+    [[nodiscard]] size_t size(size_t index) const;
+    [[nodiscard]] size_t totalSize() const;
+
+    // Copies all the pieces
+    void appendTo(ByteBuffer& buf) const;
+
+private:
+    const uint8_t* mData[kMaxCount];
+    size_t mSize[kMaxCount];
+    size_t mCount;
+    size_t mTotalSize;
+
+    uint8_t mCopy[kMaxCopySize];
+    size_t mCopySize;
+};
+
+} // namespace srtc
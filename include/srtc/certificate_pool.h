@@ -0,0 +1,62 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+struct ssl_ctx_st;
+
+namespace srtc
+{
+
+class X509Certificate;
+
+// Certificates and DTLS contexts shared by all connections in the process.
+//
+// Generating a key pair and self-signing a certificate, and then creating an SSL_CTX and loading it with
+// the certificate, costs about as much as the rest of setting up a connection. Offers take the current
+// certificate from here, which is replaced with a new one every rotation interval, and candidates take a
+// DTLS context for the certificate and their role, created once and pre-configured with the certificate,
+// key and SRTP profiles.
+//
+// By default each offer gets a new certificate, sharing them is enabled by setting a rotation interval.
+
+class CertificatePool
+{
+public:
+    struct Config {
+        // How long one certificate is given out to new offers, zero for a new certificate each time
+        std::chrono::seconds rotation_interval = std::chrono::seconds(0);
+        // Validity of the certificates, should be longer than the rotation interval plus the longest session
+        std::chrono::seconds lifetime = std::chrono::hours(24 * 365);
+    };
+
+    // Takes effect for certificates created after the call
+    static void setConfig(const Config& config);
+    [[nodiscard]] static Config getConfig();
+
+    [[nodiscard]] static std::shared_ptr<X509Certificate> getCertificate();
+
+    // The context is shared, and has a reference added for the caller, to be released with SSL_CTX_free.
+    // Returns nullptr if the context could not be set up.
+    [[nodiscard]] static struct ssl_ctx_st* getDtlsContext(const std::shared_ptr<X509Certificate>& cert,
+                                                          bool isServer);
+
+    // Drops the current certificate and the contexts not used by any connection
+    static void clear();
+
+    struct Stats {
+        uint64_t cert_created_count;
+        uint64_t cert_reused_count;
+        uint64_t dtls_ctx_created_count;
+        uint64_t dtls_ctx_reused_count;
+        // Time spent creating, and an estimate of the time saved by reusing, at the average creation cost
+        uint64_t setup_spent_micros;
+        uint64_t setup_saved_micros;
+    };
+
+    [[nodiscard]] static Stats getStats();
+};
+
+} // namespace srtc
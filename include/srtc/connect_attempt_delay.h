@@ -0,0 +1,34 @@
+#pragma once
+
+#include "srtc/srtc.h"
+
+#include <atomic>
+#include <chrono>
+
+namespace srtc
+{
+
+// RFC 8305 connection attempt delay: the next candidate starts after about twice the STUN rtt of the previous
+// one's address family, as seen by earlier connections, or after the default if there were none.
+//
+// The rtt is smoothed per address family, IPv4 and IPv6. Thread safe, connections on different threads
+// update and read it concurrently.
+
+class ConnectAttemptDelay
+{
+public:
+    static constexpr auto kDefault = std::chrono::milliseconds(100);
+    static constexpr auto kMin = std::chrono::milliseconds(25);
+    static constexpr auto kMax = std::chrono::milliseconds(250);
+
+    ConnectAttemptDelay();
+
+    [[nodiscard]] std::chrono::milliseconds get(const Host& host) const;
+    void update(const Host& host, float rttMs);
+
+private:
+    // Negative when not known yet
+    std::atomic<float> mRttMs[2];
+};
+
+} // namespace srtc
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+
+namespace srtc
+{
+
+// Collects the earliest deadline of everything that runs on a network thread, with microsecond precision,
+// so the event loop can sleep until then and no longer. Time points are used rather than millisecond
+// timeouts because the pacer and the jitter buffer have deadlines which are a fraction of a millisecond apart.
+
+class Deadline
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // The deadline is never later than now + maxWait
+    Deadline(const Clock::time_point& now, const std::chrono::microseconds& maxWait);
+
+    // The time this deadline was started, sources can use it instead of getting the current time again
+    [[nodiscard]] const Clock::time_point& getNow() const;
+
+    void update(const Clock::time_point& when);
+
+    [[nodiscard]] const Clock::time_point& getWhen() const;
+
+    // How long to wait from the current time, rounded up so we don't wake up just before the deadline
+    [[nodiscard]] std::chrono::microseconds getTimeout() const;
+
+private:
+    const Clock::time_point mNow;
+    Clock::time_point mWhen;
+};
+
+} // namespace srtc
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+
+namespace srtc
+{
+
+// Threads for the CPU heavy part of connecting: the DTLS handshake (key exchange, signatures) and deriving
+// the SRTP keys.
+//
+// With worker threads, a candidate feeds DTLS datagrams to its handshake on a worker and picks up the
+// datagrams to send and the resulting SRTP connection on its network thread, so a burst of new connections
+// doesn't stall the media of established ones on the same thread. With no worker threads (the default),
+// handshakes run on the network thread.
+
+class DtlsWorkerPool
+{
+public:
+    // Takes effect for handshake steps posted after the call, waits for the ones already posted
+    static void setThreadCount(size_t count);
+    [[nodiscard]] static size_t getThreadCount();
+
+    // Returns false if there are no worker threads, then the caller should run the job itself
+    [[nodiscard]] static bool post(std::function<void()>&& job);
+
+    // Setup latency, from starting to connect to having the SRTP keys, and the upper limits of its buckets
+    static constexpr size_t kLatencyBucketCount = 10;
+    static constexpr uint32_t kLatencyBucketMillis[kLatencyBucketCount] = {
+        10, 25, 50, 100, 250, 500, 1000, 2500, 5000, std::numeric_limits<uint32_t>::max()
+    };
+
+    static void addHandshakeTime(std::chrono::microseconds elapsed, bool isOnWorker);
+    static void addSetupLatency(std::chrono::microseconds latency);
+
+    struct Stats {
+        // Handshake steps, and the time spent in them on the workers and on the network threads
+        uint64_t worker_step_count;
+        uint64_t worker_step_micros;
+        uint64_t inline_step_count;
+        uint64_t inline_step_micros;
+        uint64_t setup_latency_histogram[kLatencyBucketCount];
+    };
+
+    [[nodiscard]] static Stats getStats();
+};
+
+} // namespace srtc
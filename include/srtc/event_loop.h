@@ -2,27 +2,76 @@
 
 #include "srtc/srtc.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace srtc
 {
 
+class SharedSocket;
 class Socket;
 
 class EventLoop
 {
 public:
-    virtual ~EventLoop() = default;
+    virtual ~EventLoop();
 
-    virtual void registerSocket(const std::shared_ptr<Socket>& socket, void* udata) = 0;
-    virtual void unregisterSocket(const std::shared_ptr<Socket>& socket) = 0;
+    // Sockets for talking to a remote address, which share one UDP port per address family (and are routed
+    // by a SharedSocket) after this has been called. A port of 0 means an ephemeral port. Call before
+    // creating any sockets.
+    void setSharedPort(uint16_t port, bool isReusePort);
+    [[nodiscard]] std::shared_ptr<SharedSocket> getSharedSocket() const;
 
-    virtual void wait(std::vector<void*>& udataList, int timeoutMillis) = 0;
+    // The ICE ufrag is our local one, it's used for routing with a shared port
+    [[nodiscard]] std::shared_ptr<Socket> createSocket(const anyaddr& addr, const std::string& iceUFrag);
+
+    void registerSocket(const std::shared_ptr<Socket>& socket, void* udata);
+    void unregisterSocket(const std::shared_ptr<Socket>& socket);
+
+    // Implementations sleep with at least 100 microsecond precision where the OS allows it
+    void wait(std::vector<void*>& udataList, const std::chrono::microseconds& timeout);
 
     virtual void interrupt() = 0;
 
+    // Which implementation the factory creates. IoUring is Linux only, and falls back to the default
+    // (epoll) if the kernel does not support it. Takes effect for event loops created after the call.
+    enum class Backend {
+        Default,
+        IoUring
+    };
+
+    static void setBackend(Backend backend);
+    [[nodiscard]] static Backend getBackend();
+
     static std::shared_ptr<EventLoop> factory();
+
+protected:
+    virtual void registerSocketImpl(const std::shared_ptr<Socket>& socket, void* udata) = 0;
+    virtual void unregisterSocketImpl(const std::shared_ptr<Socket>& socket) = 0;
+    virtual void waitImpl(std::vector<void*>& udataList, const std::chrono::microseconds& timeout) = 0;
+
+    // Wakeup coalescing, so that interrupt() only signals the OS when the loop's thread is sleeping, and
+    // only once per wait. Implementations call beginSleep() and endSleep() around their wait, and only
+    // block if beginSleep() returns true. In interrupt(), they only signal if requestWakeup() returns true.
+    [[nodiscard]] bool beginSleep();
+    void endSleep();
+    [[nodiscard]] bool requestWakeup();
+
+    // The longest we sleep for, so that a lost wakeup can't stall the loop
+    static constexpr auto kMaxTimeout = std::chrono::milliseconds(100);
+
+    [[nodiscard]] static std::chrono::microseconds clampTimeout(const std::chrono::microseconds& timeout);
+
+private:
+    std::shared_ptr<SharedSocket> mSharedSocket;
+    bool mIsSharedSocketRegistered = false;
+
+    std::atomic<bool> mIsSleeping = { false };
+    std::atomic<bool> mIsWakeupRequested = { false };
 };
 
 } // namespace srtc
\ No newline at end of file
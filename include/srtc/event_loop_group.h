@@ -0,0 +1,92 @@
+#pragma once
+
+#include "srtc/srtc.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace srtc
+{
+
+class EventLoop;
+class PeerConnection;
+
+// A fixed set of network threads shared by many peer connections.
+//
+// Each thread owns an event loop, and runs all the connections which were assigned to it. A connection
+// is assigned to the least loaded thread when it's started (when its SDP answer is set), and stays on that
+// thread until it's closed.
+//
+// Listener callbacks of a connection are invoked on its group thread, and so they are serialized with
+// the callbacks of all the other connections on the same thread. Do not close connections from callbacks.
+//
+// With a shared port, the connections on each thread share one UDP socket per address family, see
+// SharedSocket. Thread N binds the shared port + N, so that all of a connection's packets arrive on its
+// own thread; a shared port of 0 means each thread uses an ephemeral port.
+//
+// An ICE-lite connection (see IceLiteConfig) is assigned to a thread when its offer is created instead,
+// because the offer has the thread's shared port.
+
+class EventLoopGroup final
+{
+public:
+    // A thread count of 0 means one thread per CPU core
+    explicit EventLoopGroup(size_t threadCount = 0, const std::optional<uint16_t>& sharedPort = std::nullopt);
+    ~EventLoopGroup();
+
+    [[nodiscard]] size_t getThreadCount() const;
+
+    // The IPv4 port of each thread's shared socket, or empty if not sharing
+    [[nodiscard]] std::vector<uint16_t> getSharedPortList() const;
+
+    // Number of connections currently assigned to each thread
+    [[nodiscard]] std::vector<size_t> getLoad() const;
+
+private:
+    friend class PeerConnection;
+
+    // Assigns a connection to the least loaded thread and returns that thread's event loop
+    std::shared_ptr<EventLoop> attach(PeerConnection* pc) SRTC_LOCKS_EXCLUDED(mMutex);
+    // Waits until the connection's thread has stopped running the connection
+    void detach(PeerConnection* pc) SRTC_LOCKS_EXCLUDED(mMutex);
+
+    // Assigns a connection to a thread ahead of attach(), which then uses the same thread
+    std::shared_ptr<EventLoop> reserve(PeerConnection* pc) SRTC_LOCKS_EXCLUDED(mMutex);
+    // For a reserved connection which is closed without having been attached
+    void unreserve(PeerConnection* pc) SRTC_LOCKS_EXCLUDED(mMutex);
+
+    struct Worker {
+        const size_t index;
+        const std::shared_ptr<EventLoop> eventLoop;
+        std::thread thread;
+
+        size_t load = 0;
+        std::vector<PeerConnection*> startList;
+
+        // Only used on the worker's thread
+        std::vector<PeerConnection*> runList;
+
+        Worker(size_t index, const std::shared_ptr<EventLoop>& eventLoop);
+    };
+
+    [[nodiscard]] Worker* selectWorker() const SRTC_EXCLUSIVE_LOCKS_REQUIRED(mMutex);
+    void workerThreadFunc(Worker* worker);
+
+    mutable std::mutex mMutex;
+    std::condition_variable mDetachCond;
+
+    bool mIsQuit SRTC_GUARDED_BY(mMutex) = { false };
+    std::unordered_set<PeerConnection*> mAttachedSet SRTC_GUARDED_BY(mMutex);
+    std::unordered_map<PeerConnection*, Worker*> mReservedMap SRTC_GUARDED_BY(mMutex);
+    std::vector<std::unique_ptr<Worker>> mWorkerList;
+};
+
+} // namespace srtc
@@ -2,6 +2,8 @@
 
 #include "srtc/event_loop.h"
 
+struct epoll_event;
+
 namespace srtc
 {
 
@@ -11,16 +13,24 @@ public:
     EventLoop_Linux();
     ~EventLoop_Linux() override;
 
-    void registerSocket(const std::shared_ptr<Socket>& socket, void* udata) override;
-    void unregisterSocket(const std::shared_ptr<Socket>& socket) override;
+    void interrupt() override;
 
-    void wait(std::vector<void*>& udataList, int timeoutMillis) override;
+protected:
+    void registerSocketImpl(const std::shared_ptr<Socket>& socket, void* udata) override;
+    void unregisterSocketImpl(const std::shared_ptr<Socket>& socket) override;
 
-    void interrupt() override;
+    void waitImpl(std::vector<void*>& udataList, const std::chrono::microseconds& timeout) override;
 
 private:
+    // Waits with microsecond precision: epoll_pwait2 on Linux 5.11 and newer, otherwise a timer fd
+    int epollWait(struct epoll_event* eventList, int maxEvents, const std::chrono::microseconds& timeout);
+
     int mEventHandle;
     int mEpollHandle;
+    int mTimerHandle;
+    // Set until the timer fires, a wait which ended for another reason leaves it armed
+    bool mIsTimerArmed;
+    bool mIsPwait2Supported;
 };
 
 }; // namespace srtc
\ No newline at end of file
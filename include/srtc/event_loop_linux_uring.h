@@ -0,0 +1,154 @@
+#pragma once
+
+#include "srtc/event_loop.h"
+#include "srtc/socket.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+
+namespace srtc
+{
+
+// An event loop which does the socket I/O through io_uring, Linux 6.0 and newer.
+//
+// Each socket has a multishot recvmsg which takes buffers from a provided buffer ring, so receiving does
+// not need a system call per datagram or per socket. Sends are copied into a loop owned arena, which is
+// used as a ring, and are submitted as sendmsg operations together with the next wait.
+//
+// All calls except interrupt() must be made on the loop's thread.
+
+class EventLoop_LinuxUring final
+    : public EventLoop
+    , public Socket::Driver
+{
+public:
+    // Returns nullptr if the kernel does not support the io_uring features we need
+    static std::shared_ptr<EventLoop> create();
+
+    ~EventLoop_LinuxUring() override;
+
+    void interrupt() override;
+
+    void send(SocketHandle handle,
+              const anyaddr& addr,
+              socklen_t addrLen,
+              const uint8_t* data,
+              const size_t* sizeList,
+              size_t count) override;
+
+protected:
+    void registerSocketImpl(const std::shared_ptr<Socket>& socket, void* udata) override;
+    void unregisterSocketImpl(const std::shared_ptr<Socket>& socket) override;
+
+    void waitImpl(std::vector<void*>& udataList, const std::chrono::microseconds& timeout) override;
+
+private:
+    EventLoop_LinuxUring();
+
+    bool init();
+    bool probeMultishotReceive();
+
+    struct Registration {
+        const uint64_t id;
+        const std::shared_ptr<Socket> socket;
+        void* const udata;
+        struct msghdr msg;
+
+        bool isArmed = false;
+        bool isFailed = false;
+        bool isRemoved = false;
+        bool isReady = false;
+        bool isRetry = false;
+
+        // Buffers received while the socket's ring was full, in order
+        std::vector<std::pair<uint16_t, uint32_t>> pendingList;
+
+        Registration(uint64_t id, const std::shared_ptr<Socket>& socket, void* udata);
+    };
+
+    struct SendSlot {
+        struct msghdr msg;
+        struct iovec iov;
+        anyaddr addr;
+        // Where the data ends in the arena, which is free up to there once this send and all before it complete
+        size_t arenaEnd;
+        bool isDone;
+    };
+
+    // Submission and completion queues
+    struct io_uring_sqe* getSqe();
+    int enter(unsigned int minComplete, const struct __kernel_timespec* timeout);
+    void reapCompletions();
+    void handleCompletion(const struct io_uring_cqe& cqe);
+
+    // Receiving
+    void armInterrupt();
+    void armReceive(Registration* reg);
+    void cancel(uint64_t userData);
+    bool deliverBuffer(Registration* reg, uint16_t bufferId, uint32_t size);
+    void recycleBuffer(uint16_t bufferId);
+    void setReady(Registration* reg);
+    void setRetry(Registration* reg);
+    void removeRegistration(Registration* reg);
+
+    // Sending
+    [[nodiscard]] bool hasSendRoom(size_t arenaEnd) const;
+    bool waitForSendRoom(size_t arenaEnd);
+    void waitForCompletion();
+    void completeSend(uint64_t slotIndex);
+
+    int mEventHandle;
+    int mRingHandle;
+
+    // Rings shared with the kernel
+    void* mRingPtr;
+    size_t mRingSize;
+    struct io_uring_sqe* mSqes;
+    size_t mSqesSize;
+
+    unsigned int* mSqHeadPtr;
+    unsigned int* mSqTailPtr;
+    unsigned int* mSqArray;
+    unsigned int mSqMask;
+    unsigned int mSqEntries;
+    unsigned int mSqTail;
+
+    unsigned int* mCqHeadPtr;
+    unsigned int* mCqTailPtr;
+    struct io_uring_cqe* mCqes;
+    unsigned int mCqMask;
+
+    // Provided buffers for receiving
+    struct io_uring_buf_ring* mBufferRing;
+    size_t mBufferRingSize;
+    bool mIsBufferRingRegistered;
+    std::unique_ptr<uint8_t[]> mBufferMemory;
+    uint16_t mBufferTail;
+
+    bool mIsInterruptArmed;
+
+    // The result of the multishot recvmsg probe in init()
+    bool mIsProbeDone;
+    int mProbeResult;
+
+    uint64_t mNextId;
+    std::unordered_map<uint64_t, std::unique_ptr<Registration>> mRegistrationMap;
+    std::unordered_map<const Socket*, Registration*> mSocketMap;
+    std::vector<Registration*> mReadyList;
+    std::vector<Registration*> mRetryList;
+
+    // Sends in flight, both rings use running positions which are taken modulo their size
+    std::unique_ptr<uint8_t[]> mSendArena;
+    size_t mSendArenaHead;
+    size_t mSendArenaTail;
+    std::vector<SendSlot> mSendSlotList;
+    size_t mSendSlotHead;
+    size_t mSendSlotTail;
+};
+
+} // namespace srtc
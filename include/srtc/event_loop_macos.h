@@ -11,12 +11,13 @@ public:
     EventLoop_MacOS();
     ~EventLoop_MacOS() override;
 
-    void registerSocket(const std::shared_ptr<Socket>& socket, void* udata) override;
-    void unregisterSocket(const std::shared_ptr<Socket>& socket) override;
+    void interrupt() override;
 
-    void wait(std::vector<void*>& udataList, int timeoutMillis) override;
+protected:
+    void registerSocketImpl(const std::shared_ptr<Socket>& socket, void* udata) override;
+    void unregisterSocketImpl(const std::shared_ptr<Socket>& socket) override;
 
-    void interrupt() override;
+    void waitImpl(std::vector<void*>& udataList, const std::chrono::microseconds& timeout) override;
 
 private:
     int mKQueue;
@@ -14,12 +14,13 @@ public:
     EventLoop_Win();
     ~EventLoop_Win() override;
 
-    void registerSocket(const std::shared_ptr<Socket>& socket, void* udata) override;
-    void unregisterSocket(const std::shared_ptr<Socket>& socket) override;
+    void interrupt() override;
 
-    void wait(std::vector<void*>& udataList, int timeoutMillis) override;
+protected:
+    void registerSocketImpl(const std::shared_ptr<Socket>& socket, void* udata) override;
+    void unregisterSocketImpl(const std::shared_ptr<Socket>& socket) override;
 
-    void interrupt() override;
+    void waitImpl(std::vector<void*>& udataList, const std::chrono::microseconds& timeout) override;
 
 private:
     const HANDLE mEventHandle;
@@ -16,9 +16,10 @@
 namespace srtc
 {
 
+class Deadline;
 class Depacketizer;
 class Track;
-class RtpPacket;
+struct RtpPacketView;
 class RtcpPacket;
 
 // Jitter buffer, has a fixed max capacity (number of packets) and duration, for now
@@ -36,11 +37,11 @@ public:
 
     [[nodiscard]] std::shared_ptr<Track> getTrack() const;
 
-    // Adding received packets
-    void consume(const std::shared_ptr<RtpPacket>& packet);
+    // Adding received packets, the payload is copied
+    void consume(const RtpPacketView& packet);
 
     // Processing
-    [[nodiscard]] int getTimeoutMillis(int defaultTimeout) const;
+    void updateDeadline(Deadline& deadline) const;
     [[nodiscard]] std::vector<std::shared_ptr<EncodedFrame>> processDeque();
     [[nodiscard]] std::vector<uint16_t> processNack();
 
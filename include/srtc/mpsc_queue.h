@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace srtc
+{
+
+// A bounded lock-free queue for many producer threads and a single consumer thread.
+//
+// Each cell has a sequence number which tells whether it's free for the producer with the matching
+// position, or holds a value for the consumer: https://www.1024cores.net/home/lock-free-algorithms/queues
+
+template <typename T>
+class MpscQueue
+{
+public:
+    // The capacity is rounded up to a power of two
+    explicit MpscQueue(size_t capacity);
+    ~MpscQueue() = default;
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Any thread, returns false if the queue is full
+    [[nodiscard]] bool push(T&& value);
+
+    // The consumer thread only, returns false if the queue is empty
+    [[nodiscard]] bool pop(T& value);
+    void clear();
+
+private:
+    static constexpr size_t kCacheLineSize = 64;
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    static size_t roundCapacity(size_t capacity);
+
+    const size_t mMask;
+    const std::unique_ptr<Cell[]> mCellList;
+
+    // Separate cache lines for the producers and the consumer
+    alignas(kCacheLineSize) std::atomic<size_t> mPushPos;
+    alignas(kCacheLineSize) size_t mPopPos;
+};
+
+template <typename T>
+MpscQueue<T>::MpscQueue(size_t capacity)
+    : mMask(roundCapacity(capacity) - 1)
+    , mCellList(std::make_unique<Cell[]>(mMask + 1))
+    , mPushPos(0)
+    , mPopPos(0)
+{
+    for (size_t i = 0; i <= mMask; i += 1) {
+        mCellList[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+bool MpscQueue<T>::push(T&& value)
+{
+    auto pos = mPushPos.load(std::memory_order_relaxed);
+
+    while (true) {
+        auto& cell = mCellList[pos & mMask];
+        const auto sequence = cell.sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+        if (diff == 0) {
+            // The cell is free, try to claim it
+            if (mPushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.value = std::move(value);
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            // The consumer has not freed the cell yet
+            return false;
+        } else {
+            // Another producer got there first
+            pos = mPushPos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T>
+bool MpscQueue<T>::pop(T& value)
+{
+    auto& cell = mCellList[mPopPos & mMask];
+    const auto sequence = cell.sequence.load(std::memory_order_acquire);
+    if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(mPopPos + 1) < 0) {
+        return false;
+    }
+
+    value = std::move(cell.value);
+    cell.sequence.store(mPopPos + mMask + 1, std::memory_order_release);
+    mPopPos += 1;
+
+    return true;
+}
+
+template <typename T>
+void MpscQueue<T>::clear()
+{
+    T value;
+    while (pop(value)) {
+    }
+}
+
+template <typename T>
+size_t MpscQueue<T>::roundCapacity(size_t capacity)
+{
+    size_t value = 2;
+    while (value < capacity) {
+        value *= 2;
+    }
+    return value;
+}
+
+} // namespace srtc
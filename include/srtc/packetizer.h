@@ -1,5 +1,6 @@
 #pragma once
 
+#include "srtc/buffer_slice.h"
 #include "srtc/error.h"
 #include "srtc/rtp_packet.h"
 #include "srtc/srtc.h"
@@ -14,6 +15,7 @@ namespace srtc
 class Track;
 class ByteBuffer;
 class RtpPacket;
+class RtpPacketPool;
 class RtpPacketSource;
 class RtpExtension;
 class RtpExtensionSource;
@@ -30,11 +32,13 @@ public:
     virtual void setCodecSpecificData(const std::vector<ByteBuffer>& csd);
 
     [[nodiscard]] virtual bool isKeyFrame(const ByteBuffer& frame) const;
-    [[nodiscard]] virtual std::vector<std::shared_ptr<RtpPacket>> generate(
+    // The packets can refer to the frame's data instead of copying it, and keep the frame alive
+    [[nodiscard]] virtual std::vector<RtpPacketPtr> generate(
+        RtpPacketPool& pool,
         const std::vector<std::shared_ptr<RtpExtensionSource>>& extensionSourceList,
         size_t mediaProtectionOverhead,
         int64_t pts_usec,
-        const ByteBuffer& frame) = 0;
+        const SharedBuffer& frame) = 0;
 
     [[nodiscard]] std::shared_ptr<Track> getTrack() const;
 
@@ -12,11 +12,12 @@ public:
     explicit PacketizerOpus(const std::shared_ptr<Track>& track);
     ~PacketizerOpus() override;
 
-    [[nodiscard]] std::vector<std::shared_ptr<RtpPacket>> generate(
+    [[nodiscard]] std::vector<RtpPacketPtr> generate(
+        RtpPacketPool& pool,
         const std::vector<std::shared_ptr<RtpExtensionSource>>& extensionSourceList,
         size_t mediaProtectionOverhead,
         int64_t pts_usec,
-        const ByteBuffer& frame) override;
+        const SharedBuffer& frame) override;
 };
 
 } // namespace srtc
@@ -13,11 +13,12 @@ public:
     ~PacketizerVP8() override;
 
     [[nodiscard]] bool isKeyFrame(const ByteBuffer& frame) const override;
-    [[nodiscard]] std::vector<std::shared_ptr<RtpPacket>> generate(
+    [[nodiscard]] std::vector<RtpPacketPtr> generate(
+        RtpPacketPool& pool,
         const std::vector<std::shared_ptr<RtpExtensionSource>>& extensionSourceList,
         size_t mediaProtectionOverhead,
         int64_t pts_usec,
-        const ByteBuffer& frame) override;
+        const SharedBuffer& frame) override;
 };
 
 } // namespace srtc
@@ -1,10 +1,12 @@
 #pragma once
 
+#include "srtc/buffer_slice.h"
 #include "srtc/byte_buffer.h"
 #include "srtc/data_channel_message.h"
 #include "srtc/peer_candidate_listener.h"
 #include "srtc/random_generator.h"
 #include "srtc/receiver_reference_time_report.h"
+#include "srtc/rtp_packet_pool.h"
 #include "srtc/scheduler.h"
 #include "srtc/sctp_session_listener.h"
 #include "srtc/socket.h"
@@ -17,7 +19,6 @@
 #include <vector>
 
 struct ssl_st;
-struct ssl_ctx_st;
 struct bio_st;
 struct bio_method_st;
 
@@ -25,6 +26,7 @@ namespace srtc
 {
 
 struct DataChannelMessage;
+struct DtlsHandshake;
 
 class Error;
 class PeerCandidate;
@@ -68,7 +70,16 @@ public:
                   const Scheduler::Delay& startDelay);
     ~PeerCandidate() override;
 
+    [[nodiscard]] const Host& getHost() const;
+
+    // Starts connecting now instead of after the start delay, if it hasn't started yet
+    void startNow();
+    [[nodiscard]] bool isStartPending() const;
+
     void receiveFromSocket();
+    [[nodiscard]] CustomLogger* getCustomLogger() const;
+    // Sends everything queued on the socket during this loop iteration
+    void flushSocket();
 
     struct FrameToSend {
         int64_t pts_usec;
@@ -80,7 +91,7 @@ public:
     };
     void addSendFrame(FrameToSend&& frame);
 
-    [[nodiscard]] int getTimeoutMillis(int defaultValue) const;
+    void updateDeadline(Deadline& deadline) const;
     void run();
 
     void sendPublishReports();
@@ -110,11 +121,15 @@ private:
     void flushSendRaw();
 
     void onReceivedStunMessage(const Socket::ReceivedData& data);
+    // The response is in the ICE message buffer
+    void onReceivedIceLiteCheck(const Socket::ReceivedData& data, size_t responseSize, bool isUseCandidate);
     void onReceivedDtlsMessage(ByteBuffer&& buf);
-    void onReceivedRtcMessage(ByteBuffer&& buf);
+    void onReceivedDtlsData();
+    void onReceivedRtcMessage(ByteBuffer& buf);
+    void onReceivedMediaBatch();
 
     void onReceivedControlPacket(const std::shared_ptr<RtcpPacket>& packet);
-    void onReceivedMediaPacket(const std::shared_ptr<RtpPacket>& packet);
+    void onReceivedMediaPacket(const std::shared_ptr<Track>& track, const RtpPacketView& packet);
 
     void onReceivedControlMessage_SR(uint32_t ssrc, ByteReader& rtcpReader);
     void onReceivedControlMessage_RR(ByteReader& rtcpReader);
@@ -143,9 +158,13 @@ private:
     const std::shared_ptr<SdpAnswer> mAnswer;
     const Host mHost;
     const std::shared_ptr<EventLoop> mEventLoop;
+    // With ICE-lite, the peer checks us and we only respond, the socket's address is where its checks are from
+    const bool mIsIceLite;
     const std::shared_ptr<Socket> mSocket;
     const std::shared_ptr<IceAgent> mIceAgent;
     const std::unique_ptr<uint8_t[]> mIceMessageBuffer;
+    // Before the history and the pacer, which hold its packets, so it's destroyed after them
+    RtpPacketPool mRtpPacketPool;
     const std::shared_ptr<SendRtpHistory> mSendRtpHistory;
     const uint32_t mUniqueId;
     const std::shared_ptr<RtpExtensionSourceSimulcast> mExtensionSourceSimulcast;
@@ -168,9 +187,12 @@ private:
     std::shared_ptr<SendPacer> mSendPacer;
     std::shared_ptr<sctp::SctpSession> mSctpSession;
 
-    std::list<ByteBuffer> mDtlsReceiveQueue;
+    // Slots in the socket's receive ring
+    std::vector<Socket::ReceivedData*> mRawReceiveList;
 
-    std::list<Socket::ReceivedData> mRawReceiveQueue;
+    // RTP packets from the receive slots, unprotected together, and their protected sizes
+    std::vector<ByteBuffer*> mReceiveMediaList;
+    std::vector<size_t> mReceiveMediaSizeList;
 
     std::list<ByteBuffer> mRawSendQueue;
     std::list<FrameToSend> mFrameSendQueue;
@@ -181,9 +203,13 @@ private:
     std::vector<ReceiverReferenceTimeReport> mOutstandingReceiverReferenceTimeReportQueue;
 
     bool mSentUseCandidate;
+    // With ICE-lite, the peer has sent us USE-CANDIDATE
+    bool mIsNominated = false;
     bool mIsConnected;
 
     ByteBuffer mProtectedBuf;
+    ByteBuffer mRtpHeaderBuf;
+    ByteGather mRtpBodyGather;
 
     // DTLS
     enum class DtlsState {
@@ -193,7 +219,8 @@ private:
         Completed
     };
 
-    ssl_ctx_st* mDtlsCtx = {};
+    // Owns the SSL object, which belongs to a worker thread while a handshake step is running there
+    std::shared_ptr<DtlsHandshake> mDtlsHandshake;
     ssl_st* mDtlsSsl = {};
     bio_st* mDtlsBio = {};
     DtlsState mDtlsState = { DtlsState::Inactive };
@@ -207,8 +234,10 @@ private:
     static std::once_flag dgram_once;
     static struct bio_method_st* dgram_method;
 
-    static struct bio_st* BIO_new_dgram(PeerCandidate* pc);
+    static struct bio_st* BIO_new_dgram(DtlsHandshake* handshake);
 
+    void runDtlsHandshake();
+    void onDtlsHandshakeStep();
     void freeDTLS();
 
     // RTT
@@ -219,6 +248,7 @@ private:
     void emitOnIceConnected();
     void emitOnDtlsConnected();
     void emitOnFailedToConnect(const Error& error);
+    void emitOnConnectEvent(ConnectTimelineEvent::Type type, float rttMs = 0.0f);
     void emitOnDtlsDisconnected(const Error& error);
 
     void onReceivedFromRemote();
@@ -234,10 +264,13 @@ private:
     void updateKeepAliveTimeout();
     void onKeepAliveTimeout();
 
+    std::chrono::steady_clock::time_point mConnectStartTime;
     std::chrono::steady_clock::time_point mLastSendTime;
     std::chrono::steady_clock::time_point mLastReceiveTime;
 
     // Scheduler and tasks
+    std::weak_ptr<Task> mTaskStart;
+    bool mIsStartPending = true;
     std::weak_ptr<Task> mTaskConnectTimeout;
     std::weak_ptr<Task> mTaskSendStunConnectRequest;
     std::weak_ptr<Task> mTaskSendStunConnectResponse;
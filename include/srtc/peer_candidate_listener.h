@@ -1,5 +1,7 @@
 #pragma once
 
+#include "srtc/srtc.h"
+
 #include <memory>
 #include <string>
 #include <vector>
@@ -8,12 +10,13 @@ namespace srtc
 {
 
 class ByteBuffer;
+class CustomLogger;
 class PeerCandidate;
 class Error;
-class RtpPacket;
 class Media;
 class Track;
 
+struct RtpPacketView;
 struct SenderReport;
 struct SimulcastLayer;
 
@@ -29,8 +32,12 @@ public:
     virtual void onCandidateDtlsConnected(PeerCandidate* candidate) = 0;
     virtual void onCandidateDtlsDisconnected(PeerCandidate* candidate, const Error& error) = 0;
     virtual void onCandidateFailedToConnect(PeerCandidate* candidate, const Error& error) = 0;
+    // For the connect timeline, rtt is for STUN responses
+    virtual void onCandidateConnectEvent(PeerCandidate* candidate, ConnectTimelineEvent::Type type, float rttMs) = 0;
 
-    virtual void onCandidateReceivedMediaPacket(PeerCandidate* candiate, const std::shared_ptr<RtpPacket>& packet) = 0;
+    virtual void onCandidateReceivedMediaPacket(PeerCandidate* candiate,
+                                                const std::shared_ptr<Track>& track,
+                                                const RtpPacketView& packet) = 0;
     virtual void onCandidateReceivedSenderReport(PeerCandidate* candidate,
                                                  const std::shared_ptr<Track>& track,
                                                  const SenderReport& sr) = 0;
@@ -40,6 +47,9 @@ public:
     virtual void getSimulcastLayerList(const std::shared_ptr<Media>& media,
                                        std::vector<SimulcastLayer>& layerList) const = 0;
 
+    // The connection's logger, for when the candidate is called from a thread shared with other connections
+    [[nodiscard]] virtual CustomLogger* getCustomLogger() const = 0;
+
     virtual void onSctpDataChannelOpen(const std::string& label) = 0;
     virtual void onSctpDataChannelText(const std::string& label, const std::string& data) = 0;
     virtual void onSctpDataChannelBinary(const std::string& label, const ByteBuffer& data) = 0;
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "srtc/byte_buffer.h"
+#include "srtc/data_channel_message.h"
 #include "srtc/error.h"
 #include "srtc/jitter_buffer.h"
+#include "srtc/mpsc_queue.h"
 #include "srtc/peer_candidate_listener.h"
 #include "srtc/publish_config.h"
 #include "srtc/scheduler.h"
@@ -11,6 +13,7 @@
 #include "srtc/subscribe_config.h"
 #include "srtc/track_selector.h"
 
+#include <atomic>
 #include <functional>
 #include <list>
 #include <memory>
@@ -22,24 +25,33 @@ namespace srtc
 {
 
 class CustomLogger;
+class Deadline;
 class SdpAnswer;
 class SdpOffer;
 class Track;
 class Packetizer;
+class X509Certificate;
 class Scheduler;
 class PeerCandidate;
 class EventLoop;
-struct DataChannelMessage;
+class EventLoopGroup;
 
 class PeerConnection final : PeerCandidateListener
 {
 public:
     explicit PeerConnection(Direction direction);
+    // Runs the connection on a shared group thread instead of its own thread
+    PeerConnection(Direction direction, const std::shared_ptr<EventLoopGroup>& eventLoopGroup);
     ~PeerConnection() override;
 
     // Custom logger for the network thread, call before setting the SDP answer
     void setCustomLogger(CustomLogger* customLogger);
 
+    // Does the setup which doesn't depend on the offer and answer ahead of time: starts the network thread,
+    // which waits for the answer, and gets the certificate and DTLS contexts which the offer will use.
+    // Optional, creating the offer and setting the answer do whatever wasn't done here.
+    void prepare();
+
     // SDP offer
     using OfferAndError = std::pair<std::shared_ptr<SdpOffer>, Error>;
 
@@ -75,6 +87,9 @@ public:
     using ConnectionStateListener = std::function<void(ConnectionState state)>;
     void setConnectionStateListener(const ConnectionStateListener& listener);
 
+    // How the candidates raced, from the last time we started connecting
+    [[nodiscard]] std::vector<ConnectTimelineEvent> getConnectTimeline() const;
+
     // Publish listeners
     using PublishConnectionStatsListener = std::function<void(const PublishConnectionStats&)>;
     void setPublishConnectionStatsListener(const PublishConnectionStatsListener& listener);
@@ -135,35 +150,61 @@ private:
 
     std::shared_ptr<SdpOffer> mSdpOffer SRTC_GUARDED_BY(mMutex);
     std::shared_ptr<SdpAnswer> mSdpAnswer SRTC_GUARDED_BY(mMutex);
+
+    // From prepare, for the offers
+    std::shared_ptr<X509Certificate> mCertificate SRTC_GUARDED_BY(mMutex);
+    [[nodiscard]] std::shared_ptr<X509Certificate> getOfferCertificate() SRTC_LOCKS_EXCLUDED(mMutex);
     bool mDataChannelsNegotiated = false;
     uint32_t mDataChannelMaxMessageSize = 0;
 
     void networkThreadWorkerFunc();
+    [[nodiscard]] bool networkWaitForStart();
+
+    // Network processing, called on the connection's own thread or on its group thread
+    friend class EventLoopGroup;
+
+    void networkStart();
+    void networkUpdateDeadline(Deadline& deadline) const;
+    static void networkReceive(const std::vector<void*>& udataList);
+    [[nodiscard]] bool networkRun();
+    void networkStop();
 
     void setConnectionState(ConnectionState state) SRTC_LOCKS_EXCLUDED(mMutex, mListenerMutex);
 
     void startConnecting();
 
+    [[nodiscard]] Error getIceLiteHostList(const IceLiteConfig& liteConfig, std::vector<Host>& hostList)
+        SRTC_LOCKS_EXCLUDED(mMutex);
+
     bool mIsStarted SRTC_GUARDED_BY(mMutex) = { false };
     bool mIsQuit SRTC_GUARDED_BY(mMutex) = { false };
     std::thread mThread SRTC_GUARDED_BY(mMutex);
 
-    // Event loop
-    const std::shared_ptr<EventLoop> mEventLoop;
+    // Event loop, our own or assigned from the group when started
+    const std::shared_ptr<EventLoopGroup> mEventLoopGroup;
+    std::shared_ptr<EventLoop> mEventLoop;
 
+    // Set once started and once connected, for the API calls which don't lock mMutex. The event loop, the track
+    // list and the data channel parameters don't change after that.
+    std::atomic<bool> mIsRunning = { false };
+    std::atomic<bool> mIsConnected = { false };
+
+    // Queues from the API threads to the network thread
     struct FrameToSend {
         int64_t pts_usec;
         std::shared_ptr<Track> track;
-        std::shared_ptr<Packetizer> packetizer;
+        size_t track_index;
         uint64_t abs_capture_time_ntp;
         ByteBuffer buf;                      // possibly empty
         std::vector<ByteBuffer> csd;         // possibly empty
         std::optional<SimulcastLayer> layer; // possibly empty
-        bool request_pli;
     };
 
-    std::list<FrameToSend> mFrameSendQueue SRTC_GUARDED_BY(mMutex);
-    std::list<DataChannelMessage> mDataSendQueue SRTC_GUARDED_BY(mMutex);
+    [[nodiscard]] Error queueFrameToSend(FrameToSend&& frame);
+
+    MpscQueue<FrameToSend> mFrameSendQueue;
+    MpscQueue<DataChannelMessage> mDataSendQueue;
+    MpscQueue<std::shared_ptr<Track>> mPictureLossQueue;
 
     // Jitter buffer processing
     void processJitterBuffer(const std::shared_ptr<JitterBuffer>& buffer);
@@ -175,13 +216,17 @@ private:
     void onCandidateDtlsConnected(PeerCandidate* candidate) override;
     void onCandidateDtlsDisconnected(PeerCandidate* candidate, const Error& error) override;
     void onCandidateFailedToConnect(PeerCandidate* candidate, const Error& error) override;
-    void onCandidateReceivedMediaPacket(PeerCandidate* candiate, const std::shared_ptr<RtpPacket>& packet) override;
+    void onCandidateConnectEvent(PeerCandidate* candidate, ConnectTimelineEvent::Type type, float rttMs) override;
+    void onCandidateReceivedMediaPacket(PeerCandidate* candiate,
+                                        const std::shared_ptr<Track>& track,
+                                        const RtpPacketView& packet) override;
     void onCandidateReceivedSenderReport(PeerCandidate* candidate,
                                          const std::shared_ptr<Track>& track,
                                          const SenderReport& sr) override;
     void onCandidateReceivedKeyFrameRequest(PeerCandidate* candiate) override;
     void getSimulcastLayerList(const std::shared_ptr<Media>& media,
                                std::vector<SimulcastLayer>& layerList) const override;
+    [[nodiscard]] CustomLogger* getCustomLogger() const override;
 
     void onSctpDataChannelOpen(const std::string& label) override;
     void onSctpDataChannelText(const std::string& label, const std::string& data) override;
@@ -191,6 +236,12 @@ private:
     // Overall connection state and listener
     ConnectionState mConnectionState SRTC_GUARDED_BY(mMutex);
 
+    // Connect timeline
+    void addConnectEvent(const Host& host, ConnectTimelineEvent::Type type, float rttMs);
+
+    std::chrono::steady_clock::time_point mConnectStartTime;
+    std::vector<ConnectTimelineEvent> mConnectTimeline SRTC_GUARDED_BY(mMutex);
+
     std::mutex mListenerMutex;
     ConnectionStateListener mConnectionStateListener SRTC_GUARDED_BY(mListenerMutex);
     PublishConnectionStatsListener mPublishConnectionStatsListener SRTC_GUARDED_BY(mListenerMutex);
@@ -230,6 +281,9 @@ private:
     };
     std::vector<TrackEntry> mTrackEntryList;
 
+    // Same tracks in the same order, for looking up without locking
+    std::vector<std::shared_ptr<Track>> mTrackList;
+
     // Sender and receiver reports
     void sendReports();
     std::weak_ptr<Task> mTaskReports;
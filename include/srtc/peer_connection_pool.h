@@ -0,0 +1,65 @@
+#pragma once
+
+#include "srtc/srtc.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace srtc
+{
+
+class EventLoopGroup;
+class PeerConnection;
+
+// Keeps a number of prepared connections (see PeerConnection::prepare), so that starting a session only
+// takes creating the offer and the network round trips. A background thread refills the pool as connections
+// are taken from it.
+//
+// The sockets can't be created ahead of time, because they're per remote candidate from the answer.
+
+class PeerConnectionPool
+{
+public:
+    PeerConnectionPool(Direction direction, size_t size);
+    // Connections run on the group's threads, which are already running, so preparing them is only the
+    // certificate and contexts
+    PeerConnectionPool(Direction direction, size_t size, const std::shared_ptr<EventLoopGroup>& eventLoopGroup);
+    ~PeerConnectionPool();
+
+    // A prepared connection, or a new one if the pool is empty
+    [[nodiscard]] std::shared_ptr<PeerConnection> acquire();
+
+    struct Stats {
+        uint64_t hit_count;
+        uint64_t miss_count;
+        // Connections prepared in the background, and the time it took
+        uint64_t warm_up_count;
+        uint64_t warm_up_micros;
+        size_t ready_count;
+    };
+
+    [[nodiscard]] Stats getStats() const;
+
+private:
+    [[nodiscard]] std::shared_ptr<PeerConnection> create() const;
+    void refillThreadFunc();
+
+    const Direction mDirection;
+    const size_t mSize;
+    const std::shared_ptr<EventLoopGroup> mEventLoopGroup;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCond;
+    std::list<std::shared_ptr<PeerConnection>> mReadyList SRTC_GUARDED_BY(mMutex);
+    bool mIsQuit SRTC_GUARDED_BY(mMutex) = { false };
+    Stats mStats SRTC_GUARDED_BY(mMutex) = {};
+
+    std::thread mRefillThread;
+};
+
+} // namespace srtc
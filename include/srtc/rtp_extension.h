@@ -44,6 +44,12 @@ public:
 
     [[nodiscard]] std::optional<Value> findAny(uint8_t id) const;
 
+    // The same for extension data which is not in an RtpExtension, e.g. in a received packet
+    [[nodiscard]] static std::optional<Value> findAny(uint16_t extensionId,
+                                                      const uint8_t* data,
+                                                      size_t size,
+                                                      uint8_t id);
+
     // Strips the trailing zero padding that was added to align the wire data to 4 bytes
     void trimPadding();
 
@@ -57,10 +63,10 @@ private:
         size_t len;
     };
 
-    // Walks to the next element, one-byte or two-byte format depending on mId.
+    // Walks to the next element, one-byte or two-byte format depending on the extension id.
     // Returns false once padding, a reserved id, or truncated data is reached, or if
-    // mId is neither the one-byte indicator nor a recognized two-byte indicator.
-    [[nodiscard]] bool nextElement(ByteReader& reader, Element& out) const;
+    // the id is neither the one-byte indicator nor a recognized two-byte indicator.
+    [[nodiscard]] static bool nextElement(uint16_t extensionId, ByteReader& reader, Element& out);
 
     uint16_t mId;
     ByteBuffer mData;
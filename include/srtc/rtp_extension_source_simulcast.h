@@ -41,7 +41,7 @@ public:
 					  bool isKeyFrame,
 					  unsigned int packetNumber) override;
 
-	void updateForRtx(RtpExtensionBuilder& builder, const std::shared_ptr<Track>& track) const;
+	void updateForRtx(RtpExtensionBuilder& builder, const Track& track) const;
 
 private:
 	std::string mCurMediaId;
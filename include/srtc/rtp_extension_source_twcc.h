@@ -25,7 +25,7 @@ class RtpExtensionBuilder;
 class SdpOffer;
 class SdpAnswer;
 class RtpPacket;
-class RtpPacket;
+class RtpPacketPtr;
 class RealScheduler;
 
 class RtpExtensionSourceTWCC : public RtpExtensionSource
@@ -50,15 +50,15 @@ public:
                       bool isKeyFrame,
                       unsigned int packetNumber) override;
 
-    void onBeforeGeneratingRtpPacket(const std::shared_ptr<RtpPacket>& packet);
-    void onBeforeSendingRtpPacket(const std::shared_ptr<RtpPacket>& packet, size_t generatedSize, size_t encryptedSize);
-    void onPacketWasNacked(const std::shared_ptr<RtpPacket>& packet);
+    void onBeforeGeneratingRtpPacket(RtpPacket& packet);
+    void onBeforeSendingRtpPacket(const RtpPacket& packet, size_t generatedSize, size_t encryptedSize);
+    void onPacketWasNacked(const RtpPacket& packet);
 
     void onReceivedRtcpPacket(uint32_t ssrc, ByteReader& reader);
 
-    [[nodiscard]] std::optional<uint16_t> getFeedbackSeq(const std::shared_ptr<RtpPacket>& packet) const;
+    [[nodiscard]] std::optional<uint16_t> getFeedbackSeq(const RtpPacket& packet) const;
 
-    [[nodiscard]] unsigned int getPacingSpreadMillis(const std::vector<std::shared_ptr<RtpPacket>>& list,
+    [[nodiscard]] unsigned int getPacingSpreadMillis(const std::vector<RtpPacketPtr>& list,
                                                      float bandwidthScale,
                                                      unsigned int defaultValue) const;
     void updatePublishConnectionStats(PublishConnectionStats& stats) const;
@@ -73,7 +73,7 @@ private:
     };
     FixedTempBuffer<TempPacket> mTempPacketBuffer;
 
-    [[nodiscard]] uint8_t getExtensionId(const std::shared_ptr<Track>& track) const;
+    [[nodiscard]] uint8_t getExtensionId(const Track& track) const;
 
     // Probing
     bool mIsConnected;
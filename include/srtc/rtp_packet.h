@@ -1,5 +1,6 @@
 #pragma once
 
+#include "srtc/buffer_slice.h"
 #include "srtc/byte_buffer.h"
 #include "srtc/rtp_extension.h"
 
@@ -7,12 +8,48 @@
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <utility>
 
 namespace srtc
 {
 
+class RtpPacketPool;
+class RtpPacketPtr;
 class Track;
 
+// A received RTP packet parsed where it is. The extension data and the payload point into the packet's data,
+// and are valid as long as it is.
+
+struct RtpPacketView {
+    uint32_t ssrc = 0;
+    uint8_t payloadId = 0;
+    bool marker = false;
+    uint16_t sequence = 0;
+    uint32_t timestamp = 0;
+
+    // The id is 0 if there is no extension, or its id is not one we recognize
+    uint16_t extensionId = 0;
+    const uint8_t* extensionData = nullptr;
+    size_t extensionSize = 0;
+
+    // Without the padding
+    const uint8_t* payloadData = nullptr;
+    size_t payloadSize = 0;
+
+    [[nodiscard]] std::optional<RtpExtension::Value> findExtension(uint8_t id) const;
+    // Without the padding
+    [[nodiscard]] RtpExtension copyExtension() const;
+
+    // Returns false if the data is not a valid RTP packet
+    [[nodiscard]] static bool parse(const uint8_t* data, size_t size, RtpPacketView& view);
+};
+
+// An outgoing (or parsed) RTP packet.
+//
+// Packets are shared between the pacer, the send history and TWCC by RtpPacketPtr, which counts references
+// without atomics, so a packet is only used on the thread which made it. The packet doesn't keep its track
+// alive, the track belongs to the connection which sends the packet and outlives it.
+
 class RtpPacket
 {
 public:
@@ -51,9 +88,27 @@ public:
               RtpExtension&& extension,
               ByteBuffer&& payload);
 
+    // The payload is the owned part (e.g. a fragmentation header) followed by a slice of the frame
+    RtpPacket(const std::shared_ptr<Track>& track,
+              bool marker,
+              uint32_t rollover,
+              uint16_t sequence,
+              uint32_t timestamp,
+              uint8_t padding,
+              RtpExtension&& extension,
+              ByteBuffer&& payload,
+              const BufferSlice& payloadSlice);
+
     ~RtpPacket();
 
-    [[nodiscard]] std::shared_ptr<Track> getTrack() const;
+    RtpPacket(const RtpPacket& other) = delete;
+    RtpPacket& operator=(const RtpPacket& other) = delete;
+
+    // On the heap, when there is no pool
+    template <typename... Args>
+    [[nodiscard]] static RtpPacketPtr make(Args&&... args);
+
+    [[nodiscard]] Track* getTrack() const;
     [[nodiscard]] const RtpExtension& getExtension() const;
     [[nodiscard]] RtpExtension&& moveExtension();
     [[nodiscard]] bool getMarker() const;
@@ -64,8 +119,12 @@ public:
     [[nodiscard]] uint16_t getSequence() const;
     [[nodiscard]] uint32_t getSSRC() const;
     [[nodiscard]] uint32_t getTimestamp() const;
+    // The owned part of the payload, which is all of it unless the packet refers to a slice of a frame
     [[nodiscard]] const ByteBuffer& getPayload() const;
     [[nodiscard]] ByteBuffer&& movePayload();
+    [[nodiscard]] const BufferSlice& getPayloadSlice() const;
+    // All of the payload as one buffer
+    [[nodiscard]] ByteBuffer copyPayload() const;
 
     // The extension is mutable
     void setExtension(RtpExtension&& extension);
@@ -78,6 +137,12 @@ public:
     [[nodiscard]] Output generate() const;
     [[nodiscard]] Output generateRtx(const RtpExtension& extension) const;
 
+    // Same as above, but only the header and extension are written into the buffer. The payload and padding
+    // are added to the gather from where they are, so they can be encrypted without assembling the packet.
+    // Returns the rollover.
+    [[nodiscard]] uint32_t generate(ByteBuffer& header, ByteGather& body) const;
+    [[nodiscard]] uint32_t generateRtx(const RtpExtension& extension, ByteBuffer& header, ByteGather& body) const;
+
     // Send info
     struct SendInfo {
         bool is_last_packet_in_frame = false;
@@ -87,10 +152,19 @@ public:
     std::optional<SendInfo> getSendInfo() const;
 
     // Parse from a byte buffer
-    static std::shared_ptr<RtpPacket> fromUdpPacket(const std::shared_ptr<Track>& track, const ByteBuffer& data);
+    static RtpPacketPtr fromUdpPacket(const std::shared_ptr<Track>& track, const ByteBuffer& data);
 
 private:
-    const std::shared_ptr<Track> mTrack;
+    friend class RtpPacketPool;
+    friend class RtpPacketPtr;
+
+    // Called when the last reference goes away
+    static void destroy(RtpPacket* packet);
+
+    uint32_t mRefCount;
+    RtpPacketPool* mPool;
+
+    Track* const mTrack;
     const uint32_t mSSRC;
     const uint8_t mPayloadId;
     const bool mMarker;
@@ -99,8 +173,122 @@ private:
     const uint32_t mTimestamp;
     const uint8_t mPaddingSize;
     ByteBuffer mPayload;
+    BufferSlice mPayloadSlice;
     RtpExtension mExtension;
     std::optional<SendInfo> mSendInfo;
 };
 
+// A reference to a packet, which is not atomic
+
+class RtpPacketPtr
+{
+public:
+    RtpPacketPtr()
+        : mPacket(nullptr)
+    {
+    }
+
+    RtpPacketPtr(std::nullptr_t)
+        : mPacket(nullptr)
+    {
+    }
+
+    explicit RtpPacketPtr(RtpPacket* packet)
+        : mPacket(packet)
+    {
+        if (mPacket) {
+            mPacket->mRefCount += 1;
+        }
+    }
+
+    RtpPacketPtr(const RtpPacketPtr& other)
+        : RtpPacketPtr(other.mPacket)
+    {
+    }
+
+    RtpPacketPtr(RtpPacketPtr&& other) noexcept
+        : mPacket(other.mPacket)
+    {
+        other.mPacket = nullptr;
+    }
+
+    ~RtpPacketPtr()
+    {
+        reset();
+    }
+
+    RtpPacketPtr& operator=(const RtpPacketPtr& other)
+    {
+        if (mPacket != other.mPacket) {
+            RtpPacketPtr(other).swap(*this);
+        }
+        return *this;
+    }
+
+    RtpPacketPtr& operator=(RtpPacketPtr&& other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            mPacket = other.mPacket;
+            other.mPacket = nullptr;
+        }
+        return *this;
+    }
+
+    void reset()
+    {
+        if (mPacket) {
+            mPacket->mRefCount -= 1;
+            if (mPacket->mRefCount == 0) {
+                RtpPacket::destroy(mPacket);
+            }
+            mPacket = nullptr;
+        }
+    }
+
+    void swap(RtpPacketPtr& other) noexcept
+    {
+        std::swap(mPacket, other.mPacket);
+    }
+
+    [[nodiscard]] RtpPacket* get() const
+    {
+        return mPacket;
+    }
+
+    RtpPacket* operator->() const
+    {
+        return mPacket;
+    }
+
+    RtpPacket& operator*() const
+    {
+        return *mPacket;
+    }
+
+    explicit operator bool() const
+    {
+        return mPacket != nullptr;
+    }
+
+    bool operator==(const RtpPacketPtr& other) const
+    {
+        return mPacket == other.mPacket;
+    }
+
+    bool operator!=(const RtpPacketPtr& other) const
+    {
+        return mPacket != other.mPacket;
+    }
+
+private:
+    RtpPacket* mPacket;
+};
+
+template <typename... Args>
+RtpPacketPtr RtpPacket::make(Args&&... args)
+{
+    return RtpPacketPtr(new RtpPacket(std::forward<Args>(args)...));
+}
+
 } // namespace srtc
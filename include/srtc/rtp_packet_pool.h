@@ -0,0 +1,52 @@
+#pragma once
+
+#include "srtc/pool_allocator.h"
+#include "srtc/rtp_packet.h"
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace srtc
+{
+
+// Memory for a connection's outgoing packets. A packet goes back to the pool when its last reference
+// does, so a connection which keeps sending does not allocate packets from the heap in the steady state.
+//
+// Only used on the event loop's thread, and has to outlive its packets.
+
+class RtpPacketPool
+{
+public:
+    RtpPacketPool();
+    ~RtpPacketPool();
+
+    RtpPacketPool(const RtpPacketPool&) = delete;
+    RtpPacketPool& operator=(const RtpPacketPool&) = delete;
+
+    template <typename... Args>
+    [[nodiscard]] RtpPacketPtr make(Args&&... args);
+
+    // How many packets are referenced right now
+    [[nodiscard]] size_t getLiveCount() const;
+
+private:
+    friend class RtpPacket;
+
+    void release(RtpPacket* packet);
+
+    PoolAllocatorImpl mImpl;
+    size_t mLiveCount;
+};
+
+template <typename... Args>
+RtpPacketPtr RtpPacketPool::make(Args&&... args)
+{
+    const auto packet = new (mImpl.allocate()) RtpPacket(std::forward<Args>(args)...);
+    packet->mPool = this;
+    mLiveCount += 1;
+
+    return RtpPacketPtr(packet);
+}
+
+} // namespace srtc
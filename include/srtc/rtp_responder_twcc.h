@@ -14,10 +14,11 @@ namespace srtc
 
 class SdpOffer;
 class SdpAnswer;
-class RtpPacket;
 class RtcpPacket;
 class Track;
 
+struct RtpPacketView;
+
 class RtpResponderTWCC final
 {
 public:
@@ -26,7 +27,7 @@ public:
 
     static std::shared_ptr<RtpResponderTWCC> factory(const std::shared_ptr<SdpOffer>& offer);
 
-    void onMediaPacket(const std::shared_ptr<RtpPacket>& packet);
+    void onMediaPacket(const std::shared_ptr<Track>& track, const RtpPacketView& packet);
 
     [[nodiscard]] std::vector<std::shared_ptr<RtcpPacket>> run(const std::shared_ptr<Track>& track);
 
@@ -4,13 +4,14 @@
 #include <chrono>
 #include <condition_variable>
 #include <functional>
-#include <list>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
 
+#include "srtc/deadline.h"
 #include "srtc/srtc.h"
+#include "srtc/timer_wheel.h"
 
 namespace srtc
 {
@@ -49,6 +50,12 @@ public:
 
     virtual std::weak_ptr<Task> submit(const Delay& delay, const char* file, int line, const Func& func) = 0;
 
+    // Runs the function every interval, starting one interval from now, until the task is cancelled
+    virtual std::weak_ptr<Task> submitPeriodic(const Delay& interval,
+                                               const char* file,
+                                               int line,
+                                               const Func& func) = 0;
+
     virtual void cancel(std::shared_ptr<Task>& task) = 0;
 
     [[nodiscard]] virtual std::shared_ptr<RealScheduler> getRealScheduler() = 0;
@@ -78,6 +85,7 @@ public:
     ~ThreadScheduler() override;
 
     std::weak_ptr<Task> submit(const Delay& delay, const char* file, int line, const Func& func) override;
+    std::weak_ptr<Task> submitPeriodic(const Delay& interval, const char* file, int line, const Func& func) override;
 
     void cancel(std::shared_ptr<Task>& task) override;
 
@@ -93,7 +101,8 @@ private:
                  const When& when,
                  const char* file,
                  int line,
-                 const Func& func);
+                 const Func& func,
+                 const Delay& interval);
 
         ~TaskImpl() override;
 
@@ -101,12 +110,14 @@ private:
         std::weak_ptr<Task> update(const Delay& delay) override;
 
         const std::weak_ptr<ThreadScheduler> mOwner;
-        const When mWhen;
+        When mWhen;
         const char* const mFile;
         const int mLine;
         const Func mFunc;
+        const Delay mInterval;
 
         bool mIsCompleted = {false};
+        bool mIsCancelled = {false};
     };
 
     struct TaskImplLess {
@@ -116,6 +127,8 @@ private:
         };
     };
 
+    std::weak_ptr<Task> submitImpl(
+        const Delay& delay, const char* file, int line, const Func& func, const Delay& interval);
     void cancelImpl(const std::shared_ptr<TaskImpl>& task);
     std::weak_ptr<Task> updateImpl(const std::shared_ptr<TaskImpl>& oldTask, const Delay& delay);
 
@@ -132,6 +145,9 @@ private:
 
 // ----- LoopScheduler
 
+// Tasks are kept in a timing wheel with millisecond ticks, so submitting, updating and cancelling are O(1).
+// Updating a task and rescheduling a periodic task reuse the same task object.
+
 class LoopScheduler final : public RealScheduler, public std::enable_shared_from_this<LoopScheduler>
 {
 public:
@@ -140,6 +156,7 @@ public:
     ~LoopScheduler() override;
 
     std::weak_ptr<Task> submit(const Delay& delay, const char* file, int line, const Func& func) override;
+    std::weak_ptr<Task> submitPeriodic(const Delay& interval, const char* file, int line, const Func& func) override;
 
     void cancel(std::shared_ptr<Task>& task) override;
 
@@ -147,16 +164,23 @@ public:
 
     void dump() override;
 
-    [[nodiscard]] int getTimeoutMillis(int defaultValue) const;
+    void updateDeadline(Deadline& deadline) const;
 
     void run();
 
 private:
-    class TaskImpl final : public Task, public std::enable_shared_from_this<TaskImpl>
+    class TaskImpl final
+        : public Task
+        , public TimerNode
+        , public std::enable_shared_from_this<TaskImpl>
     {
     public:
-        TaskImpl(
-            const std::weak_ptr<LoopScheduler>& owner, const When& when, const char* file, int line, const Func& func);
+        TaskImpl(const std::weak_ptr<LoopScheduler>& owner,
+                 const When& when,
+                 const char* file,
+                 int line,
+                 const Func& func,
+                 const Delay& interval);
 
         ~TaskImpl() override;
 
@@ -164,26 +188,30 @@ private:
         std::weak_ptr<Task> update(const Delay& delay) override;
 
         const std::weak_ptr<LoopScheduler> mOwner;
-        const When mWhen;
+        When mWhen;
         const char* const mFile;
-        int mLine;
+        const int mLine;
         const Func mFunc;
-    };
+        const Delay mInterval;
 
-    struct TaskImplLess {
-        bool operator()(const std::shared_ptr<TaskImpl>& left, const std::shared_ptr<TaskImpl>& right)
-        {
-            return left->mWhen < right->mWhen;
-        };
+        // The scheduler's reference, while the task is scheduled or periodic
+        std::shared_ptr<TaskImpl> mSelf;
     };
 
     void assertCurrentThread() const;
 
-    void cancelImpl(std::shared_ptr<TaskImpl>& task);
-    std::weak_ptr<Task> updateImpl(const std::shared_ptr<TaskImpl>& oldTask, const Delay& delay);
+    std::weak_ptr<Task> submitImpl(
+        const Delay& delay, const char* file, int line, const Func& func, const Delay& interval);
+    void schedule(const std::shared_ptr<TaskImpl>& task);
+    void cancelImpl(const std::shared_ptr<TaskImpl>& task);
+    std::weak_ptr<Task> updateImpl(const std::shared_ptr<TaskImpl>& task, const Delay& delay);
 
+    [[nodiscard]] uint64_t getTick(const When& when) const;
+
+    const When mStartTime;
     std::thread::id mThreadId;
-    std::vector<std::shared_ptr<TaskImpl>> mTaskQueue;
+    TimerWheel mTimerWheel;
+    TimerList mDueList;
 };
 
 // ----- ScopedScheduler
@@ -196,16 +224,20 @@ public:
     ~ScopedScheduler() override;
 
     std::weak_ptr<Task> submit(const Delay& delay, const char* file, int line, const Func& func) override;
+    std::weak_ptr<Task> submitPeriodic(const Delay& interval, const char* file, int line, const Func& func) override;
 
     void cancel(std::shared_ptr<Task>& task) override;
 
     [[nodiscard]] std::shared_ptr<RealScheduler> getRealScheduler() override;
 
 private:
-    class TaskImpl final : public Task, public std::enable_shared_from_this<TaskImpl>
+    class TaskImpl final
+        : public Task
+        , public TimerNode
+        , public std::enable_shared_from_this<TaskImpl>
     {
     public:
-        TaskImpl(ScopedScheduler* owner, const std::weak_ptr<Task>& task, const char* file, int line, const Func& func);
+        TaskImpl(ScopedScheduler* owner, const std::weak_ptr<Task>& task);
 
         ~TaskImpl() override;
 
@@ -213,18 +245,20 @@ private:
         std::weak_ptr<Task> update(const Delay& delay) override;
 
         ScopedScheduler* const mOwner;
-        const std::weak_ptr<Task> mTask;
-        const char* const mFile;
-        const int mLine;
-        const Func mFunc;
+        std::weak_ptr<Task> mTask;
+
+        // Our reference, while the task is in the submitted list
+        std::shared_ptr<TaskImpl> mSelf;
     };
 
+    std::weak_ptr<Task> addLocked(const std::weak_ptr<Task>& task) SRTC_EXCLUSIVE_LOCKS_REQUIRED(mMutex);
     void cancelImpl(const std::shared_ptr<TaskImpl>& task);
-    std::weak_ptr<Task> updateImpl(const std::shared_ptr<TaskImpl>& oldTask, const Delay& delay);
+    std::weak_ptr<Task> updateImpl(const std::shared_ptr<TaskImpl>& task, const Delay& delay);
 
-    void removeExpiredLocked() SRTC_SHARED_LOCKS_REQUIRED(mMutex);
+    void removeExpiredLocked() SRTC_EXCLUSIVE_LOCKS_REQUIRED(mMutex);
 
-    std::list<std::shared_ptr<TaskImpl>> mSubmitted SRTC_GUARDED_BY(mMutex);
+    TimerList mSubmitted SRTC_GUARDED_BY(mMutex);
+    size_t mRemoveExpiredSize SRTC_GUARDED_BY(mMutex);
     std::mutex mMutex;
 
     const std::shared_ptr<RealScheduler> mScheduler;
@@ -26,13 +26,30 @@ struct DataChannelConfig {
     std::vector<std::string> data_channels;
 };
 
+// ICE-lite (https://datatracker.ietf.org/doc/html/rfc8445#section-2.5): the offer has our host candidates
+// on the event loop group's shared port, and we only answer the peer's connectivity checks, which the shared
+// socket routes to the connection by the ufrag in their USERNAME. We don't send checks or keep-alives, and
+// there is no socket per connection. The peer must be a full ICE agent, e.g. a browser.
+struct IceLiteConfig {
+    bool enable = false;
+    // Our IPv4 and IPv6 addresses as the peer sees them, e.g. the server's public addresses
+    std::vector<std::string> host_list;
+};
+
 struct PubOfferConfig {
     std::string cname;
     bool enable_rtx = true;
     bool enable_bwe = false;
     bool enable_rfc8851 = false;
     bool enable_abs_capture_time = false;
+    bool enable_gso = false; // Linux only
+    // How far back NACKs can reach, the history holds this much time at this bitrate
+    uint16_t nack_history_millis = 1000;
+    uint32_t nack_history_kbit_per_second = 8000;
+    // Keep packets protected for re-sending them without RTX, trades memory for encryption work
+    bool enable_nack_protected_cache = false;
     DataChannelConfig data_channel_config;
+    IceLiteConfig ice_lite_config;
 };
 
 struct SubOfferConfig {
@@ -41,7 +58,10 @@ struct SubOfferConfig {
     uint16_t pli_interval_millis = 2000;
     uint16_t jitter_buffer_length_millis = 0;
     uint16_t jitter_buffer_nack_delay_millis = 0;
+    bool enable_gro = false;         // Linux only, not with the io_uring event loop
+    uint32_t receive_buffer_size = 0; // for GRO, up to 64 KB, 0 = maximum
     DataChannelConfig data_channel_config;
+    IceLiteConfig ice_lite_config;
 };
 
 class SdpOffer
@@ -60,12 +80,21 @@ private:
         bool enable_rtx = true;
         bool enable_bwe = false;
         bool enable_rfc8851 = false;
+        bool enable_gso = false;
+        uint16_t nack_history_millis = 1000;
+        uint32_t nack_history_kbit_per_second = 8000;
+        bool enable_nack_protected_cache = false;
         // Subscribe
         uint16_t pli_interval_millis = 0;
         uint16_t jitter_buffer_length_millis = 0;
         uint16_t jitter_buffer_nack_delay_millis = 0;
+        bool enable_gro = false;
+        uint32_t receive_buffer_size = 0;
         // Publish and subscribe
         bool enable_abs_capture_time = false;
+        // ICE-lite, with the ports filled in
+        bool enable_ice_lite = false;
+        std::vector<Host> ice_lite_host_list;
     };
 
     struct MediaCodec {
@@ -90,7 +119,10 @@ private:
         std::vector<SimulcastLayer> layer_list;
     };
 
-    SdpOffer(Direction direction, const Config& config, const std::vector<MediaLine>& media);
+    SdpOffer(Direction direction,
+             const Config& config,
+             const std::vector<MediaLine>& media,
+             const std::shared_ptr<X509Certificate>& cert);
 
 public:
     ~SdpOffer() = default;
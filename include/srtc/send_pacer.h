@@ -8,7 +8,10 @@
 
 #include <cstdint>
 
+#include "srtc/buffer_slice.h"
+#include "srtc/byte_buffer.h"
 #include "srtc/random_generator.h"
+#include "srtc/rtp_packet.h"
 #include "srtc/sdp_offer.h"
 
 namespace srtc
@@ -17,11 +20,12 @@ namespace srtc
 class SrtpConnection;
 class Socket;
 class SendRtpHistory;
-class RtpPacket;
 class RtpExtensionSourceTWCC;
 class Track;
+class Deadline;
 
 struct PubOfferConfig;
+struct SrtpProtectItem;
 
 class SendPacer
 {
@@ -38,11 +42,11 @@ public:
 
 	void flush(const std::shared_ptr<Track>& track);
 
-	void sendNow(const std::shared_ptr<RtpPacket>& packet);
-	void sendPaced(const std::vector<std::shared_ptr<RtpPacket>>& packetList,
+	void sendNow(const RtpPacketPtr& packet);
+	void sendPaced(const std::vector<RtpPacketPtr>& packetList,
 				   unsigned int spreadMillis);
 
-	[[nodiscard]] int getTimeoutMillis(int defaultValue) const;
+	void updateDeadline(Deadline& deadline) const;
 	void run();
 
 private:
@@ -53,24 +57,34 @@ private:
 	const std::shared_ptr<RtpExtensionSourceTWCC> mTWCC;
 	const std::function<void()> mOnSend;
 
+	// Stored by value, queueing a packet doesn't allocate once the queue has grown
 	struct Item {
-		const std::chrono::steady_clock::time_point when;
-		const std::shared_ptr<RtpPacket> packet;
-
-		Item(const std::chrono::steady_clock::time_point& when,
-			  const std::shared_ptr<RtpPacket>& packet) : when(when), packet(packet) {}
+		std::chrono::steady_clock::time_point when;
+		RtpPacketPtr packet;
 	};
 
 	struct ItemLess {
-		bool operator()(const std::shared_ptr<Item>& left, const std::shared_ptr<Item>& right)
+		bool operator()(const Item& left, const Item& right)
 		{
-			return left->when < right->when;
+			return left.when < right.when;
 		};
 	};
 
-	std::vector<std::shared_ptr<Item>> mQueue;
+	std::vector<Item> mQueue;
+
+	void sendImpl(const RtpPacketPtr& packet);
+
+	// Packets which go out together are protected together, in batches which fit the socket's send queue
+	static constexpr size_t kMaxBatchSize = 16;
+
+	void sendBatch(const RtpPacketPtr* packetList, size_t packetCount);
+	void sendBatchImpl(const RtpPacketPtr* packetList, size_t packetCount);
 
-	void sendImpl(const std::shared_ptr<RtpPacket>& packet);
+	// Reused for every batch, the payload is encrypted from the frame straight into the socket's send queue
+	ByteBuffer mHeaderBufList[kMaxBatchSize];
+	ByteGather mBodyGatherList[kMaxBatchSize];
+	std::vector<SrtpProtectItem> mProtectItemList;
+	std::vector<RtpPacketPtr> mBatchList;
 
 #ifdef NDEBUG
 #else
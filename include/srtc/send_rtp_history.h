@@ -1,33 +1,83 @@
 #pragma once
 
-#include <list>
-#include <memory>
-#include <unordered_map>
+#include <chrono>
+#include <vector>
 
+#include <cstddef>
 #include <cstdint>
 
+#include "srtc/byte_buffer.h"
+#include "srtc/rtp_packet.h"
+
 namespace srtc
 {
 
-class RtpPacket;
+// Sent packets kept for re-sending when the peer asks for them with a NACK.
+//
+// Each SSRC has a ring of packets indexed by the low bits of the sequence number, so saving and finding
+// don't allocate or hash. The ring is sized to hold the packets sent during a time window at a bitrate.
+//
+// Optionally, the protected (encrypted) bytes of a packet can be kept next to it. A packet which is re-sent
+// as is (without RTX) encrypts to the same bytes, so they can be sent again without protecting the packet
+// again. This costs a datagram's worth of memory per slot, once the ring has filled up.
 
 class SendRtpHistory
 {
 public:
-	SendRtpHistory();
+    SendRtpHistory(std::chrono::milliseconds window, uint32_t kilobitsPerSecond, bool isCachingProtected);
     ~SendRtpHistory();
 
-    void save(const std::shared_ptr<RtpPacket>& packet);
+    // A power of two, for the window and bitrate, with packets of the typical size
+    [[nodiscard]] static size_t calculateCapacity(std::chrono::milliseconds window, uint32_t kilobitsPerSecond);
+
+    void save(const RtpPacketPtr& packet);
+
+    [[nodiscard]] RtpPacketPtr find(uint32_t ssrc, uint16_t sequence);
+
+    [[nodiscard]] bool isCachingProtected() const;
+    // For a packet which was saved, does nothing when not caching
+    void saveProtected(uint32_t ssrc, uint16_t sequence, const uint8_t* data, size_t size);
+    // nullptr if there is nothing cached for the packet, valid until the next save
+    [[nodiscard]] const ByteBuffer* findProtected(uint32_t ssrc, uint16_t sequence);
+
+    struct Stats {
+        uint64_t saved_count;
+        // Overwritten by a newer packet while still inside the time window, the ring is too small
+        uint64_t evicted_count;
+        uint64_t found_count;
+        // Asked for but no longer (or never) in the ring
+        uint64_t missed_count;
+        // Re-sent from the protected bytes, a subset of found_count
+        uint64_t protected_found_count;
+        size_t capacity;
+    };
 
-    [[nodiscard]] std::shared_ptr<RtpPacket> find(uint32_t ssrc, uint16_t sequence) const;
+    [[nodiscard]] Stats getStats() const;
 
 private:
+    const std::chrono::milliseconds mWindow;
+    const size_t mCapacity;
+    const size_t mCapacityMask;
+    const bool mIsCachingProtected;
+
+    struct Slot {
+        RtpPacketPtr packet;
+        std::chrono::steady_clock::time_point when;
+        ByteBuffer protectedData;
+    };
+
     struct TrackHistory {
-        std::list<std::shared_ptr<RtpPacket>> packetList;
-        std::unordered_map<uint32_t, std::shared_ptr<RtpPacket>> packetMap;
+        uint32_t ssrc;
+        std::vector<Slot> ring;
     };
 
-    std::unordered_map<uint32_t, TrackHistory> mTrackMap;
+    // There are only a few SSRCs, one per track (and simulcast layer)
+    std::vector<TrackHistory> mTrackList;
+
+    Stats mStats;
+
+    [[nodiscard]] TrackHistory* findTrack(uint32_t ssrc);
+    [[nodiscard]] Slot* findSlot(uint32_t ssrc, uint16_t sequence);
 };
 
 } // namespace srtc
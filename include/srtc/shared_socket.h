@@ -0,0 +1,108 @@
+#pragma once
+
+#include "srtc/socket.h"
+#include "srtc/srtc.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace srtc
+{
+
+// Many candidates' sockets sharing one local UDP port, so that an event loop running many connections
+// does not need a socket (and a file descriptor, and a registration with the OS) per candidate.
+//
+// There is one kernel socket per address family, bound to the same port. Received datagrams are routed
+// to the endpoint for the remote address. A STUN request from an unknown address is routed by the local
+// ICE ufrag in its USERNAME, but the address is not remembered: the ufrag is sent in the clear, so anyone
+// could claim a session with it. The candidate adds the address with addEndpointAddress once it has
+// verified the request's MESSAGE-INTEGRITY.
+//
+// Two endpoints can't share a remote address, there would be no way to tell their datagrams apart, so
+// creating an endpoint for an address which is already in use returns nullptr.
+//
+// Only used on the event loop's thread.
+
+class SharedSocket
+{
+public:
+    // A port of 0 means an ephemeral port. With isReusePort, other sockets can bind the same port with
+    // SO_REUSEPORT, and the OS balances incoming flows between them.
+    SharedSocket(uint16_t port, bool isReusePort);
+    ~SharedSocket();
+
+    SharedSocket(const SharedSocket&) = delete;
+    SharedSocket& operator=(const SharedSocket&) = delete;
+
+    // The bound port, or 0 if there is no socket for the address family
+    [[nodiscard]] uint16_t getPort(int family) const;
+
+    [[nodiscard]] std::shared_ptr<Socket> createEndpoint(const anyaddr& addr, const std::string& iceUFrag);
+    // An endpoint without a remote address, for ICE-lite: it's found by ufrag when the peer's checks arrive,
+    // and the candidate adds the verified addresses and sets the one to send to with Socket::setAddr. Returns
+    // nullptr if there is no socket for the address family.
+    [[nodiscard]] std::shared_ptr<Socket> createInboundEndpoint(int family, const std::string& iceUFrag);
+
+    // The kernel sockets, which need to be registered with the event loop
+    [[nodiscard]] std::vector<std::shared_ptr<Socket>> getKernelSocketList() const;
+
+    void addEndpoint(const std::shared_ptr<Socket>& socket, void* udata);
+    void removeEndpoint(const std::shared_ptr<Socket>& socket);
+
+    // Routes datagrams from the address to the endpoint from now on. An endpoint keeps a limited number of
+    // addresses, the oldest one is forgotten to make room, except for the one the endpoint sends to.
+    // Returns false if the address belongs to another endpoint.
+    bool addEndpointAddress(const std::shared_ptr<Socket>& socket, const anyaddr& addr);
+
+    // Reads from the kernel sockets, routes to the endpoints, and appends the udata of endpoints which
+    // have received something
+    void receive(std::vector<void*>& udataList);
+
+    struct Stats {
+        uint64_t routed_by_address;
+        uint64_t routed_by_ufrag;
+        uint64_t addr_evicted;
+        uint64_t dropped_unknown;
+        uint64_t dropped_full;
+        size_t endpoint_count;
+    };
+
+    [[nodiscard]] Stats getStats() const;
+
+private:
+    struct Endpoint {
+        const std::shared_ptr<Socket> socket;
+        void* const udata;
+        std::vector<anyaddr> addrList;
+        bool isReady = false;
+
+        Endpoint(const std::shared_ptr<Socket>& socket, void* udata);
+    };
+
+    struct AddrHash {
+        size_t operator()(const anyaddr& addr) const;
+    };
+    struct AddrEqual {
+        bool operator()(const anyaddr& addr1, const anyaddr& addr2) const;
+    };
+
+    [[nodiscard]] Endpoint* findEndpoint(const Socket::ReceivedData& data);
+
+    std::shared_ptr<Socket> mSocket4;
+    std::shared_ptr<Socket> mSocket6;
+
+    std::unordered_map<const Socket*, std::unique_ptr<Endpoint>> mEndpointMap;
+    std::unordered_map<anyaddr, Endpoint*, AddrHash, AddrEqual> mAddrMap;
+    std::unordered_multimap<std::string, Endpoint*> mUFragMap;
+
+    std::vector<Socket::ReceivedData*> mReceiveList;
+    std::vector<Endpoint*> mReadyList;
+
+    Stats mStats;
+};
+
+} // namespace srtc
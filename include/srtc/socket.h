@@ -3,10 +3,11 @@
 #include "srtc/byte_buffer.h"
 #include "srtc/srtc.h"
 
-#include <list>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
-#include <cstddef>
+#include <vector>
 
 namespace srtc
 {
@@ -15,39 +16,155 @@ class Socket
 {
 public:
     explicit Socket(const anyaddr& addr);
+
+    // An endpoint of a shared socket (see SharedSocket): sends to the address through the shared socket,
+    // and receives what the shared socket routes to it. The ICE ufrag is our local one, for routing STUN.
+    Socket(const anyaddr& addr, const std::shared_ptr<Socket>& shared, const std::string& iceUFrag);
+
     ~Socket();
 
+    // A socket bound to a local port, which receives from any address. Returns nullptr if binding fails.
+    static std::shared_ptr<Socket> createBound(int family, uint16_t port, bool isReusePort);
+
     [[nodiscard]] SocketHandle handle() const;
 
+    [[nodiscard]] const anyaddr& getAddr() const;
+    // For endpoints which were created without a remote address, see SharedSocket::createInboundEndpoint
+    void setAddr(const anyaddr& addr);
+    [[nodiscard]] uint16_t getLocalPort() const;
+
+    [[nodiscard]] bool isEndpoint() const;
+    [[nodiscard]] const std::string& getIceUFrag() const;
+
 #ifdef _WIN32
     [[nodiscard]] HANDLE event() const;
 #endif
 
+    // A slot in the receive ring
     struct ReceivedData {
         ByteBuffer buf;
         anyaddr addr;
         socklen_t addr_len;
 
-        ReceivedData(ByteBuffer&& buf, const anyaddr& addr, socklen_t addr_len)
-            : buf(std::move(buf))
-            , addr(addr)
-            , addr_len(addr_len)
+        ReceivedData()
+            : addr()
+            , addr_len(0)
         {
         }
     };
 
-    [[nodiscard]] std::list<ReceivedData> receive();
+    // Receives into the free slots of the receive ring and appends them to the list. The slots are owned
+    // by the socket and stay valid until released, oldest first. Their data can be modified in place, e.g.
+    // decrypted, and resized down.
+    void receive(std::vector<ReceivedData*>& list);
+    void release(size_t count);
+
+    // Receives coalesced runs of datagrams (UDP_GRO) into a buffer of the given size, up to 64 KB, and
+    // splits them into the ring, Linux only. A buffer size of zero means the maximum. Not supported with a
+    // driver, which does the receiving itself.
+    bool setGroEnabled(bool enabled, size_t bufferSize);
+    [[nodiscard]] bool isGroEnabled() const;
+    // Coalesced datagrams which did not fit into the ring. They have already been read from the kernel,
+    // so the event loop won't report the socket as readable for them, receive() should be called again
+    // once slots are released.
+    [[nodiscard]] bool hasPendingReceive() const;
 
     [[nodiscard]] ssize_t send(const ByteBuffer& buf);
     [[nodiscard]] ssize_t send(const void* ptr, size_t len);
 
+    // Batched sending: packets are copied into the send queue, and go out with as few system calls
+    // as possible when flushed, or when the queue fills up
+    void queue(const ByteBuffer& buf);
+    void queue(const void* ptr, size_t len);
+    void flush();
+
+    // For writing a packet straight into the send queue instead of copying it there: returns room for
+    // at least the size, and then commitQueued() adds what was written. Returns nullptr if the size is
+    // larger than the queue can take. With a count, the room is for that many packets written one after
+    // the other, each added with its own commitQueued().
+    [[nodiscard]] uint8_t* reserveQueued(size_t size, size_t count = 1);
+    void commitQueued(size_t size);
+
+    // Sends runs of equal size queued packets as single UDP_SEGMENT (GSO) messages, Linux only.
+    // Returns false if not supported, and turns itself off if the kernel rejects a send.
+    bool setGsoEnabled(bool enabled);
+
+    [[nodiscard]] float getPacketsPerSendCall() const;
+    [[nodiscard]] float getSegmentsPerGsoSend() const;
+
+    // An event loop which does the socket's I/O itself (io_uring). With a driver, receive() only reports
+    // what the driver has delivered, and flush() hands the queued packets over to the driver.
+    class Driver
+    {
+    public:
+        virtual ~Driver() = default;
+
+        virtual void send(SocketHandle handle,
+                          const anyaddr& addr,
+                          socklen_t addrLen,
+                          const uint8_t* data,
+                          const size_t* sizeList,
+                          size_t count) = 0;
+    };
+
+    void setDriver(Driver* driver);
+
+    // Puts a datagram received by the driver into the ring, returns false if the ring is full
+    bool deliver(const uint8_t* data, size_t size, const anyaddr& addr, socklen_t addrLen);
+
 private:
-    const anyaddr mAddr;
+    Socket(const anyaddr& addr,
+           SocketHandle handle,
+           const std::shared_ptr<Socket>& shared,
+           const std::string& iceUFrag,
+           bool isFiltered);
+
+    anyaddr mAddr;
     const SocketHandle mHandle;
+    // Set for endpoints, which don't own the handle
+    const std::shared_ptr<Socket> mShared;
+    const std::string mIceUFrag;
+    // Only accept datagrams from mAddr
+    const bool mIsFiltered;
 #ifdef _WIN32
     const HANDLE mEvent;
 #endif
-    const std::unique_ptr<uint8_t[]> mReceiveBuffer;
+
+    // Receive ring
+    std::vector<ReceivedData> mReceiveRing;
+    size_t mReceiveHead;
+    size_t mReceiveCount;
+    size_t mReceiveReported;
+
+    void receiveImpl();
+
+    // Accepts a datagram received into a slot past the used ones, returns false if it's not from our peer
+    bool acceptReceived(size_t slot, size_t size);
+
+    bool mGroEnabled;
+
+    Driver* mDriver;
+
+    // Send queue
+    ByteBuffer mSendBuffer;
+    std::vector<size_t> mSendSizeList;
+    uint64_t mSendPacketCount;
+    uint64_t mSendCallCount;
+    bool mGsoEnabled;
+    uint64_t mGsoSendCount;
+    uint64_t mGsoSegmentCount;
+
+#ifdef __linux__
+    struct ReceiveBatch;
+    const std::unique_ptr<ReceiveBatch> mReceiveBatch;
+
+    void receiveGro();
+    struct SendBatch;
+    const std::unique_ptr<SendBatch> mSendBatch;
+
+    // Prepares messages for the queued packets starting with the first one, returns the message count
+    size_t prepareSendBatch(size_t first);
+#endif
 };
 
 } // namespace srtc
@@ -7,6 +7,7 @@
 #include <arpa/inet.h>
 #endif
 
+#include <chrono>
 #include <string>
 #include <thread>
 #include <vector>
@@ -58,6 +59,30 @@ struct Host {
     union anyaddr addr;
 };
 
+// A step in connecting, candidates are raced and this is how it went
+struct ConnectTimelineEvent {
+    enum class Type {
+        CandidateStarted,
+        StunRequestSent,
+        StunResponseReceived,
+        // ICE-lite, a check from the peer
+        StunRequestReceived,
+        DtlsStarted,
+        DtlsCompleted,
+        CandidateFailed,
+        CandidateCancelled
+    };
+
+    Type type;
+    std::string host;
+    // Since the connection started connecting
+    std::chrono::microseconds time;
+    // For STUN responses
+    float rtt_ms;
+};
+
+std::string to_string(ConnectTimelineEvent::Type type);
+
 struct PublishConnectionStats {
     size_t frame_count = 0;
     size_t packet_count = 0;
@@ -66,6 +91,15 @@ struct PublishConnectionStats {
     float rtt_ms = 0.0f;
     float bandwidth_actual_kbit_per_second = 0.0f;
     float bandwidth_suggested_kbit_per_second = 0.0f;
+    float packets_per_send_call = 0.0f;
+    float segments_per_gso_send = 0.0f;
+    // Of the history for re-sending NACKed packets: its size in packets, packets which were overwritten
+    // while still inside its time window, NACKed packets which were no longer there, and NACKed packets
+    // which were re-sent as already protected
+    size_t nack_history_capacity = 0;
+    size_t nack_history_evicted_count = 0;
+    size_t nack_history_miss_count = 0;
+    size_t nack_history_protected_count = 0;
 };
 
 struct SubscribeConnectionStats
@@ -75,6 +109,7 @@ struct SubscribeConnectionStats
     size_t byte_count = 0;
     float packets_lost_percent = 0.0f;
     float rtt_ms = 0.0f;
+    float packets_per_send_call = 0.0f;
 };
 
 #if defined(__clang__) || defined(__GNUC__)
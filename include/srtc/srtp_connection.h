@@ -9,13 +9,17 @@
 #include <memory>
 #include <unordered_map>
 #include <optional>
+#include <vector>
 
 struct ssl_st;
 
 namespace srtc
 {
 
+class ByteGather;
 class SrtpCrypto;
+struct SrtpProtectItem;
+struct SrtpUnprotectItem;
 
 class SrtpConnection
 {
@@ -35,12 +39,31 @@ public:
 	// Returns false on error
 	bool protectSendMedia(const ByteBuffer& packetData, uint32_t rollover, ByteBuffer& output);
 
+	// Returns false on error, the packet is as from RtpPacket::generate(header, body)
+	bool protectSendMedia(const ByteBuffer& header, const ByteGather& body, uint32_t rollover, ByteBuffer& output);
+
+	// Returns false on error, the output has room for the packet and getMediaProtectionOverhead()
+	bool protectSendMedia(const ByteBuffer& header,
+						  const ByteGather& body,
+						  uint32_t rollover,
+						  uint8_t* output,
+						  size_t& outputSize);
+
+	// Several packets at once, each as above, returns how many were protected
+	size_t protectSendMedia(SrtpProtectItem* itemList, size_t itemCount);
+
 	// Returns false on error
 	bool unprotectReceiveControl(const ByteBuffer& packetData, ByteBuffer& output);
 
 	// Returns false on error
 	bool unprotectReceiveMedia(const ByteBuffer& packetData, ByteBuffer& output);
 
+	// Returns false on error, the packet is decrypted in place
+	bool unprotectReceiveMedia(ByteBuffer& packetData);
+
+	// Several packets at once, each decrypted in place, or cleared on error. Returns how many were unprotected.
+	size_t unprotectReceiveMedia(ByteBuffer* const* packetList, size_t packetCount);
+
 	// Implementation
 	SrtpConnection(const std::shared_ptr<SrtpCrypto>& crypto, unsigned long profileId);
 
@@ -84,6 +107,27 @@ private:
 
 	bool getControlSequenceNumber(const ByteBuffer& packet, uint32_t& outSequenceNumber) const;
 	bool getMediaSequenceNumber(const ByteBuffer& packet, uint16_t& outSequenceNumber) const;
+
+	// The output has room for the packet, and can be where the packet is
+	bool unprotectReceiveMediaImpl(const ByteBuffer& packetData, uint8_t* output, size_t& outputSize);
+
+	// Before decrypting: replay protection and the rollover count
+	bool prepareUnprotectMedia(const ByteBuffer& packetData,
+							   ChannelValue*& channelValue,
+							   uint16_t& sequenceNumber,
+							   uint32_t& rolloverCount);
+	// After decrypting
+	bool finishUnprotectMedia(ChannelValue& channelValue, uint16_t sequenceNumber, size_t outputSize);
+
+	// Reused for batches
+	struct UnprotectState {
+		ChannelValue* channelValue;
+		uint16_t sequenceNumber;
+		size_t packetIndex;
+	};
+
+	std::vector<SrtpUnprotectItem> mUnprotectItemList;
+	std::vector<UnprotectState> mUnprotectStateList;
 };
 
 } // namespace srtc
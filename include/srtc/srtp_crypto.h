@@ -12,8 +12,32 @@ namespace srtc
 {
 
 class ByteBuffer;
+class ByteGather;
 class HmacSha1;
 
+// For protecting several packets in one call
+struct SrtpProtectItem {
+    // The packet is as from RtpPacket::generate(header, body)
+    const ByteBuffer* header;
+    const ByteGather* body;
+    uint32_t rolloverCount;
+    // Room for the packet and the protection overhead
+    uint8_t* encrypted;
+    // Set on return, zero if there was an error
+    size_t encryptedSize;
+};
+
+// For unprotecting several packets in one call
+struct SrtpUnprotectItem {
+    const uint8_t* packet;
+    size_t packetSize;
+    uint32_t rolloverCount;
+    // Room for the packet, can be where the packet is
+    uint8_t* plain;
+    // Set on return, zero if there was an error
+    size_t plainSize;
+};
+
 class SrtpCrypto
 {
 public:
@@ -28,7 +52,29 @@ public:
     [[nodiscard]] size_t getMediaProtectionOverhead() const;
 
     [[nodiscard]] bool protectSendMedia(const ByteBuffer& packet, uint32_t rolloverCount, ByteBuffer& encrypted);
+    // The header (with the extension) and the payload are in different places
+    [[nodiscard]] bool protectSendMedia(const ByteBuffer& header,
+                                        const ByteGather& body,
+                                        uint32_t rolloverCount,
+                                        ByteBuffer& encrypted);
+    // Into memory which has room for the packet and the protection overhead (the tag), e.g. a socket's
+    // send queue. It can also be where the header and the body already are, one after the other, then the
+    // packet is encrypted in place. The encrypted size is returned in encryptedSize.
+    [[nodiscard]] bool protectSendMedia(const ByteBuffer& header,
+                                        const ByteGather& body,
+                                        uint32_t rolloverCount,
+                                        uint8_t* encrypted,
+                                        size_t& encryptedSize);
 	[[nodiscard]] bool unprotectReceiveMedia(const ByteBuffer& packet, uint32_t rolloverCount, ByteBuffer& plain);
+    // Into memory which has room for the packet, which can be where the packet is, then it's decrypted in
+    // place. The decrypted size is returned in plainSize.
+    [[nodiscard]] bool unprotectReceiveMedia(
+        const uint8_t* packet, size_t packetSize, uint32_t rolloverCount, uint8_t* plain, size_t& plainSize);
+
+    // Several packets back to back with the same keyed context, returns how many were protected
+    size_t protectSendMedia(SrtpProtectItem* itemList, size_t itemCount);
+    // Several packets back to back with the same keyed context, returns how many were unprotected
+    size_t unprotectReceiveMedia(SrtpUnprotectItem* itemList, size_t itemCount);
 
     [[nodiscard]] bool protectSendControl(const ByteBuffer& packet, uint32_t seq, ByteBuffer& encrypted);
     [[nodiscard]] bool unprotectReceiveControl(const ByteBuffer& packet, ByteBuffer& plain);
@@ -53,11 +99,35 @@ public:
                const CryptoVectors& receiveRtcp);
 
 private:
-    [[nodiscard]] bool protectSendMediaGCM(const ByteBuffer& packet, uint32_t rolloverCount, ByteBuffer& encrypted);
-    [[nodiscard]] bool protectSendMediaCM(const ByteBuffer& packet, uint32_t rolloverCount, ByteBuffer& encrypted);
-
-	[[nodiscard]] bool unprotectReceiveMediaGCM(const ByteBuffer& packet, uint32_t rolloverCount, ByteBuffer& plain);
-	[[nodiscard]] bool unprotectReceiveMediaCM(const ByteBuffer& packet, uint32_t rolloverCount, ByteBuffer& plain);
+    [[nodiscard]] bool protectSendMediaImpl(const uint8_t* headerData,
+                                            size_t headerSize,
+                                            const ByteGather& body,
+                                            uint32_t rolloverCount,
+                                            uint8_t* encrypted,
+                                            size_t& encryptedSize);
+    [[nodiscard]] bool protectSendMediaGCM(const uint8_t* headerData,
+                                           size_t headerSize,
+                                           const ByteGather& body,
+                                           uint32_t rolloverCount,
+                                           uint8_t* encrypted,
+                                           size_t& encryptedSize);
+    [[nodiscard]] bool protectSendMediaCM(const uint8_t* headerData,
+                                          size_t headerSize,
+                                          const ByteGather& body,
+                                          uint32_t rolloverCount,
+                                          uint8_t* encrypted,
+                                          size_t& encryptedSize);
+
+    [[nodiscard]] bool unprotectReceiveMediaGCM(const uint8_t* encryptedData,
+                                                size_t encryptedSize,
+                                                uint32_t rolloverCount,
+                                                uint8_t* plainData,
+                                                size_t& plainSize);
+    [[nodiscard]] bool unprotectReceiveMediaCM(const uint8_t* encryptedData,
+                                               size_t encryptedSize,
+                                               uint32_t rolloverCount,
+                                               uint8_t* plainData,
+                                               size_t& plainSize);
 
     [[nodiscard]] bool protectSendControlGCM(const ByteBuffer& packet, uint32_t seq, ByteBuffer& encrypted);
     [[nodiscard]] bool protectSendControlCM(const ByteBuffer& packet, uint32_t seq, ByteBuffer& encrypted);
@@ -66,6 +136,8 @@ private:
     [[nodiscard]] bool unprotectReceiveControlCM(const ByteBuffer& packet, ByteBuffer& plain);
 
     [[nodiscard]] const struct evp_cipher_st* createCipher() const;
+    [[nodiscard]] struct evp_cipher_ctx_st* createCipherCtx(const CryptoBytes& key, bool encrypt) const;
+    [[nodiscard]] std::shared_ptr<HmacSha1> createHmac(const CryptoBytes& auth) const;
 
     const uint64_t mProfileId;
 	const CryptoVectors mSendRtp;
@@ -73,10 +145,17 @@ private:
     const CryptoVectors mSendRtcp;
     const CryptoVectors mReceiveRtcp;
 
-    struct evp_cipher_ctx_st* mSendCipherCtx;
-    struct evp_cipher_ctx_st* mReceiveCipherCtx;
-
-    std::shared_ptr<HmacSha1> mHmacSha1;
+    // Keyed once, only the IV changes per packet
+    struct evp_cipher_ctx_st* mSendRtpCipherCtx;
+    struct evp_cipher_ctx_st* mReceiveRtpCipherCtx;
+    struct evp_cipher_ctx_st* mSendRtcpCipherCtx;
+    struct evp_cipher_ctx_st* mReceiveRtcpCipherCtx;
+
+    // Keyed once for the CM profiles, each packet starts from the keyed state
+    std::shared_ptr<HmacSha1> mSendRtpHmac;
+    std::shared_ptr<HmacSha1> mReceiveRtpHmac;
+    std::shared_ptr<HmacSha1> mSendRtcpHmac;
+    std::shared_ptr<HmacSha1> mReceiveRtcpHmac;
 };
 
 } // namespace srtc
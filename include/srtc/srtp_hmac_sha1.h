@@ -15,6 +15,9 @@ public:
     ~HmacSha1();
 
     [[nodiscard]] bool reset(const uint8_t* key, size_t keySize);
+    // Starts over with the key from before, without hashing it again: the keyed inner and outer digest
+    // states are kept by OpenSSL and copied
+    [[nodiscard]] bool reset();
     void update(const uint8_t* data, size_t size);
     void final(uint8_t* out);
 
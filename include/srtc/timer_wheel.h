@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace srtc
+{
+
+class TimerList;
+class TimerWheel;
+
+// An intrusive list node, so linking and unlinking never allocate. A node can be in one list at a time.
+
+class TimerNode
+{
+public:
+    TimerNode();
+    ~TimerNode();
+
+    TimerNode(const TimerNode&) = delete;
+    TimerNode& operator=(const TimerNode&) = delete;
+
+    [[nodiscard]] bool isLinked() const;
+    void unlink();
+
+private:
+    friend class TimerList;
+    friend class TimerWheel;
+
+    TimerNode* mPrev;
+    TimerNode* mNext;
+    TimerList* mList;
+
+    uint64_t mExpires;
+};
+
+// A doubly linked list of nodes with a sentinel head
+
+class TimerList
+{
+public:
+    TimerList();
+    ~TimerList();
+
+    TimerList(const TimerList&) = delete;
+    TimerList& operator=(const TimerList&) = delete;
+
+    [[nodiscard]] bool isEmpty() const;
+    [[nodiscard]] size_t size() const;
+
+    void pushBack(TimerNode* node);
+    TimerNode* popFront();
+
+    // Moves all nodes from the other list to the end of this one
+    void splice(TimerList& other);
+
+    // Iteration, the current node may be unlinked while iterating
+    [[nodiscard]] TimerNode* first() const;
+    [[nodiscard]] TimerNode* next(const TimerNode* node) const;
+
+private:
+    friend class TimerNode;
+
+    void remove(TimerNode* node);
+
+    TimerNode mHead;
+    size_t mSize;
+};
+
+// A hierarchical timing wheel: 4 levels of 64 slots each, the first level has a slot per tick and each
+// next level has a slot per full turn of the previous one. Inserting and removing timers is O(1), and a
+// timer is moved to a lower level at most once per level as the time comes closer.
+//
+// Time is in ticks, which are defined by the caller. Timers further than kMaxTicks away are clamped.
+
+class TimerWheel
+{
+public:
+    static constexpr unsigned int kLevelBits = 6;
+    static constexpr unsigned int kLevelCount = 4;
+    static constexpr uint64_t kSlotCount = 1u << kLevelBits;
+    static constexpr uint64_t kMaxTicks = (uint64_t{ 1 } << (kLevelBits * kLevelCount)) - 1;
+
+    explicit TimerWheel(uint64_t now);
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    [[nodiscard]] bool isEmpty() const;
+    [[nodiscard]] size_t size() const;
+
+    // The first tick which has not been processed yet
+    [[nodiscard]] uint64_t getCurrent() const;
+
+    // Timers expiring before getCurrent() are placed to expire at getCurrent(). Use TimerNode::unlink to remove.
+    void insert(TimerNode* node, uint64_t expires);
+
+    // Moves timers which expire at or before now to the expired list, in order of expiration
+    void advance(uint64_t now, TimerList& expired);
+
+    // The earliest tick at which a timer can expire, or UINT64_MAX if there are none. This can be earlier
+    // than the actual expiration when timers are still on higher levels, which is fine for sleeping.
+    [[nodiscard]] uint64_t getNextExpiration() const;
+
+    // Moves all timers to the list, for cleanup
+    void takeAll(TimerList& list);
+
+private:
+    void cascade(unsigned int level);
+
+    uint64_t mCurrent;
+    TimerList mSlotList[kLevelCount][kSlotCount];
+
+    // A bit per non-empty slot, unlinking a node does not clear it so it's cleared lazily
+    mutable uint64_t mOccupied[kLevelCount];
+};
+
+} // namespace srtc
@@ -50,7 +50,7 @@ public:
     ~PublishPacketHistory();
 
     void saveOutgoingPacket(uint16_t seq,
-                            const std::shared_ptr<Track>& track,
+                            const Track& track,
                             size_t paddingSize,
                             size_t payloadSize,
                             size_t generatedSize,
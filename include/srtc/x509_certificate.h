@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <string>
 
 struct evp_pkey_st;
@@ -16,6 +17,7 @@ class X509Certificate
 {
 public:
     X509Certificate();
+    explicit X509Certificate(std::chrono::seconds lifetime);
     ~X509Certificate();
 
     [[nodiscard]] struct evp_pkey_st* getPrivateKey() const;
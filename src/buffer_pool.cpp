@@ -0,0 +1,141 @@
+#include "srtc/buffer_pool.h"
+
+#include <vector>
+
+namespace
+{
+
+// Small buffers (RTCP, extensions, STUN), a datagram, and two sizes for coalesced sends and receives
+constexpr size_t kClassSize[srtc::BufferPool::kClassCount] = {
+    256, 2048, 16 * 1024, srtc::BufferPool::kMaxClassSize
+};
+
+// How many free blocks a thread keeps, about 1.6 MB at most
+constexpr size_t kClassMaxFree[srtc::BufferPool::kClassCount] = { 256, 256, 32, 8 };
+
+size_t findClass(size_t size)
+{
+    for (size_t i = 0; i < srtc::BufferPool::kClassCount; i += 1) {
+        if (size <= kClassSize[i]) {
+            return i;
+        }
+    }
+    return srtc::BufferPool::kClassCount;
+}
+
+struct Pool {
+    std::vector<uint8_t*> freeList[srtc::BufferPool::kClassCount];
+    srtc::BufferPool::Stats stats = {};
+
+    Pool()
+    {
+        for (size_t i = 0; i < srtc::BufferPool::kClassCount; i += 1) {
+            freeList[i].reserve(kClassMaxFree[i]);
+        }
+    }
+
+    ~Pool()
+    {
+        for (auto& list : freeList) {
+            for (const auto ptr : list) {
+                delete[] ptr;
+            }
+        }
+    }
+};
+
+// Buffers can be freed by thread local destructors which run after the pool's, then the pool is gone
+thread_local Pool* tPool = nullptr;
+thread_local bool tIsPoolDestroyed = false;
+
+struct PoolHolder {
+    ~PoolHolder()
+    {
+        delete tPool;
+        tPool = nullptr;
+        tIsPoolDestroyed = true;
+    }
+};
+
+thread_local PoolHolder tPoolHolder;
+
+Pool* getPool()
+{
+    if (tPool == nullptr && !tIsPoolDestroyed) {
+        // Make sure the holder is constructed, so its destructor runs at thread exit
+        (void)&tPoolHolder;
+        tPool = new Pool;
+    }
+    return tPool;
+}
+
+} // namespace
+
+namespace srtc
+{
+
+uint8_t* BufferPool::allocate(size_t& size)
+{
+    const auto index = findClass(size);
+    if (index == kClassCount) {
+        if (const auto pool = getPool()) {
+            pool->stats.miss_count += 1;
+        }
+        return new uint8_t[size];
+    }
+
+    size = kClassSize[index];
+
+    if (const auto pool = getPool()) {
+        auto& list = pool->freeList[index];
+        if (!list.empty()) {
+            const auto ptr = list.back();
+            list.pop_back();
+
+            pool->stats.hit_count += 1;
+            pool->stats.cached_bytes -= size;
+            return ptr;
+        }
+
+        pool->stats.miss_count += 1;
+    }
+
+    return new uint8_t[size];
+}
+
+void BufferPool::release(uint8_t* ptr, size_t size)
+{
+    if (ptr == nullptr) {
+        return;
+    }
+
+    const auto index = findClass(size);
+    if (index < kClassCount) {
+        if (const auto pool = getPool()) {
+            auto& list = pool->freeList[index];
+            if (list.size() < kClassMaxFree[index]) {
+                list.push_back(ptr);
+                pool->stats.cached_bytes += kClassSize[index];
+                return;
+            }
+        }
+    }
+
+    delete[] ptr;
+}
+
+size_t BufferPool::getBlockSize(size_t size)
+{
+    const auto index = findClass(size);
+    return index == kClassCount ? size : kClassSize[index];
+}
+
+BufferPool::Stats BufferPool::getStats()
+{
+    if (const auto pool = getPool()) {
+        return pool->stats;
+    }
+    return {};
+}
+
+} // namespace srtc
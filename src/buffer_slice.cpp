@@ -0,0 +1,114 @@
+#include "srtc/buffer_slice.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace srtc
+{
+
+// ----- BufferSlice
+
+BufferSlice::BufferSlice()
+    : mData(nullptr)
+    , mSize(0)
+{
+}
+
+BufferSlice::BufferSlice(const SharedBuffer& buf, const uint8_t* data, size_t size)
+    : mBuf(buf)
+    , mData(data)
+    , mSize(size)
+{
+    assert(buf);
+    assert(data >= buf->data() && data + size <= buf->data() + buf->size());
+}
+
+bool BufferSlice::empty() const
+{
+    return mSize == 0;
+}
+
+const uint8_t* BufferSlice::data() const
+{
+    return mData;
+}
+
+size_t BufferSlice::size() const
+{
+    return mSize;
+}
+
+// ----- ByteGather
+
+ByteGather::ByteGather()
+    : mData()
+    , mSize()
+    , mCount(0)
+    , mTotalSize(0)
+    , mCopy()
+    , mCopySize(0)
+{
+}
+
+void ByteGather::clear()
+{
+    mCount = 0;
+    mTotalSize = 0;
+    mCopySize = 0;
+}
+
+void ByteGather::add(const uint8_t* data, size_t size)
+{
+    if (size == 0) {
+        return;
+    }
+
+    assert(mCount < kMaxCount);
+    mData[mCount] = data;
+    mSize[mCount] = size;
+    mCount += 1;
+    mTotalSize += size;
+}
+
+void ByteGather::addCopy(const uint8_t* data, size_t size)
+{
+    assert(mCopySize + size <= kMaxCopySize);
+
+    const auto copy = mCopy + mCopySize;
+    std::memcpy(copy, data, size);
+    mCopySize += size;
+
+    add(copy, size);
+}
+
+size_t ByteGather::count() const
+{
+    return mCount;
+}
+
+const uint8_t* ByteGather::data(size_t index) const
+{
+    assert(index < mCount);
+    return mData[index];
+}
+
+size_t ByteGather::size(size_t index) const
+{
+    assert(index < mCount);
+    return mSize[index];
+}
+
+size_t ByteGather::totalSize() const
+{
+    return mTotalSize;
+}
+
+void ByteGather::appendTo(ByteBuffer& buf) const
+{
+    buf.reserve(buf.size() + mTotalSize);
+    for (size_t i = 0; i < mCount; i += 1) {
+        buf.append(mData[i], mSize[i]);
+    }
+}
+
+} // namespace srtc
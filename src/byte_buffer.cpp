@@ -1,4 +1,5 @@
 #include "srtc/byte_buffer.h"
+#include "srtc/buffer_pool.h"
 
 #include <algorithm>
 #include <cassert>
@@ -23,6 +24,17 @@ void check_read(const char* file, int line, const char* func, size_t r, size_t p
     }
 }
 
+uint8_t* allocate(size_t size)
+{
+    if (size == 0) {
+        return nullptr;
+    }
+
+    // Keep the requested capacity, code which receives into a buffer uses it as the maximum size
+    auto blockSize = size;
+    return srtc::BufferPool::allocate(blockSize);
+}
+
 } // namespace
 
 namespace srtc
@@ -38,14 +50,14 @@ ByteBuffer::ByteBuffer()
 }
 
 ByteBuffer::ByteBuffer(size_t size)
-    : mBuf(size == 0 ? nullptr : new uint8_t[size])
+    : mBuf(allocate(size))
     , mLen(0)
     , mCap(size)
 {
 }
 
 ByteBuffer::ByteBuffer(const uint8_t* src, size_t size)
-    : mBuf(size == 0 ? nullptr : new uint8_t[size])
+    : mBuf(allocate(size))
     , mLen(size)
     , mCap(size)
 {
@@ -56,7 +68,7 @@ ByteBuffer::ByteBuffer(const uint8_t* src, size_t size)
 
 ByteBuffer::~ByteBuffer()
 {
-    delete[] mBuf;
+    BufferPool::release(mBuf, mCap);
     mBuf = nullptr;
 }
 
@@ -73,7 +85,7 @@ ByteBuffer::ByteBuffer(ByteBuffer&& other) noexcept
 ByteBuffer& ByteBuffer::operator=(ByteBuffer&& other) noexcept
 {
     if (this != &other) {
-        delete[] mBuf;
+        BufferPool::release(mBuf, mCap);
 
         mBuf = other.mBuf;
         mLen = other.mLen;
@@ -99,7 +111,7 @@ void ByteBuffer::clear()
 
 void ByteBuffer::free()
 {
-    delete[] mBuf;
+    BufferPool::release(mBuf, mCap);
     mBuf = nullptr;
     mLen = 0;
     mCap = 0;
@@ -107,15 +119,15 @@ void ByteBuffer::free()
 
 void ByteBuffer::assign(const uint8_t* src, size_t size)
 {
-    delete[] mBuf;
+    if (size > mCap) {
+        BufferPool::release(mBuf, mCap);
+        mBuf = allocate(size);
+        mCap = size;
+    }
     if (size > 0) {
-        mBuf = new uint8_t[size];
         std::memcpy(mBuf, src, size);
-    } else {
-        mBuf = nullptr;
     }
     mLen = size;
-    mCap = size;
 }
 
 void ByteBuffer::resize(size_t size)
@@ -199,14 +211,21 @@ bool ByteBuffer::operator==(const ByteBuffer& other) const
 void ByteBuffer::ensureCapacity(size_t capacity)
 {
     if (capacity > mCap) {
-        const auto newCap = std::max(capacity + 128, mCap * 3 / 2);
-        const auto newBuf = new uint8_t[newCap];
+        // The block from the pool can be larger than what was asked for
+        if (const auto blockSize = BufferPool::getBlockSize(mCap); mBuf && capacity <= blockSize) {
+            mCap = blockSize;
+            return;
+        }
+
+        // The pool rounds up to its size class, so growing can use all of it
+        auto newCap = std::max(capacity + 128, mCap * 3 / 2);
+        const auto newBuf = BufferPool::allocate(newCap);
 
         if (mBuf && mLen > 0) {
             std::memcpy(newBuf, mBuf, mLen);
         }
 
-        delete[] mBuf;
+        BufferPool::release(mBuf, mCap);
         mBuf = newBuf;
         mCap = newCap;
     }
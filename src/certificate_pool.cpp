@@ -0,0 +1,245 @@
+#include "srtc/certificate_pool.h"
+#include "srtc/logging.h"
+#include "srtc/srtp_connection.h"
+#include "srtc/x509_certificate.h"
+
+#include <openssl/ssl.h>
+
+#include <mutex>
+#include <vector>
+
+#define LOG(level, ...) srtc::log(level, "CertificatePool", __VA_ARGS__)
+
+namespace
+{
+
+int verify_callback([[maybe_unused]] int ok, [[maybe_unused]] X509_STORE_CTX* store_ctx)
+{
+    // We verify cert has ourselves after the handshake has completed
+    return 1;
+}
+
+SSL_CTX* createDtlsContext(const srtc::X509Certificate& cert, bool isServer)
+{
+    const auto ctx = SSL_CTX_new(isServer ? DTLS_server_method() : DTLS_client_method());
+    if (ctx == nullptr) {
+        return nullptr;
+    }
+
+    SSL_CTX_use_certificate(ctx, cert.getCertificate());
+    SSL_CTX_use_PrivateKey(ctx, cert.getPrivateKey());
+
+    if (!SSL_CTX_check_private_key(ctx)) {
+        LOG(SRTC_LOG_E, "Invalid private key");
+        SSL_CTX_free(ctx);
+        return nullptr;
+    }
+
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, verify_callback);
+
+    SSL_CTX_set_min_proto_version(ctx, DTLS1_VERSION);
+    SSL_CTX_set_max_proto_version(ctx, DTLS1_2_VERSION);
+    SSL_CTX_set_read_ahead(ctx, 1);
+
+    // Returns 0 on success
+    if (SSL_CTX_set_tlsext_use_srtp(ctx, srtc::SrtpConnection::kSrtpCipherList) != 0) {
+        LOG(SRTC_LOG_E, "Cannot set the SRTP profiles");
+        SSL_CTX_free(ctx);
+        return nullptr;
+    }
+
+    return ctx;
+}
+
+uint64_t elapsedMicros(std::chrono::steady_clock::time_point start)
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+// Contexts for a certificate, kept while any offer or connection holds the certificate
+struct ContextEntry {
+    std::weak_ptr<srtc::X509Certificate> cert;
+    const srtc::X509Certificate* ptr = nullptr;
+    SSL_CTX* server = nullptr;
+    SSL_CTX* client = nullptr;
+};
+
+struct Pool {
+    std::mutex mutex;
+    srtc::CertificatePool::Config config;
+
+    std::shared_ptr<srtc::X509Certificate> current;
+    std::chrono::steady_clock::time_point currentCreated;
+
+    std::vector<ContextEntry> contextList;
+
+    uint64_t certCreatedCount = 0;
+    uint64_t certReusedCount = 0;
+    uint64_t certCreatedMicros = 0;
+    uint64_t ctxCreatedCount = 0;
+    uint64_t ctxReusedCount = 0;
+    uint64_t ctxCreatedMicros = 0;
+
+    ~Pool()
+    {
+        for (const auto& entry : contextList) {
+            SSL_CTX_free(entry.server);
+            SSL_CTX_free(entry.client);
+        }
+    }
+
+    // Under the lock
+    void pruneContexts()
+    {
+        for (auto iter = contextList.begin(); iter != contextList.end();) {
+            if (iter->cert.expired()) {
+                // Connections still using a context have their own reference
+                SSL_CTX_free(iter->server);
+                SSL_CTX_free(iter->client);
+                iter = contextList.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    }
+};
+
+Pool& getPool()
+{
+    static Pool pool;
+    return pool;
+}
+
+} // namespace
+
+namespace srtc
+{
+
+void CertificatePool::setConfig(const Config& config)
+{
+    auto& pool = getPool();
+    std::lock_guard lock(pool.mutex);
+
+    pool.config = config;
+    if (pool.config.lifetime < pool.config.rotation_interval) {
+        pool.config.lifetime = pool.config.rotation_interval;
+    }
+}
+
+CertificatePool::Config CertificatePool::getConfig()
+{
+    auto& pool = getPool();
+    std::lock_guard lock(pool.mutex);
+
+    return pool.config;
+}
+
+std::shared_ptr<X509Certificate> CertificatePool::getCertificate()
+{
+    auto& pool = getPool();
+    std::unique_lock lock(pool.mutex);
+
+    const auto now = std::chrono::steady_clock::now();
+
+    if (pool.config.rotation_interval.count() == 0) {
+        // Not shared, so connections on other threads don't wait for us to create it
+        pool.current.reset();
+        const auto lifetime = pool.config.lifetime;
+        lock.unlock();
+
+        auto cert = std::make_shared<X509Certificate>(lifetime);
+        const auto micros = elapsedMicros(now);
+
+        lock.lock();
+        pool.certCreatedCount += 1;
+        pool.certCreatedMicros += micros;
+        return cert;
+    }
+
+    if (pool.current && now - pool.currentCreated < pool.config.rotation_interval) {
+        pool.certReusedCount += 1;
+        return pool.current;
+    }
+
+    // Creating under the lock means that a burst of new connections doesn't generate a burst of certificates
+    auto cert = std::make_shared<X509Certificate>(pool.config.lifetime);
+    pool.certCreatedCount += 1;
+    pool.certCreatedMicros += elapsedMicros(now);
+
+    LOG(SRTC_LOG_V, "Created a certificate, fingerprint %s", cert->getSha256FingerprintHex().c_str());
+    pool.current = cert;
+    pool.currentCreated = now;
+
+    return cert;
+}
+
+struct ssl_ctx_st* CertificatePool::getDtlsContext(const std::shared_ptr<X509Certificate>& cert, bool isServer)
+{
+    auto& pool = getPool();
+    std::lock_guard lock(pool.mutex);
+
+    pool.pruneContexts();
+
+    ContextEntry* entry = nullptr;
+    for (auto& item : pool.contextList) {
+        if (item.ptr == cert.get()) {
+            entry = &item;
+            break;
+        }
+    }
+    if (entry == nullptr) {
+        entry = &pool.contextList.emplace_back();
+        entry->cert = cert;
+        entry->ptr = cert.get();
+    }
+
+    auto& ctx = isServer ? entry->server : entry->client;
+    if (ctx) {
+        pool.ctxReusedCount += 1;
+    } else {
+        const auto start = std::chrono::steady_clock::now();
+        ctx = createDtlsContext(*cert, isServer);
+        if (ctx == nullptr) {
+            return nullptr;
+        }
+        pool.ctxCreatedCount += 1;
+        pool.ctxCreatedMicros += elapsedMicros(start);
+    }
+
+    SSL_CTX_up_ref(ctx);
+    return ctx;
+}
+
+void CertificatePool::clear()
+{
+    auto& pool = getPool();
+    std::lock_guard lock(pool.mutex);
+
+    pool.current.reset();
+    pool.pruneContexts();
+}
+
+CertificatePool::Stats CertificatePool::getStats()
+{
+    auto& pool = getPool();
+    std::lock_guard lock(pool.mutex);
+
+    Stats stats = {};
+    stats.cert_created_count = pool.certCreatedCount;
+    stats.cert_reused_count = pool.certReusedCount;
+    stats.dtls_ctx_created_count = pool.ctxCreatedCount;
+    stats.dtls_ctx_reused_count = pool.ctxReusedCount;
+    stats.setup_spent_micros = pool.certCreatedMicros + pool.ctxCreatedMicros;
+
+    if (pool.certCreatedCount > 0) {
+        stats.setup_saved_micros += pool.certReusedCount * pool.certCreatedMicros / pool.certCreatedCount;
+    }
+    if (pool.ctxCreatedCount > 0) {
+        stats.setup_saved_micros += pool.ctxReusedCount * pool.ctxCreatedMicros / pool.ctxCreatedCount;
+    }
+
+    return stats;
+}
+
+} // namespace srtc
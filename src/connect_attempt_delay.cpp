@@ -0,0 +1,50 @@
+#include "srtc/connect_attempt_delay.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <sys/socket.h>
+#endif
+
+namespace
+{
+
+size_t getFamilyIndex(const srtc::Host& host)
+{
+    return host.addr.ss.ss_family == AF_INET6 ? 1 : 0;
+}
+
+} // namespace
+
+namespace srtc
+{
+
+ConnectAttemptDelay::ConnectAttemptDelay()
+    : mRttMs{ -1.0f, -1.0f }
+{
+}
+
+std::chrono::milliseconds ConnectAttemptDelay::get(const Host& host) const
+{
+    const auto rttMs = mRttMs[getFamilyIndex(host)].load();
+    if (rttMs < 0.0f) {
+        return kDefault;
+    }
+
+    const auto delay = std::chrono::milliseconds(static_cast<int64_t>(2.0f * rttMs));
+    return std::clamp(delay, std::chrono::milliseconds(kMin), std::chrono::milliseconds(kMax));
+}
+
+void ConnectAttemptDelay::update(const Host& host, float rttMs)
+{
+    auto& value = mRttMs[getFamilyIndex(host)];
+
+    // Connections on other threads can update it at the same time
+    auto prev = value.load();
+    while (!value.compare_exchange_weak(prev, prev < 0.0f ? rttMs : prev * 0.875f + rttMs * 0.125f)) {
+    }
+}
+
+} // namespace srtc
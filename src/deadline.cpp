@@ -0,0 +1,38 @@
+#include "srtc/deadline.h"
+
+namespace srtc
+{
+
+Deadline::Deadline(const Clock::time_point& now, const std::chrono::microseconds& maxWait)
+    : mNow(now)
+    , mWhen(now + maxWait)
+{
+}
+
+const Deadline::Clock::time_point& Deadline::getNow() const
+{
+    return mNow;
+}
+
+void Deadline::update(const Clock::time_point& when)
+{
+    if (mWhen > when) {
+        mWhen = when;
+    }
+}
+
+const Deadline::Clock::time_point& Deadline::getWhen() const
+{
+    return mWhen;
+}
+
+std::chrono::microseconds Deadline::getTimeout() const
+{
+    const auto timeout = std::chrono::ceil<std::chrono::microseconds>(mWhen - Clock::now());
+    if (timeout <= std::chrono::microseconds::zero()) {
+        return std::chrono::microseconds::zero();
+    }
+    return timeout;
+}
+
+} // namespace srtc
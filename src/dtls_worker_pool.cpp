@@ -0,0 +1,175 @@
+#include "srtc/dtls_worker_pool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct Pool {
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<std::function<void()>> jobList;
+    std::vector<std::thread> threadList;
+    bool isQuit = false;
+
+    std::atomic<uint64_t> workerStepCount = { 0 };
+    std::atomic<uint64_t> workerStepMicros = { 0 };
+    std::atomic<uint64_t> inlineStepCount = { 0 };
+    std::atomic<uint64_t> inlineStepMicros = { 0 };
+    std::atomic<uint64_t> latencyHistogram[srtc::DtlsWorkerPool::kLatencyBucketCount] = {};
+
+    ~Pool()
+    {
+        stop();
+    }
+
+    void start(size_t count)
+    {
+        for (size_t i = 0; i < count; i += 1) {
+            threadList.emplace_back([this] { workerFunc(); });
+        }
+    }
+
+    void stop()
+    {
+        std::vector<std::thread> waitForList;
+
+        {
+            std::lock_guard lock(mutex);
+            isQuit = true;
+            waitForList.swap(threadList);
+        }
+        cond.notify_all();
+
+        for (auto& thread : waitForList) {
+            thread.join();
+        }
+
+        std::lock_guard lock(mutex);
+        isQuit = false;
+    }
+
+    void workerFunc()
+    {
+        while (true) {
+            std::function<void()> job;
+
+            {
+                std::unique_lock lock(mutex);
+                cond.wait(lock, [this] { return isQuit || !jobList.empty(); });
+
+                // Finish the posted jobs even when quitting, their candidates are waiting for them
+                if (jobList.empty()) {
+                    return;
+                }
+
+                job = std::move(jobList.front());
+                jobList.pop_front();
+            }
+
+            job();
+        }
+    }
+};
+
+Pool& getPool()
+{
+    static Pool pool;
+    return pool;
+}
+
+} // namespace
+
+namespace srtc
+{
+
+void DtlsWorkerPool::setThreadCount(size_t count)
+{
+    auto& pool = getPool();
+
+    {
+        std::lock_guard lock(pool.mutex);
+        if (pool.threadList.size() == count) {
+            return;
+        }
+    }
+
+    pool.stop();
+
+    std::lock_guard lock(pool.mutex);
+    pool.start(count);
+}
+
+size_t DtlsWorkerPool::getThreadCount()
+{
+    auto& pool = getPool();
+    std::lock_guard lock(pool.mutex);
+
+    return pool.threadList.size();
+}
+
+bool DtlsWorkerPool::post(std::function<void()>&& job)
+{
+    auto& pool = getPool();
+
+    {
+        std::lock_guard lock(pool.mutex);
+        if (pool.threadList.empty()) {
+            return false;
+        }
+        pool.jobList.push_back(std::move(job));
+    }
+
+    pool.cond.notify_one();
+    return true;
+}
+
+void DtlsWorkerPool::addHandshakeTime(std::chrono::microseconds elapsed, bool isOnWorker)
+{
+    auto& pool = getPool();
+    const auto micros = static_cast<uint64_t>(elapsed.count());
+
+    if (isOnWorker) {
+        pool.workerStepCount += 1;
+        pool.workerStepMicros += micros;
+    } else {
+        pool.inlineStepCount += 1;
+        pool.inlineStepMicros += micros;
+    }
+}
+
+void DtlsWorkerPool::addSetupLatency(std::chrono::microseconds latency)
+{
+    auto& pool = getPool();
+    const auto millis = static_cast<uint64_t>(latency.count() / 1000);
+
+    for (size_t i = 0; i < kLatencyBucketCount; i += 1) {
+        if (millis < kLatencyBucketMillis[i] || i == kLatencyBucketCount - 1) {
+            pool.latencyHistogram[i] += 1;
+            break;
+        }
+    }
+}
+
+DtlsWorkerPool::Stats DtlsWorkerPool::getStats()
+{
+    auto& pool = getPool();
+
+    Stats stats = {};
+    stats.worker_step_count = pool.workerStepCount;
+    stats.worker_step_micros = pool.workerStepMicros;
+    stats.inline_step_count = pool.inlineStepCount;
+    stats.inline_step_micros = pool.inlineStepMicros;
+    for (size_t i = 0; i < kLatencyBucketCount; i += 1) {
+        stats.setup_latency_histogram[i] = pool.latencyHistogram[i];
+    }
+
+    return stats;
+}
+
+} // namespace srtc
@@ -0,0 +1,124 @@
+#include "srtc/event_loop.h"
+#include "srtc/shared_socket.h"
+#include "srtc/socket.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+
+namespace
+{
+
+std::atomic<srtc::EventLoop::Backend> gBackend = { srtc::EventLoop::Backend::Default };
+
+} // namespace
+
+namespace srtc
+{
+
+EventLoop::~EventLoop() = default;
+
+void EventLoop::setSharedPort(uint16_t port, bool isReusePort)
+{
+    mSharedSocket = std::make_shared<SharedSocket>(port, isReusePort);
+    mIsSharedSocketRegistered = false;
+}
+
+std::shared_ptr<SharedSocket> EventLoop::getSharedSocket() const
+{
+    return mSharedSocket;
+}
+
+std::shared_ptr<Socket> EventLoop::createSocket(const anyaddr& addr, const std::string& iceUFrag)
+{
+    if (mSharedSocket) {
+        if (auto socket = mSharedSocket->createEndpoint(addr, iceUFrag)) {
+            return socket;
+        }
+    }
+
+    return std::make_shared<Socket>(addr);
+}
+
+void EventLoop::registerSocket(const std::shared_ptr<Socket>& socket, void* udata)
+{
+    if (!socket->isEndpoint()) {
+        registerSocketImpl(socket, udata);
+        return;
+    }
+
+    assert(mSharedSocket);
+
+    if (!mIsSharedSocketRegistered) {
+        // The shared socket's udata is expanded into its endpoints' in wait()
+        for (const auto& kernelSocket : mSharedSocket->getKernelSocketList()) {
+            registerSocketImpl(kernelSocket, mSharedSocket.get());
+        }
+        mIsSharedSocketRegistered = true;
+    }
+
+    mSharedSocket->addEndpoint(socket, udata);
+}
+
+void EventLoop::unregisterSocket(const std::shared_ptr<Socket>& socket)
+{
+    if (socket->isEndpoint()) {
+        mSharedSocket->removeEndpoint(socket);
+    } else {
+        unregisterSocketImpl(socket);
+    }
+}
+
+void EventLoop::wait(std::vector<void*>& udataList, const std::chrono::microseconds& timeout)
+{
+    waitImpl(udataList, timeout);
+
+    if (mIsSharedSocketRegistered) {
+        const auto iter = std::remove(udataList.begin(), udataList.end(), static_cast<void*>(mSharedSocket.get()));
+        if (iter != udataList.end()) {
+            udataList.erase(iter, udataList.end());
+            mSharedSocket->receive(udataList);
+        }
+    }
+}
+
+void EventLoop::setBackend(Backend backend)
+{
+    gBackend.store(backend);
+}
+
+EventLoop::Backend EventLoop::getBackend()
+{
+    return gBackend.load();
+}
+
+bool EventLoop::beginSleep()
+{
+    // Sequentially consistent, so either we see the request, or the requesting thread sees that we're sleeping
+    mIsSleeping.store(true);
+    return !mIsWakeupRequested.load();
+}
+
+void EventLoop::endSleep()
+{
+    mIsSleeping.store(false);
+
+    // Requests made from now on need a new wakeup
+    mIsWakeupRequested.exchange(false);
+}
+
+std::chrono::microseconds EventLoop::clampTimeout(const std::chrono::microseconds& timeout)
+{
+    return std::clamp<std::chrono::microseconds>(timeout, std::chrono::microseconds::zero(), kMaxTimeout);
+}
+
+bool EventLoop::requestWakeup()
+{
+    if (mIsWakeupRequested.exchange(true)) {
+        // There already is a wakeup which hasn't been consumed
+        return false;
+    }
+    return mIsSleeping.load();
+}
+
+} // namespace srtc
@@ -0,0 +1,240 @@
+#include "srtc/event_loop_group.h"
+#include "srtc/deadline.h"
+#include "srtc/event_loop.h"
+#include "srtc/logging.h"
+#include "srtc/peer_connection.h"
+#include "srtc/shared_socket.h"
+
+#include <algorithm>
+#include <cassert>
+
+#define LOG(level, ...) srtc::log(level, "EventLoopGroup", __VA_ARGS__)
+
+namespace
+{
+
+constexpr auto kMaxWait = std::chrono::milliseconds(100);
+
+} // namespace
+
+namespace srtc
+{
+
+EventLoopGroup::Worker::Worker(size_t index, const std::shared_ptr<EventLoop>& eventLoop)
+    : index(index)
+    , eventLoop(eventLoop)
+{
+}
+
+EventLoopGroup::EventLoopGroup(size_t threadCount, const std::optional<uint16_t>& sharedPort)
+{
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (size_t i = 0; i < threadCount; i += 1) {
+        const auto eventLoop = EventLoop::factory();
+        if (sharedPort.has_value()) {
+            // The threads don't share ports, SO_REUSEPORT would balance flows without regard to threads
+            const auto port = sharedPort.value() == 0 ? 0 : static_cast<uint16_t>(sharedPort.value() + i);
+            eventLoop->setSharedPort(port, false);
+        }
+        mWorkerList.push_back(std::make_unique<Worker>(i, eventLoop));
+    }
+    for (const auto& worker : mWorkerList) {
+        worker->thread = std::thread(&EventLoopGroup::workerThreadFunc, this, worker.get());
+    }
+
+    LOG(SRTC_LOG_V, "Started %zu threads", threadCount);
+}
+
+EventLoopGroup::~EventLoopGroup()
+{
+    {
+        std::lock_guard lock(mMutex);
+
+        // Connections keep a reference to their group, so they should all be closed by now
+        assert(mAttachedSet.empty());
+        assert(mReservedMap.empty());
+
+        mIsQuit = true;
+    }
+
+    for (const auto& worker : mWorkerList) {
+        worker->eventLoop->interrupt();
+    }
+    for (const auto& worker : mWorkerList) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+size_t EventLoopGroup::getThreadCount() const
+{
+    return mWorkerList.size();
+}
+
+std::vector<uint16_t> EventLoopGroup::getSharedPortList() const
+{
+    std::vector<uint16_t> list;
+    for (const auto& worker : mWorkerList) {
+        // Set before the threads were started, and does not change
+        if (const auto sharedSocket = worker->eventLoop->getSharedSocket()) {
+            list.push_back(sharedSocket->getPort(AF_INET));
+        }
+    }
+    return list;
+}
+
+std::vector<size_t> EventLoopGroup::getLoad() const
+{
+    std::lock_guard lock(mMutex);
+
+    std::vector<size_t> load;
+    for (const auto& worker : mWorkerList) {
+        load.push_back(worker->load);
+    }
+    return load;
+}
+
+std::shared_ptr<EventLoop> EventLoopGroup::attach(PeerConnection* pc)
+{
+    std::lock_guard lock(mMutex);
+
+    Worker* selected = nullptr;
+    if (const auto iter = mReservedMap.find(pc); iter != mReservedMap.end()) {
+        // Already counted in the load
+        selected = iter->second;
+        mReservedMap.erase(iter);
+    } else {
+        selected = selectWorker();
+        selected->load += 1;
+    }
+
+    assert(selected);
+    assert(mAttachedSet.find(pc) == mAttachedSet.end());
+
+    selected->startList.push_back(pc);
+    mAttachedSet.insert(pc);
+
+    LOG(SRTC_LOG_V, "Connection %p assigned to thread %zu, load %zu", static_cast<void*>(pc), selected->index, selected->load);
+
+    selected->eventLoop->interrupt();
+    return selected->eventLoop;
+}
+
+void EventLoopGroup::detach(PeerConnection* pc)
+{
+    std::unique_lock lock(mMutex);
+
+    // The connection may have already stopped by itself, e.g. if it failed to connect
+    mDetachCond.wait(lock, [this, pc] { return mAttachedSet.find(pc) == mAttachedSet.end(); });
+}
+
+std::shared_ptr<EventLoop> EventLoopGroup::reserve(PeerConnection* pc)
+{
+    std::lock_guard lock(mMutex);
+
+    if (const auto iter = mReservedMap.find(pc); iter != mReservedMap.end()) {
+        return iter->second->eventLoop;
+    }
+
+    const auto selected = selectWorker();
+    selected->load += 1;
+    mReservedMap.emplace(pc, selected);
+
+    LOG(SRTC_LOG_V,
+        "Connection %p reserved on thread %zu, load %zu",
+        static_cast<void*>(pc),
+        selected->index,
+        selected->load);
+
+    return selected->eventLoop;
+}
+
+void EventLoopGroup::unreserve(PeerConnection* pc)
+{
+    std::lock_guard lock(mMutex);
+
+    if (const auto iter = mReservedMap.find(pc); iter != mReservedMap.end()) {
+        iter->second->load -= 1;
+        mReservedMap.erase(iter);
+    }
+}
+
+EventLoopGroup::Worker* EventLoopGroup::selectWorker() const
+{
+    Worker* selected = nullptr;
+    for (const auto& worker : mWorkerList) {
+        if (selected == nullptr || selected->load > worker->load) {
+            selected = worker.get();
+        }
+    }
+    return selected;
+}
+
+void EventLoopGroup::workerThreadFunc(Worker* worker)
+{
+    std::vector<PeerConnection*> startList;
+    std::vector<PeerConnection*> stopList;
+    std::vector<void*> udataList;
+
+    while (true) {
+        {
+            std::lock_guard lock(mMutex);
+            if (mIsQuit) {
+                break;
+            }
+
+            startList = std::move(worker->startList);
+            worker->startList.clear();
+        }
+
+        for (const auto pc : startList) {
+            pc->networkStart();
+            worker->runList.push_back(pc);
+        }
+        startList.clear();
+
+        // Wait for the earliest deadline of all our connections
+        Deadline deadline(std::chrono::steady_clock::now(), kMaxWait);
+        for (const auto pc : worker->runList) {
+            pc->networkUpdateDeadline(deadline);
+        }
+
+        udataList.clear();
+        worker->eventLoop->wait(udataList, deadline.getTimeout());
+
+        // The sockets belong to candidates of the connections on this thread, which are all still running
+        PeerConnection::networkReceive(udataList);
+
+        for (const auto pc : worker->runList) {
+            if (!pc->networkRun()) {
+                stopList.push_back(pc);
+            }
+        }
+
+        if (!stopList.empty()) {
+            for (const auto pc : stopList) {
+                pc->networkStop();
+                worker->runList.erase(std::find(worker->runList.begin(), worker->runList.end(), pc));
+            }
+
+            {
+                std::lock_guard lock(mMutex);
+                for (const auto pc : stopList) {
+                    worker->load -= 1;
+                    mAttachedSet.erase(pc);
+                }
+            }
+            mDetachCond.notify_all();
+
+            stopList.clear();
+        }
+    }
+
+    setThreadSpecificCustomLogger(nullptr);
+}
+
+} // namespace srtc
@@ -2,8 +2,14 @@
 #include "srtc/logging.h"
 #include "srtc/socket.h"
 
+#ifdef SRTC_HAVE_IO_URING
+#include "srtc/event_loop_linux_uring.h"
+#endif
+
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
 #include <cstring>
 #include <algorithm>
@@ -15,12 +21,28 @@ namespace srtc
 
 std::shared_ptr<EventLoop> EventLoop::factory()
 {
+#ifdef SRTC_HAVE_IO_URING
+    if (getBackend() == Backend::IoUring) {
+        if (auto loop = EventLoop_LinuxUring::create()) {
+            return loop;
+        }
+        LOG(SRTC_LOG_W, "Cannot use io_uring, falling back to epoll");
+    }
+#endif
+
     return std::make_shared<EventLoop_Linux>();
 }
 
 EventLoop_Linux::EventLoop_Linux()
     : mEventHandle(eventfd(0, EFD_NONBLOCK))
     , mEpollHandle(epoll_create(1))
+    , mTimerHandle(-1)
+    , mIsTimerArmed(false)
+#ifdef __NR_epoll_pwait2
+    , mIsPwait2Supported(true)
+#else
+    , mIsPwait2Supported(false)
+#endif
 {
     struct epoll_event ev = {};
 
@@ -32,11 +54,14 @@ EventLoop_Linux::EventLoop_Linux()
 
 EventLoop_Linux::~EventLoop_Linux()
 {
+    if (mTimerHandle >= 0) {
+        close(mTimerHandle);
+    }
     close(mEpollHandle);
     close(mEventHandle);
 }
 
-void EventLoop_Linux::registerSocket(const std::shared_ptr<Socket>& socket, void* udata)
+void EventLoop_Linux::registerSocketImpl(const std::shared_ptr<Socket>& socket, void* udata)
 {
     struct epoll_event ev = {};
     ev.events = EPOLLIN;
@@ -44,20 +69,21 @@ void EventLoop_Linux::registerSocket(const std::shared_ptr<Socket>& socket, void
     epoll_ctl(mEpollHandle, EPOLL_CTL_ADD, socket->handle(), &ev);
 }
 
-void EventLoop_Linux::unregisterSocket(const std::shared_ptr<Socket>& socket)
+void EventLoop_Linux::unregisterSocketImpl(const std::shared_ptr<Socket>& socket)
 {
     epoll_ctl(mEpollHandle, EPOLL_CTL_DEL, socket->handle(), nullptr);
 }
 
-void EventLoop_Linux::wait(std::vector<void*>& udataList, int timeoutMillis)
+void EventLoop_Linux::waitImpl(std::vector<void*>& udataList, const std::chrono::microseconds& timeout)
 {
     udataList.clear();
 
-    // Calling epoll with timeout < 0 causes it to wait indefinitely
-    const auto timeoutArg = std::clamp(timeoutMillis, 0, 100);
+    const auto timeoutArg = beginSleep() ? clampTimeout(timeout) : std::chrono::microseconds::zero();
 
     struct epoll_event epollEvent[10];
-    const auto nfds = epoll_wait(mEpollHandle, epollEvent, sizeof(epollEvent) / sizeof(epollEvent[0]), timeoutArg);
+    const auto nfds = epollWait(epollEvent, sizeof(epollEvent) / sizeof(epollEvent[0]), timeoutArg);
+
+    endSleep();
 
     if (nfds > 0) {
         for (int i = 0; i < nfds; i += 1) {
@@ -66,6 +92,11 @@ void EventLoop_Linux::wait(std::vector<void*>& udataList, int timeoutMillis)
                 // The event fd
                 eventfd_t value = { 0 };
                 eventfd_read(mEventHandle, &value);
+            } else if (event.data.ptr == &mTimerHandle) {
+                // The timer fd
+                uint64_t value = 0;
+                (void)read(mTimerHandle, &value, sizeof(value));
+                mIsTimerArmed = false;
             } else {
                 // A socket
                 udataList.push_back(event.data.ptr);
@@ -77,9 +108,66 @@ void EventLoop_Linux::wait(std::vector<void*>& udataList, int timeoutMillis)
     }
 }
 
+int EventLoop_Linux::epollWait(struct epoll_event* eventList, int maxEvents, const std::chrono::microseconds& timeout)
+{
+    const auto micros = timeout.count();
+
+#ifdef __NR_epoll_pwait2
+    if (mIsPwait2Supported) {
+        struct timespec ts = {};
+        ts.tv_sec = static_cast<time_t>(micros / 1000000);
+        ts.tv_nsec = static_cast<long>(micros % 1000000) * 1000;
+
+        const auto r =
+            static_cast<int>(syscall(__NR_epoll_pwait2, mEpollHandle, eventList, maxEvents, &ts, nullptr, 0));
+        if (r >= 0 || errno != ENOSYS) {
+            return r;
+        }
+
+        LOG(SRTC_LOG_W, "epoll_pwait2 is not supported, will use a timer fd");
+        mIsPwait2Supported = false;
+    }
+#endif
+
+    // Whole milliseconds don't need the timer, which must not wake us up early if it's still armed
+    if (micros % 1000 == 0) {
+        if (mIsTimerArmed) {
+            const struct itimerspec spec = {};
+            timerfd_settime(mTimerHandle, 0, &spec, nullptr);
+            mIsTimerArmed = false;
+        }
+        return epoll_wait(mEpollHandle, eventList, maxEvents, static_cast<int>(micros / 1000));
+    }
+
+    if (mTimerHandle < 0) {
+        mTimerHandle = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (mTimerHandle < 0) {
+            const auto message = strerror(errno);
+            LOG(SRTC_LOG_E, "Error creating a timer fd: %s", message);
+            return epoll_wait(mEpollHandle, eventList, maxEvents, static_cast<int>((micros + 999) / 1000));
+        }
+
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.ptr = &mTimerHandle;
+        epoll_ctl(mEpollHandle, EPOLL_CTL_ADD, mTimerHandle, &ev);
+    }
+
+    // Setting the time also resets an expiration which we haven't read
+    struct itimerspec spec = {};
+    spec.it_value.tv_sec = static_cast<time_t>(micros / 1000000);
+    spec.it_value.tv_nsec = static_cast<long>(micros % 1000000) * 1000;
+    timerfd_settime(mTimerHandle, 0, &spec, nullptr);
+    mIsTimerArmed = true;
+
+    return epoll_wait(mEpollHandle, eventList, maxEvents, -1);
+}
+
 void EventLoop_Linux::interrupt()
 {
-    eventfd_write(mEventHandle, 1);
+    if (requestWakeup()) {
+        eventfd_write(mEventHandle, 1);
+    }
 }
 
 } // namespace srtc
\ No newline at end of file
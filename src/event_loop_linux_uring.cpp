@@ -0,0 +1,821 @@
+#include "srtc/event_loop_linux_uring.h"
+#include "srtc/logging.h"
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <netinet/in.h>
+
+#define LOG(level, ...) srtc::log(level, "EventLoop_LinuxUring", __VA_ARGS__)
+
+namespace
+{
+
+constexpr unsigned int kSubmitQueueSize = 256;
+constexpr unsigned int kCompletionQueueSize = 4096;
+
+// Each buffer holds a struct io_uring_recvmsg_out, the peer address and the payload
+constexpr uint16_t kBufferGroup = 0;
+constexpr size_t kBufferCount = 512;
+constexpr size_t kBufferSize = 2048 + 64;
+
+constexpr size_t kSendArenaSize = 256 * 1024;
+constexpr size_t kSendSlotCount = 512;
+
+// How long a send waits for earlier sends to complete when the arena, the slots or the submission queue are full
+constexpr int kSendWaitAttempts = 10;
+constexpr long kSendWaitNanos = 1000 * 1000;
+
+// The low bits of user_data tell what the operation is, the rest is the registration id
+constexpr uint64_t kTagBits = 3;
+constexpr uint64_t kTagMask = (1u << kTagBits) - 1;
+constexpr uint64_t kTagInterrupt = 1;
+constexpr uint64_t kTagReceive = 2;
+constexpr uint64_t kTagSend = 3;
+constexpr uint64_t kTagCancel = 4;
+constexpr uint64_t kTagProbe = 5;
+
+// How long to wait for cancelled receives when shutting down
+constexpr int kShutdownAttempts = 10;
+constexpr long kShutdownWaitNanos = 10 * 1000 * 1000;
+
+int sysSetup(unsigned int entries, struct io_uring_params* params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sysEnter(int fd, unsigned int toSubmit, unsigned int minComplete, unsigned int flags, const void* arg, size_t argSize)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argSize));
+}
+
+int sysRegister(int fd, unsigned int opcode, const void* arg, unsigned int argCount)
+{
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, argCount));
+}
+
+uint64_t makeUserData(uint64_t id, uint64_t tag)
+{
+    return (id << kTagBits) | tag;
+}
+
+} // namespace
+
+namespace srtc
+{
+
+EventLoop_LinuxUring::Registration::Registration(uint64_t id, const std::shared_ptr<Socket>& socket, void* udata)
+    : id(id)
+    , socket(socket)
+    , udata(udata)
+    , msg()
+{
+    // We only need the peer address, which is at most a sockaddr_in6
+    msg.msg_namelen = sizeof(sockaddr_in6);
+}
+
+std::shared_ptr<EventLoop> EventLoop_LinuxUring::create()
+{
+    std::shared_ptr<EventLoop_LinuxUring> loop(new EventLoop_LinuxUring());
+    if (!loop->init()) {
+        return nullptr;
+    }
+    return loop;
+}
+
+EventLoop_LinuxUring::EventLoop_LinuxUring()
+    : mEventHandle(-1)
+    , mRingHandle(-1)
+    , mRingPtr(MAP_FAILED)
+    , mRingSize(0)
+    , mSqes(static_cast<struct io_uring_sqe*>(MAP_FAILED))
+    , mSqesSize(0)
+    , mSqHeadPtr(nullptr)
+    , mSqTailPtr(nullptr)
+    , mSqArray(nullptr)
+    , mSqMask(0)
+    , mSqEntries(0)
+    , mSqTail(0)
+    , mCqHeadPtr(nullptr)
+    , mCqTailPtr(nullptr)
+    , mCqes(nullptr)
+    , mCqMask(0)
+    , mBufferRing(static_cast<struct io_uring_buf_ring*>(MAP_FAILED))
+    , mBufferRingSize(0)
+    , mIsBufferRingRegistered(false)
+    , mBufferTail(0)
+    , mIsInterruptArmed(false)
+    , mIsProbeDone(false)
+    , mProbeResult(0)
+    , mNextId(1)
+    , mSendArenaHead(0)
+    , mSendArenaTail(0)
+    , mSendSlotHead(0)
+    , mSendSlotTail(0)
+{
+}
+
+EventLoop_LinuxUring::~EventLoop_LinuxUring()
+{
+    if (mRingHandle >= 0) {
+        // The kernel writes into our buffers until the receives are cancelled, and it does that asynchronously
+        // when the ring is closed, so cancel them here and wait
+        for (const auto& iter : mRegistrationMap) {
+            const auto reg = iter.second.get();
+            reg->isRemoved = true;
+            reg->socket->setDriver(nullptr);
+            if (reg->isArmed) {
+                cancel(makeUserData(reg->id, kTagReceive));
+            }
+        }
+
+        for (int attempt = 0; attempt < kShutdownAttempts; attempt += 1) {
+            bool isBusy = mSendSlotHead != mSendSlotTail;
+            for (const auto& iter : mRegistrationMap) {
+                isBusy = isBusy || iter.second->isArmed;
+            }
+            if (!isBusy) {
+                break;
+            }
+
+            struct __kernel_timespec timeout = {};
+            timeout.tv_nsec = kShutdownWaitNanos;
+            enter(1, &timeout);
+            reapCompletions();
+        }
+
+        if (mIsBufferRingRegistered) {
+            struct io_uring_buf_reg reg = {};
+            reg.bgid = kBufferGroup;
+            sysRegister(mRingHandle, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+        }
+
+        close(mRingHandle);
+    }
+
+    if (mSqes != MAP_FAILED) {
+        munmap(mSqes, mSqesSize);
+    }
+    if (mRingPtr != MAP_FAILED) {
+        munmap(mRingPtr, mRingSize);
+    }
+    if (mBufferRing != MAP_FAILED) {
+        munmap(mBufferRing, mBufferRingSize);
+    }
+    if (mEventHandle >= 0) {
+        close(mEventHandle);
+    }
+}
+
+bool EventLoop_LinuxUring::init()
+{
+    // https://man7.org/linux/man-pages/man2/io_uring_setup.2.html
+    struct io_uring_params params = {};
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = kCompletionQueueSize;
+
+    mRingHandle = sysSetup(kSubmitQueueSize, &params);
+    if (mRingHandle < 0 && errno == EINVAL) {
+        // Older kernels don't have cooperative task running
+        params = {};
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = kCompletionQueueSize;
+        mRingHandle = sysSetup(kSubmitQueueSize, &params);
+    }
+    if (mRingHandle < 0) {
+        const auto message = strerror(errno);
+        LOG(SRTC_LOG_W, "io_uring is not available: %s", message);
+        return false;
+    }
+
+    const auto requiredFeatures = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((params.features & requiredFeatures) != requiredFeatures) {
+        LOG(SRTC_LOG_W, "io_uring is missing required features: 0x%x", params.features);
+        return false;
+    }
+
+    // The submission and completion rings share a single mapping
+    mRingSize = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned int),
+                         params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe));
+    mRingPtr = mmap(nullptr, mRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingHandle, IORING_OFF_SQ_RING);
+    if (mRingPtr == MAP_FAILED) {
+        const auto message = strerror(errno);
+        LOG(SRTC_LOG_E, "Cannot map the io_uring rings: %s", message);
+        return false;
+    }
+
+    mSqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    mSqes = static_cast<struct io_uring_sqe*>(
+        mmap(nullptr, mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingHandle, IORING_OFF_SQES));
+    if (mSqes == MAP_FAILED) {
+        const auto message = strerror(errno);
+        LOG(SRTC_LOG_E, "Cannot map the io_uring submission entries: %s", message);
+        return false;
+    }
+
+    const auto base = static_cast<uint8_t*>(mRingPtr);
+    mSqHeadPtr = reinterpret_cast<unsigned int*>(base + params.sq_off.head);
+    mSqTailPtr = reinterpret_cast<unsigned int*>(base + params.sq_off.tail);
+    mSqArray = reinterpret_cast<unsigned int*>(base + params.sq_off.array);
+    mSqMask = *reinterpret_cast<unsigned int*>(base + params.sq_off.ring_mask);
+    mSqEntries = params.sq_entries;
+    mSqTail = *mSqTailPtr;
+
+    mCqHeadPtr = reinterpret_cast<unsigned int*>(base + params.cq_off.head);
+    mCqTailPtr = reinterpret_cast<unsigned int*>(base + params.cq_off.tail);
+    mCqes = reinterpret_cast<struct io_uring_cqe*>(base + params.cq_off.cqes);
+    mCqMask = *reinterpret_cast<unsigned int*>(base + params.cq_off.ring_mask);
+
+    // The provided buffer ring, Linux 5.19
+    mBufferRingSize = kBufferCount * sizeof(struct io_uring_buf);
+    mBufferRing = static_cast<struct io_uring_buf_ring*>(
+        mmap(nullptr, mBufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (mBufferRing == MAP_FAILED) {
+        const auto message = strerror(errno);
+        LOG(SRTC_LOG_E, "Cannot allocate the buffer ring: %s", message);
+        return false;
+    }
+
+    struct io_uring_buf_reg bufferReg = {};
+    bufferReg.ring_addr = reinterpret_cast<uint64_t>(mBufferRing);
+    bufferReg.ring_entries = kBufferCount;
+    bufferReg.bgid = kBufferGroup;
+    if (sysRegister(mRingHandle, IORING_REGISTER_PBUF_RING, &bufferReg, 1) != 0) {
+        const auto message = strerror(errno);
+        LOG(SRTC_LOG_W, "io_uring does not support provided buffer rings: %s", message);
+        return false;
+    }
+    mIsBufferRingRegistered = true;
+
+    mBufferMemory = std::make_unique<uint8_t[]>(kBufferCount * kBufferSize);
+    for (size_t i = 0; i < kBufferCount; i += 1) {
+        recycleBuffer(static_cast<uint16_t>(i));
+    }
+
+    if (!probeMultishotReceive()) {
+        return false;
+    }
+
+    mSendArena = std::make_unique<uint8_t[]>(kSendArenaSize);
+    mSendSlotList.resize(kSendSlotCount);
+
+    mEventHandle = eventfd(0, EFD_NONBLOCK);
+    if (mEventHandle < 0) {
+        const auto message = strerror(errno);
+        LOG(SRTC_LOG_E, "Cannot create an eventfd: %s", message);
+        return false;
+    }
+
+    armInterrupt();
+
+    LOG(SRTC_LOG_V, "Created an io_uring event loop, features 0x%x", params.features);
+    return true;
+}
+
+bool EventLoop_LinuxUring::probeMultishotReceive()
+{
+    // Multishot recvmsg is Linux 6.0, older kernels fail it with EINVAL, and then every socket would be deaf.
+    // Arm one on a loopback socket which gets no data, and cancel it.
+    const auto handle = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (handle < 0) {
+        const auto message = strerror(errno);
+        LOG(SRTC_LOG_E, "Cannot create a socket: %s", message);
+        return false;
+    }
+
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(handle, reinterpret_cast<const struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+        const auto message = strerror(errno);
+        LOG(SRTC_LOG_E, "Cannot bind a socket: %s", message);
+        close(handle);
+        return false;
+    }
+
+    struct msghdr msg = {};
+    msg.msg_namelen = sizeof(sockaddr_in6);
+
+    const auto sqe = getSqe();
+    if (sqe == nullptr) {
+        close(handle);
+        return false;
+    }
+
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = handle;
+    sqe->addr = reinterpret_cast<uint64_t>(&msg);
+    sqe->len = 1;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    sqe->user_data = makeUserData(0, kTagProbe);
+
+    cancel(makeUserData(0, kTagProbe));
+
+    for (int attempt = 0; attempt < kShutdownAttempts && !mIsProbeDone; attempt += 1) {
+        struct __kernel_timespec timeout = {};
+        timeout.tv_nsec = kShutdownWaitNanos;
+        enter(1, &timeout);
+        reapCompletions();
+    }
+
+    close(handle);
+
+    if (!mIsProbeDone) {
+        LOG(SRTC_LOG_W, "io_uring did not complete the multishot recvmsg probe");
+        return false;
+    }
+    if (mProbeResult == -EINVAL) {
+        LOG(SRTC_LOG_W, "io_uring does not support multishot recvmsg");
+        return false;
+    }
+
+    return true;
+}
+
+void EventLoop_LinuxUring::registerSocketImpl(const std::shared_ptr<Socket>& socket, void* udata)
+{
+    // We don't ask for the UDP_GRO control message, and the provided buffers are too small for coalesced
+    // datagrams, so the kernel should not coalesce
+    if (socket->isGroEnabled()) {
+        LOG(SRTC_LOG_W, "GRO is not supported with io_uring, turning it off");
+        (void)socket->setGroEnabled(false, 0);
+    }
+
+    const auto id = mNextId++;
+    auto reg = std::make_unique<Registration>(id, socket, udata);
+    const auto ptr = reg.get();
+
+    mRegistrationMap.emplace(id, std::move(reg));
+    mSocketMap.emplace(socket.get(), ptr);
+
+    socket->setDriver(this);
+    armReceive(ptr);
+}
+
+void EventLoop_LinuxUring::unregisterSocketImpl(const std::shared_ptr<Socket>& socket)
+{
+    const auto iter = mSocketMap.find(socket.get());
+    if (iter == mSocketMap.end()) {
+        return;
+    }
+
+    const auto reg = iter->second;
+    mSocketMap.erase(iter);
+
+    // Packets which were queued, but not flushed, go out with a plain sendto
+    socket->setDriver(nullptr);
+
+    reg->isRemoved = true;
+    for (const auto& pending : reg->pendingList) {
+        recycleBuffer(pending.first);
+    }
+    reg->pendingList.clear();
+
+    if (reg->isArmed) {
+        // The registration stays until the final completion of its receive
+        cancel(makeUserData(reg->id, kTagReceive));
+        enter(0, nullptr);
+    } else {
+        removeRegistration(reg);
+    }
+}
+
+void EventLoop_LinuxUring::waitImpl(std::vector<void*>& udataList, const std::chrono::microseconds& timeout)
+{
+    udataList.clear();
+
+    if (!mIsInterruptArmed) {
+        armInterrupt();
+    }
+
+    // Deliver what didn't fit into the sockets' rings last time, and re-arm receives which have ended
+    if (!mRetryList.empty()) {
+        auto retryList = std::move(mRetryList);
+        mRetryList.clear();
+
+        for (const auto reg : retryList) {
+            reg->isRetry = false;
+
+            size_t delivered = 0;
+            while (delivered < reg->pendingList.size()) {
+                const auto& pending = reg->pendingList[delivered];
+                if (!deliverBuffer(reg, pending.first, pending.second)) {
+                    break;
+                }
+                recycleBuffer(pending.first);
+                delivered += 1;
+            }
+            if (delivered > 0) {
+                reg->pendingList.erase(reg->pendingList.begin(),
+                                       reg->pendingList.begin() + static_cast<std::ptrdiff_t>(delivered));
+                setReady(reg);
+            }
+
+            if (!reg->isArmed && !reg->isFailed) {
+                armReceive(reg);
+            }
+            if (!reg->pendingList.empty()) {
+                setRetry(reg);
+            }
+        }
+    }
+
+    // Don't block if there is already something to report
+    const auto isSleep = beginSleep() && mReadyList.empty();
+
+    // The timeout has nanosecond precision
+    struct __kernel_timespec timeoutArg = {};
+    if (isSleep) {
+        const auto micros = clampTimeout(timeout).count();
+        timeoutArg.tv_sec = micros / 1000000;
+        timeoutArg.tv_nsec = (micros % 1000000) * 1000;
+    }
+
+    const auto r = enter(isSleep ? 1 : 0, &timeoutArg);
+    if (r < 0 && errno != ETIME && errno != EINTR && errno != EBUSY) {
+        const auto message = strerror(errno);
+        LOG(SRTC_LOG_E, "Error calling io_uring_enter: %s", message);
+    }
+
+    endSleep();
+
+    reapCompletions();
+
+    for (const auto reg : mReadyList) {
+        reg->isReady = false;
+        udataList.push_back(reg->udata);
+    }
+    mReadyList.clear();
+}
+
+void EventLoop_LinuxUring::interrupt()
+{
+    if (requestWakeup()) {
+        eventfd_write(mEventHandle, 1);
+    }
+}
+
+void EventLoop_LinuxUring::send(SocketHandle handle,
+                                const anyaddr& addr,
+                                socklen_t addrLen,
+                                const uint8_t* data,
+                                const size_t* sizeList,
+                                size_t count)
+{
+    for (size_t i = 0; i < count; i += 1) {
+        const auto ptr = data;
+        const auto size = sizeList[i];
+        data += size;
+
+        // The arena is a ring, a packet which doesn't fit before its end goes to the start
+        auto start = mSendArenaTail;
+        if (start % kSendArenaSize + size > kSendArenaSize) {
+            start += kSendArenaSize - start % kSendArenaSize;
+        }
+        const auto end = start + size;
+
+        if (!waitForSendRoom(end)) {
+            LOG(SRTC_LOG_E, "Earlier sends did not complete, dropping a packet");
+            continue;
+        }
+
+        // getSqe() has already submitted, wait for the kernel to take some of the queue
+        auto sqe = getSqe();
+        for (int attempt = 0; sqe == nullptr && attempt < kSendWaitAttempts; attempt += 1) {
+            waitForCompletion();
+            sqe = getSqe();
+        }
+        if (sqe == nullptr) {
+            LOG(SRTC_LOG_E, "The submission queue is full, dropping a packet");
+            continue;
+        }
+
+        const auto copy = mSendArena.get() + start % kSendArenaSize;
+        std::memcpy(copy, ptr, size);
+        mSendArenaTail = end;
+
+        const auto slotIndex = mSendSlotTail % kSendSlotCount;
+        mSendSlotTail += 1;
+
+        auto& slot = mSendSlotList[slotIndex];
+        slot.arenaEnd = end;
+        slot.isDone = false;
+        slot.addr = addr;
+        slot.iov.iov_base = copy;
+        slot.iov.iov_len = size;
+        slot.msg = {};
+        slot.msg.msg_name = &slot.addr;
+        slot.msg.msg_namelen = addrLen;
+        slot.msg.msg_iov = &slot.iov;
+        slot.msg.msg_iovlen = 1;
+
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = handle;
+        sqe->addr = reinterpret_cast<uint64_t>(&slot.msg);
+        sqe->len = 1;
+        sqe->user_data = makeUserData(slotIndex, kTagSend);
+    }
+
+    // Submitted with the next wait, which comes soon after a flush
+}
+
+struct io_uring_sqe* EventLoop_LinuxUring::getSqe()
+{
+    if (mSqTail - __atomic_load_n(mSqHeadPtr, __ATOMIC_ACQUIRE) >= mSqEntries) {
+        enter(0, nullptr);
+        if (mSqTail - __atomic_load_n(mSqHeadPtr, __ATOMIC_ACQUIRE) >= mSqEntries) {
+            return nullptr;
+        }
+    }
+
+    const auto index = mSqTail & mSqMask;
+    mSqArray[index] = index;
+    mSqTail += 1;
+
+    const auto sqe = &mSqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+int EventLoop_LinuxUring::enter(unsigned int minComplete, const struct __kernel_timespec* timeout)
+{
+    // https://man7.org/linux/man-pages/man2/io_uring_enter.2.html
+    __atomic_store_n(mSqTailPtr, mSqTail, __ATOMIC_RELEASE);
+    const auto toSubmit = mSqTail - __atomic_load_n(mSqHeadPtr, __ATOMIC_ACQUIRE);
+
+    if (timeout == nullptr) {
+        const auto flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+        return sysEnter(mRingHandle, toSubmit, minComplete, flags, nullptr, 0);
+    }
+
+    struct io_uring_getevents_arg arg = {};
+    arg.ts = reinterpret_cast<uint64_t>(timeout);
+
+    return sysEnter(mRingHandle, toSubmit, minComplete, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+}
+
+void EventLoop_LinuxUring::reapCompletions()
+{
+    auto head = *mCqHeadPtr;
+    const auto tail = __atomic_load_n(mCqTailPtr, __ATOMIC_ACQUIRE);
+
+    while (head != tail) {
+        handleCompletion(mCqes[head & mCqMask]);
+        head += 1;
+    }
+
+    __atomic_store_n(mCqHeadPtr, head, __ATOMIC_RELEASE);
+}
+
+void EventLoop_LinuxUring::handleCompletion(const struct io_uring_cqe& cqe)
+{
+    const auto tag = cqe.user_data & kTagMask;
+    const auto isMore = (cqe.flags & IORING_CQE_F_MORE) != 0;
+
+    switch (tag) {
+    case kTagInterrupt: {
+        eventfd_t value = { 0 };
+        eventfd_read(mEventHandle, &value);
+        if (!isMore) {
+            mIsInterruptArmed = false;
+        }
+        break;
+    }
+    case kTagSend:
+        if (cqe.res < 0 && cqe.res != -EAGAIN && cqe.res != -EINTR) {
+            const auto message = strerror(-cqe.res);
+            LOG(SRTC_LOG_E, "Cannot send on a socket: %s", message);
+        }
+        completeSend(cqe.user_data >> kTagBits);
+        break;
+    case kTagReceive: {
+        const auto iter = mRegistrationMap.find(cqe.user_data >> kTagBits);
+        const auto reg = iter == mRegistrationMap.end() ? nullptr : iter->second.get();
+
+        if ((cqe.flags & IORING_CQE_F_BUFFER) != 0) {
+            const auto bufferId = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            const auto size = static_cast<uint32_t>(std::max(cqe.res, 0));
+
+            if (reg == nullptr || reg->isRemoved || cqe.res < 0) {
+                recycleBuffer(bufferId);
+            } else if (!reg->pendingList.empty() || !deliverBuffer(reg, bufferId, size)) {
+                // Keep the order
+                reg->pendingList.emplace_back(bufferId, size);
+                setRetry(reg);
+            } else {
+                recycleBuffer(bufferId);
+                setReady(reg);
+            }
+        }
+
+        if (reg != nullptr && !isMore) {
+            reg->isArmed = false;
+            if (reg->isRemoved) {
+                removeRegistration(reg);
+            } else {
+                if (cqe.res == -EINVAL) {
+                    // Support was probed in init(), so this is something about the socket, don't keep re-arming
+                    const auto message = strerror(-cqe.res);
+                    LOG(SRTC_LOG_E, "Receive failed: %s", message);
+                    reg->isFailed = true;
+                } else if (cqe.res < 0 && cqe.res != -ENOBUFS && cqe.res != -ECANCELED) {
+                    const auto message = strerror(-cqe.res);
+                    LOG(SRTC_LOG_W, "Receive ended: %s", message);
+                }
+                // Re-arm with the next wait, when buffers have been returned
+                setRetry(reg);
+            }
+        }
+        break;
+    }
+    case kTagProbe:
+        if ((cqe.flags & IORING_CQE_F_BUFFER) != 0) {
+            recycleBuffer(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+        }
+        if (!isMore) {
+            mIsProbeDone = true;
+            mProbeResult = cqe.res;
+        }
+        break;
+    case kTagCancel:
+    default:
+        break;
+    }
+}
+
+void EventLoop_LinuxUring::armInterrupt()
+{
+    const auto sqe = getSqe();
+    if (sqe == nullptr) {
+        return;
+    }
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = mEventHandle;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = makeUserData(0, kTagInterrupt);
+
+    mIsInterruptArmed = true;
+}
+
+void EventLoop_LinuxUring::armReceive(Registration* reg)
+{
+    const auto sqe = getSqe();
+    if (sqe == nullptr) {
+        setRetry(reg);
+        return;
+    }
+
+    // https://man7.org/linux/man-pages/man3/io_uring_prep_recvmsg_multishot.3.html
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = reg->socket->handle();
+    sqe->addr = reinterpret_cast<uint64_t>(&reg->msg);
+    sqe->len = 1;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    sqe->user_data = makeUserData(reg->id, kTagReceive);
+
+    reg->isArmed = true;
+}
+
+void EventLoop_LinuxUring::cancel(uint64_t userData)
+{
+    const auto sqe = getSqe();
+    if (sqe == nullptr) {
+        return;
+    }
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = userData;
+    sqe->user_data = makeUserData(0, kTagCancel);
+}
+
+bool EventLoop_LinuxUring::deliverBuffer(Registration* reg, uint16_t bufferId, uint32_t size)
+{
+    const auto buffer = mBufferMemory.get() + static_cast<size_t>(bufferId) * kBufferSize;
+
+    // The buffer starts with struct io_uring_recvmsg_out, followed by the address, control and payload
+    const auto headerSize = sizeof(struct io_uring_recvmsg_out) + reg->msg.msg_namelen + reg->msg.msg_controllen;
+    if (size < headerSize) {
+        return true;
+    }
+
+    struct io_uring_recvmsg_out out = {};
+    std::memcpy(&out, buffer, sizeof(out));
+
+    if ((out.flags & MSG_TRUNC) != 0) {
+        LOG(SRTC_LOG_E, "Received a datagram larger than %zu bytes, dropping", kBufferSize - headerSize);
+        return true;
+    }
+
+    anyaddr addr = {};
+    const auto addrLen = std::min(out.namelen, reg->msg.msg_namelen);
+    std::memcpy(&addr, buffer + sizeof(out), addrLen);
+
+    return reg->socket->deliver(buffer + headerSize, size - headerSize, addr, addrLen);
+}
+
+void EventLoop_LinuxUring::recycleBuffer(uint16_t bufferId)
+{
+    // The ring's tail overlays the reserved field of the first entry, so don't assign whole entries. In C++,
+    // the kernel header's flexible array member "bufs" is not at offset 0, so don't use it.
+    auto& entry = reinterpret_cast<struct io_uring_buf*>(mBufferRing)[mBufferTail & (kBufferCount - 1)];
+    entry.addr = reinterpret_cast<uint64_t>(mBufferMemory.get() + static_cast<size_t>(bufferId) * kBufferSize);
+    entry.len = kBufferSize;
+    entry.bid = bufferId;
+
+    mBufferTail += 1;
+    __atomic_store_n(&mBufferRing->tail, mBufferTail, __ATOMIC_RELEASE);
+}
+
+void EventLoop_LinuxUring::setReady(Registration* reg)
+{
+    if (!reg->isReady) {
+        reg->isReady = true;
+        mReadyList.push_back(reg);
+    }
+}
+
+void EventLoop_LinuxUring::setRetry(Registration* reg)
+{
+    if (!reg->isRetry) {
+        reg->isRetry = true;
+        mRetryList.push_back(reg);
+    }
+}
+
+void EventLoop_LinuxUring::removeRegistration(Registration* reg)
+{
+    mReadyList.erase(std::remove(mReadyList.begin(), mReadyList.end(), reg), mReadyList.end());
+    mRetryList.erase(std::remove(mRetryList.begin(), mRetryList.end(), reg), mRetryList.end());
+
+    // Destroys the registration, and possibly the socket
+    mRegistrationMap.erase(reg->id);
+}
+
+bool EventLoop_LinuxUring::hasSendRoom(size_t arenaEnd) const
+{
+    return mSendSlotTail - mSendSlotHead < kSendSlotCount && arenaEnd - mSendArenaHead <= kSendArenaSize;
+}
+
+bool EventLoop_LinuxUring::waitForSendRoom(size_t arenaEnd)
+{
+    if (hasSendRoom(arenaEnd)) {
+        return true;
+    }
+
+    // Only as long as it takes for the oldest sends to complete, not for all of them
+    reapCompletions();
+    for (int attempt = 0; !hasSendRoom(arenaEnd) && attempt < kSendWaitAttempts; attempt += 1) {
+        waitForCompletion();
+    }
+
+    return hasSendRoom(arenaEnd);
+}
+
+void EventLoop_LinuxUring::waitForCompletion()
+{
+    struct __kernel_timespec timeout = {};
+    timeout.tv_nsec = kSendWaitNanos;
+
+    const auto r = enter(1, &timeout);
+    if (r < 0 && errno != ETIME && errno != EINTR && errno != EBUSY) {
+        const auto message = strerror(errno);
+        LOG(SRTC_LOG_E, "Error calling io_uring_enter: %s", message);
+    }
+
+    reapCompletions();
+}
+
+void EventLoop_LinuxUring::completeSend(uint64_t slotIndex)
+{
+    if (slotIndex >= kSendSlotCount) {
+        return;
+    }
+    mSendSlotList[slotIndex].isDone = true;
+
+    // Sends can complete out of order, the arena is freed up to the oldest one still in flight
+    while (mSendSlotHead != mSendSlotTail) {
+        auto& slot = mSendSlotList[mSendSlotHead % kSendSlotCount];
+        if (!slot.isDone) {
+            break;
+        }
+        mSendArenaHead = slot.arenaEnd;
+        mSendSlotHead += 1;
+    }
+}
+
+} // namespace srtc
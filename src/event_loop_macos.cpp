@@ -41,7 +41,7 @@ EventLoop_MacOS::~EventLoop_MacOS()
     close(mKQueue);
 }
 
-void EventLoop_MacOS::registerSocket(const std::shared_ptr<Socket>& socket, void* udata)
+void EventLoop_MacOS::registerSocketImpl(const std::shared_ptr<Socket>& socket, void* udata)
 {
     assert(udata != nullptr);
 
@@ -53,7 +53,7 @@ void EventLoop_MacOS::registerSocket(const std::shared_ptr<Socket>& socket, void
     }
 }
 
-void EventLoop_MacOS::unregisterSocket(const std::shared_ptr<Socket>& socket)
+void EventLoop_MacOS::unregisterSocketImpl(const std::shared_ptr<Socket>& socket)
 {
     struct kevent change = {};
     EV_SET(&change, socket->handle(), EVFILT_READ, EV_DELETE, 0, 0, nullptr);
@@ -63,25 +63,22 @@ void EventLoop_MacOS::unregisterSocket(const std::shared_ptr<Socket>& socket)
     }
 }
 
-void EventLoop_MacOS::wait(std::vector<void*>& udataList, int timeoutMillis)
+void EventLoop_MacOS::waitImpl(std::vector<void*>& udataList, const std::chrono::microseconds& timeout)
 {
     udataList.clear();
 
     struct kevent event[10];
 
-    struct timespec timeout = {};
-    if (timeoutMillis < 0) {
-        timeout.tv_sec = 0;
-        timeout.tv_nsec = 0;
-    } else if (timeoutMillis < 1000) {
-        timeout.tv_sec = 0;
-        timeout.tv_nsec = timeoutMillis * 1000000;
-    } else {
-        timeout.tv_sec = timeoutMillis / 1000;
-        timeout.tv_nsec = (timeoutMillis % 1000) * 1000000;
+    struct timespec timeoutArg = {};
+    if (beginSleep()) {
+        const auto micros = clampTimeout(timeout).count();
+        timeoutArg.tv_sec = static_cast<time_t>(micros / 1000000);
+        timeoutArg.tv_nsec = static_cast<long>(micros % 1000000) * 1000;
     }
 
-    const auto n = kevent(mKQueue, nullptr, 0, event, sizeof(event) / sizeof(event[0]), &timeout);
+    const auto n = kevent(mKQueue, nullptr, 0, event, sizeof(event) / sizeof(event[0]), &timeoutArg);
+    endSleep();
+
     if (n > 0) {
         for (int i = 0; i < n; i += 1) {
             const auto& ev = event[i];
@@ -98,6 +95,10 @@ void EventLoop_MacOS::wait(std::vector<void*>& udataList, int timeoutMillis)
 
 void EventLoop_MacOS::interrupt()
 {
+    if (!requestWakeup()) {
+        return;
+    }
+
     struct kevent change = {};
     EV_SET(&change, kInterruptId, EVFILT_USER, 0, NOTE_TRIGGER, 0, nullptr);
 
@@ -26,12 +26,12 @@ EventLoop_Win::~EventLoop_Win()
     }
 }
 
-void EventLoop_Win::registerSocket(const std::shared_ptr<Socket>& socket, void* udata)
+void EventLoop_Win::registerSocketImpl(const std::shared_ptr<Socket>& socket, void* udata)
 {
     mSocketList.emplace_back(socket, udata);
 }
 
-void EventLoop_Win::unregisterSocket(const std::shared_ptr<Socket>& socket)
+void EventLoop_Win::unregisterSocketImpl(const std::shared_ptr<Socket>& socket)
 {
     for (auto iter = mSocketList.begin(); iter != mSocketList.end();) {
         if (iter->socket.lock() == socket) {
@@ -43,7 +43,7 @@ void EventLoop_Win::unregisterSocket(const std::shared_ptr<Socket>& socket)
     }
 }
 
-void EventLoop_Win::wait(std::vector<void*>& udataList, int timeoutMillis)
+void EventLoop_Win::waitImpl(std::vector<void*>& udataList, const std::chrono::microseconds& timeout)
 {
     const auto size = 1 + mSocketList.size();
 
@@ -67,9 +67,13 @@ void EventLoop_Win::wait(std::vector<void*>& udataList, int timeoutMillis)
 
     udataList.clear();
 
-    const auto timeoutArg = std::clamp(timeoutMillis, 0, 100);
+    // Windows waits are in milliseconds, round up so we don't wake up before the deadline
+    const auto timeoutArg =
+        beginSleep() ? static_cast<DWORD>(std::chrono::ceil<std::chrono::milliseconds>(clampTimeout(timeout)).count())
+                     : 0;
 
     const auto res = WaitForMultipleObjects(static_cast<DWORD>(count), handleListPtr, FALSE, timeoutArg);
+    endSleep();
     if (res != WAIT_TIMEOUT) {
         const auto index = res - WAIT_OBJECT_0;
         if (index >= 1 && index < count) {
@@ -93,7 +97,9 @@ void EventLoop_Win::wait(std::vector<void*>& udataList, int timeoutMillis)
 
 void EventLoop_Win::interrupt()
 {
-    SetEvent(mEventHandle);
+    if (requestWakeup()) {
+        SetEvent(mEventHandle);
+    }
 }
 
 } // namespace srtc
@@ -1,4 +1,5 @@
 #include "srtc/jitter_buffer.h"
+#include "srtc/deadline.h"
 #include "srtc/depacketizer.h"
 #include "srtc/logging.h"
 #include "srtc/media.h"
@@ -19,11 +20,8 @@ namespace
 
 constexpr auto kNoPacketsResetDelay = std::chrono::milliseconds(2000);
 
-// We calculate timeouts for the event loop (when there are no network events) with millisecond precision. When we
-// time out and go to process actual logic like de-queuing frames or sending nacks, we need to use millisecond precision
-// as well. If we don't, we might have a timeout = 0, but the actual logic won't run because it's 12 nanoseconds in the
-// future or something. Then we'll end up cycling the event loop with 0 millisecond timeout value several times, which
-// is bad for performance.
+// The event loop sleeps until the exact time of our earliest deadline (rounded up to a microsecond), so processing
+// compares time points directly. This is used for logging and for frame statistics.
 
 int diff_millis(const std::chrono::steady_clock::time_point& when, const std::chrono::steady_clock::time_point& now)
 {
@@ -76,32 +74,34 @@ std::shared_ptr<Track> JitterBuffer::getTrack() const
     return mTrack;
 }
 
-void JitterBuffer::consume(const std::shared_ptr<RtpPacket>& packet)
+void JitterBuffer::consume(const RtpPacketView& packet)
 {
-    assert(mTrack == packet->getTrack());
+    assert((packet.ssrc == mTrack->getSSRC() && packet.payloadId == mTrack->getPayloadId()) ||
+           (packet.ssrc == mTrack->getRtxSSRC() && packet.payloadId == mTrack->getRtxPayloadId()));
 
     const auto media = mTrack->getMedia();
 
-    auto seq = packet->getSequence();
-    auto extension = packet->moveExtension();
-    auto payload = packet->movePayload();
+    auto seq = packet.sequence;
+    auto payloadData = packet.payloadData;
+    auto payloadSize = packet.payloadSize;
 
-    if (packet->getSSRC() == mTrack->getRtxSSRC() && packet->getPayloadId() == mTrack->getRtxPayloadId()) {
+    if (packet.ssrc == mTrack->getRtxSSRC() && packet.payloadId == mTrack->getRtxPayloadId()) {
         // Unwrap RTX
-        if (payload.size() < 2) {
+        if (payloadSize < 2) {
             LOG(SRTC_LOG_E, "RTX payload is less than 2 bytes, which can't be");
             return;
         }
 
-        ByteReader reader(payload);
+        ByteReader reader(payloadData, payloadSize);
         seq = reader.readU16();
 
-        payload = { payload.data() + 2, payload.size() - 2 };
+        payloadData += 2;
+        payloadSize -= 2;
     }
 
     // Extend
     const auto seq_ext = mExtValueSeq.extend(seq);
-    const auto rtp_timestamp_ext = mExtValueRtpTimestamp.extend(packet->getTimestamp());
+    const auto rtp_timestamp_ext = mExtValueRtpTimestamp.extend(packet.timestamp);
 
     // Is this packet too late?
     if (mLastFrameTimeStamp.has_value() && mLastFrameTimeStamp.value() > rtp_timestamp_ext) {
@@ -277,10 +277,11 @@ void JitterBuffer::consume(const std::shared_ptr<RtpPacket>& packet)
 
     item->seq_ext = seq_ext;
     item->rtp_timestamp_ext = rtp_timestamp_ext;
-    item->marker = packet->getMarker();
+    item->marker = packet.marker;
 
-    item->extension = std::move(extension);
-    item->payload = std::move(payload);
+    // The only copy of the received payload, the packet's memory goes back to the socket
+    item->extension = packet.copyExtension();
+    item->payload.assign(payloadData, payloadSize);
 
     item->kind = mDepacketizer->getPacketKind(item->payload, item->marker);
 
@@ -321,7 +322,7 @@ void JitterBuffer::consume(const std::shared_ptr<RtpPacket>& packet)
 #ifdef VERBOSE_LOGGING
     if (mTrack->getMediaType() == MediaType::Video) {
         std::printf(
-            "Consume seq = %" PRIu64 ", size = %zu, marker = %d\n", seq_ext, payload.size(), packet->getMarker());
+            "Consume seq = %" PRIu64 ", size = %zu, marker = %d\n", seq_ext, payloadSize, packet.marker);
 
         for (auto debug_seq = mMinSeq; debug_seq < mMaxSeq; debug_seq += 1) {
             const char* label = "?";
@@ -355,23 +356,18 @@ void JitterBuffer::consume(const std::shared_ptr<RtpPacket>& packet)
 #endif
 }
 
-int JitterBuffer::getTimeoutMillis(int defaultTimeout) const
+void JitterBuffer::updateDeadline(Deadline& deadline) const
 {
     if (!mItemList) {
-        return defaultTimeout;
+        return;
     }
 
-    const auto now = std::chrono::steady_clock::now();
-    const auto cutoff = now + std::chrono::milliseconds(defaultTimeout);
+    // Anything after this can't make the deadline earlier
+    const auto cutoff = deadline.getWhen();
 
-    std::optional<int> when_request;
-    std::optional<int> when_abandon;
-    std::optional<int> when_dequeue;
-
-    if (!mTrack->hasNack()) {
-        when_request = 2 * defaultTimeout;
-        when_abandon = 2 * defaultTimeout;
-    }
+    bool has_request = !mTrack->hasNack();
+    bool has_abandon = !mTrack->hasNack();
+    bool has_dequeue = false;
 
     // We add packets on the Max end and consume them from the Min end
     for (auto seq = mMinSeq; seq < mMaxSeq; seq += 1) {
@@ -381,39 +377,29 @@ int JitterBuffer::getTimeoutMillis(int defaultTimeout) const
 
         if (item->received) {
             // Depacketization
-            if (!when_dequeue.has_value()) {
-                when_dequeue = diff_millis(item->when_dequeue, now);
+            if (!has_dequeue) {
+                has_dequeue = true;
+                deadline.update(item->when_dequeue);
             }
         } else {
             // Requesting and abandoning nacks
-            if (!when_request.has_value() && item->nack_needed) {
-                when_request = diff_millis(item->when_nack_request, now);
+            if (!has_request && item->nack_needed) {
+                has_request = true;
+                deadline.update(item->when_nack_request);
             }
-            if (!when_abandon.has_value()) {
-                when_abandon = diff_millis(item->when_nack_abandon, now);
+            if (!has_abandon) {
+                has_abandon = true;
+                deadline.update(item->when_nack_abandon);
             }
         }
 
-        if (when_dequeue.has_value() && when_request.has_value() && when_abandon.has_value()) {
+        if (has_dequeue && has_request && has_abandon) {
             break;
         }
         if (item->when_dequeue > cutoff && item->when_nack_request > cutoff && item->when_nack_abandon > cutoff) {
             break;
         }
     }
-
-    auto timeout = defaultTimeout;
-    if (when_request.has_value() && when_request.value() < timeout) {
-        timeout = when_request.value();
-    }
-    if (when_abandon.has_value() && when_abandon.value() < timeout) {
-        timeout = when_abandon.value();
-    }
-    if (when_dequeue.has_value() && when_dequeue.value() < timeout) {
-        timeout = when_dequeue.value();
-    }
-
-    return timeout;
 }
 
 std::vector<std::shared_ptr<EncodedFrame>> JitterBuffer::processDeque()
@@ -433,7 +419,7 @@ std::vector<std::shared_ptr<EncodedFrame>> JitterBuffer::processDeque()
         const auto item = mItemList[index];
         assert(item);
 
-        if (item->received && diff_millis(item->when_dequeue, now) <= 0) {
+        if (item->received && item->when_dequeue <= now) {
             if (item->kind == PacketKind::Standalone) {
                 // A standalone packet, which is ready to be extracted, possibly into multiple frames
                 mTempPacketList.clear();
@@ -518,7 +504,7 @@ std::vector<std::shared_ptr<EncodedFrame>> JitterBuffer::processDeque()
 
                 deleteItem(item);
             }
-        } else if (!item->received && diff_millis(item->when_nack_abandon, now) <= 0) {
+        } else if (!item->received && item->when_nack_abandon <= now) {
             // A nack that was never received - delete and keep going
             mItemList[index] = nullptr;
             mMinSeq += 1;
@@ -548,7 +534,7 @@ std::vector<uint16_t> JitterBuffer::processNack()
         const auto item = mItemList[index];
         assert(item);
 
-        if (diff_millis(item->when_nack_request, now) <= 0) {
+        if (item->when_nack_request <= now) {
             if (!item->received && item->nack_needed) {
                 item->nack_needed = false;
                 result.push_back(static_cast<uint16_t>(item->seq_ext));
@@ -568,7 +554,7 @@ std::vector<uint16_t> JitterBuffer::processNack()
                     static_cast<uint16_t>(mMaxSeq));
 #endif
             }
-        } else if (diff_millis(item->when_nack_abandon, now) <= 0) {
+        } else if (item->when_nack_abandon <= now) {
             break;
         }
     }
@@ -741,7 +727,7 @@ bool JitterBuffer::findNextToDequeue(const std::chrono::steady_clock::time_point
         assert(item);
 
         if (item->received && item->rtp_timestamp_ext > startTimestamp) {
-            if (diff_millis(item->when_dequeue, now) <= 0) {
+            if (item->when_dequeue <= now) {
                 return true;
             }
         }
@@ -5,6 +5,7 @@
 #include "srtc/rtp_extension_builder.h"
 #include "srtc/rtp_extension_source.h"
 #include "srtc/rtp_packet.h"
+#include "srtc/rtp_packet_pool.h"
 #include "srtc/rtp_packet_source.h"
 #include "srtc/rtp_time_source.h"
 #include "srtc/track.h"
@@ -66,13 +67,14 @@ bool PacketizerAV1::isKeyFrame(const ByteBuffer& frame) const
     return false;
 }
 
-std::vector<std::shared_ptr<RtpPacket>> PacketizerAV1::generate(
+std::vector<RtpPacketPtr> PacketizerAV1::generate(
+    RtpPacketPool& pool,
     const std::vector<std::shared_ptr<RtpExtensionSource>>& extensionSourceList,
     size_t mediaProtectionOverhead,
     int64_t pts_usec,
-    const ByteBuffer& frame)
+    const SharedBuffer& frame)
 {
-    std::vector<std::shared_ptr<RtpPacket>> result;
+    std::vector<RtpPacketPtr> result;
 
     const auto track = getTrack();
 
@@ -83,7 +85,7 @@ std::vector<std::shared_ptr<RtpPacket>> PacketizerAV1::generate(
 
     // We need to know if there is a key frame (new coded video sequence)
     bool isNewCodedVideoSequence = false;
-    for (av1::ObuParser parser(frame); parser; parser.next()) {
+    for (av1::ObuParser parser(*frame); parser; parser.next()) {
         if (parser.currType() == av1::ObuType::SequenceHeader) {
             isNewCodedVideoSequence = true;
             break;
@@ -106,10 +108,10 @@ std::vector<std::shared_ptr<RtpPacket>> PacketizerAV1::generate(
     auto packetNumber = 0u;
 
 #ifdef VERBOSE_LOGGING
-    dumpFrame(pts_usec, frame);
+    dumpFrame(pts_usec, *frame);
 #endif
 
-    for (av1::ObuParser parser(frame); parser; parser.next()) {
+    for (av1::ObuParser parser(*frame); parser; parser.next()) {
         const auto obuType = parser.currType();
         if (obuType == av1::ObuType::TemporalDelimiter) {
             // https://aomediacodec.github.io/av1-rtp-spec/#packetization
@@ -139,14 +141,14 @@ std::vector<std::shared_ptr<RtpPacket>> PacketizerAV1::generate(
                     writeNow = std::min<size_t>(obuCurrSize, usablePayloadSize - payloadSizeSoFar);
                 } else {
                     const auto [rollover, sequence] = packetSource->getNextSequence();
-                    result.push_back(std::make_shared<RtpPacket>(track,
-                                                                 false,
-                                                                 rollover,
-                                                                 sequence,
-                                                                 frameTimestamp,
-                                                                 padding,
-                                                                 std::move(extension),
-                                                                 std::move(payload)));
+                    result.push_back(pool.make(track,
+                                               false,
+                                               rollover,
+                                               sequence,
+                                               frameTimestamp,
+                                               padding,
+                                               std::move(extension),
+                                               std::move(payload)));
 
                     payload.clear();
                     packetNumber += 1;
@@ -178,20 +180,30 @@ std::vector<std::shared_ptr<RtpPacket>> PacketizerAV1::generate(
                 }
             }
 
-            // Payload
-            writer.write(obuCurrData, writeNow);
-
             // Was this partial?
             isContinuation = writeNow < obuCurrSize;
             if (isContinuation) {
                 payload.data()[0] |= (1 << 6);
 
+                // The fragment ends the packet, so it can refer to the frame instead of being copied
+                const auto payloadSlice = BufferSlice{ frame, obuCurrData, writeNow };
+
                 const auto [rollover, sequence] = packetSource->getNextSequence();
-                result.push_back(std::make_shared<RtpPacket>(
-                    track, false, rollover, sequence, frameTimestamp, padding, extension.copy(), std::move(payload)));
+                result.push_back(pool.make(track,
+                                           false,
+                                           rollover,
+                                           sequence,
+                                           frameTimestamp,
+                                           padding,
+                                           extension.copy(),
+                                           std::move(payload),
+                                           payloadSlice));
 
                 payload.clear();
                 packetNumber += 1;
+            } else {
+                // Payload, there may be more OBUs after it
+                writer.write(obuCurrData, writeNow);
             }
 
             // Advance
@@ -202,7 +214,7 @@ std::vector<std::shared_ptr<RtpPacket>> PacketizerAV1::generate(
 
     if (!payload.empty()) {
         const auto [rollover, sequence] = packetSource->getNextSequence();
-        result.push_back(std::make_shared<RtpPacket>(
+        result.push_back(pool.make(
             track, true, rollover, sequence, frameTimestamp, padding, std::move(extension), std::move(payload)));
     }
 
@@ -5,6 +5,7 @@
 #include "srtc/rtp_extension_builder.h"
 #include "srtc/rtp_extension_source.h"
 #include "srtc/rtp_packet.h"
+#include "srtc/rtp_packet_pool.h"
 #include "srtc/rtp_packet_source.h"
 #include "srtc/rtp_time_source.h"
 #include "srtc/track.h"
@@ -64,13 +65,14 @@ bool PacketizerH264::isKeyFrame(const ByteBuffer& frame) const
     return false;
 }
 
-std::vector<std::shared_ptr<RtpPacket>> PacketizerH264::generate(
+std::vector<RtpPacketPtr> PacketizerH264::generate(
+    RtpPacketPool& pool,
     const std::vector<std::shared_ptr<RtpExtensionSource>>& extensionSourceList,
     size_t mediaProtectionOverhead,
     int64_t pts_usec,
-    const ByteBuffer& frame)
+    const SharedBuffer& frame)
 {
-    std::vector<std::shared_ptr<RtpPacket>> result;
+    std::vector<RtpPacketPtr> result;
 
     // https://datatracker.ietf.org/doc/html/rfc6184
 
@@ -83,7 +85,7 @@ std::vector<std::shared_ptr<RtpPacket>> PacketizerH264::generate(
 
     const auto frameTimestamp = timeSource->getFrameTimestamp(pts_usec);
 
-    for (NaluParser parser(frame); parser; parser.next()) {
+    for (NaluParser parser(*frame); parser; parser.next()) {
         const auto naluType = parser.currType();
 
         if (naluType == NaluType::SPS) {
@@ -116,7 +118,7 @@ std::vector<std::shared_ptr<RtpPacket>> PacketizerH264::generate(
                 RtpExtension extension = buildExtension(track, extensionSourceList, true, 0);
 
                 const auto [rollover, sequence] = packetSource->getNextSequence();
-                result.push_back(std::make_shared<RtpPacket>(
+                result.push_back(pool.make(
                     track, false, rollover, sequence, frameTimestamp, 0, std::move(extension), std::move(payload)));
             }
 
@@ -138,15 +140,16 @@ std::vector<std::shared_ptr<RtpPacket>> PacketizerH264::generate(
                 // https://datatracker.ietf.org/doc/html/rfc6184#section-5.6
                 const auto marker = parser.isAtEnd();
                 const auto [rollover, sequence] = packetSource->getNextSequence();
-                auto payload = ByteBuffer{ naluData, naluSize };
-                result.push_back(std::make_shared<RtpPacket>(track,
-                                                             marker,
-                                                             rollover,
-                                                             sequence,
-                                                             frameTimestamp,
-                                                             padding,
-                                                             std::move(extension),
-                                                             std::move(payload)));
+                const auto payloadSlice = BufferSlice{ frame, naluData, naluSize };
+                result.push_back(pool.make(track,
+                                           marker,
+                                           rollover,
+                                           sequence,
+                                           frameTimestamp,
+                                           padding,
+                                           std::move(extension),
+                                           ByteBuffer{},
+                                           payloadSlice));
             } else if (naluSize > 1) {
                 // https://datatracker.ietf.org/doc/html/rfc6184#section-5.8
                 const auto nri = static_cast<uint8_t>(naluData[0] & 0x60);
@@ -188,16 +191,17 @@ std::vector<std::shared_ptr<RtpPacket>> PacketizerH264::generate(
                     const auto marker = isEnd && parser.isAtEnd();
 
                     const auto writeNow = std::min(currSize, packetSize);
-                    writer.write(currData, writeNow);
-
-                    result.push_back(std::make_shared<RtpPacket>(track,
-                                                                 marker,
-                                                                 rollover,
-                                                                 sequence,
-                                                                 frameTimestamp,
-                                                                 padding,
-                                                                 std::move(extension),
-                                                                 std::move(payload)));
+                    const auto payloadSlice = BufferSlice{ frame, currData, writeNow };
+
+                    result.push_back(pool.make(track,
+                                               marker,
+                                               rollover,
+                                               sequence,
+                                               frameTimestamp,
+                                               padding,
+                                               std::move(extension),
+                                               std::move(payload),
+                                               payloadSlice));
 
                     currData += writeNow;
                     currSize -= writeNow;
@@ -5,6 +5,7 @@
 #include "srtc/rtp_extension_builder.h"
 #include "srtc/rtp_extension_source.h"
 #include "srtc/rtp_packet.h"
+#include "srtc/rtp_packet_pool.h"
 #include "srtc/rtp_packet_source.h"
 #include "srtc/rtp_time_source.h"
 #include "srtc/track.h"
@@ -67,13 +68,14 @@ bool PacketizerH265::isKeyFrame(const ByteBuffer& frame) const
     return false;
 }
 
-std::vector<std::shared_ptr<RtpPacket>> PacketizerH265::generate(
+std::vector<RtpPacketPtr> PacketizerH265::generate(
+    RtpPacketPool& pool,
     const std::vector<std::shared_ptr<RtpExtensionSource>>& extensionSourceList,
     size_t mediaProtectionOverhead,
     int64_t pts_usec,
-    const ByteBuffer& frame)
+    const SharedBuffer& frame)
 {
-    std::vector<std::shared_ptr<RtpPacket>> result;
+    std::vector<RtpPacketPtr> result;
 
     // https://datatracker.ietf.org/doc/html/rfc7798
 
@@ -86,7 +88,7 @@ std::vector<std::shared_ptr<RtpPacket>> PacketizerH265::generate(
 
     const auto frameTimestamp = timeSource->getFrameTimestamp(pts_usec);
 
-    for (NaluParser parser(frame); parser; parser.next()) {
+    for (NaluParser parser(*frame); parser; parser.next()) {
         const auto naluType = parser.currType();
 
         if (naluType == NaluType::VPS) {
@@ -124,7 +126,7 @@ std::vector<std::shared_ptr<RtpPacket>> PacketizerH265::generate(
                 RtpExtension extension = buildExtension(track, extensionSourceList, true, 0);
 
                 const auto [rollover, sequence] = packetSource->getNextSequence();
-                result.push_back(std::make_shared<RtpPacket>(
+                result.push_back(pool.make(
                     track, false, rollover, sequence, frameTimestamp, 0, std::move(extension), std::move(payload)));
             }
 
@@ -146,15 +148,16 @@ std::vector<std::shared_ptr<RtpPacket>> PacketizerH265::generate(
                 // https://datatracker.ietf.org/doc/html/rfc7798#section-4.4.1
                 const auto marker = parser.isAtEnd();
                 const auto [rollover, sequence] = packetSource->getNextSequence();
-                auto payload = ByteBuffer{ naluData, naluSize };
-                result.push_back(std::make_shared<RtpPacket>(track,
-                                                             marker,
-                                                             rollover,
-                                                             sequence,
-                                                             frameTimestamp,
-                                                             padding,
-                                                             std::move(extension),
-                                                             std::move(payload)));
+                const auto payloadSlice = BufferSlice{ frame, naluData, naluSize };
+                result.push_back(pool.make(track,
+                                           marker,
+                                           rollover,
+                                           sequence,
+                                           frameTimestamp,
+                                           padding,
+                                           std::move(extension),
+                                           ByteBuffer{},
+                                           payloadSlice));
             } else if (naluSize > 2) {
                 // https://datatracker.ietf.org/doc/html/rfc7798#section-4.4.3
                 uint8_t layerId = ((naluData[0] & 0x01) << 5) | ((naluData[1] >> 3) & 0x1F);
@@ -195,16 +198,17 @@ std::vector<std::shared_ptr<RtpPacket>> PacketizerH265::generate(
                     const auto marker = isEnd && parser.isAtEnd();
 
                     const auto writeNow = std::min(currSize, packetSize);
-                    writer.write(currData, writeNow);
-
-                    result.push_back(std::make_shared<RtpPacket>(track,
-                                                                 marker,
-                                                                 rollover,
-                                                                 sequence,
-                                                                 frameTimestamp,
-                                                                 padding,
-                                                                 std::move(extension),
-                                                                 std::move(payload)));
+                    const auto payloadSlice = BufferSlice{ frame, currData, writeNow };
+
+                    result.push_back(pool.make(track,
+                                               marker,
+                                               rollover,
+                                               sequence,
+                                               frameTimestamp,
+                                               padding,
+                                               std::move(extension),
+                                               std::move(payload),
+                                               payloadSlice));
 
                     currData += writeNow;
                     currSize -= writeNow;
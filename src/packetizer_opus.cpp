@@ -1,10 +1,12 @@
 #include "srtc/packetizer_opus.h"
 #include "srtc/rtp_extension_builder.h"
 #include "srtc/rtp_extension_source.h"
+#include "srtc/rtp_packet_pool.h"
 #include "srtc/rtp_packet_source.h"
 #include "srtc/rtp_time_source.h"
 #include "srtc/track.h"
 
+#include <algorithm>
 #include <cassert>
 
 namespace srtc
@@ -18,13 +20,14 @@ PacketizerOpus::PacketizerOpus(const std::shared_ptr<Track>& track)
 
 PacketizerOpus::~PacketizerOpus() = default;
 
-std::vector<std::shared_ptr<RtpPacket>> PacketizerOpus::generate(
+std::vector<RtpPacketPtr> PacketizerOpus::generate(
+    RtpPacketPool& pool,
     const std::vector<std::shared_ptr<RtpExtensionSource>>& extensionSourceList,
     [[maybe_unused]] size_t mediaProtectionOverhead,
     int64_t pts_usec,
-    const ByteBuffer& frame)
+    const SharedBuffer& frame)
 {
-    std::vector<std::shared_ptr<RtpPacket>> result;
+    std::vector<RtpPacketPtr> result;
 
     // https://datatracker.ietf.org/doc/rfc7587
 
@@ -35,19 +38,14 @@ std::vector<std::shared_ptr<RtpPacket>> PacketizerOpus::generate(
 
     const auto frameTimestamp = timeSource->getFrameTimestamp(pts_usec);
 
-    auto payload = frame.copy();
-    if (payload.size() > RtpPacket::kMaxPayloadSize) {
-        payload.resize(RtpPacket::kMaxPayloadSize);
-    }
+    const auto payloadSize = std::min(frame->size(), RtpPacket::kMaxPayloadSize);
+    const auto payloadSlice = BufferSlice{ frame, frame->data(), payloadSize };
 
     auto extension = buildExtension(track, extensionSourceList, false, 0);
 
     const auto [rollover, sequence] = packetSource->getNextSequence();
-    result.push_back(
-        extension.empty()
-            ? std::make_shared<RtpPacket>(track, false, rollover, sequence, frameTimestamp, 0, std::move(payload))
-            : std::make_shared<RtpPacket>(
-                  track, false, rollover, sequence, frameTimestamp, 0, std::move(extension), std::move(payload)));
+    result.push_back(pool.make(
+        track, false, rollover, sequence, frameTimestamp, 0, std::move(extension), ByteBuffer{}, payloadSlice));
 
     return result;
 }
@@ -1,4 +1,5 @@
 #include "srtc/packetizer_vp8.h"
+#include "srtc/rtp_packet_pool.h"
 #include "srtc/rtp_packet_source.h"
 #include "srtc/rtp_time_source.h"
 #include "srtc/track.h"
@@ -30,13 +31,14 @@ bool PacketizerVP8::isKeyFrame(const srtc::ByteBuffer& frame) const
     return tagFrameType == 0;
 }
 
-std::vector<std::shared_ptr<RtpPacket>> PacketizerVP8::generate(
+std::vector<RtpPacketPtr> PacketizerVP8::generate(
+    RtpPacketPool& pool,
     const std::vector<std::shared_ptr<RtpExtensionSource>>& extensionSourceList,
     size_t mediaProtectionOverhead,
     int64_t pts_usec,
-    const ByteBuffer& frame)
+    const SharedBuffer& frame)
 {
-    std::vector<std::shared_ptr<RtpPacket>> result;
+    std::vector<RtpPacketPtr> result;
 
     // https://datatracker.ietf.org/doc/html/rfc7741
 
@@ -48,8 +50,8 @@ std::vector<std::shared_ptr<RtpPacket>> PacketizerVP8::generate(
     const auto frameTimestamp = timeSource->getFrameTimestamp(pts_usec);
 
     // https://datatracker.ietf.org/doc/html/rfc6386#section-9.1
-    const auto frameData = frame.data();
-    const auto frameSize = frame.size();
+    const auto frameData = frame->data();
+    const auto frameSize = frame->size();
     if (frameSize < 3) {
         return result;
     }
@@ -58,8 +60,8 @@ std::vector<std::shared_ptr<RtpPacket>> PacketizerVP8::generate(
     const auto tagFrameType = tag & 0x01;
 
     // https://datatracker.ietf.org/doc/html/rfc7741#section-4.2
-    auto currData = frame.data();
-    auto currSize = frame.size();
+    auto currData = frame->data();
+    auto currSize = frame->size();
 
     const auto basicPacketSize = getBasicPacketSize(mediaProtectionOverhead);
 
@@ -81,12 +83,19 @@ std::vector<std::shared_ptr<RtpPacket>> PacketizerVP8::generate(
 
         // Payload
         const auto writeNow = std::min(currSize, packetSize);
-        writer.write(currData, writeNow);
+        const auto payloadSlice = BufferSlice{ frame, currData, writeNow };
 
         // Make a packet
         const auto marker = currSize <= packetSize;
-        result.push_back(std::make_shared<RtpPacket>(
-            track, marker, rollover, sequence, frameTimestamp, padding, std::move(extension), std::move(payload)));
+        result.push_back(pool.make(track,
+                                   marker,
+                                   rollover,
+                                   sequence,
+                                   frameTimestamp,
+                                   padding,
+                                   std::move(extension),
+                                   std::move(payload),
+                                   payloadSlice));
 
         // Advance
         currData += writeNow;
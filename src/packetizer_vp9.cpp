@@ -1,5 +1,6 @@
 #include "srtc/packetizer_vp9.h"
 #include "srtc/codec_vp9.h"
+#include "srtc/rtp_packet_pool.h"
 #include "srtc/rtp_packet_source.h"
 #include "srtc/rtp_time_source.h"
 #include "srtc/track.h"
@@ -23,13 +24,14 @@ bool PacketizerVP9::isKeyFrame(const ByteBuffer& frame) const
     return srtc::vp9::isKeyFrame(frame.data(), frame.size());
 }
 
-std::vector<std::shared_ptr<RtpPacket>> PacketizerVP9::generate(
+std::vector<RtpPacketPtr> PacketizerVP9::generate(
+    RtpPacketPool& pool,
     const std::vector<std::shared_ptr<RtpExtensionSource>>& extensionSourceList,
     size_t mediaProtectionOverhead,
     int64_t pts_usec,
-    const ByteBuffer& frame)
+    const SharedBuffer& frame)
 {
-    std::vector<std::shared_ptr<RtpPacket>> result;
+    std::vector<RtpPacketPtr> result;
 
     // https://www.rfc-editor.org/rfc/rfc9628
 
@@ -39,7 +41,7 @@ std::vector<std::shared_ptr<RtpPacket>> PacketizerVP9::generate(
     const auto packetSource = track->getRtpPacketSource();
 
     const auto frameTimestamp = timeSource->getFrameTimestamp(pts_usec);
-    const auto frameIsKeyFrame = vp9::isKeyFrame(frame.data(), frame.size());
+    const auto frameIsKeyFrame = vp9::isKeyFrame(frame->data(), frame->size());
 
     // Claim and advance the picture ID (15-bit, wraps)
     const auto pictureId = mPictureId;
@@ -51,8 +53,8 @@ std::vector<std::shared_ptr<RtpPacket>> PacketizerVP9::generate(
 
     const auto basicPacketSize = getBasicPacketSize(mediaProtectionOverhead);
 
-    auto currData = frame.data();
-    auto currSize = frame.size();
+    auto currData = frame->data();
+    auto currSize = frame->size();
     auto packetNumber = 0u;
 
     while (currSize > 0) {
@@ -78,11 +80,18 @@ std::vector<std::shared_ptr<RtpPacket>> PacketizerVP9::generate(
 
         // VP9 bitstream fragment
         const auto writeNow = std::min(currSize, packetSize);
-        writer.write(currData, writeNow);
+        const auto payloadSlice = BufferSlice{ frame, currData, writeNow };
 
         const auto marker = endOfFrame;
-        result.push_back(std::make_shared<RtpPacket>(
-            track, marker, rollover, sequence, frameTimestamp, padding, std::move(extension), std::move(payload)));
+        result.push_back(pool.make(track,
+                                   marker,
+                                   rollover,
+                                   sequence,
+                                   frameTimestamp,
+                                   padding,
+                                   std::move(extension),
+                                   std::move(payload),
+                                   payloadSlice));
 
         currData += writeNow;
         currSize -= writeNow;
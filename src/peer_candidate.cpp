@@ -6,6 +6,8 @@
 #undef PKCS7_SIGNER_INFO
 #endif
 
+#include "srtc/certificate_pool.h"
+#include "srtc/dtls_worker_pool.h"
 #include "srtc/event_loop.h"
 #include "srtc/ice_agent.h"
 #include "srtc/logging.h"
@@ -29,6 +31,7 @@
 #include "srtc/send_rtp_history.h"
 #include "srtc/sender_report.h"
 #include "srtc/sender_reports_history.h"
+#include "srtc/shared_socket.h"
 #include "srtc/srtp_connection.h"
 #include "srtc/srtp_openssl.h"
 #include "srtc/track.h"
@@ -50,12 +53,6 @@ namespace
 
 std::atomic<uint32_t> gNextUniqueId = 0;
 
-int verify_callback([[maybe_unused]] int ok, [[maybe_unused]] X509_STORE_CTX* store_ctx)
-{
-    // We verify cert has ourselves after the handshake has completed
-    return 1;
-}
-
 std::string get_openssl_error()
 {
     BIO* bio = BIO_new(BIO_s_mem());
@@ -78,8 +75,9 @@ constexpr auto kExpireStunPeriod = std::chrono::milliseconds(1000);
 constexpr auto kExpireStunTimeout = std::chrono::milliseconds(5000);
 constexpr auto kKeepAliveCheckTimeout = std::chrono::milliseconds(1000);
 constexpr auto kKeepAliveSendTimeout = std::chrono::milliseconds(3000);
-constexpr auto kConnectRepeatPeriod = std::chrono::milliseconds(100);
-constexpr auto kConnectRepeatIncrement = std::chrono::milliseconds(100);
+// STUN checks are repeated quickly at first, then backing off
+constexpr auto kConnectRepeatInitial = std::chrono::milliseconds(50);
+constexpr auto kConnectRepeatMax = std::chrono::milliseconds(500);
 constexpr auto kMaxRecentEnough = std::chrono::milliseconds(5 * 1000);
 
 // https://datatracker.ietf.org/doc/html/rfc5245#section-4.1.2.1
@@ -193,6 +191,26 @@ bool is_rtcp_message(const srtc::ByteBuffer& buf)
     return false;
 }
 
+std::chrono::milliseconds getConnectRepeatDelay(unsigned int iteration)
+{
+    // 50, 100, 200, 400, 500, 500 ...
+    if (iteration >= 4) {
+        return kConnectRepeatMax;
+    }
+    return std::min(kConnectRepeatInitial * (1 << iteration), kConnectRepeatMax);
+}
+
+std::shared_ptr<srtc::Socket> create_candidate_socket(const std::shared_ptr<srtc::EventLoop>& eventLoop,
+                                                      const srtc::Host& host,
+                                                      const std::shared_ptr<srtc::SdpOffer>& offer)
+{
+    if (offer->getConfig().enable_ice_lite) {
+        // The peer's checks are routed to us by ufrag, from addresses we don't know yet
+        return eventLoop->getSharedSocket()->createInboundEndpoint(host.addr.ss.ss_family, offer->getIceUFrag());
+    }
+    return eventLoop->createSocket(host.addr, offer->getIceUFrag());
+}
+
 float calculateLayerBandwidthScale(const std::vector<srtc::SimulcastLayer>& layerList,
                                    const std::shared_ptr<srtc::SimulcastLayer>& trackLayer)
 {
@@ -213,6 +231,137 @@ float calculateLayerBandwidthScale(const std::vector<srtc::SimulcastLayer>& laye
 namespace srtc
 {
 
+// A DTLS handshake, stepped on a worker thread or on the network thread, and its datagrams in and out
+// through the BIO. The fields under the mutex are shared between the threads, the SSL object belongs
+// to whoever set isBusy, or to the network thread when it's not set.
+struct DtlsHandshake {
+    SSL_CTX* const ctx;
+    SSL* const ssl;
+    const ByteBuffer expectedHash;
+    const bool isSetupActive;
+    const std::shared_ptr<EventLoop> eventLoop;
+
+    std::mutex mutex;
+    std::list<ByteBuffer> receiveQueue;
+    std::list<ByteBuffer> sendQueue;
+    bool isBusy = false;
+    bool isCancelled = false;
+
+    enum class Result {
+        InProgress,
+        Completed,
+        Failed
+    };
+
+    Result result = Result::InProgress;
+    std::string errorMessage;
+    std::string remoteHashHex;
+    std::shared_ptr<SrtpConnection> srtpConnection;
+
+    DtlsHandshake(SSL_CTX* ctx,
+                  const ByteBuffer& expectedHash,
+                  bool isSetupActive,
+                  const std::shared_ptr<EventLoop>& eventLoop)
+        : ctx(ctx)
+        , ssl(SSL_new(ctx))
+        , expectedHash(expectedHash.copy())
+        , isSetupActive(isSetupActive)
+        , eventLoop(eventLoop)
+    {
+    }
+
+    ~DtlsHandshake()
+    {
+        SSL_free(ssl);
+        SSL_CTX_free(ctx);
+    }
+
+    // Runs the handshake as far as the received datagrams allow, and once it's done, checks the remote
+    // certificate and derives the SRTP keys
+    void step(bool isOnWorker)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        const auto r1 = SSL_do_handshake(ssl);
+        const auto err = SSL_get_error(ssl, r1);
+
+        auto stepResult = Result::InProgress;
+        std::string stepErrorMessage;
+        std::string stepHashHex;
+        std::shared_ptr<SrtpConnection> stepSrtpConnection;
+
+        if (err == SSL_ERROR_WANT_READ) {
+            // Still in progress
+        } else if (r1 == 1 && err == 0) {
+            const auto cert = SSL_get_peer_certificate(ssl);
+            if (cert == nullptr) {
+                stepResult = Result::Failed;
+                stepErrorMessage = "There is no DTLS server certificate";
+            } else {
+                uint8_t fpBuf[32] = {};
+                unsigned int fpSize = {};
+
+                const auto digest = EVP_get_digestbyname("sha256");
+                X509_digest(cert, digest, fpBuf, &fpSize);
+                X509_free(cert);
+
+                stepHashHex = bin_to_hex(fpBuf, fpSize);
+
+                if (expectedHash == ByteBuffer{ fpBuf, fpSize }) {
+                    const auto [srtpConnection, srtpError] = SrtpConnection::create(ssl, isSetupActive);
+                    if (srtpError.isOk()) {
+                        stepResult = Result::Completed;
+                        stepSrtpConnection = srtpConnection;
+                    } else {
+                        stepResult = Result::Failed;
+                        stepErrorMessage = srtpError.message;
+                    }
+                } else {
+                    stepResult = Result::Failed;
+                    stepErrorMessage = "Certificate hash doesn't match";
+                }
+            }
+        } else {
+            stepResult = Result::Failed;
+            stepErrorMessage = "Failure during DTLS handshake: " + get_openssl_error();
+        }
+
+        DtlsWorkerPool::addHandshakeTime(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start),
+            isOnWorker);
+
+        std::lock_guard lock(mutex);
+        result = stepResult;
+        errorMessage = std::move(stepErrorMessage);
+        remoteHashHex = std::move(stepHashHex);
+        srtpConnection = std::move(stepSrtpConnection);
+    }
+
+    // On a worker thread, keeps stepping while datagrams keep coming, then wakes up the network thread
+    static void stepOnWorker(const std::shared_ptr<DtlsHandshake>& handshake)
+    {
+        while (true) {
+            {
+                std::lock_guard lock(handshake->mutex);
+                if (handshake->isCancelled) {
+                    handshake->isBusy = false;
+                    return;
+                }
+            }
+
+            handshake->step(true);
+
+            std::lock_guard lock(handshake->mutex);
+            if (handshake->result != Result::InProgress || handshake->receiveQueue.empty()) {
+                handshake->isBusy = false;
+                break;
+            }
+        }
+
+        handshake->eventLoop->interrupt();
+    }
+};
+
 PeerCandidate::PeerCandidate(PeerCandidateListener* const listener,
                              Direction direction,
                              const std::shared_ptr<SdpOffer>& offer,
@@ -229,10 +378,14 @@ PeerCandidate::PeerCandidate(PeerCandidateListener* const listener,
     , mAnswer(answer)
     , mHost(host)
     , mEventLoop(eventLoop)
-    , mSocket(std::make_shared<Socket>(host.addr))
+    , mIsIceLite(offer->getConfig().enable_ice_lite)
+    , mSocket(create_candidate_socket(eventLoop, host, offer))
     , mIceAgent(std::make_shared<IceAgent>())
     , mIceMessageBuffer(std::make_unique<uint8_t[]>(kIceMessageBufferSize))
-    , mSendRtpHistory(std::make_shared<SendRtpHistory>())
+    , mSendRtpHistory(std::make_shared<SendRtpHistory>(
+          std::chrono::milliseconds(offer->getConfig().nack_history_millis),
+          offer->getConfig().nack_history_kbit_per_second,
+          offer->getConfig().enable_nack_protected_cache))
     , mUniqueId(++gNextUniqueId)
     , mExtensionSourceSimulcast(RtpExtensionSourceSimulcast::factory(answer->isVideoSimulcast()))
     , mExtensionSourceTWCC(RtpExtensionSourceTWCC::factory(offer, scheduler))
@@ -277,13 +430,20 @@ PeerCandidate::PeerCandidate(PeerCandidateListener* const listener,
 
     mEventLoop->registerSocket(mSocket, this);
 
-    mScheduler.submit(startDelay, __FILE__, __LINE__, [this] { startConnecting(); });
+    // After registering, the event loop may not support it
+    if (const auto& config = mOffer->getConfig(); config.enable_gro) {
+        if (mSocket->setGroEnabled(true, config.receive_buffer_size)) {
+            LOG(SRTC_LOG_V, "GRO is enabled");
+        }
+    }
+
+    mTaskStart = mScheduler.submit(startDelay, __FILE__, __LINE__, [this] { startConnecting(); });
 
     // Trim stun requests from time to time
     Task::cancelHelper(mTaskExpireStunRequests);
 
     mTaskExpireStunRequests =
-        mScheduler.submit(kExpireStunPeriod, __FILE__, __LINE__, [this] { forgetExpiredStunRequests(); });
+        mScheduler.submitPeriodic(kExpireStunPeriod, __FILE__, __LINE__, [this] { forgetExpiredStunRequests(); });
 }
 
 PeerCandidate::~PeerCandidate()
@@ -295,13 +455,38 @@ PeerCandidate::~PeerCandidate()
     freeDTLS();
 }
 
-void PeerCandidate::receiveFromSocket()
+const Host& PeerCandidate::getHost() const
+{
+    return mHost;
+}
+
+void PeerCandidate::startNow()
 {
-    auto list = mSocket->receive();
-    for (auto& item : list) {
-        mRawReceiveQueue.push_back(std::move(item));
+    if (mIsStartPending) {
+        LOG(SRTC_LOG_V, "Starting now instead of after the delay #%u", mUniqueId);
+        Task::cancelHelper(mTaskStart);
+        startConnecting();
     }
-    list.clear();
+}
+
+bool PeerCandidate::isStartPending() const
+{
+    return mIsStartPending;
+}
+
+void PeerCandidate::receiveFromSocket()
+{
+    mSocket->receive(mRawReceiveList);
+}
+
+CustomLogger* PeerCandidate::getCustomLogger() const
+{
+    return mListener->getCustomLogger();
+}
+
+void PeerCandidate::flushSocket()
+{
+    mSocket->flush();
 }
 
 void PeerCandidate::addSendFrame(FrameToSend&& frame)
@@ -549,6 +734,15 @@ void PeerCandidate::updatePublishConnectionStats(PublishConnectionStats& stats)
         stats.rtt_ms = rtt_ms.value();
     }
 
+    stats.packets_per_send_call = mSocket->getPacketsPerSendCall();
+    stats.segments_per_gso_send = mSocket->getSegmentsPerGsoSend();
+
+    const auto historyStats = mSendRtpHistory->getStats();
+    stats.nack_history_capacity = historyStats.capacity;
+    stats.nack_history_evicted_count = static_cast<size_t>(historyStats.evicted_count);
+    stats.nack_history_miss_count = static_cast<size_t>(historyStats.missed_count);
+    stats.nack_history_protected_count = static_cast<size_t>(historyStats.protected_found_count);
+
     if (mExtensionSourceTWCC) {
         mExtensionSourceTWCC->updatePublishConnectionStats(stats);
     } else {
@@ -577,6 +771,8 @@ void PeerCandidate::updateSubscribeConnectionStats(SubscribeConnectionStats& sta
     if (rtt_ms.has_value()) {
         stats.rtt_ms = rtt_ms.value();
     }
+
+    stats.packets_per_send_call = mSocket->getPacketsPerSendCall();
 }
 
 std::optional<float> PeerCandidate::getIceRtt() const
@@ -647,12 +843,15 @@ void PeerCandidate::sendDataChannelMessage(DataChannelMessage&& message)
     }
 }
 
-[[nodiscard]] int PeerCandidate::getTimeoutMillis(int defaultValue) const
+void PeerCandidate::updateDeadline(Deadline& deadline) const
 {
     if (mSendPacer) {
-        return mSendPacer->getTimeoutMillis(defaultValue);
+        mSendPacer->updateDeadline(deadline);
+    }
+    if (mSocket->hasPendingReceive()) {
+        // Don't sleep, see run()
+        deadline.update(deadline.getNow());
     }
-    return defaultValue;
 }
 
 void PeerCandidate::run()
@@ -680,7 +879,7 @@ void PeerCandidate::run()
 
     // Frames
     while (!mFrameSendQueue.empty()) {
-        const auto item = std::move(mFrameSendQueue.front());
+        auto item = std::move(mFrameSendQueue.front());
         mFrameSendQueue.erase(mFrameSendQueue.begin());
 
         if (!item.csd.empty()) {
@@ -714,9 +913,13 @@ void PeerCandidate::run()
                 mExtensionSourceAbsCaptureTime->prepare(item.track, item.abs_capture_time_ntp);
             }
 
-            // Packetize
-            const auto packetList = item.packetizer->generate(
-                mExtensionSourceList, mSrtpConnection->getMediaProtectionOverhead(), item.pts_usec, item.buf);
+            // Packetize, the packets refer to the frame's data instead of having copies
+            const auto frame = std::make_shared<const ByteBuffer>(std::move(item.buf));
+            const auto packetList = item.packetizer->generate(mRtpPacketPool,
+                                                              mExtensionSourceList,
+                                                              mSrtpConnection->getMediaProtectionOverhead(),
+                                                              item.pts_usec,
+                                                              frame);
 
             // Flush any packets from the same track which we haven't sent yet
             mSendPacer->flush(item.track);
@@ -743,51 +946,57 @@ void PeerCandidate::run()
         }
     }
 
+    // Coalesced datagrams which didn't fit into the receive ring last time, the event loop won't report them
+    if (mRawReceiveList.empty() && mSocket->hasPendingReceive()) {
+        receiveFromSocket();
+    }
+
     // Receive
-    while (!mRawReceiveQueue.empty()) {
-        Socket::ReceivedData data = std::move(mRawReceiveQueue.front());
-        mRawReceiveQueue.erase(mRawReceiveQueue.begin());
+    for (const auto ptr : mRawReceiveList) {
+        auto& data = *ptr;
 
         if (is_stun_message(data.buf)) {
             LOG(SRTC_LOG_V, "Received STUN message %zd, %d, #%u", data.buf.size(), data.buf.front(), mUniqueId);
             onReceivedStunMessage(data);
         } else if (mDtlsSsl && is_dtls_message(data.buf)) {
             LOG(SRTC_LOG_V, "Received DTLS message %zd, %d, #%u", data.buf.size(), data.buf.front(), mUniqueId);
-            onReceivedDtlsMessage(std::move(data.buf));
+            onReceivedDtlsMessage(data.buf.copy());
         } else if (is_rtc_message(data.buf)) {
             LOG(SRTC_LOG_V, "Received RTP/RTCP message size = %zd, id = %d", data.buf.size(), data.buf.front());
-            onReceivedRtcMessage(std::move(data.buf));
+            onReceivedRtcMessage(data.buf);
         } else {
             LOG(SRTC_LOG_V, "Received unknown message %zd, %d", data.buf.size(), data.buf.front());
         }
     }
 
+    // Before the slots are released
+    onReceivedMediaBatch();
+
+    mSocket->release(mRawReceiveList.size());
+    mRawReceiveList.clear();
+
     if (mDtlsState == DtlsState::Activating && mDtlsSsl == nullptr) {
         LOG(SRTC_LOG_V, "Preparing for the DTLS handshake");
 
+        // Shared by the connections using the same certificate and role, already set up with the certificate,
+        // private key and SRTP profiles
         const auto cert = mOffer->getCertificate();
-        mDtlsCtx = SSL_CTX_new(mAnswer->isSetupActive() ? DTLS_server_method() : DTLS_client_method());
-
-        SSL_CTX_use_certificate(mDtlsCtx, cert->getCertificate());
-        SSL_CTX_use_PrivateKey(mDtlsCtx, cert->getPrivateKey());
+        const auto ctx = CertificatePool::getDtlsContext(cert, mAnswer->isSetupActive());
 
-        if (!SSL_CTX_check_private_key(mDtlsCtx)) {
-            LOG(SRTC_LOG_V, "ERROR: invalid private key");
+        if (ctx == nullptr) {
+            LOG(SRTC_LOG_V, "ERROR: cannot set up the DTLS context");
             mDtlsState = DtlsState::Failed;
-            emitOnFailedToConnect({ Error::Code::InvalidData, "Invalid private key" });
+            emitOnFailedToConnect({ Error::Code::InvalidData, "Cannot set up the DTLS context" });
         } else {
-            SSL_CTX_set_verify(mDtlsCtx, SSL_VERIFY_PEER, verify_callback);
-
-            SSL_CTX_set_min_proto_version(mDtlsCtx, DTLS1_VERSION);
-            SSL_CTX_set_max_proto_version(mDtlsCtx, DTLS1_2_VERSION);
-            SSL_CTX_set_read_ahead(mDtlsCtx, 1);
+            mDtlsHandshake = std::make_shared<DtlsHandshake>(
+                ctx, mAnswer->getCertificateHash().getBin(), mAnswer->isSetupActive(), mEventLoop);
+            mDtlsSsl = mDtlsHandshake->ssl;
 
-            mDtlsSsl = SSL_new(mDtlsCtx);
+            emitOnConnectEvent(ConnectTimelineEvent::Type::DtlsStarted);
 
-            mDtlsBio = BIO_new_dgram(this);
+            mDtlsBio = BIO_new_dgram(mDtlsHandshake.get());
             SSL_set_bio(mDtlsSsl, mDtlsBio, mDtlsBio);
 
-            SSL_set_tlsext_use_srtp(mDtlsSsl, SrtpConnection::kSrtpCipherList);
             SSL_set_connect_state(mDtlsSsl);
 
             if (mAnswer->isSetupActive()) {
@@ -798,6 +1007,9 @@ void PeerCandidate::run()
                 SSL_do_handshake(mDtlsSsl);
             }
         }
+    } else if (mDtlsState == DtlsState::Activating) {
+        // A handshake step may have completed on a worker thread
+        onDtlsHandshakeStep();
     }
 
     // TWCC
@@ -814,8 +1026,11 @@ void PeerCandidate::run()
 
 void PeerCandidate::startConnecting()
 {
+    mIsStartPending = false;
+
     // Notify the listener
     emitOnConnecting();
+    emitOnConnectEvent(ConnectTimelineEvent::Type::CandidateStarted);
 
     // Clean up some things
     Task::cancelHelper(mTaskConnectionLostTimeout);
@@ -827,10 +1042,18 @@ void PeerCandidate::startConnecting()
     // Connecting should take a limited amount of time
     Task::cancelHelper(mTaskConnectTimeout);
 
+    mConnectStartTime = std::chrono::steady_clock::now();
+
     mTaskConnectTimeout = mScheduler.submit(kConnectTimeout, __FILE__, __LINE__, [this] {
         emitOnFailedToConnect({ Error::Code::InvalidData, "Connect timeout" });
     });
 
+    if (mIsIceLite) {
+        // The peer opens the conversation, see onReceivedStunMessage
+        LOG(SRTC_LOG_V, "Waiting for ICE-lite checks #%u", mUniqueId);
+        return;
+    }
+
     // Open the conversation by sending a STUN binding request
     sendStunBindingRequest(0);
 }
@@ -843,16 +1066,18 @@ void PeerCandidate::addSendRaw(ByteBuffer&& buf)
 
 void PeerCandidate::flushSendRaw()
 {
+    if (mDtlsHandshake) {
+        // Written by OpenSSL, possibly on a worker thread
+        std::lock_guard lock(mDtlsHandshake->mutex);
+        mRawSendQueue.splice(mRawSendQueue.end(), mDtlsHandshake->sendQueue);
+    }
+
     while (!mRawSendQueue.empty()) {
         const auto buf = std::move(mRawSendQueue.front());
         mRawSendQueue.erase(mRawSendQueue.begin());
 
-        const auto w = mSocket->send(buf);
-        if (w < 0) {
-            LOG(SRTC_LOG_E, "Error sending %zd raw bytes", buf.size());
-        } else {
-            LOG(SRTC_LOG_V, "Sent %zd raw bytes", w);
-        }
+        mSocket->queue(buf);
+        LOG(SRTC_LOG_V, "Queued %zu raw bytes", buf.size());
     }
 }
 
@@ -875,6 +1100,11 @@ void PeerCandidate::onReceivedStunMessage(const Socket::ReceivedData& data)
         const auto icePassword = mOffer->getIcePassword();
 
         if (mIceAgent->verifyRequestMessage(&incomingMessage, iceUserName, icePassword)) {
+            if (mSocket->isEndpoint() && !mIsIceLite) {
+                // A shared socket only routes by ufrag, now we know the request is really from our peer
+                mEventLoop->getSharedSocket()->addEndpointAddress(mSocket, data.addr);
+            }
+
             const auto response = make_stun_message_binding_response(mIceAgent,
                                                                      mIceMessageBuffer.get(),
                                                                      kIceMessageBufferSize,
@@ -882,7 +1112,14 @@ void PeerCandidate::onReceivedStunMessage(const Socket::ReceivedData& data)
                                                                      incomingMessage,
                                                                      data.addr,
                                                                      data.addr_len);
-            addSendRaw({ mIceMessageBuffer.get(), stun::stun_message_length(&response) });
+            if (mIsIceLite && !mIsNominated) {
+                uint16_t len = 0;
+                const auto useCandidate =
+                    stun::stun_message_find(&incomingMessage, stun::STUN_ATTRIBUTE_USE_CANDIDATE, &len);
+                onReceivedIceLiteCheck(data, stun::stun_message_length(&response), useCandidate != nullptr);
+            } else {
+                addSendRaw({ mIceMessageBuffer.get(), stun::stun_message_length(&response) });
+            }
         } else {
             LOG(SRTC_LOG_E, "STUN request verification failed, ignoring");
         }
@@ -916,6 +1153,7 @@ void PeerCandidate::onReceivedStunMessage(const Socket::ReceivedData& data)
 
                     mSentUseCandidate = true;
 
+                    emitOnConnectEvent(ConnectTimelineEvent::Type::StunResponseReceived, rtt);
                     emitOnIceConnected();
                     sendStunBindingResponse(0);
 
@@ -928,135 +1166,185 @@ void PeerCandidate::onReceivedStunMessage(const Socket::ReceivedData& data)
     }
 }
 
+void PeerCandidate::onReceivedIceLiteCheck(const Socket::ReceivedData& data, size_t responseSize, bool isUseCandidate)
+{
+    // Verified, so the peer's datagrams from this address are routed to us from now on
+    if (!mEventLoop->getSharedSocket()->addEndpointAddress(mSocket, data.addr)) {
+        LOG(SRTC_LOG_W, "ICE-lite check from %s which belongs to another session", to_string(data.addr).c_str());
+        return;
+    }
+
+    // https://datatracker.ietf.org/doc/html/rfc8445#section-7.3, the peer may be checking several of its
+    // candidates, so the response is sent right away before the socket's address changes again
+    mSocket->setAddr(data.addr);
+    mSocket->queue(mIceMessageBuffer.get(), responseSize);
+    mSocket->flush();
+
+    emitOnConnectEvent(ConnectTimelineEvent::Type::StunRequestReceived);
+
+    if (!isUseCandidate) {
+        return;
+    }
+
+    // The peer has nominated this address, we send to it from now on
+    LOG(SRTC_LOG_V, "ICE-lite check with use candidate from %s #%u", to_string(data.addr).c_str(), mUniqueId);
+
+    mIsNominated = true;
+
+    emitOnIceConnected();
+
+    mDtlsState = DtlsState::Activating;
+}
+
 void PeerCandidate::onReceivedDtlsMessage(ByteBuffer&& buf)
 {
     Task::cancelHelper(mTaskSendStunConnectRequest);
     Task::cancelHelper(mTaskSendStunConnectResponse);
 
-    mDtlsReceiveQueue.push_back(std::move(buf));
+    {
+        std::lock_guard lock(mDtlsHandshake->mutex);
+        mDtlsHandshake->receiveQueue.push_back(std::move(buf));
+    }
 
     // Try the handshake
     if (mDtlsState == DtlsState::Activating) {
-        const auto r1 = SSL_do_handshake(mDtlsSsl);
-        const auto err = SSL_get_error(mDtlsSsl, r1);
-        LOG(SRTC_LOG_V, "DTLS handshake: %d, %d", r1, err);
+        runDtlsHandshake();
+    } else if (mDtlsState == DtlsState::Completed) {
+        onReceivedDtlsData();
+    }
+}
 
-        if (err == SSL_ERROR_WANT_READ) {
-            LOG(SRTC_LOG_V, "Still in progress");
-        } else if (r1 == 1 && err == 0) {
-            const auto cert = SSL_get_peer_certificate(mDtlsSsl);
-            if (cert == nullptr) {
-                // Error, no certificate
-                LOG(SRTC_LOG_E, "There is no DTLS server certificate");
-                mDtlsState = DtlsState::Failed;
+void PeerCandidate::onReceivedDtlsData()
+{
+    uint8_t tmp[4096];
+    const auto r = SSL_read(mDtlsSsl, tmp, sizeof(tmp));
 
-                Task::cancelHelper(mTaskConnectTimeout);
-                emitOnFailedToConnect({ Error::Code::InvalidData, "There is no DTLS server certificate" });
-            } else {
-                uint8_t fpBuf[32] = {};
-                unsigned int fpSize = {};
+    if (r > 0) {
+        if (mSctpSession) {
+            mSctpSession->onReceiveData({ tmp, static_cast<size_t>(r) });
+        }
+    } else {
+        if ((SSL_get_shutdown(mDtlsSsl) & SSL_RECEIVED_SHUTDOWN) != 0) {
+            LOG(SRTC_LOG_V, "Received DTLS close_notify, peer disconnected gracefully");
+            emitOnDtlsDisconnected(Error::OK);
+        } else {
+            const auto err = SSL_get_error(mDtlsSsl, r);
+            if (err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE) {
+                LOG(SRTC_LOG_V, "DTLS connection lost, ssl error = %d", err);
+                emitOnDtlsDisconnected({ Error::Code::InvalidData, "DTLS connection lost unexpectedly" });
+            }
+        }
+    }
+}
 
-                const auto digest = EVP_get_digestbyname("sha256");
-                X509_digest(cert, digest, fpBuf, &fpSize);
-                X509_free(cert);
+void PeerCandidate::runDtlsHandshake()
+{
+    {
+        std::lock_guard lock(mDtlsHandshake->mutex);
+        if (mDtlsHandshake->isBusy) {
+            // The worker picks up the new datagram when its current step is done
+            return;
+        }
+        mDtlsHandshake->isBusy = true;
+    }
 
-                std::string hex = bin_to_hex(fpBuf, fpSize);
-                LOG(SRTC_LOG_V, "Remote certificate sha-256: %s", hex.c_str());
+    const auto handshake = mDtlsHandshake;
+    if (DtlsWorkerPool::post([handshake] { DtlsHandshake::stepOnWorker(handshake); })) {
+        return;
+    }
 
-                const auto expectedHash = mAnswer->getCertificateHash();
-                const auto actualHashBin = ByteBuffer{ fpBuf, fpSize };
+    // There are no worker threads
+    handshake->step(false);
 
-                if (expectedHash.getBin() == actualHashBin) {
-                    const auto [srtpConnection, srtpError] = SrtpConnection::create(mDtlsSsl, mAnswer->isSetupActive());
+    {
+        std::lock_guard lock(handshake->mutex);
+        handshake->isBusy = false;
+    }
 
-                    if (srtpError.isOk()) {
-                        mSrtpConnection = srtpConnection;
-                        mSendPacer =
-                            std::make_shared<SendPacer>(mOffer->getConfig(),
-                                                        mSrtpConnection,
-                                                        mSocket,
-                                                        mSendRtpHistory,
-                                                        mExtensionSourceTWCC,
-                                                        [this]() { mLastSendTime = std::chrono::steady_clock::now(); });
-                        mDtlsState = DtlsState::Completed;
-
-                        const auto addr = to_string(mHost.addr);
-                        const auto cipher = SSL_get_cipher(mDtlsSsl);
-                        const auto profile = SSL_get_selected_srtp_profile(mDtlsSsl);
-                        LOG(SRTC_LOG_V,
-                            "Connected to %s with cipher %s, profile %s, ice rtt = %.2f ms",
-                            addr.c_str(),
-                            cipher,
-                            profile->name,
-                            mIceRttFilter.value());
+    onDtlsHandshakeStep();
+}
 
-                        onReceivedFromRemote();
+void PeerCandidate::onDtlsHandshakeStep()
+{
+    auto result = DtlsHandshake::Result::InProgress;
+    std::string errorMessage;
+    std::string remoteHashHex;
+    std::shared_ptr<SrtpConnection> srtpConnection;
 
-                        if (mSctpSession) {
-                            mSctpSession->start();
-                        }
-                    } else {
-                        // Error, failed to initialize SRTP
-                        LOG(SRTC_LOG_E,
-                            "Failed to initialize SRTP: %d, %s",
-                            static_cast<int>(srtpError.code),
-                            srtpError.message.c_str());
-                        mDtlsState = DtlsState::Failed;
-
-                        Task::cancelHelper(mTaskConnectTimeout);
-                        emitOnFailedToConnect(srtpError);
-                    }
-                } else {
-                    // Error, certificate hash does not match
-                    LOG(SRTC_LOG_E, "Server cert doesn't match the fingerprint");
-                    mDtlsState = DtlsState::Failed;
+    {
+        std::lock_guard lock(mDtlsHandshake->mutex);
+        if (mDtlsHandshake->isBusy || mDtlsHandshake->result == DtlsHandshake::Result::InProgress) {
+            return;
+        }
 
-                    Task::cancelHelper(mTaskConnectTimeout);
-                    emitOnFailedToConnect({ Error::Code::InvalidData, "Certificate hash doesn't match" });
-                }
-            }
-        } else {
-            // Error during DTLS handshake
-            const auto opensslError = get_openssl_error();
-            LOG(SRTC_LOG_E, "Failed during DTLS handshake: %s", opensslError.c_str());
-            mDtlsState = DtlsState::Failed;
+        result = mDtlsHandshake->result;
+        errorMessage = mDtlsHandshake->errorMessage;
+        remoteHashHex = mDtlsHandshake->remoteHashHex;
+        srtpConnection = std::move(mDtlsHandshake->srtpConnection);
+    }
 
-            Task::cancelHelper(mTaskConnectTimeout);
-            emitOnFailedToConnect({ Error::Code::InvalidData, "Failure during DTLS handshake: " + opensslError });
-        }
+    if (!remoteHashHex.empty()) {
+        LOG(SRTC_LOG_V, "Remote certificate sha-256: %s", remoteHashHex.c_str());
+    }
+
+    if (result == DtlsHandshake::Result::Completed) {
+        mSrtpConnection = srtpConnection;
+        mSendPacer = std::make_shared<SendPacer>(mOffer->getConfig(),
+                                                 mSrtpConnection,
+                                                 mSocket,
+                                                 mSendRtpHistory,
+                                                 mExtensionSourceTWCC,
+                                                 [this]() { mLastSendTime = std::chrono::steady_clock::now(); });
+        mDtlsState = DtlsState::Completed;
+        emitOnConnectEvent(ConnectTimelineEvent::Type::DtlsCompleted);
+
+        const auto now = std::chrono::steady_clock::now();
+        DtlsWorkerPool::addSetupLatency(std::chrono::duration_cast<std::chrono::microseconds>(now - mConnectStartTime));
 
-        if (mDtlsState == DtlsState::Failed) {
-            freeDTLS();
+        const auto addr = to_string(mHost.addr);
+        const auto cipher = SSL_get_cipher(mDtlsSsl);
+        const auto profile = SSL_get_selected_srtp_profile(mDtlsSsl);
+        LOG(SRTC_LOG_V,
+            "Connected to %s with cipher %s, profile %s, ice rtt = %.2f ms",
+            addr.c_str(),
+            cipher,
+            profile->name,
+            mIceRttFilter.value());
+
+        onReceivedFromRemote();
+
+        if (mSctpSession) {
+            mSctpSession->start();
         }
-    } else if (mDtlsState == DtlsState::Completed) {
-        uint8_t tmp[4096];
-        const auto r = SSL_read(mDtlsSsl, tmp, sizeof(tmp));
 
-        if (r > 0) {
-            if (mSctpSession) {
-                mSctpSession->onReceiveData({ tmp, static_cast<size_t>(r) });
-            }
-        } else {
-            if ((SSL_get_shutdown(mDtlsSsl) & SSL_RECEIVED_SHUTDOWN) != 0) {
-                LOG(SRTC_LOG_V, "Received DTLS close_notify, peer disconnected gracefully");
-                emitOnDtlsDisconnected(Error::OK);
-            } else {
-                const auto err = SSL_get_error(mDtlsSsl, r);
-                if (err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE) {
-                    LOG(SRTC_LOG_V, "DTLS connection lost, ssl error = %d", err);
-                    emitOnDtlsDisconnected({ Error::Code::InvalidData, "DTLS connection lost unexpectedly" });
-                }
-            }
+        // Datagrams which arrived while the last step was running on a worker
+        size_t pendingCount;
+        {
+            std::lock_guard lock(mDtlsHandshake->mutex);
+            pendingCount = mDtlsHandshake->receiveQueue.size();
+        }
+        for (; pendingCount > 0 && mDtlsSsl != nullptr; pendingCount -= 1) {
+            onReceivedDtlsData();
         }
+    } else {
+        LOG(SRTC_LOG_E, "DTLS handshake failed: %s", errorMessage.c_str());
+        mDtlsState = DtlsState::Failed;
+
+        Task::cancelHelper(mTaskConnectTimeout);
+        emitOnFailedToConnect({ Error::Code::InvalidData, errorMessage });
+
+        freeDTLS();
     }
 }
 
-void PeerCandidate::onReceivedRtcMessage(ByteBuffer&& buf)
+void PeerCandidate::onReceivedRtcMessage(ByteBuffer& buf)
 {
-    ByteBuffer output;
-
     if (mSrtpConnection) {
         if (is_rtcp_message(buf)) {
+            // In the order received
+            onReceivedMediaBatch();
+
+            ByteBuffer output;
             if (mSrtpConnection->unprotectReceiveControl(buf, output)) {
                 LOG(SRTC_LOG_V, "RTCP unprotect: size = %zd", output.size());
 
@@ -1066,23 +1354,47 @@ void PeerCandidate::onReceivedRtcMessage(ByteBuffer&& buf)
                 }
             }
         } else {
-            if (mSrtpConnection->unprotectReceiveMedia(buf, output)) {
-                LOG(SRTC_LOG_V, "RTP unprotect: size = %zd", output.size());
+            // Unprotected together with the RTP packets next to it
+            mReceiveMediaList.push_back(&buf);
+            mReceiveMediaSizeList.push_back(buf.size());
+        }
+    }
+}
 
-                if (const auto track = findReceiveTrack(output)) {
-                    const auto packet = RtpPacket::fromUdpPacket(track, output);
-                    if (packet) {
-                        const auto stats = track->getStats();
+void PeerCandidate::onReceivedMediaBatch()
+{
+    if (mReceiveMediaList.empty()) {
+        return;
+    }
 
-                        stats->incrementReceivedPackets(1);
-                        stats->incrementReceivedBytes(buf.size());
+    // Decrypted in the socket's receive slots, and parsed where they are
+    if (mSrtpConnection) {
+        mSrtpConnection->unprotectReceiveMedia(mReceiveMediaList.data(), mReceiveMediaList.size());
 
-                        onReceivedMediaPacket(packet);
-                    }
+        for (size_t i = 0; i < mReceiveMediaList.size(); i += 1) {
+            auto& buf = *mReceiveMediaList[i];
+            if (buf.empty()) {
+                continue;
+            }
+
+            LOG(SRTC_LOG_V, "RTP unprotect: size = %zd", buf.size());
+
+            if (const auto track = findReceiveTrack(buf)) {
+                RtpPacketView packet;
+                if (RtpPacketView::parse(buf.data(), buf.size(), packet)) {
+                    const auto stats = track->getStats();
+
+                    stats->incrementReceivedPackets(1);
+                    stats->incrementReceivedBytes(mReceiveMediaSizeList[i]);
+
+                    onReceivedMediaPacket(track, packet);
                 }
             }
         }
     }
+
+    mReceiveMediaList.clear();
+    mReceiveMediaSizeList.clear();
 }
 
 void PeerCandidate::onReceivedControlPacket(const std::shared_ptr<RtcpPacket>& packet)
@@ -1173,25 +1485,23 @@ void PeerCandidate::onReceivedControlPacket(const std::shared_ptr<RtcpPacket>& p
     }
 }
 
-void PeerCandidate::onReceivedMediaPacket(const std::shared_ptr<RtpPacket>& packet)
+void PeerCandidate::onReceivedMediaPacket(const std::shared_ptr<Track>& track, const RtpPacketView& packet)
 {
     onReceivedFromRemote();
 
-    const auto track = packet->getTrack();
-
     LOG(SRTC_LOG_V,
         "RTP media packet: media = %s, ssrc = %12" PRIu32 ", seq = %5u, pt = %u, size = %zu",
         to_string(track->getMediaType()).c_str(),
-        packet->getSSRC(),
-        packet->getSequence(),
-        packet->getPayloadId(),
-        packet->getPayloadSize());
+        packet.ssrc,
+        packet.sequence,
+        packet.payloadId,
+        packet.payloadSize);
 
     if (mResponderTWCC) {
-        mResponderTWCC->onMediaPacket(packet);
+        mResponderTWCC->onMediaPacket(track, packet);
     }
 
-    mListener->onCandidateReceivedMediaPacket(this, packet);
+    mListener->onCandidateReceivedMediaPacket(this, track, packet);
 }
 
 void PeerCandidate::onReceivedControlMessage_SR(uint32_t ssrc, ByteReader& rtcpReader)
@@ -1280,42 +1590,67 @@ void PeerCandidate::onReceivedControlMessage_NACK(uint32_t ssrc, ByteReader& rtc
 
             // Record in TWCC
             if (packet && mExtensionSourceTWCC) {
-                mExtensionSourceTWCC->onPacketWasNacked(packet);
+                mExtensionSourceTWCC->onPacketWasNacked(*packet);
             }
 
             if (packet && mSrtpConnection) {
-                // Generate
                 const auto track = packet->getTrack();
 
-                RtpPacket::Output packetData;
+                // Without RTX the packet goes out the same as the first time, it may have been kept protected
+                if (track->getRtxPayloadId() == 0) {
+                    if (const auto cached = mSendRtpHistory->findProtected(ssrc, seq)) {
+                        mSocket->queue(*cached);
+                        LOG(SRTC_LOG_V,
+                            "Re-sent protected RTP packet with SSRC = %u, SEQ = %u, size = %zu",
+                            packet->getSSRC(),
+                            packet->getSequence(),
+                            cached->size());
+
+                        // Keep stats
+                        const auto stats = track->getStats();
+                        stats->incrementSentPackets(1);
+                        stats->incrementSentBytes(cached->size());
+                        continue;
+                    }
+                }
+
+                // Generate
+                uint32_t rollover;
                 if (track->getRtxPayloadId() > 0) {
                     RtpExtension extension = packet->getExtension().copy();
 
                     if (track->isSimulcast() && mExtensionSourceSimulcast) {
                         auto builder = RtpExtensionBuilder::from(extension);
-                        mExtensionSourceSimulcast->updateForRtx(builder, track);
+                        mExtensionSourceSimulcast->updateForRtx(builder, *track);
                         extension = builder.build();
                     }
 
-                    packetData = packet->generateRtx(extension);
+                    rollover = packet->generateRtx(extension, mRtpHeaderBuf, mRtpBodyGather);
                 } else {
-                    packetData = packet->generate();
+                    rollover = packet->generate(mRtpHeaderBuf, mRtpBodyGather);
                 }
 
-                if (mSrtpConnection->protectSendMedia(packetData.buf, packetData.rollover, mProtectedBuf)) {
+                // Protect into the socket's send queue
+                const auto generatedSize = mRtpHeaderBuf.size() + mRtpBodyGather.totalSize();
+                const auto output =
+                    mSocket->reserveQueued(generatedSize + mSrtpConnection->getMediaProtectionOverhead());
+
+                size_t protectedSize = 0;
+                if (output &&
+                    mSrtpConnection->protectSendMedia(mRtpHeaderBuf, mRtpBodyGather, rollover, output, protectedSize)) {
                     // And send
-                    const auto sentSize = mSocket->send(mProtectedBuf.data(), mProtectedBuf.size());
+                    mSocket->commitQueued(protectedSize);
                     LOG(SRTC_LOG_V,
                         "Re-sent RTP packet with SSRC = %u, SEQ = %u, size = %zu, rtx = %d",
                         packet->getSSRC(),
                         packet->getSequence(),
-                        sentSize,
+                        protectedSize,
                         packet->getTrack()->getRtxPayloadId() > 0);
 
                     // Keep stats
                     const auto stats = packet->getTrack()->getStats();
                     stats->incrementSentPackets(1);
-                    stats->incrementSentBytes(mProtectedBuf.size());
+                    stats->incrementSentBytes(protectedSize);
                 } else {
                     LOG(SRTC_LOG_E, "Error protecting packet for re-sending");
                 }
@@ -1389,9 +1724,6 @@ void PeerCandidate::onReceivedControlMessage_DLRR([[maybe_unused]] uint32_t ssrc
 void PeerCandidate::forgetExpiredStunRequests()
 {
     mIceAgent->forgetExpiredTransactions(kExpireStunTimeout);
-
-    mTaskExpireStunRequests =
-        mScheduler.submit(kExpireStunPeriod, __FILE__, __LINE__, [this] { forgetExpiredStunRequests(); });
 }
 
 void PeerCandidate::sendRtcpPacket(const std::shared_ptr<Track>& track, const std::shared_ptr<RtcpPacket>& packet)
@@ -1407,8 +1739,8 @@ void PeerCandidate::sendRtcpPacket(const std::shared_ptr<RtcpPacketSource>& sour
         const auto packetData = packet->generate();
 
         if (mSrtpConnection->protectSendControl(packetData, source->getNextSequence(), mProtectedBuf)) {
-            const auto w = mSocket->send(mProtectedBuf.data(), mProtectedBuf.size());
-            LOG(SRTC_LOG_V, "Sent %zu bytes of RTCP", w);
+            mSocket->queue(mProtectedBuf);
+            LOG(SRTC_LOG_V, "Sent %zu bytes of RTCP", mProtectedBuf.size());
         }
     }
 }
@@ -1420,8 +1752,8 @@ void PeerCandidate::sendRtcpPacket(const std::shared_ptr<RtcpPacketSource>& sour
         const auto packetData = packet->generate();
 
         if (mSrtpConnection->protectSendControl(packetData, source->getNextSequence(), mProtectedBuf)) {
-            const auto w = mSocket->send(mProtectedBuf.data(), mProtectedBuf.size());
-            LOG(SRTC_LOG_V, "Sent %zu bytes of RTCP", w);
+            mSocket->queue(mProtectedBuf);
+            LOG(SRTC_LOG_V, "Sent %zu bytes of RTCP", mProtectedBuf.size());
         }
     }
 }
@@ -1462,7 +1794,7 @@ std::shared_ptr<Track> PeerCandidate::findReceiveTrack(ByteBuffer& packet) const
 // Custom BIO for DGRAM
 
 struct dgram_data {
-    PeerCandidate* pc;
+    DtlsHandshake* handshake;
 };
 
 int PeerCandidate::dgram_read(BIO* b, char* out, int outl)
@@ -1476,13 +1808,20 @@ int PeerCandidate::dgram_read(BIO* b, char* out, int outl)
     auto ptr = BIO_get_data(b);
     auto data = reinterpret_cast<dgram_data*>(ptr);
 
-    if (data->pc->mDtlsReceiveQueue.empty()) {
-        BIO_set_retry_read(b);
-        return -1;
-    }
+    ByteBuffer item;
+
+    {
+        std::lock_guard lock(data->handshake->mutex);
 
-    const auto item = std::move(data->pc->mDtlsReceiveQueue.front());
-    data->pc->mDtlsReceiveQueue.erase(data->pc->mDtlsReceiveQueue.begin());
+        auto& queue = data->handshake->receiveQueue;
+        if (queue.empty()) {
+            BIO_set_retry_read(b);
+            return -1;
+        }
+
+        item = std::move(queue.front());
+        queue.erase(queue.begin());
+    }
 
     const auto ret = std::min(static_cast<int>(item.size()), outl);
     std::memcpy(out, item.data(), static_cast<size_t>(ret));
@@ -1499,7 +1838,13 @@ int PeerCandidate::dgram_write(BIO* b, const char* in, int inl)
     auto ptr = BIO_get_data(b);
     auto data = reinterpret_cast<dgram_data*>(ptr);
 
-    data->pc->addSendRaw({ reinterpret_cast<const uint8_t*>(in), static_cast<size_t>(inl) });
+    {
+        std::lock_guard lock(data->handshake->mutex);
+        data->handshake->sendQueue.emplace_back(reinterpret_cast<const uint8_t*>(in), static_cast<size_t>(inl));
+    }
+
+    // The network thread sends it, we can be on a worker
+    data->handshake->eventLoop->interrupt();
 
     return inl;
 }
@@ -1536,7 +1881,7 @@ int PeerCandidate::dgram_free(BIO* b)
 std::once_flag PeerCandidate::dgram_once;
 BIO_METHOD* PeerCandidate::dgram_method = nullptr;
 
-BIO* PeerCandidate::BIO_new_dgram(PeerCandidate* pc)
+BIO* PeerCandidate::BIO_new_dgram(DtlsHandshake* handshake)
 {
     std::call_once(dgram_once, [] {
         dgram_method = BIO_meth_new(BIO_TYPE_DGRAM, "dgram");
@@ -1554,29 +1899,34 @@ BIO* PeerCandidate::BIO_new_dgram(PeerCandidate* pc)
     BIO_set_init(b, 1);
     BIO_set_shutdown(b, 0);
 
-    const auto ptr = new dgram_data{ pc };
+    const auto ptr = new dgram_data{ handshake };
     BIO_set_data(b, ptr);
     return b;
 }
 
 void PeerCandidate::freeDTLS()
 {
-    if (mDtlsSsl) {
-        SSL_shutdown(mDtlsSsl);
-        SSL_free(mDtlsSsl);
-        mDtlsSsl = nullptr;
-    }
+    if (mDtlsHandshake) {
+        bool isBusy;
+        {
+            std::lock_guard lock(mDtlsHandshake->mutex);
+            isBusy = mDtlsHandshake->isBusy;
+            mDtlsHandshake->isCancelled = true;
+        }
 
-    if (mDtlsCtx) {
-        SSL_CTX_free(mDtlsCtx);
-        mDtlsCtx = nullptr;
+        // If a worker has the SSL object, it frees it when it's done with its step
+        if (!isBusy) {
+            SSL_shutdown(mDtlsSsl);
+        }
     }
 
-    mDtlsReceiveQueue.clear();
-    mDtlsBio = nullptr;
-
-    // Flush the send queue to send the DTLS_close message
+    // Flush the send queue to send the DTLS_close message, right away since we may be going away
     flushSendRaw();
+    mSocket->flush();
+
+    mDtlsHandshake.reset();
+    mDtlsSsl = nullptr;
+    mDtlsBio = nullptr;
 }
 
 // RTT
@@ -1624,9 +1974,15 @@ void PeerCandidate::emitOnDtlsDisconnected(const Error& error)
 
 void PeerCandidate::emitOnFailedToConnect(const Error& error)
 {
+    emitOnConnectEvent(ConnectTimelineEvent::Type::CandidateFailed);
     mListener->onCandidateFailedToConnect(this, error);
 }
 
+void PeerCandidate::emitOnConnectEvent(ConnectTimelineEvent::Type type, float rttMs)
+{
+    mListener->onCandidateConnectEvent(this, type, rttMs);
+}
+
 void PeerCandidate::onReceivedFromRemote()
 {
     mLastReceiveTime = std::chrono::steady_clock::now();
@@ -1649,7 +2005,9 @@ void PeerCandidate::sendStunBindingRequest(unsigned int iteration)
         mIceAgent, mIceMessageBuffer.get(), kIceMessageBufferSize, mOffer, mAnswer, false);
     addSendRaw({ mIceMessageBuffer.get(), stun_message_length(&iceMessage) });
 
-    mTaskSendStunConnectRequest = mScheduler.submit(kConnectRepeatPeriod + (iteration + 1) * kConnectRepeatIncrement,
+    emitOnConnectEvent(ConnectTimelineEvent::Type::StunRequestSent);
+
+    mTaskSendStunConnectRequest = mScheduler.submit(getConnectRepeatDelay(iteration),
                                                     __FILE__,
                                                     __LINE__,
                                                     [this, iteration] { sendStunBindingRequest(iteration + 1); });
@@ -1664,7 +2022,7 @@ void PeerCandidate::sendStunBindingResponse(unsigned int iteration)
 
     addSendRaw({ mIceMessageBuffer.get(), stun_message_length(&iceMessage) });
 
-    mTaskSendStunConnectResponse = mScheduler.submit(kConnectRepeatPeriod + (iteration + 1) * kConnectRepeatIncrement,
+    mTaskSendStunConnectResponse = mScheduler.submit(getConnectRepeatDelay(iteration),
                                                      __FILE__,
                                                      __LINE__,
                                                      [this, iteration] { sendStunBindingResponse(iteration + 1); });
@@ -1703,6 +2061,11 @@ void PeerCandidate::onConnectionLostTimeout()
 
 void PeerCandidate::sendConnectionRestoreRequest()
 {
+    if (mIsIceLite) {
+        // The peer's consent checks still get responses, see onReceivedStunMessage
+        return;
+    }
+
     LOG(SRTC_LOG_V, "Sending a STUN request to restore the connection #%u", mUniqueId);
 
     const auto request = make_stun_message_binding_request(
@@ -1716,6 +2079,11 @@ void PeerCandidate::sendConnectionRestoreRequest()
 
 void PeerCandidate::updateKeepAliveTimeout()
 {
+    if (mIsIceLite) {
+        // https://datatracker.ietf.org/doc/html/rfc8445#section-11, a lite agent doesn't send keep-alives
+        return;
+    }
+
     if (const auto task = mTaskKeepAliveTimeout.lock()) {
         mTaskKeepAliveTimeout = task->update(kKeepAliveCheckTimeout);
     } else {
@@ -1,7 +1,11 @@
 #include "srtc/peer_connection.h"
+#include "srtc/certificate_pool.h"
+#include "srtc/connect_attempt_delay.h"
 #include "srtc/data_channel_message.h"
+#include "srtc/deadline.h"
 #include "srtc/depacketizer.h"
 #include "srtc/event_loop.h"
+#include "srtc/event_loop_group.h"
 #include "srtc/ice_agent.h"
 #include "srtc/jitter_buffer.h"
 #include "srtc/logging.h"
@@ -10,15 +14,25 @@
 #include "srtc/peer_candidate.h"
 #include "srtc/rtcp_packet_source.h"
 #include "srtc/sdp_answer.h"
+#include "srtc/shared_socket.h"
 #include "srtc/srtc.h"
 #include "srtc/srtp_connection.h"
 #include "srtc/track.h"
 #include "srtc/track_stats.h"
 #include "stunmessage.h"
 
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#endif
+
 #include <algorithm>
 #include <cassert>
 
+#include <openssl/ssl.h>
+
 #define LOG(level, ...) srtc::log(level, "PeerConnection", __VA_ARGS__)
 
 namespace
@@ -29,6 +43,16 @@ std::once_flag gInitFlag;
 constexpr auto kReportsInterval = std::chrono::seconds(5);
 constexpr auto kConnectionStatsInterval = std::chrono::seconds(5);
 constexpr auto kJitterBufferSize = 4096;
+constexpr auto kMaxNetworkWait = std::chrono::milliseconds(100);
+
+constexpr size_t kMaxConnectTimelineSize = 1024;
+
+// For all connections
+srtc::ConnectAttemptDelay gConnectAttemptDelay;
+
+constexpr size_t kFrameSendQueueSize = 256;
+constexpr size_t kDataSendQueueSize = 1024;
+constexpr size_t kPictureLossQueueSize = 16;
 
 template <typename T>
 srtc::Error validateMediaItem(const T& mediaItem)
@@ -61,6 +85,23 @@ PeerConnection::PeerConnection(Direction direction)
     : mDirection(direction)
     , mCustomLogger(nullptr)
     , mEventLoop(EventLoop::factory())
+    , mFrameSendQueue(kFrameSendQueueSize)
+    , mDataSendQueue(kDataSendQueueSize)
+    , mPictureLossQueue(kPictureLossQueueSize)
+    , mConnectionState(ConnectionState::Inactive)
+{
+    std::call_once(gInitFlag, [] {
+        // Just in case we need something
+    });
+}
+
+PeerConnection::PeerConnection(Direction direction, const std::shared_ptr<EventLoopGroup>& eventLoopGroup)
+    : mDirection(direction)
+    , mCustomLogger(nullptr)
+    , mEventLoopGroup(eventLoopGroup)
+    , mFrameSendQueue(kFrameSendQueueSize)
+    , mDataSendQueue(kDataSendQueueSize)
+    , mPictureLossQueue(kPictureLossQueueSize)
     , mConnectionState(ConnectionState::Inactive)
 {
     std::call_once(gInitFlag, [] {
@@ -78,6 +119,33 @@ void PeerConnection::setCustomLogger(CustomLogger* custom)
     mCustomLogger = custom;
 }
 
+void PeerConnection::prepare()
+{
+    // Outside the lock, a new certificate takes a while. The pool keeps the contexts while we keep the certificate.
+    std::shared_ptr<X509Certificate> cert;
+    {
+        std::lock_guard lock(mMutex);
+        cert = mCertificate;
+    }
+    if (!cert) {
+        cert = CertificatePool::getCertificate();
+        SSL_CTX_free(CertificatePool::getDtlsContext(cert, true));
+        SSL_CTX_free(CertificatePool::getDtlsContext(cert, false));
+    }
+
+    std::lock_guard lock(mMutex);
+
+    if (!mCertificate) {
+        mCertificate = cert;
+    }
+
+    if (mIsStarted || mIsQuit || mEventLoopGroup || mThread.joinable()) {
+        return;
+    }
+
+    mThread = std::thread(&PeerConnection::networkThreadWorkerFunc, this);
+}
+
 std::pair<std::shared_ptr<SdpOffer>, Error> PeerConnection::createPublishOffer(const PubOfferConfig& pubConfig,
                                                                                const PubMediaConfig& mediaConfig)
 {
@@ -91,7 +159,18 @@ std::pair<std::shared_ptr<SdpOffer>, Error> PeerConnection::createPublishOffer(c
     config.enable_rtx = pubConfig.enable_rtx;
     config.enable_bwe = pubConfig.enable_bwe;
     config.enable_rfc8851 = pubConfig.enable_rfc8851;
+    config.enable_gso = pubConfig.enable_gso;
+    config.nack_history_millis = pubConfig.nack_history_millis;
+    config.nack_history_kbit_per_second = pubConfig.nack_history_kbit_per_second;
+    config.enable_nack_protected_cache = pubConfig.enable_nack_protected_cache;
     config.enable_abs_capture_time = pubConfig.enable_abs_capture_time;
+    if (pubConfig.ice_lite_config.enable) {
+        config.enable_ice_lite = true;
+        if (const auto error = getIceLiteHostList(pubConfig.ice_lite_config, config.ice_lite_host_list);
+            error.isError()) {
+            return { {}, error };
+        }
+    }
 
     std::vector<SdpOffer::MediaLine> media;
 
@@ -121,7 +200,8 @@ std::pair<std::shared_ptr<SdpOffer>, Error> PeerConnection::createPublishOffer(c
         }
     }
 
-    return { std::shared_ptr<SdpOffer>(new SdpOffer(Direction::Publish, config, media)), Error::OK };
+    return { std::shared_ptr<SdpOffer>(new SdpOffer(Direction::Publish, config, media, getOfferCertificate())),
+             Error::OK };
 }
 
 std::pair<std::shared_ptr<SdpOffer>, Error> PeerConnection::createSubscribeOffer(const SubOfferConfig& subConfig,
@@ -138,6 +218,15 @@ std::pair<std::shared_ptr<SdpOffer>, Error> PeerConnection::createSubscribeOffer
     config.pli_interval_millis = subConfig.pli_interval_millis;
     config.jitter_buffer_length_millis = subConfig.jitter_buffer_length_millis;
     config.jitter_buffer_nack_delay_millis = subConfig.jitter_buffer_nack_delay_millis;
+    config.enable_gro = subConfig.enable_gro;
+    config.receive_buffer_size = subConfig.receive_buffer_size;
+    if (subConfig.ice_lite_config.enable) {
+        config.enable_ice_lite = true;
+        if (const auto error = getIceLiteHostList(subConfig.ice_lite_config, config.ice_lite_host_list);
+            error.isError()) {
+            return { {}, error };
+        }
+    }
 
     std::vector<SdpOffer::MediaLine> media;
 
@@ -157,7 +246,75 @@ std::pair<std::shared_ptr<SdpOffer>, Error> PeerConnection::createSubscribeOffer
         }
     }
 
-    return { std::shared_ptr<SdpOffer>(new SdpOffer(Direction::Subscribe, config, media)), Error::OK };
+    return { std::shared_ptr<SdpOffer>(new SdpOffer(Direction::Subscribe, config, media, getOfferCertificate())),
+             Error::OK };
+}
+
+std::shared_ptr<X509Certificate> PeerConnection::getOfferCertificate()
+{
+    {
+        std::lock_guard lock(mMutex);
+        if (mCertificate) {
+            return mCertificate;
+        }
+    }
+
+    // Not prepared
+    return CertificatePool::getCertificate();
+}
+
+Error PeerConnection::getIceLiteHostList(const IceLiteConfig& liteConfig, std::vector<Host>& hostList)
+{
+    if (!mEventLoopGroup) {
+        return { Error::Code::InvalidData, "ICE-lite needs an event loop group with a shared port" };
+    }
+
+    std::lock_guard lock(mMutex);
+
+    if (mIsStarted) {
+        return { Error::Code::InvalidData, "Connection is already started" };
+    }
+
+    // The offer has the shared port of the thread we'll run on
+    const auto eventLoop = mEventLoopGroup->reserve(this);
+    const auto sharedSocket = eventLoop->getSharedSocket();
+    if (!sharedSocket) {
+        mEventLoopGroup->unreserve(this);
+        return { Error::Code::InvalidData, "ICE-lite needs an event loop group with a shared port" };
+    }
+
+    for (const auto& addrStr : liteConfig.host_list) {
+        Host host = {};
+        uint16_t port = 0;
+
+        if (inet_pton(AF_INET, addrStr.c_str(), &host.addr.sin_ipv4.sin_addr) > 0) {
+            port = sharedSocket->getPort(AF_INET);
+            host.addr.ss.ss_family = AF_INET;
+            host.addr.sin_ipv4.sin_port = htons(port);
+        } else if (inet_pton(AF_INET6, addrStr.c_str(), &host.addr.sin_ipv6.sin6_addr) > 0) {
+            port = sharedSocket->getPort(AF_INET6);
+            host.addr.ss.ss_family = AF_INET6;
+            host.addr.sin_ipv6.sin6_port = htons(port);
+        } else {
+            mEventLoopGroup->unreserve(this);
+            return { Error::Code::InvalidData, "Invalid ICE-lite host address: " + addrStr };
+        }
+
+        if (port == 0) {
+            LOG(SRTC_LOG_W, "No shared socket for ICE-lite host %s, skipping", addrStr.c_str());
+            continue;
+        }
+
+        hostList.push_back(host);
+    }
+
+    if (hostList.empty()) {
+        mEventLoopGroup->unreserve(this);
+        return { Error::Code::InvalidData, "No ICE-lite hosts" };
+    }
+
+    mEventLoop = eventLoop;
+    return Error::OK;
 }
 
 Error PeerConnection::setOffer(const std::shared_ptr<SdpOffer>& offer)
@@ -227,6 +384,7 @@ Error PeerConnection::setAnswer(const std::shared_ptr<SdpAnswer>& answer)
         }
         for (const auto& track : answer->getTrackList()) {
             mTrackEntryList.emplace_back(track);
+            mTrackList.push_back(track);
         }
 
         mDataChannelsNegotiated = mSdpOffer->hasDataChannel() && mSdpAnswer->hasDataChannel();
@@ -268,13 +426,27 @@ Error PeerConnection::setAnswer(const std::shared_ptr<SdpAnswer>& answer)
         // We are started
         mIsStarted = true;
 
-        // The network thread
-        mThread = std::thread(&PeerConnection::networkThreadWorkerFunc, this);
+        // The network thread, our own or shared, our own may be already running if we were prepared
+        if (mEventLoopGroup) {
+            mEventLoop = mEventLoopGroup->attach(this);
+        } else if (mThread.joinable()) {
+            mEventLoop->interrupt();
+        } else {
+            mThread = std::thread(&PeerConnection::networkThreadWorkerFunc, this);
+        }
+
+        mIsRunning.store(true);
     }
 
     return Error::OK;
 }
 
+std::vector<ConnectTimelineEvent> PeerConnection::getConnectTimeline() const
+{
+    std::lock_guard lock(mMutex);
+    return mConnectTimeline;
+}
+
 std::shared_ptr<SdpOffer> PeerConnection::getOffer() const
 {
     std::lock_guard lock(mMutex);
@@ -337,27 +509,11 @@ Error PeerConnection::setVideoCodecSpecificData(const std::shared_ptr<Track>& tr
         return { Error::Code::InvalidData, "The peer connection's direction is not publish" };
     }
 
-    std::lock_guard lock(mMutex);
-
-    if (mConnectionState != ConnectionState::Connected) {
-        return Error::OK;
-    }
-
-    for (const auto& entry : mTrackEntryList) {
-        if (entry.track == track) {
-            FrameToSend fr = {};
-            fr.track = track;
-            fr.packetizer = entry.packetizer;
-            fr.csd = std::move(list);
-
-            mFrameSendQueue.push_back(std::move(fr));
-            mEventLoop->interrupt();
-
-            return Error::OK;
-        }
-    }
+    FrameToSend fr = {};
+    fr.track = track;
+    fr.csd = std::move(list);
 
-    return { Error::Code::InvalidData, "The track is not found" };
+    return queueFrameToSend(std::move(fr));
 }
 
 Error PeerConnection::publishVideoFrame(const std::shared_ptr<Track>& track,
@@ -369,29 +525,13 @@ Error PeerConnection::publishVideoFrame(const std::shared_ptr<Track>& track,
         return { Error::Code::InvalidData, "The peer connection's direction is not publish" };
     }
 
-    std::lock_guard lock(mMutex);
-
-    if (mConnectionState != ConnectionState::Connected) {
-        return Error::OK;
-    }
-
-    for (const auto& entry : mTrackEntryList) {
-        if (entry.track == track) {
-            FrameToSend fr = {};
-            fr.pts_usec = pts_usec;
-            fr.track = track;
-            fr.packetizer = entry.packetizer;
-            fr.buf = std::move(buf);
-            fr.abs_capture_time_ntp = abs_capture_time_ntp;
-
-            mFrameSendQueue.push_back(std::move(fr));
-            mEventLoop->interrupt();
-
-            return Error::OK;
-        }
-    }
+    FrameToSend fr = {};
+    fr.pts_usec = pts_usec;
+    fr.track = track;
+    fr.buf = std::move(buf);
+    fr.abs_capture_time_ntp = abs_capture_time_ntp;
 
-    return { Error::Code::InvalidData, "The track is not found" };
+    return queueFrameToSend(std::move(fr));
 }
 
 Error PeerConnection::updateVideoSimulcastLayer(const std::shared_ptr<Track>& track, const SimulcastLayer& updated)
@@ -414,27 +554,11 @@ Error PeerConnection::updateVideoSimulcastLayer(const std::shared_ptr<Track>& tr
         return { Error::Code::InvalidData, "The track name does not match the layer name" };
     }
 
-    std::lock_guard lock(mMutex);
-
-    if (mConnectionState != ConnectionState::Connected) {
-        return Error::OK;
-    }
-
-    for (const auto& entry : mTrackEntryList) {
-        if (entry.track == track) {
-            FrameToSend fr = {};
-            fr.track = track;
-            fr.packetizer = entry.packetizer;
-            fr.layer = updated;
-
-            mFrameSendQueue.push_back(std::move(fr));
-            mEventLoop->interrupt();
-
-            return Error::OK;
-        }
-    }
+    FrameToSend fr = {};
+    fr.track = track;
+    fr.layer = updated;
 
-    return { Error::Code::InvalidData, "The track is not found" };
+    return queueFrameToSend(std::move(fr));
 }
 
 Error PeerConnection::publishAudioFrame(const std::shared_ptr<Track>& track,
@@ -446,29 +570,33 @@ Error PeerConnection::publishAudioFrame(const std::shared_ptr<Track>& track,
         return { Error::Code::InvalidData, "The peer connection's direction is not publish" };
     }
 
-    std::lock_guard lock(mMutex);
+    FrameToSend fr = {};
+    fr.pts_usec = pts_usec;
+    fr.track = track;
+    fr.buf = std::move(buf);
+    fr.abs_capture_time_ntp = abs_capture_time_ntp;
 
-    if (mConnectionState != ConnectionState::Connected) {
+    return queueFrameToSend(std::move(fr));
+}
+
+Error PeerConnection::queueFrameToSend(FrameToSend&& frame)
+{
+    if (!mIsConnected.load()) {
         return Error::OK;
     }
 
-    for (const auto& entry : mTrackEntryList) {
-        if (entry.track == track) {
-            FrameToSend fr = {};
-            fr.pts_usec = pts_usec;
-            fr.track = track;
-            fr.packetizer = entry.packetizer;
-            fr.buf = std::move(buf);
-            fr.abs_capture_time_ntp = abs_capture_time_ntp;
-
-            mFrameSendQueue.push_back(std::move(fr));
-            mEventLoop->interrupt();
+    const auto iter = std::find(mTrackList.begin(), mTrackList.end(), frame.track);
+    if (iter == mTrackList.end()) {
+        return { Error::Code::InvalidData, "The track is not found" };
+    }
+    frame.track_index = static_cast<size_t>(iter - mTrackList.begin());
 
-            return Error::OK;
-        }
+    if (!mFrameSendQueue.push(std::move(frame))) {
+        return { Error::Code::InvalidData, "The frame send queue is full" };
     }
+    mEventLoop->interrupt();
 
-    return { Error::Code::InvalidData, "The track is not found" };
+    return Error::OK;
 }
 
 void PeerConnection::setSubscribeConnectionStatsListener(const SubscribeConnectionStatsListener& listener)
@@ -495,17 +623,15 @@ Error PeerConnection::requestPictureLossIndicator(const std::shared_ptr<Track>&
         return { Error::Code::InvalidData, "Can only request a PLI when subscribing" };
     }
 
-    std::lock_guard lock(mMutex);
-
-    if (mConnectionState != ConnectionState::Connected) {
+    if (!mIsConnected.load()) {
         return Error::OK;
     }
 
-    FrameToSend fr = {};
-    fr.track = track;
-    fr.request_pli = true;
-
-    mFrameSendQueue.push_back(std::move(fr));
+    auto item = track;
+    if (!mPictureLossQueue.push(std::move(item))) {
+        // There are already plenty of requests
+        return Error::OK;
+    }
     mEventLoop->interrupt();
 
     return Error::OK;
@@ -518,16 +644,16 @@ uint32_t PeerConnection::getDataChannelMaxMessageSize() const
 
 Error PeerConnection::sendDataChannelText(const std::string& label, std::string&& data)
 {
-    std::lock_guard lock(mMutex);
-
-    if (!mDataChannelsNegotiated) {
+    if (!mIsRunning.load() || !mDataChannelsNegotiated) {
         return { Error::Code::InvalidData, "Data channels were not negotiated" };
     }
     if (mDataChannelMaxMessageSize > 0 && data.size() > mDataChannelMaxMessageSize) {
         return { Error::Code::InvalidData, "Message size exceeds peer maximum" };
     }
 
-    mDataSendQueue.emplace_back(DataChannelMessage::makeText(label, std::move(data)));
+    if (!mDataSendQueue.push(DataChannelMessage::makeText(label, std::move(data)))) {
+        return { Error::Code::InvalidData, "The data channel send queue is full" };
+    }
     mEventLoop->interrupt();
 
     return Error::OK;
@@ -535,16 +661,16 @@ Error PeerConnection::sendDataChannelText(const std::string& label, std::string&
 
 Error PeerConnection::sendDataChannelBinary(const std::string& label, ByteBuffer&& data)
 {
-    std::lock_guard lock(mMutex);
-
-    if (!mDataChannelsNegotiated) {
+    if (!mIsRunning.load() || !mDataChannelsNegotiated) {
         return { Error::Code::InvalidData, "Data channels were not negotiated" };
     }
     if (mDataChannelMaxMessageSize > 0 && data.size() > mDataChannelMaxMessageSize) {
         return { Error::Code::InvalidData, "Message size exceeds peer maximum" };
     }
 
-    mDataSendQueue.emplace_back(DataChannelMessage::makeBinary(label, std::move(data)));
+    if (!mDataSendQueue.push(DataChannelMessage::makeBinary(label, std::move(data)))) {
+        return { Error::Code::InvalidData, "The data channel send queue is full" };
+    }
     mEventLoop->interrupt();
 
     return Error::OK;
@@ -561,153 +687,222 @@ void PeerConnection::setDataChannelListener(const std::shared_ptr<DataChannelLis
 void PeerConnection::close()
 {
     std::thread waitForThread;
+    std::shared_ptr<EventLoopGroup> waitForGroup;
 
     {
         std::lock_guard lock(mMutex);
 
-        if (mIsStarted) {
+        if (mIsStarted || mThread.joinable()) {
             mIsQuit = true;
             mEventLoop->interrupt();
             waitForThread = std::move(mThread);
+            waitForGroup = mEventLoopGroup;
+        } else if (mEventLoopGroup) {
+            // An ICE-lite offer may have reserved a thread
+            mEventLoopGroup->unreserve(this);
         }
     }
 
     if (waitForThread.joinable()) {
         waitForThread.join();
     }
+    if (waitForGroup) {
+        waitForGroup->detach(this);
+    }
 }
 
 void PeerConnection::networkThreadWorkerFunc()
 {
-    // Logging
-    setThreadSpecificCustomLogger(mCustomLogger);
-
-    // Loop scheduler
-    mLoopScheduler = std::make_shared<LoopScheduler>();
+    if (!networkWaitForStart()) {
+        return;
+    }
 
-    // We are connecting
-    startConnecting();
+    networkStart();
 
     // Our processing loop
     while (true) {
-        // Epoll for incoming data
-        constexpr auto kDefaultTimeoutMillis = 100;
+        // Epoll for incoming data, until the earliest deadline
+        Deadline deadline(std::chrono::steady_clock::now(), kMaxNetworkWait);
+        networkUpdateDeadline(deadline);
 
-        auto timeout = mLoopScheduler->getTimeoutMillis(kDefaultTimeoutMillis);
-        if (mSelectedCandidate) {
-            if (const auto selectedTimeout = mSelectedCandidate->getTimeoutMillis(kDefaultTimeoutMillis);
-                timeout > selectedTimeout) {
-                timeout = selectedTimeout;
-            }
-        }
+        std::vector<void*> udataList;
+        mEventLoop->wait(udataList, deadline.getTimeout());
 
-        for (const auto& trackEntry : mTrackEntryList) {
-            if (trackEntry.jitterBuffer) {
-                if (const auto jitterTimeout = trackEntry.jitterBuffer->getTimeoutMillis(kDefaultTimeoutMillis);
-                    timeout > jitterTimeout) {
-                    timeout = jitterTimeout;
-                }
-            }
-        }
+        // Read data from the network
+        networkReceive(udataList);
 
-        std::vector<void*> udataList;
-        mEventLoop->wait(udataList, timeout);
+        if (!networkRun()) {
+            break;
+        }
+    }
 
-        std::list<FrameToSend> frameSendQueue;
-        std::list<DataChannelMessage> dataSendQueue;
+    networkStop();
+}
 
+bool PeerConnection::networkWaitForStart()
+{
+    // A prepared connection's thread is started before there is an answer
+    while (true) {
         {
             std::lock_guard lock(mMutex);
             if (mIsQuit) {
-                break;
+                return false;
             }
-            if (mConnectionState == ConnectionState::Failed || mConnectionState == ConnectionState::Closed) {
-                break;
+            if (mIsStarted) {
+                return true;
             }
+        }
 
-            frameSendQueue = std::move(mFrameSendQueue);
+        std::vector<void*> udataList;
+        mEventLoop->wait(udataList, kMaxNetworkWait);
+    }
+}
 
-            if (mSelectedCandidate) {
-                dataSendQueue = std::move(mDataSendQueue);
-            }
+void PeerConnection::networkStart()
+{
+    // Logging
+    setThreadSpecificCustomLogger(mCustomLogger);
+
+    // Loop scheduler
+    mLoopScheduler = std::make_shared<LoopScheduler>();
+
+    // We are connecting
+    startConnecting();
+}
+
+void PeerConnection::networkUpdateDeadline(Deadline& deadline) const
+{
+    mLoopScheduler->updateDeadline(deadline);
+
+    if (mSelectedCandidate) {
+        mSelectedCandidate->updateDeadline(deadline);
+    }
+    for (const auto& candidate : mConnectingCandidateList) {
+        candidate->updateDeadline(deadline);
+    }
+
+    for (const auto& trackEntry : mTrackEntryList) {
+        if (trackEntry.jitterBuffer) {
+            trackEntry.jitterBuffer->updateDeadline(deadline);
         }
+    }
+}
 
-        // Read data from the network
-        for (const auto udata : udataList) {
-            if (udata) {
-                // Read from socket
-                const auto ptr = static_cast<PeerCandidate*>(udata);
-                ptr->receiveFromSocket();
-            }
+void PeerConnection::networkReceive(const std::vector<void*>& udataList)
+{
+    for (const auto udata : udataList) {
+        if (udata) {
+            // Read from socket, the candidates can belong to different connections on a group thread
+            const auto ptr = static_cast<PeerCandidate*>(udata);
+            setThreadSpecificCustomLogger(ptr->getCustomLogger());
+            ptr->receiveFromSocket();
         }
+    }
+}
 
-        // Scheduler
-        mLoopScheduler->run();
-
-        for (auto& item : frameSendQueue) {
-            // Update simulcast layer
-            if (item.layer.has_value()) {
-                const auto updated = item.layer.value();
-                const auto media = item.track->getMedia();
-
-                for (auto& mediaEntry : mMediaEntryList) {
-                    if (mediaEntry.media == media) {
-                        for (auto& layer : mediaEntry.layerList) {
-                            if (layer.name == updated.name) {
-                                layer.width = updated.width;
-                                layer.height = updated.height;
-                                layer.frames_per_second = updated.frames_per_second;
-                                layer.kilobits_per_second = updated.kilobits_per_second;
-                                break;
-                            }
+bool PeerConnection::networkRun()
+{
+    // Logging, there can be other connections on this thread
+    setThreadSpecificCustomLogger(mCustomLogger);
+
+    {
+        std::lock_guard lock(mMutex);
+        if (mIsQuit) {
+            return false;
+        }
+        if (mConnectionState == ConnectionState::Failed || mConnectionState == ConnectionState::Closed) {
+            return false;
+        }
+    }
+
+    // Scheduler
+    mLoopScheduler->run();
+
+    FrameToSend item;
+    while (mFrameSendQueue.pop(item)) {
+        // Update simulcast layer
+        if (item.layer.has_value()) {
+            const auto updated = item.layer.value();
+            const auto media = item.track->getMedia();
+
+            for (auto& mediaEntry : mMediaEntryList) {
+                if (mediaEntry.media == media) {
+                    for (auto& layer : mediaEntry.layerList) {
+                        if (layer.name == updated.name) {
+                            layer.width = updated.width;
+                            layer.height = updated.height;
+                            layer.frames_per_second = updated.frames_per_second;
+                            layer.kilobits_per_second = updated.kilobits_per_second;
+                            break;
                         }
                     }
                 }
             }
+        }
 
-            // Request key frame
-            if (mSelectedCandidate && item.request_pli) {
-                mSelectedCandidate->sendPictureLossIndicator(item.track);
-            }
-
-            // Frames to send
-            if (mSelectedCandidate && (!item.buf.empty() || !item.csd.empty())) {
-                mSelectedCandidate->addSendFrame(PeerCandidate::FrameToSend{ item.pts_usec,
-                                                                             item.abs_capture_time_ntp,
-                                                                             item.track,
-                                                                             item.packetizer,
-                                                                             std::move(item.buf),
-                                                                             std::move(item.csd) });
-            }
+        // Frames to send
+        if (mSelectedCandidate && (!item.buf.empty() || !item.csd.empty()) &&
+            item.track_index < mTrackEntryList.size()) {
+            mSelectedCandidate->addSendFrame(PeerCandidate::FrameToSend{ item.pts_usec,
+                                                                         item.abs_capture_time_ntp,
+                                                                         item.track,
+                                                                         mTrackEntryList[item.track_index].packetizer,
+                                                                         std::move(item.buf),
+                                                                         std::move(item.csd) });
         }
+    }
 
+    // Request key frames
+    std::shared_ptr<Track> pictureLossTrack;
+    while (mPictureLossQueue.pop(pictureLossTrack)) {
         if (mSelectedCandidate) {
-            for (auto& item : dataSendQueue) {
-                mSelectedCandidate->sendDataChannelMessage(std::move(item));
-            }
+            mSelectedCandidate->sendPictureLossIndicator(pictureLossTrack);
         }
+    }
 
-        // Candidate processing
-        for (const auto& candidate : mConnectingCandidateList) {
-            candidate->run();
-            if (mConnectingCandidateList.empty()) {
-                // A candidate reached ICE connected, and we removed all connecting ones
-                break;
-            }
+    // Data channel messages wait until we're connected
+    if (mSelectedCandidate) {
+        DataChannelMessage message;
+        while (mDataSendQueue.pop(message)) {
+            mSelectedCandidate->sendDataChannelMessage(std::move(message));
         }
+    }
 
-        if (mSelectedCandidate) {
-            mSelectedCandidate->run();
+    // Candidate processing
+    for (const auto& candidate : mConnectingCandidateList) {
+        candidate->run();
+        if (mConnectingCandidateList.empty()) {
+            // A candidate reached ICE connected, and we removed all connecting ones
+            break;
         }
+    }
 
-        // Jitter buffer processing
-        for (const auto& trackEntry : mTrackEntryList) {
-            if (trackEntry.jitterBuffer) {
-                processJitterBuffer(trackEntry.jitterBuffer);
-            }
+    if (mSelectedCandidate) {
+        mSelectedCandidate->run();
+    }
+
+    // Jitter buffer processing
+    for (const auto& trackEntry : mTrackEntryList) {
+        if (trackEntry.jitterBuffer) {
+            processJitterBuffer(trackEntry.jitterBuffer);
         }
     }
 
+    // Send everything queued during this iteration
+    for (const auto& candidate : mConnectingCandidateList) {
+        candidate->flushSocket();
+    }
+    if (mSelectedCandidate) {
+        mSelectedCandidate->flushSocket();
+    }
+
+    return true;
+}
+
+void PeerConnection::networkStop()
+{
+    setThreadSpecificCustomLogger(mCustomLogger);
+
     mLoopScheduler.reset();
 
     // Clear everything on this thread before exiting
@@ -737,6 +932,7 @@ void PeerConnection::setConnectionState(ConnectionState state)
         }
 
         mConnectionState = state;
+        mIsConnected.store(state == ConnectionState::Connected);
 
         if (mConnectionState == ConnectionState::Failed) {
             mIsQuit = true;
@@ -756,11 +952,42 @@ void PeerConnection::startConnecting()
 {
     setConnectionState(ConnectionState::Connecting);
 
+    mFrameSendQueue.clear();
+    mPictureLossQueue.clear();
+
     std::lock_guard lock(mMutex);
 
-    mFrameSendQueue.clear();
+    mConnectStartTime = std::chrono::steady_clock::now();
+    mConnectTimeline.clear();
+
+    if (const auto& config = mSdpOffer->getConfig(); config.enable_ice_lite) {
+        // The peer connects to us, there is a candidate for each address family we have hosts for, and the
+        // peer's checks decide which one it's going to be
+        for (const auto family : { AF_INET, AF_INET6 }) {
+            if (std::any_of(config.ice_lite_host_list.begin(),
+                            config.ice_lite_host_list.end(),
+                            [family](const Host& host) { return host.addr.ss.ss_family == family; })) {
+                Host host = {};
+                host.addr.ss.ss_family = static_cast<decltype(host.addr.ss.ss_family)>(family);
+
+                const auto listener = static_cast<PeerCandidateListener*>(this);
+                const auto candidate = std::make_shared<PeerCandidate>(listener,
+                                                                       mDirection,
+                                                                       mSdpOffer,
+                                                                       mSdpAnswer,
+                                                                       mDataChannelMaxMessageSize,
+                                                                       mLoopScheduler,
+                                                                       host,
+                                                                       mEventLoop,
+                                                                       std::chrono::milliseconds(0));
+                mConnectingCandidateList.push_back(candidate);
+            }
+        }
+        return;
+    }
 
-    // Interleave IPv4 and IPv6 candidates
+    // Interleave IPv4 and IPv6 candidates, each starting a little after the previous one, sooner if the
+    // previous one fails
     std::vector<Host> hostList4;
     std::vector<Host> hostList6;
     for (const auto& host : mSdpAnswer->getHostList()) {
@@ -773,7 +1000,7 @@ void PeerConnection::startConnecting()
     }
 
     const auto maxHostSize = std::max(hostList4.size(), hostList6.size());
-    auto connectDelay = 0;
+    auto connectDelay = std::chrono::milliseconds(0);
     for (size_t i = 0; i < maxHostSize; i += 1) {
         if (i < hostList4.size()) {
             const auto listener = static_cast<PeerCandidateListener*>(this);
@@ -785,8 +1012,9 @@ void PeerConnection::startConnecting()
                                                                    mLoopScheduler,
                                                                    hostList4[i],
                                                                    mEventLoop,
-                                                                   std::chrono::milliseconds(connectDelay));
+                                                                   connectDelay);
             mConnectingCandidateList.push_back(candidate);
+            connectDelay += gConnectAttemptDelay.get(hostList4[i]);
         }
         if (i < hostList6.size()) {
             const auto listener = static_cast<PeerCandidateListener*>(this);
@@ -798,11 +1026,10 @@ void PeerConnection::startConnecting()
                                                                    mLoopScheduler,
                                                                    hostList6[i],
                                                                    mEventLoop,
-                                                                   std::chrono::milliseconds(connectDelay));
+                                                                   connectDelay);
             mConnectingCandidateList.push_back(candidate);
+            connectDelay += gConnectAttemptDelay.get(hostList6[i]);
         }
-
-        connectDelay += 100;
     }
 }
 
@@ -851,10 +1078,12 @@ void PeerConnection::onCandidateConnecting([[maybe_unused]] PeerCandidate* candi
 
 void PeerConnection::onCandidateIceConnected(PeerCandidate* candidate)
 {
+    // The first one wins, the others are dropped
     for (const auto& item : mConnectingCandidateList) {
         if (item.get() == candidate) {
             mSelectedCandidate = item;
-            break;
+        } else {
+            addConnectEvent(item->getHost(), ConnectTimelineEvent::Type::CandidateCancelled, 0.0f);
         }
     }
 
@@ -872,11 +1101,11 @@ void PeerConnection::onCandidateIceConnected(PeerCandidate* candidate)
     }
 
     Task::cancelHelper(mTaskReports);
-    mTaskReports = mLoopScheduler->submit(kReportsInterval, __FILE__, __LINE__, [this] { sendReports(); });
+    mTaskReports = mLoopScheduler->submitPeriodic(kReportsInterval, __FILE__, __LINE__, [this] { sendReports(); });
 
     Task::cancelHelper(mTaskConnectionStats);
-    mTaskConnectionStats =
-        mLoopScheduler->submit(kConnectionStatsInterval, __FILE__, __LINE__, [this] { sendConnectionStats(); });
+    mTaskConnectionStats = mLoopScheduler->submitPeriodic(
+        kConnectionStatsInterval, __FILE__, __LINE__, [this] { sendConnectionStats(); });
 }
 
 void PeerConnection::onCandidateDtlsConnected(PeerCandidate* candidate)
@@ -929,6 +1158,14 @@ void PeerConnection::onCandidateDtlsConnected(PeerCandidate* candidate)
         const auto& config = mSdpOffer->getConfig();
 
         if (config.pli_interval_millis > 0) {
+            const auto interval = std::clamp<uint16_t>(config.pli_interval_millis, 500u, 4000u);
+
+            Task::cancelHelper(mTaskPictureLossIndicator);
+            mTaskPictureLossIndicator =
+                mLoopScheduler->submitPeriodic(std::chrono::milliseconds(interval), __FILE__, __LINE__, [this] {
+                    sendPeriodicPictureLossIndicators();
+                });
+
             sendPeriodicPictureLossIndicators();
         }
     }
@@ -962,17 +1199,46 @@ void PeerConnection::onCandidateFailedToConnect(PeerCandidate* candidate, const
     // We have tried all candidates and they all failed
     if (mConnectingCandidateList.empty()) {
         setConnectionState(ConnectionState::Failed);
+        return;
+    }
+
+    // The next one doesn't have to wait for its turn
+    for (const auto& item : mConnectingCandidateList) {
+        if (item->isStartPending()) {
+            item->startNow();
+            break;
+        }
+    }
+}
+
+void PeerConnection::onCandidateConnectEvent(PeerCandidate* candidate, ConnectTimelineEvent::Type type, float rttMs)
+{
+    if (type == ConnectTimelineEvent::Type::StunResponseReceived) {
+        gConnectAttemptDelay.update(candidate->getHost(), rttMs);
+    }
+
+    addConnectEvent(candidate->getHost(), type, rttMs);
+}
+
+void PeerConnection::addConnectEvent(const Host& host, ConnectTimelineEvent::Type type, float rttMs)
+{
+    const auto elapsed = std::chrono::steady_clock::now() - mConnectStartTime;
+
+    std::lock_guard lock(mMutex);
+
+    if (mConnectTimeline.size() < kMaxConnectTimelineSize) {
+        mConnectTimeline.push_back(
+            { type, to_string(host.addr), std::chrono::duration_cast<std::chrono::microseconds>(elapsed), rttMs });
     }
 }
 
 void PeerConnection::onCandidateReceivedMediaPacket([[maybe_unused]] PeerCandidate* candiate,
-                                                    const std::shared_ptr<RtpPacket>& packet)
+                                                    const std::shared_ptr<Track>& track,
+                                                    const RtpPacketView& packet)
 {
     if (mDirection == Direction::Subscribe) {
-        const auto track = packet->getTrack();
-
         const auto stats = track->getStats();
-        stats->setHighestReceivedSeq(packet->getSequence());
+        stats->setHighestReceivedSeq(packet.sequence);
 
         for (const auto& trackEntry : mTrackEntryList) {
             if (trackEntry.track == track) {
@@ -1015,6 +1281,11 @@ void PeerConnection::getSimulcastLayerList(const std::shared_ptr<Media>& media,
     }
 }
 
+CustomLogger* PeerConnection::getCustomLogger() const
+{
+    return mCustomLogger;
+}
+
 void PeerConnection::onSctpDataChannelOpen(const std::string& label)
 {
     std::lock_guard lock(mListenerMutex);
@@ -1049,9 +1320,6 @@ void PeerConnection::onSctpDataChannelClosed(const std::string& label)
 
 void PeerConnection::sendReports()
 {
-    Task::cancelHelper(mTaskReports);
-    mTaskReports = mLoopScheduler->submit(kReportsInterval, __FILE__, __LINE__, [this] { sendReports(); });
-
     if (mSelectedCandidate) {
         std::lock_guard lock(mMutex);
 
@@ -1064,10 +1332,6 @@ void PeerConnection::sendReports()
 
 void PeerConnection::sendConnectionStats()
 {
-    Task::cancelHelper(mTaskConnectionStats);
-    mTaskConnectionStats =
-        mLoopScheduler->submit(kConnectionStatsInterval, __FILE__, __LINE__, [this] { sendConnectionStats(); });
-
     PublishConnectionStats publishConnectionStats = {};
     SubscribeConnectionStats subscribeConnectionStats = {};
 
@@ -1123,15 +1387,6 @@ void PeerConnection::sendPeriodicPictureLossIndicators()
     if (mDirection == Direction::Subscribe) {
         {
             std::lock_guard lock(mMutex);
-            const auto& config = mSdpOffer->getConfig();
-            const auto interval = std::clamp<uint16_t>(config.pli_interval_millis, 500u, 4000u);
-
-            Task::cancelHelper(mTaskPictureLossIndicator);
-            mTaskPictureLossIndicator =
-                mLoopScheduler->submit(std::chrono::milliseconds(interval), __FILE__, __LINE__, [this] {
-                    sendPeriodicPictureLossIndicators();
-                });
-
             if (mConnectionState != ConnectionState::Connected) {
                 return;
             }
@@ -0,0 +1,111 @@
+#include "srtc/peer_connection_pool.h"
+#include "srtc/logging.h"
+#include "srtc/peer_connection.h"
+
+#define LOG(level, ...) srtc::log(level, "PeerConnectionPool", __VA_ARGS__)
+
+namespace srtc
+{
+
+PeerConnectionPool::PeerConnectionPool(Direction direction, size_t size)
+    : PeerConnectionPool(direction, size, nullptr)
+{
+}
+
+PeerConnectionPool::PeerConnectionPool(Direction direction,
+                                       size_t size,
+                                       const std::shared_ptr<EventLoopGroup>& eventLoopGroup)
+    : mDirection(direction)
+    , mSize(size)
+    , mEventLoopGroup(eventLoopGroup)
+{
+    mRefillThread = std::thread(&PeerConnectionPool::refillThreadFunc, this);
+}
+
+PeerConnectionPool::~PeerConnectionPool()
+{
+    {
+        std::lock_guard lock(mMutex);
+        mIsQuit = true;
+    }
+    mCond.notify_one();
+
+    mRefillThread.join();
+
+    // Closes the connections and stops their threads
+    std::list<std::shared_ptr<PeerConnection>> list;
+    {
+        std::lock_guard lock(mMutex);
+        list.swap(mReadyList);
+    }
+    for (const auto& conn : list) {
+        conn->close();
+    }
+}
+
+std::shared_ptr<PeerConnection> PeerConnectionPool::acquire()
+{
+    {
+        std::lock_guard lock(mMutex);
+
+        if (!mReadyList.empty()) {
+            auto conn = std::move(mReadyList.front());
+            mReadyList.pop_front();
+            mStats.hit_count += 1;
+            mCond.notify_one();
+            return conn;
+        }
+
+        mStats.miss_count += 1;
+        mCond.notify_one();
+    }
+
+    LOG(SRTC_LOG_V, "The pool is empty, creating a connection");
+    return create();
+}
+
+PeerConnectionPool::Stats PeerConnectionPool::getStats() const
+{
+    std::lock_guard lock(mMutex);
+
+    auto stats = mStats;
+    stats.ready_count = mReadyList.size();
+    return stats;
+}
+
+std::shared_ptr<PeerConnection> PeerConnectionPool::create() const
+{
+    if (mEventLoopGroup) {
+        return std::make_shared<PeerConnection>(mDirection, mEventLoopGroup);
+    }
+    return std::make_shared<PeerConnection>(mDirection);
+}
+
+void PeerConnectionPool::refillThreadFunc()
+{
+    while (true) {
+        {
+            std::unique_lock lock(mMutex);
+            mCond.wait(lock, [this] { return mIsQuit || mReadyList.size() < mSize; });
+            if (mIsQuit) {
+                return;
+            }
+        }
+
+        // Outside the lock, so that acquire() doesn't wait for us
+        const auto start = std::chrono::steady_clock::now();
+
+        const auto conn = create();
+        conn->prepare();
+
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+
+        std::lock_guard lock(mMutex);
+        mReadyList.push_back(conn);
+        mStats.warm_up_count += 1;
+        mStats.warm_up_micros +=
+            static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+    }
+}
+
+} // namespace srtc
@@ -105,14 +105,24 @@ std::optional<uint64_t> RtpExtension::findU64(uint8_t nExtId) const
 
 std::optional<RtpExtension::Value> RtpExtension::findAny(uint8_t nExtId) const
 {
-    if (!empty()) {
-        ByteReader reader(mData);
-        Element elem = {};
-
-        while (nextElement(reader, elem)) {
-            if (elem.id == nExtId) {
-                return Value{ elem.ptr, elem.len };
-            }
+    if (empty()) {
+        return {};
+    }
+
+    return findAny(mId, mData.data(), mData.size(), nExtId);
+}
+
+std::optional<RtpExtension::Value> RtpExtension::findAny(uint16_t extensionId,
+                                                         const uint8_t* data,
+                                                         size_t size,
+                                                         uint8_t nExtId)
+{
+    ByteReader reader(data, size);
+    Element elem = {};
+
+    while (nextElement(extensionId, reader, elem)) {
+        if (elem.id == nExtId) {
+            return Value{ elem.ptr, elem.len };
         }
     }
 
@@ -129,7 +139,7 @@ void RtpExtension::trimPadding()
     Element elem = {};
 
     size_t end = 0;
-    while (nextElement(reader, elem)) {
+    while (nextElement(mId, reader, elem)) {
         end = reader.position();
     }
 
@@ -145,13 +155,13 @@ RtpExtension RtpExtension::copy() const
     return { mId, mData.copy() };
 }
 
-bool RtpExtension::nextElement(ByteReader& reader, Element& out) const
+bool RtpExtension::nextElement(uint16_t extensionId, ByteReader& reader, Element& out)
 {
-    if (!isValidExtensionId(mId)) {
+    if (!isValidExtensionId(extensionId)) {
         return false;
     }
 
-    if (mId == kOneByte) {
+    if (extensionId == kOneByte) {
         if (reader.remaining() < 1) {
             return false;
         }
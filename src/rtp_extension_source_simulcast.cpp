@@ -90,19 +90,19 @@ void RtpExtensionSourceSimulcast::addExtension(RtpExtensionBuilder& builder,
     builder.addBinaryValue(mCurExtGoogleVLA, mCurGoogleVLA);
 }
 
-void RtpExtensionSourceSimulcast::updateForRtx(RtpExtensionBuilder& builder, const std::shared_ptr<Track>& track) const
+void RtpExtensionSourceSimulcast::updateForRtx(RtpExtensionBuilder& builder, const Track& track) const
 {
-    const auto media = track->getMedia();
+    const auto media = track.getMedia();
     const auto& extensionMap = media->getExtensionMap();
 
     const auto extMediaId = extensionMap.findByName(RtpStandardExtensions::kExtSdesMid);
     const auto extRepairedStreamId = extensionMap.findByName(RtpStandardExtensions::kExtSdesRtpRepairedStreamId);
 
-    const auto layer = track->getSimulcastLayer();
+    const auto layer = track.getSimulcastLayer();
 
     if (const auto id = extMediaId; id != 0) {
         if (!builder.contains(id)) {
-            builder.addStringValue(id, track->getMedia()->getId());
+            builder.addStringValue(id, track.getMedia()->getId());
         }
     }
     if (const auto id = extRepairedStreamId; id != 0) {
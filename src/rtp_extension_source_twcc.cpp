@@ -97,7 +97,7 @@ bool RtpExtensionSourceTWCC::wantsExtension(const std::shared_ptr<Track>& track,
                                             [[maybe_unused]] bool isKeyFrame,
                                             [[maybe_unused]] unsigned int packetNumber) const
 {
-    return getExtensionId(track) != 0;
+    return getExtensionId(*track) != 0;
 }
 
 void RtpExtensionSourceTWCC::addExtension(RtpExtensionBuilder& builder,
@@ -107,27 +107,27 @@ void RtpExtensionSourceTWCC::addExtension(RtpExtensionBuilder& builder,
 {
     // Because of pacing, we don't assign a sequence number here, we do it before generating. But we still want to
     // write a placeholder so that packet size measurement works correctly.
-    if (const auto id = getExtensionId(track); id != 0) {
+    if (const auto id = getExtensionId(*track); id != 0) {
         builder.addU16Value(id, 0);
     }
 }
 
-void RtpExtensionSourceTWCC::onBeforeGeneratingRtpPacket(const std::shared_ptr<RtpPacket>& packet)
+void RtpExtensionSourceTWCC::onBeforeGeneratingRtpPacket(RtpPacket& packet)
 {
-    const auto track = packet->getTrack();
-    if (const auto id = getExtensionId(track); id != 0) {
-        auto builder = RtpExtensionBuilder::from(packet->getExtension());
+    const auto track = packet.getTrack();
+    if (const auto id = getExtensionId(*track); id != 0) {
+        auto builder = RtpExtensionBuilder::from(packet.getExtension());
 
         const auto seq = mNextPacketSEQ;
         mNextPacketSEQ += 1;
 
         builder.addOrReplaceU16Value(id, seq);
 
-        packet->setExtension(builder.build());
+        packet.setExtension(builder.build());
     }
 }
 
-void RtpExtensionSourceTWCC::onBeforeSendingRtpPacket(const std::shared_ptr<RtpPacket>& packet,
+void RtpExtensionSourceTWCC::onBeforeSendingRtpPacket(const RtpPacket& packet,
                                                       size_t generatedSize,
                                                       size_t encryptedSize)
 {
@@ -136,14 +136,14 @@ void RtpExtensionSourceTWCC::onBeforeSendingRtpPacket(const std::shared_ptr<RtpP
         return;
     }
 
-    const auto track = packet->getTrack();
-    const auto paddingSize = packet->getPaddingSize();
-    const auto payloadSize = packet->getPayloadSize();
+    const auto track = packet.getTrack();
+    const auto paddingSize = packet.getPaddingSize();
+    const auto payloadSize = packet.getPayloadSize();
 
-    mPacketHistory->saveOutgoingPacket(seq.value(), track, paddingSize, payloadSize, generatedSize, encryptedSize);
+    mPacketHistory->saveOutgoingPacket(seq.value(), *track, paddingSize, payloadSize, generatedSize, encryptedSize);
 }
 
-void RtpExtensionSourceTWCC::onPacketWasNacked(const std::shared_ptr<RtpPacket>& packet)
+void RtpExtensionSourceTWCC::onPacketWasNacked(const RtpPacket& packet)
 {
     const auto seq = getFeedbackSeq(packet);
     if (!seq.has_value()) {
@@ -326,19 +326,19 @@ void RtpExtensionSourceTWCC::onReceivedRtcpPacket([[maybe_unused]] uint32_t ssrc
     }
 }
 
-std::optional<uint16_t> RtpExtensionSourceTWCC::getFeedbackSeq(const std::shared_ptr<RtpPacket>& packet) const
+std::optional<uint16_t> RtpExtensionSourceTWCC::getFeedbackSeq(const RtpPacket& packet) const
 {
-    const auto track = packet->getTrack();
-    const auto nExtId = getExtensionId(track);
+    const auto track = packet.getTrack();
+    const auto nExtId = getExtensionId(*track);
     if (nExtId == 0) {
         return {};
     }
 
-    const auto& ext = packet->getExtension();
+    const auto& ext = packet.getExtension();
     return ext.findU16(nExtId);
 }
 
-unsigned int RtpExtensionSourceTWCC::getPacingSpreadMillis(const std::vector<std::shared_ptr<RtpPacket>>& list,
+unsigned int RtpExtensionSourceTWCC::getPacingSpreadMillis(const std::vector<RtpPacketPtr>& list,
                                                            float bandwidthScale,
                                                            unsigned int defaultValue) const
 {
@@ -355,9 +355,9 @@ void RtpExtensionSourceTWCC::updatePublishConnectionStats(PublishConnectionStats
     mPacketHistory->updatePublishConnectionStats(stats);
 }
 
-uint8_t RtpExtensionSourceTWCC::getExtensionId(const std::shared_ptr<Track>& track) const
+uint8_t RtpExtensionSourceTWCC::getExtensionId(const Track& track) const
 {
-    const auto media = track->getMedia();
+    const auto media = track.getMedia();
     const auto& extensionMap = media->getExtensionMap();
     return extensionMap.findByName(RtpStandardExtensions::kExtGoogleTWCC);
 }
@@ -1,4 +1,5 @@
 #include "srtc/rtp_packet.h"
+#include "srtc/rtp_packet_pool.h"
 #include "srtc/rtp_packet_source.h"
 #include "srtc/track.h"
 
@@ -28,19 +29,43 @@ void writeExtension(srtc::ByteWriter& writer, const srtc::RtpExtension& extensio
     }
 }
 
-void writePayload(srtc::ByteWriter& writer, const srtc::ByteBuffer& payload)
-{
-    writer.write(payload);
-}
+// The padding is zeros with the count in the last byte
+constexpr uint8_t kZeroPadding[255] = {};
 
-void writePadding(srtc::ByteWriter& writer, uint8_t padding)
+void addPadding(srtc::ByteGather& body, uint8_t padding)
 {
     if (padding == 0) {
         return;
     }
 
-    writer.padding(0, padding - 1);
-    writer.writeU8(padding);
+    body.add(kZeroPadding, padding - 1u);
+    body.addCopy(&padding, 1);
+}
+
+void writeHeader(srtc::ByteWriter& writer,
+                 bool marker,
+                 uint8_t payloadId,
+                 uint16_t sequence,
+                 uint32_t timestamp,
+                 uint32_t ssrc,
+                 uint8_t padding,
+                 const srtc::RtpExtension& extension)
+{
+    // https://blog.webex.com/engineering/introducing-rtp-the-packet-format/
+
+    // V=2 | P | X | CC | M | PT
+    const auto pad = padding != 0;
+    const auto ext = !extension.empty();
+    const uint16_t header =
+        (2 << 14) | (pad ? (1 << 13) : 0) | (ext ? (1 << 12) : 0) | (marker ? (1 << 7) : 0) | (payloadId & 0x7Fu);
+    writer.writeU16(header);
+
+    writer.writeU16(sequence);
+    writer.writeU32(timestamp);
+    writer.writeU32(ssrc);
+
+    // Extension
+    writeExtension(writer, extension);
 }
 
 } // namespace
@@ -55,7 +80,9 @@ RtpPacket::RtpPacket(const std::shared_ptr<Track>& track,
                      uint32_t timestamp,
                      uint8_t padding,
                      ByteBuffer&& payload)
-    : mTrack(track)
+    : mRefCount(0)
+    , mPool(nullptr)
+    , mTrack(track.get())
     , mSSRC(track->getSSRC())
     , mPayloadId(track->getPayloadId())
     , mMarker(marker)
@@ -75,7 +102,9 @@ RtpPacket::RtpPacket(const std::shared_ptr<Track>& track,
                      uint8_t padding,
                      RtpExtension&& extension,
                      ByteBuffer&& payload)
-    : mTrack(track)
+    : mRefCount(0)
+    , mPool(nullptr)
+    , mTrack(track.get())
     , mSSRC(track->getSSRC())
     , mPayloadId(track->getPayloadId())
     , mMarker(marker)
@@ -98,7 +127,9 @@ RtpPacket::RtpPacket(const std::shared_ptr<Track>& track,
                      uint8_t padding,
                      RtpExtension&& extension,
                      ByteBuffer&& payload)
-    : mTrack(track)
+    : mRefCount(0)
+    , mPool(nullptr)
+    , mTrack(track.get())
     , mSSRC(ssrc)
     , mPayloadId(payloadId)
     , mMarker(marker)
@@ -111,9 +142,46 @@ RtpPacket::RtpPacket(const std::shared_ptr<Track>& track,
 {
 }
 
-RtpPacket::~RtpPacket() = default;
+RtpPacket::RtpPacket(const std::shared_ptr<Track>& track,
+                     bool marker,
+                     uint32_t rollover,
+                     uint16_t sequence,
+                     uint32_t timestamp,
+                     uint8_t padding,
+                     RtpExtension&& extension,
+                     ByteBuffer&& payload,
+                     const BufferSlice& payloadSlice)
+    : mRefCount(0)
+    , mPool(nullptr)
+    , mTrack(track.get())
+    , mSSRC(track->getSSRC())
+    , mPayloadId(track->getPayloadId())
+    , mMarker(marker)
+    , mRollover(rollover)
+    , mSequence(sequence)
+    , mTimestamp(timestamp)
+    , mPaddingSize(padding)
+    , mPayload(std::move(payload))
+    , mPayloadSlice(payloadSlice)
+    , mExtension(std::move(extension))
+{
+}
+
+RtpPacket::~RtpPacket()
+{
+    assert(mRefCount == 0);
+}
 
-std::shared_ptr<Track> RtpPacket::getTrack() const
+void RtpPacket::destroy(RtpPacket* packet)
+{
+    if (const auto pool = packet->mPool) {
+        pool->release(packet);
+    } else {
+        delete packet;
+    }
+}
+
+Track* RtpPacket::getTrack() const
 {
     return mTrack;
 }
@@ -150,7 +218,7 @@ uint8_t RtpPacket::getPaddingSize() const
 
 size_t RtpPacket::getPayloadSize() const
 {
-    return mPayload.size();
+    return mPayload.size() + mPayloadSlice.size();
 }
 
 uint16_t RtpPacket::getSequence() const
@@ -160,44 +228,31 @@ uint16_t RtpPacket::getSequence() const
 
 RtpPacket::Output RtpPacket::generate() const
 {
-    // https://blog.webex.com/engineering/introducing-rtp-the-packet-format/
-
     ByteBuffer buf;
-    ByteWriter writer(buf);
+    ByteGather body;
 
-    // V=2 | P | X | CC | M | PT
-    const auto pad = mPaddingSize != 0;
-    const auto ext = !mExtension.empty();
-    const uint16_t header =
-        (2 << 14) | (pad ? (1 << 13) : 0) | (ext ? (1 << 12) : 0) | (mMarker ? (1 << 7) : 0) | (mPayloadId & 0x7Fu);
-    writer.writeU16(header);
+    const auto rollover = generate(buf, body);
+    body.appendTo(buf);
 
-    writer.writeU16(mSequence);
-    writer.writeU32(mTimestamp);
-    writer.writeU32(mSSRC);
+    return { std::move(buf), rollover };
+}
 
-    // Extension
-    writeExtension(writer, mExtension);
+uint32_t RtpPacket::generate(ByteBuffer& header, ByteGather& body) const
+{
+    header.clear();
+    body.clear();
 
-    // Payload
-    writePayload(writer, mPayload);
+    ByteWriter writer(header);
+    writeHeader(writer, mMarker, mPayloadId, mSequence, mTimestamp, mSSRC, mPaddingSize, mExtension);
 
-    // Write padding
-    writePadding(writer, mPaddingSize);
+    // Payload
+    body.add(mPayload.data(), mPayload.size());
+    body.add(mPayloadSlice.data(), mPayloadSlice.size());
 
-#if 0
-	if (mPaddingSize > 0) {
-		std::printf("***** Packet with padding: payload size = %zu, ext size = %zu, "
-					"padding size = %u, total size = %zu, last byte of payload = %u\n",
-					mPayload.size(),
-					mExtension.size(),
-					mPaddingSize,
-					buf.size(),
-					mPayload.data()[mPayload.size() - 1]);
-	}
-#endif
+    // Padding
+    addPadding(body, mPaddingSize);
 
-    return { std::move(buf), mRollover };
+    return mRollover;
 }
 
 uint32_t RtpPacket::getSSRC() const
@@ -220,47 +275,63 @@ ByteBuffer&& RtpPacket::movePayload()
     return std::move(mPayload);
 }
 
+const BufferSlice& RtpPacket::getPayloadSlice() const
+{
+    return mPayloadSlice;
+}
+
+ByteBuffer RtpPacket::copyPayload() const
+{
+    ByteBuffer buf(getPayloadSize());
+    buf.append(mPayload);
+    buf.append(mPayloadSlice.data(), mPayloadSlice.size());
+    return buf;
+}
+
 void RtpPacket::setExtension(RtpExtension&& extension)
 {
     mExtension = std::move(extension);
 }
 
 RtpPacket::Output RtpPacket::generateRtx(const RtpExtension& extension) const
+{
+    ByteBuffer buf;
+    ByteGather body;
+
+    const auto rollover = generateRtx(extension, buf, body);
+    body.appendTo(buf);
+
+    return { std::move(buf), rollover };
+}
+
+uint32_t RtpPacket::generateRtx(const RtpExtension& extension, ByteBuffer& header, ByteGather& body) const
 {
     const auto rtxPayloadId = mTrack->getRtxPayloadId();
     assert(rtxPayloadId > 0);
 
     // https://datatracker.ietf.org/doc/html/rfc4588#section-4
 
-    ByteBuffer buf;
-    ByteWriter writer(buf);
-
-    // V=2 | P | X | CC | M | PT
-    const auto pad = mPaddingSize != 0;
-    const auto ext = !extension.empty();
-    const uint16_t header =
-        (2 << 14) | (pad ? (1 << 13) : 0) | (ext ? (1 << 12) : 0) | (mMarker ? (1 << 7) : 0) | (rtxPayloadId & 0x7Fu);
-    writer.writeU16(header);
+    header.clear();
+    body.clear();
 
     const auto packetSource = mTrack->getRtxPacketSource();
     const auto [rtxRollover, rtxSequence] = packetSource->getNextSequence();
-    writer.writeU16(rtxSequence);
-    writer.writeU32(mTimestamp);
-    writer.writeU32(mTrack->getRtxSSRC());
 
-    // Extension
-    writeExtension(writer, extension);
+    ByteWriter writer(header);
+    writeHeader(writer, mMarker, rtxPayloadId, rtxSequence, mTimestamp, mTrack->getRtxSSRC(), mPaddingSize, extension);
 
     // The original sequence
-    writer.writeU16(mSequence);
+    const uint8_t originalSequence[2] = { static_cast<uint8_t>(mSequence >> 8), static_cast<uint8_t>(mSequence) };
+    body.addCopy(originalSequence, sizeof(originalSequence));
 
     // Payload
-    writePayload(writer, mPayload);
+    body.add(mPayload.data(), mPayload.size());
+    body.add(mPayloadSlice.data(), mPayloadSlice.size());
 
     // Padding
-    writePadding(writer, mPaddingSize);
+    addPadding(body, mPaddingSize);
 
-    return { std::move(buf), rtxRollover };
+    return rtxRollover;
 }
 
 void RtpPacket::setSendInfo(const SendInfo& sendInfo)
@@ -273,66 +344,112 @@ std::optional<RtpPacket::SendInfo> RtpPacket::getSendInfo() const
     return mSendInfo;
 }
 
-std::shared_ptr<RtpPacket> RtpPacket::fromUdpPacket(const std::shared_ptr<Track>& track, const srtc::ByteBuffer& data)
+RtpPacketPtr RtpPacket::fromUdpPacket(const std::shared_ptr<Track>& track, const srtc::ByteBuffer& data)
 {
-    ByteReader reader(data);
+    RtpPacketView view;
+    if (!RtpPacketView::parse(data.data(), data.size(), view)) {
+        return {};
+    }
 
-    if (reader.remaining() < 4 + 4 + 4) {
+    assert((view.ssrc == track->getSSRC() && view.payloadId == track->getPayloadId()) ||
+           (view.ssrc == track->getRtxSSRC() && view.payloadId == track->getRtxPayloadId()));
+
+    return make(track,
+                view.ssrc,
+                view.payloadId,
+                view.marker,
+                0,
+                view.sequence,
+                view.timestamp,
+                0,
+                view.copyExtension(),
+                ByteBuffer{ view.payloadData, view.payloadSize });
+}
+
+// ----- RtpPacketView
+
+std::optional<RtpExtension::Value> RtpPacketView::findExtension(uint8_t id) const
+{
+    if (extensionId == 0) {
         return {};
     }
 
+    return RtpExtension::findAny(extensionId, extensionData, extensionSize, id);
+}
+
+RtpExtension RtpPacketView::copyExtension() const
+{
+    if (extensionId == 0) {
+        return {};
+    }
+
+    RtpExtension extension(extensionId, ByteBuffer{ extensionData, extensionSize });
+    extension.trimPadding();
+    return extension;
+}
+
+bool RtpPacketView::parse(const uint8_t* data, size_t size, RtpPacketView& view)
+{
+    ByteReader reader(data, size);
+
+    if (reader.remaining() < 4 + 4 + 4) {
+        return false;
+    }
+
     const auto header = reader.readU16();
     const auto padding = (header & (1 << 13)) != 0;
-    const auto marker = (header & (1 << 7)) != 0;
-    const auto payloadId = header & 0x7Fu;
 
-    const auto sequence = reader.readU16();
-    const auto timestamp = reader.readU32();
-    const auto ssrc = reader.readU32();
+    view.marker = (header & (1 << 7)) != 0;
+    view.payloadId = header & 0x7Fu;
 
-    assert((ssrc == track->getSSRC() && payloadId == track->getPayloadId()) ||
-           (ssrc == track->getRtxSSRC() && payloadId == track->getRtxPayloadId()));
+    view.sequence = reader.readU16();
+    view.timestamp = reader.readU32();
+    view.ssrc = reader.readU32();
 
-    RtpExtension extension;
+    view.extensionId = 0;
+    view.extensionData = nullptr;
+    view.extensionSize = 0;
 
     if ((header & (1 << 12)) != 0) {
         // There is an extension
         if (reader.remaining() < 4) {
-            return {};
+            return false;
         }
 
         const auto extId = reader.readU16();
         const auto extSize = reader.readU16() * 4u;
 
         if (reader.remaining() < extSize) {
-            return {};
+            return false;
         }
 
-        auto extData = reader.readByteBuffer(extSize);
         if (RtpExtension::isValidExtensionId(extId)) {
-            extension = RtpExtension(extId, std::move(extData));
-            extension.trimPadding();
+            view.extensionId = extId;
+            view.extensionData = reader.current();
+            view.extensionSize = extSize;
         }
+        reader.skip(extSize);
     }
 
     auto payloadSize = reader.remaining();
-    auto payload = reader.readByteBuffer(payloadSize);
+    const auto payloadData = reader.current();
 
     if (padding) {
-        if (payload.empty()) {
-            return {};
+        if (payloadSize == 0) {
+            return false;
         }
-        const auto paddingCount = payload.data()[payloadSize - 1];
+        const auto paddingCount = payloadData[payloadSize - 1];
         if (paddingCount > payloadSize) {
-            return {};
+            return false;
         }
 
         payloadSize -= paddingCount;
-        payload.resize(payloadSize);
     }
 
-    return std::make_shared<RtpPacket>(
-        track, ssrc, payloadId, marker, 0, sequence, timestamp, 0, std::move(extension), std::move(payload));
+    view.payloadData = payloadData;
+    view.payloadSize = payloadSize;
+
+    return true;
 }
 
 } // namespace srtc
@@ -0,0 +1,34 @@
+#include "srtc/rtp_packet_pool.h"
+
+#include <cassert>
+
+namespace srtc
+{
+
+RtpPacketPool::RtpPacketPool()
+    : mImpl(sizeof(RtpPacket))
+    , mLiveCount(0)
+{
+}
+
+RtpPacketPool::~RtpPacketPool()
+{
+    assert(mLiveCount == 0);
+}
+
+size_t RtpPacketPool::getLiveCount() const
+{
+    return mLiveCount;
+}
+
+void RtpPacketPool::release(RtpPacket* packet)
+{
+    assert(packet->mPool == this);
+    assert(mLiveCount > 0);
+    mLiveCount -= 1;
+
+    packet->~RtpPacket();
+    mImpl.release(packet);
+}
+
+} // namespace srtc
@@ -31,22 +31,23 @@ std::shared_ptr<RtpResponderTWCC> RtpResponderTWCC::factory(const std::shared_pt
     return std::make_shared<RtpResponderTWCC>();
 }
 
-void RtpResponderTWCC::onMediaPacket(const std::shared_ptr<RtpPacket>& packet)
+void RtpResponderTWCC::onMediaPacket(const std::shared_ptr<Track>& track, const RtpPacketView& packet)
 {
-    const auto track = packet->getTrack();
     const auto ext_id = getExtensionId(track);
     if (ext_id == 0) {
         return;
     }
 
-    const auto& extension = packet->getExtension();
-    const auto seq = extension.findU16(ext_id);
-    if (!seq.has_value()) {
+    const auto value = packet.findExtension(ext_id);
+    if (!value.has_value() || value->size < 2) {
         return;
     }
 
+    ByteReader reader(value->ptr, value->size);
+    const auto seq = reader.readU16();
+
     const auto now = getStableTimeMicros();
-    mPacketHistory->saveIncomingPacket(seq.value(), now);
+    mPacketHistory->saveIncomingPacket(seq, now);
 }
 
 std::vector<std::shared_ptr<RtcpPacket>> RtpResponderTWCC::run(const std::shared_ptr<Track>& track)
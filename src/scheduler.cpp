@@ -7,6 +7,14 @@
 
 #define LOG(level, tag, ...) srtc::log(level, tag, __VA_ARGS__)
 
+namespace
+{
+
+// The scoped scheduler's list of submitted tasks is not trimmed until it's this big
+constexpr size_t kRemoveExpiredMinSize = 16;
+
+} // namespace
+
 namespace srtc
 {
 
@@ -30,13 +38,18 @@ Scheduler::~Scheduler() = default;
 
 // ----- ThreadScheduler
 
-ThreadScheduler::TaskImpl::TaskImpl(
-    const std::weak_ptr<ThreadScheduler>& owner, const When& when, const char* file, int line, const Func& func)
+ThreadScheduler::TaskImpl::TaskImpl(const std::weak_ptr<ThreadScheduler>& owner,
+                                    const When& when,
+                                    const char* file,
+                                    int line,
+                                    const Func& func,
+                                    const Delay& interval)
     : mOwner(owner)
     , mWhen(when)
     , mFile(file)
     , mLine(line)
     , mFunc(func)
+    , mInterval(interval)
 {
     assert(mOwner.lock());
 }
@@ -84,12 +97,27 @@ ThreadScheduler::~ThreadScheduler()
 }
 
 std::weak_ptr<Task> ThreadScheduler::submit(const Delay& delay, const char* file, int line, const Func& func)
+{
+    return submitImpl(delay, file, line, func, Delay::zero());
+}
+
+std::weak_ptr<Task> ThreadScheduler::submitPeriodic(const Delay& interval,
+                                                    const char* file,
+                                                    int line,
+                                                    const Func& func)
+{
+    assert(interval > Delay::zero());
+    return submitImpl(interval, file, line, func, std::max(interval, Delay{ 1 }));
+}
+
+std::weak_ptr<Task> ThreadScheduler::submitImpl(
+    const Delay& delay, const char* file, int line, const Func& func, const Delay& interval)
 {
     // Please instantiate using std::make_shared
     assert(weak_from_this().lock());
 
     const auto when = std::chrono::steady_clock::now() + delay;
-    const auto task = std::make_shared<TaskImpl>(weak_from_this(), when, file, line, func);
+    const auto task = std::make_shared<TaskImpl>(weak_from_this(), when, file, line, func, interval);
 
     {
         std::lock_guard lock(mMutex);
@@ -122,11 +150,18 @@ void ThreadScheduler::cancelImpl(const std::shared_ptr<TaskImpl>& task)
 {
     std::unique_lock lock(mMutex);
 
+    task->mIsCancelled = true;
+
     if (const auto iter = std::find(mTaskQueue.begin(), mTaskQueue.end(), task); iter != mTaskQueue.end()) {
         mTaskQueue.erase(iter);
         return;
     }
 
+    if (std::this_thread::get_id() == mThread.get_id()) {
+        // A task cancelling itself while running
+        return;
+    }
+
     mCondVar.wait(lock, [this, task]() SRTC_EXCLUSIVE_LOCKS_REQUIRED(mMutex) { return mIsQuit || task->mIsCompleted; });
 }
 
@@ -140,8 +175,8 @@ std::weak_ptr<Task> ThreadScheduler::updateImpl(const std::shared_ptr<TaskImpl>&
     }
 
     const auto when = std::chrono::steady_clock::now() + delay;
-    const auto newTask =
-        std::make_shared<TaskImpl>(weak_from_this(), when, oldTask->mFile, oldTask->mLine, oldTask->mFunc);
+    const auto newTask = std::make_shared<TaskImpl>(
+        weak_from_this(), when, oldTask->mFile, oldTask->mLine, oldTask->mFunc, oldTask->mInterval);
 
     mTaskQueue.insert(std::upper_bound(mTaskQueue.begin(), mTaskQueue.end(), newTask, TaskImplLess()), newTask);
 
@@ -163,7 +198,18 @@ void ThreadScheduler::threadFunc([[maybe_unused]] const std::string name)
             std::unique_lock lock(mMutex);
 
             if (task) {
-                task->mIsCompleted = true;
+                if (task->mInterval > Delay::zero() && !task->mIsCancelled && !mIsQuit) {
+                    // Periodic, schedule the next run
+                    const auto now = std::chrono::steady_clock::now();
+                    task->mWhen += task->mInterval;
+                    if (task->mWhen <= now) {
+                        task->mWhen = now + task->mInterval;
+                    }
+                    mTaskQueue.insert(std::upper_bound(mTaskQueue.begin(), mTaskQueue.end(), task, TaskImplLess()),
+                                      task);
+                } else {
+                    task->mIsCompleted = true;
+                }
                 task.reset();
                 mCondVar.notify_all();
             }
@@ -214,13 +260,18 @@ void ThreadScheduler::threadFunc([[maybe_unused]] const std::string name)
 
 // ----- LoopScheduler
 
-LoopScheduler::TaskImpl::TaskImpl(
-    const std::weak_ptr<LoopScheduler>& owner, const When& when, const char* file, int line, const Func& func)
+LoopScheduler::TaskImpl::TaskImpl(const std::weak_ptr<LoopScheduler>& owner,
+                                  const When& when,
+                                  const char* file,
+                                  int line,
+                                  const Func& func,
+                                  const Delay& interval)
     : mOwner(owner)
     , mWhen(when)
     , mFile(file)
     , mLine(line)
     , mFunc(func)
+    , mInterval(interval)
 {
     assert(mOwner.lock());
 }
@@ -246,32 +297,38 @@ std::weak_ptr<Task> LoopScheduler::TaskImpl::update(const Delay& delay)
 }
 
 LoopScheduler::LoopScheduler()
-    : mThreadId(std::this_thread::get_id())
+    : mStartTime(std::chrono::steady_clock::now())
+    , mThreadId(std::this_thread::get_id())
+    , mTimerWheel(0)
 {
 }
 
 LoopScheduler::~LoopScheduler()
 {
     assertCurrentThread();
-}
 
-std::weak_ptr<Task> LoopScheduler::submit(const Delay& delay, const char* file, int line, const Func& func)
-{
-    // Please instantiate using std::make_shared
-    assert(weak_from_this().lock());
+    // Break the tasks' references to themselves
+    TimerList list;
+    mTimerWheel.takeAll(list);
+    list.splice(mDueList);
 
-    if (line == 781) {
-        LOG(SRTC_LOG_V, "submit for %s %d", file, line);
+    while (const auto node = list.popFront()) {
+        const auto task = std::move(static_cast<TaskImpl*>(node)->mSelf);
     }
+}
 
-    assertCurrentThread();
-
-    const auto when = std::chrono::steady_clock::now() + delay;
-    const auto task = std::make_shared<TaskImpl>(weak_from_this(), when, file, line, func);
-
-    mTaskQueue.insert(std::upper_bound(mTaskQueue.begin(), mTaskQueue.end(), task, TaskImplLess()), task);
+std::weak_ptr<Task> LoopScheduler::submit(const Delay& delay, const char* file, int line, const Func& func)
+{
+    return submitImpl(delay, file, line, func, Delay::zero());
+}
 
-    return task;
+std::weak_ptr<Task> LoopScheduler::submitPeriodic(const Delay& interval,
+                                                  const char* file,
+                                                  int line,
+                                                  const Func& func)
+{
+    assert(interval > Delay::zero());
+    return submitImpl(interval, file, line, func, std::max(interval, Delay{ 1 }));
 }
 
 void LoopScheduler::cancel(std::shared_ptr<Task>& task)
@@ -287,36 +344,48 @@ std::shared_ptr<RealScheduler> LoopScheduler::getRealScheduler()
 
 void LoopScheduler::dump()
 {
-    srtc::log(SRTC_LOG_V, "LoopScheduler", "Queue contains %zu items", mTaskQueue.size());
+    srtc::log(SRTC_LOG_V, "LoopScheduler", "Queue contains %zu items", mTimerWheel.size() + mDueList.size());
 }
 
-int LoopScheduler::getTimeoutMillis(int defaultValue) const
+void LoopScheduler::updateDeadline(Deadline& deadline) const
 {
     assertCurrentThread();
 
-    if (mTaskQueue.empty()) {
-        return defaultValue;
+    if (!mDueList.isEmpty()) {
+        deadline.update(deadline.getNow());
+        return;
     }
 
-    const auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(mTaskQueue.front()->mWhen -
-                                                                            std::chrono::steady_clock::now());
-    if (diff <= std::chrono::milliseconds::zero()) {
-        return 0;
+    // A task's tick is not reached until the full millisecond has passed
+    if (const auto tick = mTimerWheel.getNextExpiration(); tick != std::numeric_limits<uint64_t>::max()) {
+        deadline.update(mStartTime + std::chrono::milliseconds(tick));
     }
-    if (diff.count() > std::numeric_limits<unsigned int>::max()) {
-        return std::numeric_limits<int>::max();
-    }
-    return static_cast<int>(diff.count());
 }
 
 void LoopScheduler::run()
 {
     assertCurrentThread();
 
-    while (!mTaskQueue.empty() && mTaskQueue.front()->mWhen <= std::chrono::steady_clock::now()) {
-        const auto task = mTaskQueue.front();
-        mTaskQueue.erase(mTaskQueue.begin());
+    // The last tick which has fully passed
+    const auto elapsed = std::chrono::floor<std::chrono::milliseconds>(std::chrono::steady_clock::now() - mStartTime);
+    mTimerWheel.advance(static_cast<uint64_t>(elapsed.count()), mDueList);
+
+    // Tasks which are submitted with no delay while we're running get added to the due list and run here too
+    while (const auto node = mDueList.popFront()) {
+        const auto impl = static_cast<TaskImpl*>(node);
+        const auto task = impl->mInterval > Delay::zero() ? impl->mSelf : std::move(impl->mSelf);
+
         task->mFunc();
+
+        // A periodic task is rescheduled unless it was cancelled or updated while running
+        if (task->mSelf && !task->isLinked()) {
+            const auto curr = std::chrono::steady_clock::now();
+            task->mWhen += task->mInterval;
+            if (task->mWhen <= curr) {
+                task->mWhen = curr + task->mInterval;
+            }
+            schedule(task);
+        }
     }
 }
 
@@ -325,42 +394,65 @@ void LoopScheduler::assertCurrentThread() const
     assert(mThreadId == std::this_thread::get_id());
 }
 
-void LoopScheduler::cancelImpl(std::shared_ptr<TaskImpl>& task)
+std::weak_ptr<Task> LoopScheduler::submitImpl(
+    const Delay& delay, const char* file, int line, const Func& func, const Delay& interval)
 {
+    // Please instantiate using std::make_shared
+    assert(weak_from_this().lock());
+
     assertCurrentThread();
 
-    if (const auto iter = std::find(mTaskQueue.begin(), mTaskQueue.end(), task); iter != mTaskQueue.end()) {
-        mTaskQueue.erase(iter);
+    const auto when = std::chrono::steady_clock::now() + delay;
+    const auto task = std::make_shared<TaskImpl>(weak_from_this(), when, file, line, func, interval);
+
+    schedule(task);
+
+    return task;
+}
+
+void LoopScheduler::schedule(const std::shared_ptr<TaskImpl>& task)
+{
+    if (task->mWhen <= std::chrono::steady_clock::now()) {
+        mDueList.pushBack(task.get());
+    } else {
+        mTimerWheel.insert(task.get(), getTick(task->mWhen));
     }
+
+    task->mSelf = task;
 }
 
-std::weak_ptr<Task> LoopScheduler::updateImpl(const std::shared_ptr<TaskImpl>& oldTask,
-                                              const srtc::Scheduler::Delay& delay)
+void LoopScheduler::cancelImpl(const std::shared_ptr<TaskImpl>& task)
 {
     assertCurrentThread();
 
-    if (const auto iter = std::find(mTaskQueue.begin(), mTaskQueue.end(), oldTask); iter != mTaskQueue.end()) {
-        mTaskQueue.erase(iter);
-    }
+    task->unlink();
+    task->mSelf.reset();
+}
 
-    const auto when = std::chrono::steady_clock::now() + delay;
-    const auto newTask =
-        std::make_shared<TaskImpl>(weak_from_this(), when, oldTask->mFile, oldTask->mLine, oldTask->mFunc);
+std::weak_ptr<Task> LoopScheduler::updateImpl(const std::shared_ptr<TaskImpl>& task,
+                                              const srtc::Scheduler::Delay& delay)
+{
+    assertCurrentThread();
 
-    mTaskQueue.insert(std::upper_bound(mTaskQueue.begin(), mTaskQueue.end(), newTask, TaskImplLess()), newTask);
+    task->unlink();
+    task->mWhen = std::chrono::steady_clock::now() + delay;
+    schedule(task);
 
-    return newTask;
+    return task;
+}
+
+uint64_t LoopScheduler::getTick(const When& when) const
+{
+    // The first tick at or after the time point
+    const auto ticks = std::chrono::ceil<std::chrono::milliseconds>(when - mStartTime).count();
+    return ticks <= 0 ? 0 : static_cast<uint64_t>(ticks);
 }
 
 // ScopedScheduler
 
-ScopedScheduler::TaskImpl::TaskImpl(
-    ScopedScheduler* owner, const std::weak_ptr<Task>& task, const char* file, int line, const Func& func)
+ScopedScheduler::TaskImpl::TaskImpl(ScopedScheduler* owner, const std::weak_ptr<Task>& task)
     : mOwner(owner)
     , mTask(task)
-    , mFile(file)
-    , mLine(line)
-    , mFunc(func)
 {
 }
 
@@ -379,7 +471,8 @@ std::weak_ptr<Task> ScopedScheduler::TaskImpl::update(const Delay& delay)
 }
 
 ScopedScheduler::ScopedScheduler(const std::shared_ptr<RealScheduler>& scheduler)
-    : mScheduler(scheduler)
+    : mRemoveExpiredSize(kRemoveExpiredMinSize)
+    , mScheduler(scheduler)
 {
 }
 
@@ -387,26 +480,31 @@ ScopedScheduler::~ScopedScheduler()
 {
     std::lock_guard lock(mMutex);
 
-    for (const auto& iter : mSubmitted) {
-        if (const auto task = iter->mTask.lock()) {
+    while (const auto node = mSubmitted.popFront()) {
+        const auto impl = std::move(static_cast<TaskImpl*>(node)->mSelf);
+        if (const auto task = impl->mTask.lock()) {
             task->cancel();
         }
     }
-
-    mSubmitted.clear();
 }
 
 std::weak_ptr<Task> ScopedScheduler::submit(const Delay& delay, const char* file, int line, const Func& func)
 {
     std::lock_guard lock(mMutex);
 
-    removeExpiredLocked();
-
     const auto task = mScheduler->submit(delay, file, line, func);
-    const auto impl = std::make_shared<TaskImpl>(this, task, file, line, func);
-    mSubmitted.push_back(impl);
+    return addLocked(task);
+}
 
-    return impl;
+std::weak_ptr<Task> ScopedScheduler::submitPeriodic(const Delay& interval,
+                                                    const char* file,
+                                                    int line,
+                                                    const Func& func)
+{
+    std::lock_guard lock(mMutex);
+
+    const auto task = mScheduler->submitPeriodic(interval, file, line, func);
+    return addLocked(task);
 }
 
 void ScopedScheduler::cancel(std::shared_ptr<Task>& task)
@@ -420,6 +518,21 @@ std::shared_ptr<RealScheduler> ScopedScheduler::getRealScheduler()
     return mScheduler;
 }
 
+std::weak_ptr<Task> ScopedScheduler::addLocked(const std::weak_ptr<Task>& task)
+{
+    // Tasks which have run are removed in bulk, when the list has doubled in size since the last time
+    if (mSubmitted.size() >= mRemoveExpiredSize) {
+        removeExpiredLocked();
+        mRemoveExpiredSize = std::max(kRemoveExpiredMinSize, mSubmitted.size() * 2);
+    }
+
+    const auto impl = std::make_shared<TaskImpl>(this, task);
+    impl->mSelf = impl;
+    mSubmitted.pushBack(impl.get());
+
+    return impl;
+}
+
 void ScopedScheduler::cancelImpl(const std::shared_ptr<TaskImpl>& task)
 {
     if (const auto ptr = task->mTask.lock()) {
@@ -428,39 +541,42 @@ void ScopedScheduler::cancelImpl(const std::shared_ptr<TaskImpl>& task)
 
     std::lock_guard lock(mMutex);
 
-    if (const auto iter = std::find(mSubmitted.begin(), mSubmitted.end(), task); iter != mSubmitted.end()) {
-        mSubmitted.erase(iter);
-    }
+    task->unlink();
+    task->mSelf.reset();
 }
 
-std::weak_ptr<Task> ScopedScheduler::updateImpl(const std::shared_ptr<TaskImpl>& oldTask, const Delay& delay)
+std::weak_ptr<Task> ScopedScheduler::updateImpl(const std::shared_ptr<TaskImpl>& task, const Delay& delay)
 {
     std::lock_guard lock(mMutex);
 
-    removeExpiredLocked();
-
-    if (const auto iter = std::find(mSubmitted.begin(), mSubmitted.end(), oldTask); iter != mSubmitted.end()) {
-        mSubmitted.erase(iter);
+    if (const auto ptr = task->mTask.lock()) {
+        task->mTask = ptr->update(delay);
+        if (!task->isLinked()) {
+            task->mSelf = task;
+            mSubmitted.pushBack(task.get());
+        }
+        return task;
     }
 
-    if (const auto ptr = oldTask->mTask.lock()) {
-        const auto updated = ptr->update(delay);
-        const auto newTask = std::make_shared<TaskImpl>(this, updated, oldTask->mFile, oldTask->mLine, oldTask->mFunc);
-        mSubmitted.push_back(newTask);
-        return newTask;
-    }
+    task->unlink();
+    task->mSelf.reset();
 
     return {};
 }
 
 void ScopedScheduler::removeExpiredLocked()
 {
-    for (auto iter = mSubmitted.begin(); iter != mSubmitted.end();) {
-        if ((*iter)->mTask.expired()) {
-            iter = mSubmitted.erase(iter);
-        } else {
-            ++iter;
+    auto node = mSubmitted.first();
+    while (node) {
+        const auto next = mSubmitted.next(node);
+
+        const auto impl = static_cast<TaskImpl*>(node);
+        if (impl->mTask.expired()) {
+            impl->unlink();
+            impl->mSelf.reset();
         }
+
+        node = next;
     }
 }
 
@@ -43,6 +43,7 @@
  */
 
 #include "sctp_crc32.h"
+#include "sctp_crc32_hw.h"
 
 #include <cstddef>
 #include <cstdint>
@@ -165,7 +166,7 @@ const uint32_t crc_tableil8_o48[256] = {
     0xC3D4340C, 0x6695A672, 0x8CBB6601, 0x29FAF47F, 0x5D0A9016, 0xF84B0268, 0x1265C21B, 0xB7245065,
     0x6A638C57, 0xCF221E29, 0x250CDE5A, 0x804D4C24, 0xF4BD284D, 0x51FCBA33, 0xBBD27A40, 0x1E93E83E,
     0x5232B292, 0xF77320EC, 0x1D5DE09F, 0xB81C72E1, 0xCCEC1688, 0x69AD84F6, 0x83834485, 0x26C2D6FB,
-    0x1AC1F1DD, 0xBF8063A3, 0x55AEA3D0, 0xF0EF31AE, 0x841F55C7, 0x195EC7B9, 0xCB7007CA, 0x6E3195B4,
+    0x1AC1F1DD, 0xBF8063A3, 0x55AEA3D0, 0xF0EF31AE, 0x841F55C7, 0x215EC7B9, 0xCB7007CA, 0x6E3195B4,
     0x2290CF18, 0x87D15D66, 0x6DFF9D15, 0xC8BE0F6B, 0xBC4E6B02, 0x190FF97C, 0xF321390F, 0x5660AB71,
     0x4C42F79A, 0xE90365E4, 0x032DA597, 0xA66C37E9, 0xD29C5380, 0x77DDC1FE, 0x9DF3018D, 0x38B293F3,
     0x7413C95F, 0xD1525B21, 0x3B7C9B52, 0x9E3D092C, 0xEACD6D45, 0x4F8CFF3B, 0xA5A23F48, 0x00E3AD36,
@@ -484,13 +485,35 @@ crc32c_compute_internal(uint32_t crc, const uint8_t* data, size_t length)
     return crc32c_sb8_64bit(crc, data, length, init_bytes);
 }
 
+const crc32c_hw_impl& crc32c_select()
+{
+    static const crc32c_hw_impl impl = [] {
+        const auto hw = crc32c_select_hw();
+        if (hw.update) {
+            return hw;
+        }
+        return crc32c_hw_impl{ "table", crc32c_compute_internal };
+    }();
+    return impl;
+}
+
 } // anonymous namespace
 
 uint32_t crc32c_update(uint32_t crc, const uint8_t* data, size_t length)
+{
+    return crc32c_select().update(crc, data, length);
+}
+
+uint32_t crc32c_update_table(uint32_t crc, const uint8_t* data, size_t length)
 {
     return crc32c_compute_internal(crc, data, length);
 }
 
+const char* crc32c_implementation()
+{
+    return crc32c_select().name;
+}
+
 uint32_t crc32c_finalize(uint32_t crc)
 {
 #if BYTE_ORDER == BIG_ENDIAN
@@ -505,7 +528,7 @@ uint32_t crc32c_finalize(uint32_t crc)
 
 uint32_t crc32c(const uint8_t* data, size_t length)
 {
-    return crc32c_finalize(crc32c_compute_internal(0xFFFFFFFFu, data, length));
+    return crc32c_finalize(crc32c_update(0xFFFFFFFFu, data, length));
 }
 
 } // namespace srtc::sctp
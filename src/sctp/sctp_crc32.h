@@ -48,4 +48,11 @@ uint32_t crc32c_finalize(uint32_t crc);
 // Convenience: compute CRC-32c of a complete buffer in one call.
 uint32_t crc32c(const uint8_t* data, size_t length);
 
+// The implementation used by the above, picked once at runtime from what the CPU supports:
+// "sse4.2+pclmul", "sse4.2", "armv8" or "table".
+const char* crc32c_implementation();
+
+// The portable slicing-by-8 version, used when the CPU has no CRC-32c instructions.
+uint32_t crc32c_update_table(uint32_t crc, const uint8_t* data, size_t length);
+
 } // namespace srtc::sctp
@@ -0,0 +1,206 @@
+#include "sctp_crc32_hw.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#  define SRTC_CRC32C_X86 1
+#  include <nmmintrin.h>
+#  include <wmmintrin.h>
+#  if defined(_MSC_VER) && !defined(__clang__)
+#    include <intrin.h>
+#    define SRTC_TARGET_SSE42
+#    define SRTC_TARGET_SSE42_PCLMUL
+#  else
+#    include <cpuid.h>
+#    define SRTC_TARGET_SSE42        __attribute__((target("sse4.2")))
+#    define SRTC_TARGET_SSE42_PCLMUL __attribute__((target("sse4.2,pclmul")))
+#  endif
+#elif (defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))) || defined(_M_ARM64)
+#  define SRTC_CRC32C_ARM64 1
+#  include <arm_acle.h>
+#  if defined(__linux__) || defined(__ANDROID__)
+#    include <sys/auxv.h>
+#    ifndef HWCAP_CRC32
+#      define HWCAP_CRC32 (1 << 7)
+#    endif
+#  elif defined(_WIN32)
+#    include <windows.h>
+#  endif
+#  if defined(_MSC_VER) && !defined(__clang__)
+#    define SRTC_TARGET_CRC
+#  elif defined(__clang__)
+#    define SRTC_TARGET_CRC __attribute__((target("crc")))
+#  else
+#    define SRTC_TARGET_CRC __attribute__((target("+crc")))
+#  endif
+#endif
+
+namespace srtc::sctp {
+
+namespace {
+
+#if defined(SRTC_CRC32C_X86)
+
+// Three streams of this size are in flight at once, to hide the latency of the crc32 instruction
+constexpr size_t kStreamBytes = 128;
+
+// x^n mod P in the reflected representation, where bit i stands for x^(31 - i)
+constexpr uint32_t crc32c_xpow(size_t n)
+{
+    uint32_t v = 0x80000000u;
+    for (size_t i = 0; i < n; i++) {
+        v = (v >> 1) ^ ((v & 1) ? 0x82F63B78u : 0u);
+    }
+    return v;
+}
+
+// Multiplying by x^(8n - 33) with PCLMULQDQ and reducing with crc32 (which adds x^33) advances
+// a CRC state over n zero bytes
+constexpr uint32_t kShiftOneStream = crc32c_xpow(8 * kStreamBytes - 33);
+constexpr uint32_t kShiftTwoStreams = crc32c_xpow(8 * 2 * kStreamBytes - 33);
+
+inline uint64_t load_u64(const uint8_t* p)
+{
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+SRTC_TARGET_SSE42
+uint32_t crc32c_sse42(uint32_t crc, const uint8_t* data, size_t length)
+{
+    const uint8_t* p = data;
+
+    while (length > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+        crc = _mm_crc32_u8(crc, *p++);
+        length--;
+    }
+
+    uint64_t crc64 = crc;
+    while (length >= 8) {
+        crc64 = _mm_crc32_u64(crc64, load_u64(p));
+        p += 8;
+        length -= 8;
+    }
+    crc = static_cast<uint32_t>(crc64);
+
+    while (length > 0) {
+        crc = _mm_crc32_u8(crc, *p++);
+        length--;
+    }
+    return crc;
+}
+
+SRTC_TARGET_SSE42_PCLMUL
+uint32_t crc32c_shift(uint32_t crc, uint32_t k)
+{
+    const __m128i product = _mm_clmulepi64_si128(
+        _mm_cvtsi32_si128(static_cast<int>(crc)), _mm_cvtsi32_si128(static_cast<int>(k)), 0x00);
+    return static_cast<uint32_t>(_mm_crc32_u64(0, static_cast<uint64_t>(_mm_cvtsi128_si64(product))));
+}
+
+SRTC_TARGET_SSE42_PCLMUL
+uint32_t crc32c_sse42_pclmul(uint32_t crc, const uint8_t* data, size_t length)
+{
+    const uint8_t* p = data;
+
+    while (length > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+        crc = _mm_crc32_u8(crc, *p++);
+        length--;
+    }
+
+    // The CRC of the three streams is: the first one advanced over the other two, the second one
+    // advanced over the third, and the third one
+    while (length >= 3 * kStreamBytes) {
+        uint64_t crc0 = crc;
+        uint64_t crc1 = 0;
+        uint64_t crc2 = 0;
+
+        for (size_t i = 0; i < kStreamBytes; i += 8) {
+            crc0 = _mm_crc32_u64(crc0, load_u64(p + i));
+            crc1 = _mm_crc32_u64(crc1, load_u64(p + kStreamBytes + i));
+            crc2 = _mm_crc32_u64(crc2, load_u64(p + 2 * kStreamBytes + i));
+        }
+
+        crc = crc32c_shift(static_cast<uint32_t>(crc0), kShiftTwoStreams) ^
+              crc32c_shift(static_cast<uint32_t>(crc1), kShiftOneStream) ^ static_cast<uint32_t>(crc2);
+
+        p += 3 * kStreamBytes;
+        length -= 3 * kStreamBytes;
+    }
+
+    return crc32c_sse42(crc, p, length);
+}
+
+#elif defined(SRTC_CRC32C_ARM64)
+
+SRTC_TARGET_CRC
+uint32_t crc32c_armv8(uint32_t crc, const uint8_t* data, size_t length)
+{
+    const uint8_t* p = data;
+
+    while (length > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+        crc = __crc32cb(crc, *p++);
+        length--;
+    }
+
+    while (length >= 8) {
+        uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        crc = __crc32cd(crc, value);
+        p += 8;
+        length -= 8;
+    }
+
+    while (length > 0) {
+        crc = __crc32cb(crc, *p++);
+        length--;
+    }
+    return crc;
+}
+
+#endif
+
+} // anonymous namespace
+
+crc32c_hw_impl crc32c_select_hw()
+{
+#if defined(SRTC_CRC32C_X86)
+    bool has_sse42 = false;
+    bool has_pclmul = false;
+#  if defined(_MSC_VER) && !defined(__clang__)
+    int info[4] = {};
+    __cpuid(info, 1);
+    has_sse42 = (info[2] & (1 << 20)) != 0;
+    has_pclmul = (info[2] & (1 << 1)) != 0;
+#  else
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        has_sse42 = (ecx & bit_SSE4_2) != 0;
+        has_pclmul = (ecx & bit_PCLMUL) != 0;
+    }
+#  endif
+    if (has_sse42 && has_pclmul) {
+        return { "sse4.2+pclmul", crc32c_sse42_pclmul };
+    }
+    if (has_sse42) {
+        return { "sse4.2", crc32c_sse42 };
+    }
+#elif defined(SRTC_CRC32C_ARM64)
+#  if defined(__ARM_FEATURE_CRC32) || defined(__APPLE__)
+    // Built for it, or always there
+    return { "armv8", crc32c_armv8 };
+#  elif defined(__linux__) || defined(__ANDROID__)
+    if ((getauxval(AT_HWCAP) & HWCAP_CRC32) != 0) {
+        return { "armv8", crc32c_armv8 };
+    }
+#  elif defined(_WIN32)
+    if (IsProcessorFeaturePresent(PF_ARM_V8_CRC32_INSTRUCTIONS_AVAILABLE)) {
+        return { "armv8", crc32c_armv8 };
+    }
+#  endif
+#endif
+    return { nullptr, nullptr };
+}
+
+} // namespace srtc::sctp
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace srtc::sctp {
+
+// CRC-32c with CPU instructions: SSE4.2 (with PCLMULQDQ for combining interleaved streams) on x86-64,
+// and the CRC32 extension on ARMv8. Same state and semantics as crc32c_update().
+
+using crc32c_update_func = uint32_t (*)(uint32_t crc, const uint8_t* data, size_t length);
+
+struct crc32c_hw_impl {
+    const char* name;
+    // nullptr if the CPU doesn't have the instructions, or we were built for another architecture
+    crc32c_update_func update;
+};
+
+// Checks what the CPU supports at runtime
+crc32c_hw_impl crc32c_select_hw();
+
+} // namespace srtc::sctp
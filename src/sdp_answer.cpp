@@ -420,7 +420,8 @@ std::pair<std::shared_ptr<SdpAnswer>, Error> SdpAnswerParser::parse(const std::s
     if (hasMedia && !isRtcpMux) {
         return { {}, { Error::Code::InvalidData, "The rtcp-mux extension is required" } };
     }
-    if (hostList.empty()) {
+    if (hostList.empty() && !offer->getConfig().enable_ice_lite) {
+        // With ICE-lite, the peer connects to us
         return { {}, { Error::Code::InvalidData, "No hosts to connect to" } };
     }
 
@@ -1,3 +1,10 @@
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#endif
+
 #include <cassert>
 #include <cstring>
 #include <sstream>
@@ -47,6 +54,36 @@ std::string list_to_string(size_t start, size_t end)
     return ss.str();
 }
 
+// https://datatracker.ietf.org/doc/html/rfc8445#section-5.1.2.1, host candidates with local preference
+// going down in the order they were configured
+void write_ice_lite_candidates(std::stringstream& ss, const std::vector<srtc::Host>& hostList)
+{
+    for (size_t i = 0; i < hostList.size(); i += 1) {
+        const auto& addr = hostList[i].addr;
+
+        char buf[INET6_ADDRSTRLEN];
+        const char* ptr;
+        uint16_t port;
+        if (addr.ss.ss_family == AF_INET6) {
+            ptr = inet_ntop(AF_INET6, &addr.sin_ipv6.sin6_addr, buf, sizeof(buf));
+            port = ntohs(addr.sin_ipv6.sin6_port);
+        } else {
+            ptr = inet_ntop(AF_INET, &addr.sin_ipv4.sin_addr, buf, sizeof(buf));
+            port = ntohs(addr.sin_ipv4.sin_port);
+        }
+        if (ptr == nullptr) {
+            continue;
+        }
+
+        const auto priority = (126u << 24) | ((65535u - static_cast<uint32_t>(i)) << 8) | 255u;
+        ss << "a=candidate:" << (i + 1) << " 1 udp " << priority << " " << ptr << " " << port << " typ host"
+           << std::endl;
+    }
+    if (!hostList.empty()) {
+        ss << "a=end-of-candidates" << std::endl;
+    }
+}
+
 constexpr uint16_t kSctpPort = 5000;
 constexpr uint32_t kSctpMaxMessageSize = 262144;
 
@@ -55,7 +92,10 @@ constexpr uint32_t kSctpMaxMessageSize = 262144;
 namespace srtc
 {
 
-SdpOffer::SdpOffer(Direction direction, const Config& config, const std::vector<MediaLine>& media)
+SdpOffer::SdpOffer(Direction direction,
+                   const Config& config,
+                   const std::vector<MediaLine>& media,
+                   const std::shared_ptr<X509Certificate>& cert)
     : mRandomGenerator(0, 0x7ffffffe)
     , mDirection(direction)
     , mConfig(config)
@@ -63,7 +103,7 @@ SdpOffer::SdpOffer(Direction direction, const Config& config, const std::vector<
     , mOriginId((static_cast<uint64_t>(mRandomGenerator.next()) << 32) | mRandomGenerator.next())
     , mIceUfrag(generateRandomString(8))
     , mIcePassword(generateRandomString(24))
-    , mCert(std::make_shared<X509Certificate>())
+    , mCert(cert)
 {
 }
 
@@ -94,6 +134,9 @@ std::pair<std::string, Error> SdpOffer::generate()
     ss << "t=0 0" << std::endl;
     ss << "a=extmap-allow-mixed" << std::endl;
     ss << "a=msid-semantic: WMS" << std::endl;
+    if (mConfig.enable_ice_lite) {
+        ss << "a=ice-lite" << std::endl;
+    }
 
     // Bundle
     {
@@ -162,6 +205,7 @@ std::pair<std::string, Error> SdpOffer::generate()
         ss << "a=ice-pwd:" << mIcePassword << std::endl;
         ss << "a=setup:actpass" << std::endl;
         ss << "a=mid:" << mediaLine.id << std::endl;
+        write_ice_lite_candidates(ss, mConfig.ice_lite_host_list);
 
         if (mDirection == Direction::Publish) {
             ss << "a=sendonly" << std::endl;
@@ -303,6 +347,7 @@ std::pair<std::string, Error> SdpOffer::generate()
         ss << "a=ice-pwd:" << mIcePassword << std::endl;
         ss << "a=setup:actpass" << std::endl;
         ss << "a=mid:datachannel" << std::endl;
+        write_ice_lite_candidates(ss, mConfig.ice_lite_host_list);
         ss << "a=sctp-port:" << kSctpPort << std::endl;
         ss << "a=max-message-size:" << kSctpMaxMessageSize << std::endl;
     }
@@ -1,4 +1,5 @@
 #include "srtc/send_pacer.h"
+#include "srtc/deadline.h"
 #include "srtc/logging.h"
 #include "srtc/media.h"
 #include "srtc/rtp_extension_source_twcc.h"
@@ -6,10 +7,12 @@
 #include "srtc/send_rtp_history.h"
 #include "srtc/socket.h"
 #include "srtc/srtp_connection.h"
+#include "srtc/srtp_crypto.h"
 #include "srtc/track.h"
 #include "srtc/track_stats.h"
 
 #include <algorithm>
+#include <cstring>
 
 #define LOG(level, ...) srtc::log(level, "SendPacer", __VA_ARGS__)
 
@@ -28,30 +31,37 @@ SendPacer::SendPacer(const SdpOffer::Config& offerConfig,
     , mHistory(history)
     , mTWCC(twcc)
     , mOnSend(onSend)
+    , mProtectItemList(kMaxBatchSize)
 #ifdef NDEBUG
 #else
     , mLosePacketsRandomGenerator(0, 99)
 #endif
 {
+    if (mOfferConfig.enable_gso) {
+        // Frames released back to back go out as segmented super-buffers
+        if (mSocket->setGsoEnabled(true)) {
+            LOG(SRTC_LOG_V, "GSO is enabled");
+        }
+    }
 }
 
 SendPacer::~SendPacer() = default;
 
 void SendPacer::flush(const std::shared_ptr<Track>& track)
 {
-    size_t flushCount = 0;
-
     for (auto iter = mQueue.begin(); iter != mQueue.end();) {
-        const auto packet = (*iter)->packet;
-        if (packet->getTrack()->getSSRC() == track->getSSRC()) {
+        if (iter->packet->getTrack()->getSSRC() == track->getSSRC()) {
+            mBatchList.push_back(std::move(iter->packet));
             iter = mQueue.erase(iter);
-            sendImpl(packet);
-            flushCount += 1;
         } else {
             ++iter;
         }
     }
 
+    const auto flushCount = mBatchList.size();
+    sendBatch(mBatchList.data(), mBatchList.size());
+    mBatchList.clear();
+
     (void)flushCount;
 
     //	if (flushCount > 0) {
@@ -59,7 +69,7 @@ void SendPacer::flush(const std::shared_ptr<Track>& track)
     //	}
 }
 
-void SendPacer::sendNow(const std::shared_ptr<RtpPacket>& packet)
+void SendPacer::sendNow(const RtpPacketPtr& packet)
 {
     RtpPacket::SendInfo sendInfo = {};
     sendInfo.is_last_packet_in_frame = true;
@@ -68,7 +78,7 @@ void SendPacer::sendNow(const std::shared_ptr<RtpPacket>& packet)
     sendImpl(packet);
 }
 
-void SendPacer::sendPaced(const std::vector<std::shared_ptr<RtpPacket>>& packetList, unsigned int spreadMillis)
+void SendPacer::sendPaced(const std::vector<RtpPacketPtr>& packetList, unsigned int spreadMillis)
 {
     if (packetList.empty()) {
         return;
@@ -84,9 +94,7 @@ void SendPacer::sendPaced(const std::vector<std::shared_ptr<RtpPacket>>& packetL
     packetList.back()->setSendInfo(sendInfo);
 
     if (spreadMillis == 0) {
-        for (const auto& packet : packetList) {
-            sendImpl(packet);
-        }
+        sendBatch(packetList.data(), size);
         return;
     }
 
@@ -97,81 +105,145 @@ void SendPacer::sendPaced(const std::vector<std::shared_ptr<RtpPacket>>& packetL
     unsigned int i = 0;
     for (const auto& packet : packetList) {
         const auto when = now + delta * i;
-        const auto item = std::make_shared<Item>(when, packet);
+        Item item = { when, packet };
 
-        mQueue.insert(std::upper_bound(mQueue.begin(), mQueue.end(), item, ItemLess()), item);
+        mQueue.insert(std::upper_bound(mQueue.begin(), mQueue.end(), item, ItemLess()), std::move(item));
 
         i += 1;
     }
 }
 
-[[nodiscard]] int SendPacer::getTimeoutMillis(int defaultValue) const
+void SendPacer::updateDeadline(Deadline& deadline) const
 {
     if (!mQueue.empty()) {
-        const auto when = mQueue.front()->when;
-        const auto now = std::chrono::steady_clock::now();
-        const auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(when - now);
-        return static_cast<int>(diff.count());
+        deadline.update(mQueue.front().when);
     }
-
-    return defaultValue;
 }
 
 void SendPacer::run()
 {
-    for (auto iter = mQueue.begin(); iter != mQueue.end();) {
-        if ((*iter)->when <= std::chrono::steady_clock::now()) {
-            const auto packet = (*iter)->packet;
-            iter = mQueue.erase(iter);
-            sendImpl(packet);
-        } else {
-            break;
-        }
+    // The queue is sorted, the packets which are due are at the front
+    const auto now = std::chrono::steady_clock::now();
+
+    auto iter = mQueue.begin();
+    while (iter != mQueue.end() && iter->when <= now) {
+        mBatchList.push_back(std::move(iter->packet));
+        ++iter;
     }
+    mQueue.erase(mQueue.begin(), iter);
+
+    sendBatch(mBatchList.data(), mBatchList.size());
+    mBatchList.clear();
+}
+
+void SendPacer::sendImpl(const RtpPacketPtr& packet)
+{
+    sendBatch(&packet, 1);
 }
 
-void SendPacer::sendImpl(const std::shared_ptr<RtpPacket>& packet)
+void SendPacer::sendBatch(const RtpPacketPtr* packetList, size_t packetCount)
 {
-    if (mTWCC) {
-        mTWCC->onBeforeGeneratingRtpPacket(packet);
+    while (packetCount > 0) {
+        const auto count = std::min(packetCount, kMaxBatchSize);
+        sendBatchImpl(packetList, count);
+
+        packetList += count;
+        packetCount -= count;
     }
+}
 
-    // Save
-    const auto track = packet->getTrack();
-    if (track->hasNack() || track->getRtxPayloadId() > 0) {
-        mHistory->save(packet);
+void SendPacer::sendBatchImpl(const RtpPacketPtr* packetList, size_t packetCount)
+{
+    const auto overhead = mSrtp->getMediaProtectionOverhead();
+
+    // Generate
+    size_t totalSize = 0;
+    for (size_t i = 0; i < packetCount; i += 1) {
+        const auto& packet = packetList[i];
+
+        if (mTWCC) {
+            mTWCC->onBeforeGeneratingRtpPacket(*packet);
+        }
+
+        // Save
+        const auto track = packet->getTrack();
+        if (track->hasNack() || track->getRtxPayloadId() > 0) {
+            mHistory->save(packet);
+        }
+
+        auto& header = mHeaderBufList[i];
+        auto& body = mBodyGatherList[i];
+
+        auto& item = mProtectItemList[i];
+        item.header = &header;
+        item.body = &body;
+        item.rolloverCount = packet->generate(header, body);
+        item.encryptedSize = 0;
+
+        totalSize += header.size() + body.totalSize() + overhead;
     }
 
-    // Stats
-    const auto stats = track->getStats();
+    // Protect into the socket's send queue, one after the other, with room for the tags
+    const auto output = mSocket->reserveQueued(totalSize, packetCount);
+    if (output == nullptr) {
+        return;
+    }
 
-    // Send info
-    const auto sendInfo = packet->getSendInfo();
+    size_t offset = 0;
+    for (size_t i = 0; i < packetCount; i += 1) {
+        auto& item = mProtectItemList[i];
+        item.encrypted = output + offset;
+        offset += item.header->size() + item.body->totalSize() + overhead;
+    }
+
+    mSrtp->protectSendMedia(mProtectItemList.data(), packetCount);
+
+    // Send, before anything else can use the queue
+    size_t sentSize = 0;
+    for (size_t i = 0; i < packetCount; i += 1) {
+        const auto& packet = packetList[i];
+        const auto& item = mProtectItemList[i];
+
+        const auto protectedSize = item.encryptedSize;
+        if (protectedSize == 0) {
+            continue;
+        }
+
+        // Past a packet which could not be protected, the queue has to stay contiguous
+        const auto protectedData = output + sentSize;
+        if (item.encrypted != protectedData) {
+            std::memmove(protectedData, item.encrypted, protectedSize);
+        }
+
+        // Keep the protected packet for re-sending as is, when it will not be re-sent as RTX
+        const auto track = packet->getTrack();
+        if (mHistory->isCachingProtected() && track->hasNack() && track->getRtxPayloadId() == 0) {
+            mHistory->saveProtected(packet->getSSRC(), packet->getSequence(), protectedData, protectedSize);
+        }
+
+        mSocket->commitQueued(protectedSize);
+        sentSize += protectedSize;
 
-    // Generate
-    const auto packetData = packet->generate();
-    ByteBuffer protectedData;
-    if (mSrtp->protectSendMedia(packetData.buf, packetData.rollover, protectedData)) {
         // Keep stats
+        const auto stats = track->getStats();
+        const auto sendInfo = packet->getSendInfo();
         if (sendInfo.has_value() && sendInfo->is_last_packet_in_frame) {
             stats->incrementSentFrames(1);
         }
 
         stats->incrementSentPackets(1);
-        stats->incrementSentBytes(protectedData.size());
+        stats->incrementSentBytes(protectedSize);
 
         // Record in TWCC
         if (mTWCC) {
-            mTWCC->onBeforeSendingRtpPacket(packet, packetData.buf.size(), protectedData.size());
-        }
-
-        // Notify the sending callback
-        if (mOnSend) {
-            mOnSend();
+            const auto generatedSize = item.header->size() + item.body->totalSize();
+            mTWCC->onBeforeSendingRtpPacket(*packet, generatedSize, protectedSize);
         }
+    }
 
-        // Send
-        (void)mSocket->send(protectedData.data(), protectedData.size());
+    // Notify the sending callback
+    if (sentSize > 0 && mOnSend) {
+        mOnSend();
     }
 }
 
@@ -1,47 +1,137 @@
-#include "srtc/rtp_packet.h"
 #include "srtc/send_rtp_history.h"
+#include "srtc/rtp_packet.h"
 
 namespace
 {
 
-constexpr auto kMaxHistory = 512;
+// Most video packets are full
+constexpr size_t kTypicalPacketSize = srtc::RtpPacket::kMaxPayloadSize;
 
-}
+constexpr size_t kMinCapacity = 64;
+// Half the sequence number space at most, so a slot is never mistaken for a packet a rollover ago
+constexpr size_t kMaxCapacity = 32768;
+
+} // namespace
 
 namespace srtc
 {
 
-SendRtpHistory::SendRtpHistory() = default;
+SendRtpHistory::SendRtpHistory(std::chrono::milliseconds window, uint32_t kilobitsPerSecond, bool isCachingProtected)
+    : mWindow(window)
+    , mCapacity(calculateCapacity(window, kilobitsPerSecond))
+    , mCapacityMask(mCapacity - 1)
+    , mIsCachingProtected(isCachingProtected)
+    , mStats()
+{
+    mStats.capacity = mCapacity;
+}
 
 SendRtpHistory::~SendRtpHistory() = default;
 
-void SendRtpHistory::save(const std::shared_ptr<RtpPacket>& packet)
+size_t SendRtpHistory::calculateCapacity(std::chrono::milliseconds window, uint32_t kilobitsPerSecond)
+{
+    // kbit/s * ms = bits
+    const auto bytes = static_cast<uint64_t>(window.count() > 0 ? window.count() : 0) * kilobitsPerSecond / 8;
+    const auto packets = (bytes + kTypicalPacketSize - 1) / kTypicalPacketSize;
+
+    size_t capacity = kMinCapacity;
+    while (capacity < packets && capacity < kMaxCapacity) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+void SendRtpHistory::save(const RtpPacketPtr& packet)
 {
     const auto ssrc = packet->getSSRC();
 
-    auto& item = mTrackMap[ssrc];
-    while (item.packetList.size() >= kMaxHistory) {
-        auto& packetList = item.packetList;
-        auto& packetMap = item.packetMap;
-        if (const auto iter = packetMap.find(packetList.back()->getSequence()); iter != packetMap.end()) {
-            packetMap.erase(iter);
-        }
-        packetList.pop_back();
+    auto track = findTrack(ssrc);
+    if (track == nullptr) {
+        // Once per SSRC
+        mTrackList.push_back({ ssrc, std::vector<Slot>(mCapacity) });
+        track = &mTrackList.back();
     }
 
-    item.packetList.push_front(packet);
-    item.packetMap.insert_or_assign(packet->getSequence(), packet);
+    const auto now = std::chrono::steady_clock::now();
+    auto& slot = track->ring[packet->getSequence() & mCapacityMask];
+
+    if (slot.packet && slot.packet->getSequence() != packet->getSequence() && now - slot.when < mWindow) {
+        mStats.evicted_count += 1;
+    }
+
+    slot.packet = packet;
+    slot.when = now;
+    // Keeps the memory
+    slot.protectedData.resize(0);
+
+    mStats.saved_count += 1;
+}
+
+RtpPacketPtr SendRtpHistory::find(uint32_t ssrc, uint16_t sequence)
+{
+    if (const auto slot = findSlot(ssrc, sequence)) {
+        mStats.found_count += 1;
+        return slot->packet;
+    }
+
+    mStats.missed_count += 1;
+    return nullptr;
 }
 
-std::shared_ptr<RtpPacket> SendRtpHistory::find(uint32_t ssrc, uint16_t sequence) const
+bool SendRtpHistory::isCachingProtected() const
 {
-    if (const auto i1 = mTrackMap.find(ssrc); i1 != mTrackMap.end()) {
-        const auto& packetMap = i1->second.packetMap;
-        if (const auto i2 = packetMap.find(sequence); i2 != packetMap.end()) {
-            return i2->second;
+    return mIsCachingProtected;
+}
+
+void SendRtpHistory::saveProtected(uint32_t ssrc, uint16_t sequence, const uint8_t* data, size_t size)
+{
+    if (!mIsCachingProtected) {
+        return;
+    }
+
+    if (const auto slot = findSlot(ssrc, sequence)) {
+        slot->protectedData.assign(data, size);
+    }
+}
+
+const ByteBuffer* SendRtpHistory::findProtected(uint32_t ssrc, uint16_t sequence)
+{
+    if (!mIsCachingProtected) {
+        return nullptr;
+    }
+
+    if (const auto slot = findSlot(ssrc, sequence); slot && !slot->protectedData.empty()) {
+        // The packet was already counted as found when it was looked up for the NACK
+        mStats.protected_found_count += 1;
+        return &slot->protectedData;
+    }
+
+    return nullptr;
+}
+
+SendRtpHistory::Stats SendRtpHistory::getStats() const
+{
+    return mStats;
+}
+
+SendRtpHistory::TrackHistory* SendRtpHistory::findTrack(uint32_t ssrc)
+{
+    for (auto& track : mTrackList) {
+        if (track.ssrc == ssrc) {
+            return &track;
         }
     }
+    return nullptr;
+}
 
+SendRtpHistory::Slot* SendRtpHistory::findSlot(uint32_t ssrc, uint16_t sequence)
+{
+    if (const auto track = findTrack(ssrc)) {
+        auto& slot = track->ring[sequence & mCapacityMask];
+        if (slot.packet && slot.packet->getSequence() == sequence) {
+            return &slot;
+        }
+    }
     return nullptr;
 }
 
@@ -0,0 +1,320 @@
+#include "srtc/shared_socket.h"
+#include "srtc/ice_agent.h"
+#include "srtc/logging.h"
+#include "srtc/util.h"
+
+#include "stunmessage.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+#define LOG(level, ...) srtc::log(level, "SharedSocket", __VA_ARGS__)
+
+namespace
+{
+
+// Remote addresses per endpoint, a peer checks from a few of its candidates
+constexpr size_t kMaxEndpointAddrCount = 8;
+
+// https://datatracker.ietf.org/doc/html/rfc5245#section-7.1.2.3, the USERNAME of a request we receive
+// is our ufrag, a colon, and the peer's ufrag
+bool get_stun_local_ufrag(const srtc::ByteBuffer& buf, std::string& ufrag)
+{
+    const auto data = buf.data();
+    const auto size = buf.size();
+
+    // https://datatracker.ietf.org/doc/html/rfc5764#section-5.1.2
+    if (size <= 20 || data[0] >= 2) {
+        return false;
+    }
+
+    const uint32_t magic = htonl(srtc::IceAgent::kRfc5389Cookie);
+    if (std::memcmp(&magic, data + 4, 4) != 0) {
+        return false;
+    }
+
+    if (stun::stun_message_validate_buffer_length(data, size, true) != static_cast<int>(size)) {
+        return false;
+    }
+
+    stun::StunMessage msg = {};
+    msg.buffer = const_cast<uint8_t*>(data);
+    msg.buffer_len = size;
+
+    if (stun::stun_message_get_class(&msg) != stun::STUN_REQUEST) {
+        return false;
+    }
+
+    uint16_t userNameLen = 0;
+    const auto userNamePtr = stun::stun_message_find(&msg, stun::STUN_ATTRIBUTE_USERNAME, &userNameLen);
+    if (userNamePtr == nullptr || userNameLen == 0) {
+        return false;
+    }
+
+    const auto userName = static_cast<const char*>(userNamePtr);
+    const auto colon = static_cast<const char*>(std::memchr(userName, ':', userNameLen));
+    ufrag.assign(userName, colon ? colon : userName + userNameLen);
+
+    return !ufrag.empty();
+}
+
+// Inbound endpoints don't have a remote address until they receive something
+bool has_remote_addr(const srtc::anyaddr& addr)
+{
+    if (addr.ss.ss_family == AF_INET6) {
+        return addr.sin_ipv6.sin6_port != 0;
+    }
+    return addr.sin_ipv4.sin_port != 0;
+}
+
+} // namespace
+
+namespace srtc
+{
+
+SharedSocket::Endpoint::Endpoint(const std::shared_ptr<Socket>& socket, void* udata)
+    : socket(socket)
+    , udata(udata)
+{
+}
+
+size_t SharedSocket::AddrHash::operator()(const anyaddr& addr) const
+{
+    uint64_t value = 0;
+    if (addr.ss.ss_family == AF_INET6) {
+        uint64_t half[2];
+        std::memcpy(half, &addr.sin_ipv6.sin6_addr, sizeof(half));
+        value = half[0] * 31 + half[1];
+        value = value * 31 + addr.sin_ipv6.sin6_port;
+    } else {
+        value = (static_cast<uint64_t>(addr.sin_ipv4.sin_addr.s_addr) << 16) | addr.sin_ipv4.sin_port;
+    }
+    return std::hash<uint64_t>()(value);
+}
+
+bool SharedSocket::AddrEqual::operator()(const anyaddr& addr1, const anyaddr& addr2) const
+{
+    return addr1 == addr2;
+}
+
+SharedSocket::SharedSocket(uint16_t port, bool isReusePort)
+    : mStats()
+{
+    mSocket4 = Socket::createBound(AF_INET, port, isReusePort);
+    if (mSocket4 && port == 0) {
+        // Use the same port for IPv6
+        port = mSocket4->getLocalPort();
+    }
+
+    mSocket6 = Socket::createBound(AF_INET6, port, isReusePort);
+
+    LOG(SRTC_LOG_V, "Shared socket ports: IPv4 %u, IPv6 %u", getPort(AF_INET), getPort(AF_INET6));
+}
+
+SharedSocket::~SharedSocket() = default;
+
+uint16_t SharedSocket::getPort(int family) const
+{
+    const auto& socket = family == AF_INET6 ? mSocket6 : mSocket4;
+    return socket ? socket->getLocalPort() : 0;
+}
+
+std::shared_ptr<Socket> SharedSocket::createEndpoint(const anyaddr& addr, const std::string& iceUFrag)
+{
+    const auto& socket = addr.ss.ss_family == AF_INET6 ? mSocket6 : mSocket4;
+    if (!socket) {
+        return nullptr;
+    }
+
+    if (mAddrMap.find(addr) != mAddrMap.end()) {
+        LOG(SRTC_LOG_W, "Address %s is already used by another endpoint", to_string(addr).c_str());
+        return nullptr;
+    }
+
+    return std::make_shared<Socket>(addr, socket, iceUFrag);
+}
+
+std::shared_ptr<Socket> SharedSocket::createInboundEndpoint(int family, const std::string& iceUFrag)
+{
+    const auto& socket = family == AF_INET6 ? mSocket6 : mSocket4;
+    if (!socket || iceUFrag.empty()) {
+        return nullptr;
+    }
+
+    anyaddr addr = {};
+    addr.ss.ss_family = static_cast<decltype(addr.ss.ss_family)>(family);
+
+    return std::make_shared<Socket>(addr, socket, iceUFrag);
+}
+
+std::vector<std::shared_ptr<Socket>> SharedSocket::getKernelSocketList() const
+{
+    std::vector<std::shared_ptr<Socket>> list;
+    if (mSocket4) {
+        list.push_back(mSocket4);
+    }
+    if (mSocket6) {
+        list.push_back(mSocket6);
+    }
+    return list;
+}
+
+void SharedSocket::addEndpoint(const std::shared_ptr<Socket>& socket, void* udata)
+{
+    const auto& addr = socket->getAddr();
+    const auto hasAddr = has_remote_addr(addr);
+    if (hasAddr && mAddrMap.find(addr) != mAddrMap.end()) {
+        LOG(SRTC_LOG_E, "Address %s is already used by another endpoint", to_string(addr).c_str());
+        return;
+    }
+
+    auto endpoint = std::make_unique<Endpoint>(socket, udata);
+    const auto ptr = endpoint.get();
+
+    if (hasAddr) {
+        ptr->addrList.push_back(addr);
+        mAddrMap.emplace(addr, ptr);
+    }
+    if (!socket->getIceUFrag().empty()) {
+        mUFragMap.emplace(socket->getIceUFrag(), ptr);
+    }
+
+    mEndpointMap.emplace(socket.get(), std::move(endpoint));
+}
+
+void SharedSocket::removeEndpoint(const std::shared_ptr<Socket>& socket)
+{
+    const auto iter = mEndpointMap.find(socket.get());
+    if (iter == mEndpointMap.end()) {
+        return;
+    }
+
+    const auto ptr = iter->second.get();
+    for (const auto& addr : ptr->addrList) {
+        mAddrMap.erase(addr);
+    }
+
+    const auto range = mUFragMap.equal_range(socket->getIceUFrag());
+    for (auto ufragIter = range.first; ufragIter != range.second; ++ufragIter) {
+        if (ufragIter->second == ptr) {
+            mUFragMap.erase(ufragIter);
+            break;
+        }
+    }
+
+    mEndpointMap.erase(iter);
+}
+
+bool SharedSocket::addEndpointAddress(const std::shared_ptr<Socket>& socket, const anyaddr& addr)
+{
+    const auto iter = mEndpointMap.find(socket.get());
+    if (iter == mEndpointMap.end()) {
+        return false;
+    }
+
+    const auto ptr = iter->second.get();
+    if (const auto addrIter = mAddrMap.find(addr); addrIter != mAddrMap.end()) {
+        if (addrIter->second != ptr) {
+            LOG(SRTC_LOG_W, "Address %s is already used by another endpoint", to_string(addr).c_str());
+            return false;
+        }
+        return true;
+    }
+
+    if (ptr->addrList.size() >= kMaxEndpointAddrCount) {
+        const auto& sendAddr = socket->getAddr();
+        const auto evictIter = std::find_if(
+            ptr->addrList.begin(), ptr->addrList.end(), [&sendAddr](const anyaddr& it) { return !(it == sendAddr); });
+        if (evictIter != ptr->addrList.end()) {
+            LOG(SRTC_LOG_V, "Forgetting address %s of an endpoint", to_string(*evictIter).c_str());
+            mAddrMap.erase(*evictIter);
+            ptr->addrList.erase(evictIter);
+            mStats.addr_evicted += 1;
+        }
+    }
+
+    ptr->addrList.push_back(addr);
+    mAddrMap.emplace(addr, ptr);
+
+    return true;
+}
+
+void SharedSocket::receive(std::vector<void*>& udataList)
+{
+    for (const auto& socket : { mSocket4, mSocket6 }) {
+        if (!socket) {
+            continue;
+        }
+
+        mReceiveList.clear();
+        socket->receive(mReceiveList);
+
+        for (const auto data : mReceiveList) {
+            const auto endpoint = findEndpoint(*data);
+            if (endpoint == nullptr) {
+                mStats.dropped_unknown += 1;
+                continue;
+            }
+
+            if (!endpoint->socket->deliver(data->buf.data(), data->buf.size(), data->addr, data->addr_len)) {
+                // Same as the kernel would do when a socket's buffer is full
+                mStats.dropped_full += 1;
+                continue;
+            }
+
+            if (!endpoint->isReady) {
+                endpoint->isReady = true;
+                mReadyList.push_back(endpoint);
+            }
+        }
+
+        socket->release(mReceiveList.size());
+    }
+
+    for (const auto endpoint : mReadyList) {
+        endpoint->isReady = false;
+        udataList.push_back(endpoint->udata);
+    }
+    mReadyList.clear();
+}
+
+SharedSocket::Stats SharedSocket::getStats() const
+{
+    auto stats = mStats;
+    stats.endpoint_count = mEndpointMap.size();
+    return stats;
+}
+
+SharedSocket::Endpoint* SharedSocket::findEndpoint(const Socket::ReceivedData& data)
+{
+    if (const auto iter = mAddrMap.find(data.addr); iter != mAddrMap.end()) {
+        mStats.routed_by_address += 1;
+        return iter->second;
+    }
+
+    // A connectivity check from an address we haven't seen, e.g. a peer reflexive candidate. Only routed,
+    // the candidate decides whether to keep the address after checking the request's integrity.
+    std::string ufrag;
+    if (!get_stun_local_ufrag(data.buf, ufrag)) {
+        return nullptr;
+    }
+
+    const auto range = mUFragMap.equal_range(ufrag);
+    for (auto iter = range.first; iter != range.second; ++iter) {
+        const auto endpoint = iter->second;
+        if (endpoint->socket->getAddr().ss.ss_family == data.addr.ss.ss_family) {
+            LOG(SRTC_LOG_V,
+                "Routing %s to the endpoint for %s by ufrag",
+                to_string(data.addr).c_str(),
+                to_string(endpoint->socket->getAddr()).c_str());
+
+            mStats.routed_by_ufrag += 1;
+            return endpoint;
+        }
+    }
+
+    return nullptr;
+}
+
+} // namespace srtc
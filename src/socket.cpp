@@ -7,9 +7,13 @@
 #include <ws2tcpip.h>
 #else
 #include <fcntl.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
 #include <unistd.h>
 #endif
 
+#include <algorithm>
+#include <cassert>
 #include <cstring>
 
 #define LOG(level, ...) srtc::log(level, "Socket", __VA_ARGS__)
@@ -53,21 +57,97 @@ HANDLE createEvent(SOCKET socket)
 }
 #endif
 
-constexpr auto kReceiveBufferSize = 16 * 1024;
+// WebRTC stacks keep their datagrams below the path MTU, but we take anything up to the size we always did.
+// Larger ones are dropped, on every receive path. Also a buffer pool size class, so there is no waste.
+constexpr size_t kReceiveSlotSize = 16 * 1024;
+constexpr size_t kReceiveSlotCount = 32;
+
+// Coalesced receive, a UDP datagram can't be larger than this
+constexpr size_t kMaxReceiveBufferSize = 64 * 1024;
+
+constexpr size_t kSendBatchSize = 64;
+constexpr size_t kSendBufferSize = 64 * 1024;
+
+// https://github.com/torvalds/linux/blob/master/include/linux/udp.h, UDP_MAX_SEGMENTS is 64 on older kernels
+constexpr size_t kGsoMaxSegments = 64;
+constexpr size_t kGsoMaxSize = 63 * 1024;
 
 } // namespace
 
 namespace srtc
 {
 
+#ifdef __linux__
+struct Socket::ReceiveBatch {
+    struct mmsghdr msgs[kReceiveSlotCount];
+    struct iovec iovs[kReceiveSlotCount];
+    size_t slots[kReceiveSlotCount];
+
+    // UDP_GRO
+    ByteBuffer groBuffer;
+    anyaddr groAddr = {};
+    socklen_t groAddrLen = 0;
+    size_t groOffset = 0;
+    size_t groSegmentSize = 0;
+    uint8_t groControl[CMSG_SPACE(sizeof(int))];
+};
+
+struct Socket::SendBatch {
+    struct mmsghdr msgs[kSendBatchSize];
+    struct iovec iovs[kSendBatchSize];
+    size_t offsets[kSendBatchSize];
+    size_t packets[kSendBatchSize];
+    uint8_t control[kSendBatchSize][CMSG_SPACE(sizeof(uint16_t))];
+};
+#endif
+
 Socket::Socket(const anyaddr& addr)
+    : Socket(addr, createSocket(addr), nullptr, {}, true)
+{
+}
+
+Socket::Socket(const anyaddr& addr, const std::shared_ptr<Socket>& shared, const std::string& iceUFrag)
+    : Socket(addr, shared->handle(), shared, iceUFrag, false)
+{
+}
+
+Socket::Socket(const anyaddr& addr,
+               SocketHandle handle,
+               const std::shared_ptr<Socket>& shared,
+               const std::string& iceUFrag,
+               bool isFiltered)
     : mAddr(addr)
-    , mHandle(createSocket(addr))
+    , mHandle(handle)
+    , mShared(shared)
+    , mIceUFrag(iceUFrag)
+    , mIsFiltered(isFiltered)
 #ifdef _WIN32
-    , mEvent(createEvent(mHandle))
+    , mEvent(shared ? INVALID_HANDLE_VALUE : createEvent(mHandle))
+#endif
+    , mReceiveRing(kReceiveSlotCount)
+    , mReceiveHead(0)
+    , mReceiveCount(0)
+    , mReceiveReported(0)
+    , mGroEnabled(false)
+    , mDriver(nullptr)
+    , mSendBuffer(kSendBufferSize)
+    , mSendPacketCount(0)
+    , mSendCallCount(0)
+    , mGsoEnabled(false)
+    , mGsoSendCount(0)
+    , mGsoSegmentCount(0)
+#ifdef __linux__
+    , mReceiveBatch(std::make_unique<ReceiveBatch>())
+    , mSendBatch(std::make_unique<SendBatch>())
 #endif
-    , mReceiveBuffer(std::make_unique<uint8_t[]>(kReceiveBufferSize))
 {
+    for (auto& item : mReceiveRing) {
+        // Exactly this capacity, receiving uses it as the maximum size
+        item.buf = ByteBuffer(kReceiveSlotSize);
+    }
+
+    mSendSizeList.reserve(kSendBatchSize);
+
 #ifdef _WIN32
     u_long mode = 1u;
     ioctlsocket(mHandle, FIONBIO, &mode);
@@ -80,6 +160,11 @@ Socket::Socket(const anyaddr& addr)
 
 Socket::~Socket()
 {
+    if (mShared) {
+        // The handle belongs to the shared socket
+        return;
+    }
+
 #ifdef _WIN32
     if (mHandle != INVALID_SOCKET) {
         closesocket(mHandle);
@@ -94,11 +179,99 @@ Socket::~Socket()
 #endif
 }
 
+std::shared_ptr<Socket> Socket::createBound(int family, uint16_t port, bool isReusePort)
+{
+    anyaddr addr = {};
+    socklen_t addrLen = 0;
+    if (family == AF_INET6) {
+        addr.sin_ipv6.sin6_family = AF_INET6;
+        addr.sin_ipv6.sin6_port = htons(port);
+        addr.sin_ipv6.sin6_addr = in6addr_any;
+        addrLen = sizeof(addr.sin_ipv6);
+    } else {
+        addr.sin_ipv4.sin_family = AF_INET;
+        addr.sin_ipv4.sin_port = htons(port);
+        addr.sin_ipv4.sin_addr.s_addr = htonl(INADDR_ANY);
+        addrLen = sizeof(addr.sin_ipv4);
+    }
+
+    const auto handle = createSocket(addr);
+#ifdef _WIN32
+    if (handle == INVALID_SOCKET) {
+        return nullptr;
+    }
+#else
+    if (handle < 0) {
+        return nullptr;
+    }
+#endif
+
+    std::shared_ptr<Socket> socket(new Socket(addr, handle, nullptr, {}, false));
+
+    int value = 1;
+    (void)setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&value), sizeof(value));
+#ifdef SO_REUSEPORT
+    if (isReusePort) {
+        (void)setsockopt(handle, SOL_SOCKET, SO_REUSEPORT, &value, sizeof(value));
+    }
+#else
+    (void)isReusePort;
+#endif
+    if (family == AF_INET6) {
+        // So that there can be an IPv4 socket on the same port
+        (void)setsockopt(handle, IPPROTO_IPV6, IPV6_V6ONLY, reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    if (bind(handle, reinterpret_cast<const struct sockaddr*>(&addr), addrLen) != 0) {
+#ifdef _WIN32
+        LOG(SRTC_LOG_E, "Cannot bind a socket to port %u", port);
+#else
+        const auto message = strerror(errno);
+        LOG(SRTC_LOG_E, "Cannot bind a socket to port %u: %s", port, message);
+#endif
+        return nullptr;
+    }
+
+    return socket;
+}
+
 SocketHandle Socket::handle() const
 {
     return mHandle;
 }
 
+const anyaddr& Socket::getAddr() const
+{
+    return mAddr;
+}
+
+void Socket::setAddr(const anyaddr& addr)
+{
+    assert(!mIsFiltered);
+    mAddr = addr;
+}
+
+uint16_t Socket::getLocalPort() const
+{
+    anyaddr addr = {};
+    socklen_t addrLen = sizeof(addr);
+    if (getsockname(mHandle, reinterpret_cast<struct sockaddr*>(&addr), &addrLen) != 0) {
+        return 0;
+    }
+
+    return ntohs(addr.ss.ss_family == AF_INET6 ? addr.sin_ipv6.sin6_port : addr.sin_ipv4.sin_port);
+}
+
+bool Socket::isEndpoint() const
+{
+    return mShared != nullptr;
+}
+
+const std::string& Socket::getIceUFrag() const
+{
+    return mIceUFrag;
+}
+
 #ifdef _WIN32
 HANDLE Socket::event() const
 {
@@ -106,35 +279,241 @@ HANDLE Socket::event() const
 }
 #endif
 
-[[nodiscard]] std::list<Socket::ReceivedData> Socket::receive()
+void Socket::receive(std::vector<ReceivedData*>& list)
+{
+    // With a driver, or for an endpoint, the ring has already been filled
+    if (mDriver == nullptr && mShared == nullptr) {
+        receiveImpl();
+    }
+
+    for (size_t i = mReceiveReported; i < mReceiveCount; i += 1) {
+        list.push_back(&mReceiveRing[(mReceiveHead + i) % kReceiveSlotCount]);
+    }
+    mReceiveReported = mReceiveCount;
+}
+
+void Socket::receiveImpl()
 {
-    std::list<ReceivedData> list;
+#ifdef __linux__
+    // https://man7.org/linux/man-pages/man2/recvmmsg.2.html
+    auto& batch = *mReceiveBatch;
+
+    while (!mGroEnabled && mReceiveCount < kReceiveSlotCount) {
+        const auto freeCount = kReceiveSlotCount - mReceiveCount;
+        for (size_t i = 0; i < freeCount; i += 1) {
+            const auto slot = (mReceiveHead + mReceiveCount + i) % kReceiveSlotCount;
+            auto& item = mReceiveRing[slot];
+            item.buf.resize(item.buf.capacity());
+
+            batch.iovs[i].iov_base = item.buf.data();
+            batch.iovs[i].iov_len = item.buf.size();
+
+            auto& hdr = batch.msgs[i].msg_hdr;
+            hdr = {};
+            hdr.msg_name = &item.addr;
+            hdr.msg_namelen = sizeof(item.addr);
+            hdr.msg_iov = &batch.iovs[i];
+            hdr.msg_iovlen = 1;
+
+            batch.slots[i] = slot;
+        }
+
+        const auto r = recvmmsg(mHandle, batch.msgs, static_cast<unsigned int>(freeCount), 0, nullptr);
+        if (r <= 0) {
+            break;
+        }
+
+        for (size_t i = 0; i < static_cast<size_t>(r); i += 1) {
+            const auto& hdr = batch.msgs[i].msg_hdr;
+            if ((hdr.msg_flags & MSG_TRUNC) != 0) {
+                LOG(SRTC_LOG_E, "Received a datagram larger than %zu bytes, dropping", kReceiveSlotSize);
+                continue;
+            }
+
+            mReceiveRing[batch.slots[i]].addr_len = hdr.msg_namelen;
+            acceptReceived(batch.slots[i], batch.msgs[i].msg_len);
+        }
+
+        if (static_cast<size_t>(r) < freeCount) {
+            // No more data
+            break;
+        }
+    }
 
-    while (true) {
-        union anyaddr from = {};
-        socklen_t fromLen = sizeof(from);
+    if (mGroEnabled) {
+        receiveGro();
+    }
+#elif defined(_WIN32)
+    while (mReceiveCount < kReceiveSlotCount) {
+        const auto slot = (mReceiveHead + mReceiveCount) % kReceiveSlotCount;
+        auto& item = mReceiveRing[slot];
+        item.buf.resize(item.buf.capacity());
+        item.addr_len = sizeof(item.addr);
 
         const auto r = recvfrom(mHandle,
-#ifdef _WIN32
-                                reinterpret_cast<char*>(mReceiveBuffer.get()),
-#else
-                                mReceiveBuffer.get(),
-#endif
-                                kReceiveBufferSize,
+                                reinterpret_cast<char*>(item.buf.data()),
+                                static_cast<int>(item.buf.size()),
                                 0,
-                                reinterpret_cast<struct sockaddr*>(&from),
-                                &fromLen);
+                                reinterpret_cast<struct sockaddr*>(&item.addr),
+                                &item.addr_len);
         if (r > 0) {
-            if (mAddr == from) {
-                ByteBuffer buf = { mReceiveBuffer.get(), static_cast<size_t>(r) };
-                list.emplace_back(std::move(buf), from, fromLen);
-            }
+            acceptReceived(slot, static_cast<size_t>(r));
+        } else if (r == SOCKET_ERROR && WSAGetLastError() == WSAEMSGSIZE) {
+            // https://learn.microsoft.com/en-us/windows/win32/api/winsock/nf-winsock-recvfrom, truncated
+            LOG(SRTC_LOG_E, "Received a datagram larger than %zu bytes, dropping", kReceiveSlotSize);
         } else {
             break;
         }
     }
+#else
+    while (mReceiveCount < kReceiveSlotCount) {
+        const auto slot = (mReceiveHead + mReceiveCount) % kReceiveSlotCount;
+        auto& item = mReceiveRing[slot];
+        item.buf.resize(item.buf.capacity());
+
+        // recvfrom would silently truncate, recvmsg tells us
+        struct iovec iov = {};
+        iov.iov_base = item.buf.data();
+        iov.iov_len = item.buf.size();
+
+        struct msghdr hdr = {};
+        hdr.msg_name = &item.addr;
+        hdr.msg_namelen = sizeof(item.addr);
+        hdr.msg_iov = &iov;
+        hdr.msg_iovlen = 1;
+
+        const auto r = recvmsg(mHandle, &hdr, 0);
+        if (r <= 0) {
+            break;
+        }
+        if ((hdr.msg_flags & MSG_TRUNC) != 0) {
+            LOG(SRTC_LOG_E, "Received a datagram larger than %zu bytes, dropping", kReceiveSlotSize);
+            continue;
+        }
+
+        item.addr_len = hdr.msg_namelen;
+        acceptReceived(slot, static_cast<size_t>(r));
+    }
+#endif
+}
+
+bool Socket::setGroEnabled(bool enabled, size_t bufferSize)
+{
+#if defined(__linux__) && defined(UDP_GRO)
+    if (mShared) {
+        // Endpoints don't receive from the kernel
+        return false;
+    }
+    if (enabled && mDriver) {
+        LOG(SRTC_LOG_W, "GRO is not supported by the event loop");
+        return false;
+    }
+
+    // https://man7.org/linux/man-pages/man7/udp.7.html
+    int value = enabled ? 1 : 0;
+    if (setsockopt(mHandle, SOL_UDP, UDP_GRO, &value, sizeof(value)) != 0) {
+        LOG(SRTC_LOG_W, "GRO is not supported by the kernel");
+        mGroEnabled = false;
+        return false;
+    }
+
+    if (enabled) {
+        if (bufferSize == 0 || bufferSize > kMaxReceiveBufferSize) {
+            bufferSize = kMaxReceiveBufferSize;
+        } else if (bufferSize < kReceiveSlotSize) {
+            bufferSize = kReceiveSlotSize;
+        }
+
+        auto& batch = *mReceiveBatch;
+        batch.groBuffer = ByteBuffer(bufferSize);
+        batch.groOffset = 0;
+        batch.groSegmentSize = 0;
+    }
+
+    mGroEnabled = enabled;
+    return true;
+#else
+    (void)enabled;
+    (void)bufferSize;
+    return false;
+#endif
+}
+
+bool Socket::isGroEnabled() const
+{
+    return mGroEnabled;
+}
+
+bool Socket::hasPendingReceive() const
+{
+#ifdef __linux__
+    if (!mGroEnabled) {
+        return false;
+    }
+
+    const auto& batch = *mReceiveBatch;
+    return batch.groOffset < batch.groBuffer.size();
+#else
+    return false;
+#endif
+}
+
+void Socket::release(size_t count)
+{
+    assert(count <= mReceiveReported);
+
+    mReceiveHead = (mReceiveHead + count) % kReceiveSlotCount;
+    mReceiveCount -= count;
+    mReceiveReported -= count;
+}
+
+void Socket::setDriver(Driver* driver)
+{
+    mDriver = driver;
+}
+
+bool Socket::deliver(const uint8_t* data, size_t size, const anyaddr& addr, socklen_t addrLen)
+{
+    if (mReceiveCount == kReceiveSlotCount) {
+        return false;
+    }
+
+    if (mIsFiltered && !(mAddr == addr)) {
+        // Not from our peer, consumed
+        return true;
+    }
+    if (size > kReceiveSlotSize) {
+        LOG(SRTC_LOG_E, "Received a datagram larger than %zu bytes, dropping", kReceiveSlotSize);
+        return true;
+    }
+
+    auto& item = mReceiveRing[(mReceiveHead + mReceiveCount) % kReceiveSlotCount];
+    item.buf.resize(size);
+    std::memcpy(item.buf.data(), data, size);
+    item.addr = addr;
+    item.addr_len = addrLen;
+
+    mReceiveCount += 1;
+
+    return true;
+}
+
+bool Socket::acceptReceived(size_t slot, size_t size)
+{
+    if (mIsFiltered && !(mAddr == mReceiveRing[slot].addr)) {
+        return false;
+    }
+
+    // Keep the used slots contiguous, rejected datagrams leave gaps
+    const auto write = (mReceiveHead + mReceiveCount) % kReceiveSlotCount;
+    if (slot != write) {
+        std::swap(mReceiveRing[slot], mReceiveRing[write]);
+    }
 
-    return list;
+    mReceiveRing[write].buf.resize(size);
+    mReceiveCount += 1;
+
+    return true;
 }
 
 ssize_t Socket::send(const ByteBuffer& buf)
@@ -156,6 +535,9 @@ ssize_t Socket::send(const void* ptr, size_t len)
                           (struct sockaddr*)&mAddr,
                           mAddr.ss.ss_family == AF_INET ? sizeof(mAddr.sin_ipv4) : sizeof(mAddr.sin_ipv6));
 
+    mSendPacketCount += 1;
+    mSendCallCount += 1;
+
     if (r == -1) {
 #ifdef _WIN32
         const auto error = GetLastError();
@@ -180,4 +562,325 @@ ssize_t Socket::send(const void* ptr, size_t len)
     return r;
 }
 
+void Socket::queue(const ByteBuffer& buf)
+{
+    queue(buf.data(), buf.size());
+}
+
+void Socket::queue(const void* ptr, size_t len)
+{
+    if (len > kSendBufferSize) {
+        flush();
+        (void)send(ptr, len);
+        return;
+    }
+
+    if (mSendSizeList.size() == kSendBatchSize || mSendBuffer.size() + len > kSendBufferSize) {
+        flush();
+    }
+
+    // The buffer has enough capacity, so this does not reallocate
+    mSendBuffer.append(static_cast<const uint8_t*>(ptr), len);
+    mSendSizeList.push_back(len);
+}
+
+uint8_t* Socket::reserveQueued(size_t size, size_t count)
+{
+    if (size > kSendBufferSize || count > kSendBatchSize) {
+        return nullptr;
+    }
+
+    if (mSendSizeList.size() + count > kSendBatchSize || mSendBuffer.size() + size > kSendBufferSize) {
+        flush();
+    }
+
+    return mSendBuffer.data() + mSendBuffer.size();
+}
+
+void Socket::commitQueued(size_t size)
+{
+    assert(mSendSizeList.size() < kSendBatchSize);
+    assert(mSendBuffer.size() + size <= kSendBufferSize);
+
+    mSendBuffer.resize(mSendBuffer.size() + size);
+    mSendSizeList.push_back(size);
+}
+
+void Socket::flush()
+{
+    if (mSendSizeList.empty()) {
+        return;
+    }
+
+    if (mDriver) {
+        const auto addrLen = mAddr.ss.ss_family == AF_INET ? sizeof(mAddr.sin_ipv4) : sizeof(mAddr.sin_ipv6);
+        mDriver->send(mHandle,
+                      mAddr,
+                      static_cast<socklen_t>(addrLen),
+                      mSendBuffer.data(),
+                      mSendSizeList.data(),
+                      mSendSizeList.size());
+
+        mSendPacketCount += mSendSizeList.size();
+        mSendCallCount += 1;
+
+        mSendBuffer.clear();
+        mSendSizeList.clear();
+        return;
+    }
+
+#ifdef __linux__
+    // https://man7.org/linux/man-pages/man2/sendmmsg.2.html
+    auto& batch = *mSendBatch;
+
+    const auto count = mSendSizeList.size();
+
+    size_t offset = 0;
+    for (size_t i = 0; i < count; i += 1) {
+        batch.offsets[i] = offset;
+        offset += mSendSizeList[i];
+    }
+
+    size_t first = 0;
+    while (first < count) {
+        const auto messageCount = prepareSendBatch(first);
+
+        size_t sent = 0;
+        bool isGsoFailed = false;
+
+        while (sent < messageCount) {
+            const auto r = sendmmsg(mHandle, batch.msgs + sent, static_cast<unsigned int>(messageCount - sent), 0);
+            mSendCallCount += 1;
+
+            if (r < 0) {
+                const auto e = errno;
+                if (e == EINTR) {
+                    continue;
+                }
+                if (e != EAGAIN && batch.packets[sent] > 1) {
+                    // The kernel or the network device can't do segmentation offload
+                    const auto message = strerror(e);
+                    LOG(SRTC_LOG_W, "Cannot send with GSO: %s, turning it off", message);
+                    mGsoEnabled = false;
+                    isGsoFailed = true;
+                    break;
+                }
+                if (e != EAGAIN) {
+                    // Skip only the message which failed, the ones after it can still go out
+                    const auto message = strerror(e);
+                    LOG(SRTC_LOG_E, "Cannot send on a socket: %s", message);
+                    first += batch.packets[sent];
+                    sent += 1;
+                    continue;
+                }
+                // The socket's buffer is full, drop the rest
+                first = count;
+                break;
+            }
+
+            for (size_t i = sent; i < sent + static_cast<size_t>(r); i += 1) {
+                first += batch.packets[i];
+                mSendPacketCount += batch.packets[i];
+                if (batch.packets[i] > 1) {
+                    mGsoSendCount += 1;
+                    mGsoSegmentCount += batch.packets[i];
+                }
+            }
+            sent += static_cast<size_t>(r);
+        }
+
+        if (!isGsoFailed) {
+            break;
+        }
+    }
+#else
+    auto ptr = mSendBuffer.data();
+    for (const auto size : mSendSizeList) {
+        (void)send(ptr, size);
+        ptr += size;
+    }
+#endif
+
+    mSendBuffer.clear();
+    mSendSizeList.clear();
+}
+
+bool Socket::setGsoEnabled(bool enabled)
+{
+#if defined(__linux__) && defined(UDP_SEGMENT)
+    if (enabled) {
+        // https://man7.org/linux/man-pages/man7/udp.7.html
+        int value = 0;
+        socklen_t valueLen = sizeof(value);
+        if (getsockopt(mHandle, SOL_UDP, UDP_SEGMENT, &value, &valueLen) != 0) {
+            LOG(SRTC_LOG_W, "GSO is not supported by the kernel");
+            mGsoEnabled = false;
+            return false;
+        }
+    }
+
+    mGsoEnabled = enabled;
+    return true;
+#else
+    (void)enabled;
+    return false;
+#endif
+}
+
+float Socket::getPacketsPerSendCall() const
+{
+    if (mSendCallCount == 0) {
+        return 0.0f;
+    }
+
+    return static_cast<float>(mSendPacketCount) / static_cast<float>(mSendCallCount);
+}
+
+float Socket::getSegmentsPerGsoSend() const
+{
+    if (mGsoSendCount == 0) {
+        return 0.0f;
+    }
+
+    return static_cast<float>(mGsoSegmentCount) / static_cast<float>(mGsoSendCount);
+}
+
+#ifdef __linux__
+size_t Socket::prepareSendBatch(size_t first)
+{
+    auto& batch = *mSendBatch;
+
+    const auto count = mSendSizeList.size();
+    const auto addrLen = mAddr.ss.ss_family == AF_INET ? sizeof(mAddr.sin_ipv4) : sizeof(mAddr.sin_ipv6);
+
+    size_t messageCount = 0;
+    for (size_t i = first; i < count;) {
+        const auto segmentSize = mSendSizeList[i];
+
+        // With GSO, a run of equal size packets where only the last one can be shorter
+        size_t packetCount = 1;
+        size_t totalSize = segmentSize;
+        if (mGsoEnabled) {
+            while (i + packetCount < count && packetCount < kGsoMaxSegments) {
+                const auto nextSize = mSendSizeList[i + packetCount];
+                if (nextSize > segmentSize || totalSize + nextSize > kGsoMaxSize) {
+                    break;
+                }
+                packetCount += 1;
+                totalSize += nextSize;
+                if (nextSize < segmentSize) {
+                    break;
+                }
+            }
+        }
+
+        batch.iovs[messageCount].iov_base = mSendBuffer.data() + batch.offsets[i];
+        batch.iovs[messageCount].iov_len = totalSize;
+
+        auto& hdr = batch.msgs[messageCount].msg_hdr;
+        hdr = {};
+        hdr.msg_name = const_cast<anyaddr*>(&mAddr);
+        hdr.msg_namelen = addrLen;
+        hdr.msg_iov = &batch.iovs[messageCount];
+        hdr.msg_iovlen = 1;
+
+#ifdef UDP_SEGMENT
+        if (packetCount > 1) {
+            hdr.msg_control = batch.control[messageCount];
+            hdr.msg_controllen = sizeof(batch.control[messageCount]);
+
+            const auto cmsg = CMSG_FIRSTHDR(&hdr);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+
+            const auto value = static_cast<uint16_t>(segmentSize);
+            std::memcpy(CMSG_DATA(cmsg), &value, sizeof(value));
+        }
+#endif
+
+        batch.packets[messageCount] = packetCount;
+        messageCount += 1;
+        i += packetCount;
+    }
+
+    return messageCount;
+}
+
+void Socket::receiveGro()
+{
+    auto& batch = *mReceiveBatch;
+
+    while (mReceiveCount < kReceiveSlotCount) {
+        if (batch.groOffset >= batch.groBuffer.size()) {
+            // Read the next coalesced buffer
+            batch.groBuffer.resize(batch.groBuffer.capacity());
+
+            struct iovec iov = {};
+            iov.iov_base = batch.groBuffer.data();
+            iov.iov_len = batch.groBuffer.size();
+
+            struct msghdr hdr = {};
+            hdr.msg_name = &batch.groAddr;
+            hdr.msg_namelen = sizeof(batch.groAddr);
+            hdr.msg_iov = &iov;
+            hdr.msg_iovlen = 1;
+            hdr.msg_control = batch.groControl;
+            hdr.msg_controllen = sizeof(batch.groControl);
+
+            const auto r = recvmsg(mHandle, &hdr, 0);
+            if (r <= 0) {
+                batch.groBuffer.clear();
+                break;
+            }
+
+            batch.groBuffer.resize(static_cast<size_t>(r));
+            batch.groAddrLen = hdr.msg_namelen;
+            batch.groOffset = 0;
+            batch.groSegmentSize = static_cast<size_t>(r);
+
+            if ((hdr.msg_flags & MSG_TRUNC) != 0) {
+                LOG(SRTC_LOG_E, "Received more than %zu bytes, dropping", batch.groBuffer.capacity());
+                batch.groBuffer.clear();
+                continue;
+            }
+            if (mIsFiltered && !(mAddr == batch.groAddr)) {
+                batch.groBuffer.clear();
+                continue;
+            }
+
+#ifdef UDP_GRO
+            for (auto cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+                if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+                    int segmentSize = 0;
+                    std::memcpy(&segmentSize, CMSG_DATA(cmsg), sizeof(segmentSize));
+                    if (segmentSize > 0) {
+                        batch.groSegmentSize = static_cast<size_t>(segmentSize);
+                    }
+                }
+            }
+#endif
+        }
+
+        // Split off the next datagram, the last one can be shorter
+        const auto size = std::min(batch.groSegmentSize, batch.groBuffer.size() - batch.groOffset);
+        const auto ptr = batch.groBuffer.data() + batch.groOffset;
+        batch.groOffset += size;
+
+        if (size > kReceiveSlotSize) {
+            LOG(SRTC_LOG_E, "Received a datagram larger than %zu bytes, dropping", kReceiveSlotSize);
+            continue;
+        }
+
+        auto& item = mReceiveRing[(mReceiveHead + mReceiveCount) % kReceiveSlotCount];
+        item.buf.resize(size);
+        std::memcpy(item.buf.data(), ptr, size);
+        item.addr = batch.groAddr;
+        item.addr_len = batch.groAddrLen;
+
+        mReceiveCount += 1;
+    }
+}
+#endif
+
 } // namespace srtc
@@ -57,6 +57,30 @@ std::string to_string(MediaType m)
     }
 }
 
+std::string to_string(ConnectTimelineEvent::Type type)
+{
+    switch (type) {
+    case ConnectTimelineEvent::Type::CandidateStarted:
+        return "candidate-started";
+    case ConnectTimelineEvent::Type::StunRequestSent:
+        return "stun-request-sent";
+    case ConnectTimelineEvent::Type::StunResponseReceived:
+        return "stun-response-received";
+    case ConnectTimelineEvent::Type::StunRequestReceived:
+        return "stun-request-received";
+    case ConnectTimelineEvent::Type::DtlsStarted:
+        return "dtls-started";
+    case ConnectTimelineEvent::Type::DtlsCompleted:
+        return "dtls-completed";
+    case ConnectTimelineEvent::Type::CandidateFailed:
+        return "candidate-failed";
+    case ConnectTimelineEvent::Type::CandidateCancelled:
+        return "candidate-cancelled";
+    default:
+        return "unknown-" + std::to_string(static_cast<unsigned int>(type));
+    }
+}
+
 std::string to_string(const anyaddr& addr)
 {
     char buf[INET6_ADDRSTRLEN + 16];
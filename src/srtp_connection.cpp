@@ -150,6 +150,48 @@ bool SrtpConnection::protectSendMedia(const ByteBuffer& packetData, uint32_t rol
     return mCrypto->protectSendMedia(packetData, rollover, output);
 }
 
+bool SrtpConnection::protectSendMedia(const ByteBuffer& header,
+                                      const ByteGather& body,
+                                      uint32_t rollover,
+                                      ByteBuffer& output)
+{
+    if (header.size() < 4 + 4 + 4) {
+        LOG(SRTC_LOG_E, "Outgoing RTP packet is too small");
+        return false;
+    }
+
+    return mCrypto->protectSendMedia(header, body, rollover, output);
+}
+
+bool SrtpConnection::protectSendMedia(const ByteBuffer& header,
+                                      const ByteGather& body,
+                                      uint32_t rollover,
+                                      uint8_t* output,
+                                      size_t& outputSize)
+{
+    if (header.size() < 4 + 4 + 4) {
+        LOG(SRTC_LOG_E, "Outgoing RTP packet is too small");
+        return false;
+    }
+
+    return mCrypto->protectSendMedia(header, body, rollover, output, outputSize);
+}
+
+size_t SrtpConnection::protectSendMedia(SrtpProtectItem* itemList, size_t itemCount)
+{
+    for (size_t i = 0; i < itemCount; i += 1) {
+        if (itemList[i].header->size() < 4 + 4 + 4) {
+            LOG(SRTC_LOG_E, "Outgoing RTP packet is too small");
+            for (size_t j = 0; j < itemCount; j += 1) {
+                itemList[j].encryptedSize = 0;
+            }
+            return 0;
+        }
+    }
+
+    return mCrypto->protectSendMedia(itemList, itemCount);
+}
+
 bool SrtpConnection::unprotectReceiveControl(const ByteBuffer& packetData, ByteBuffer& output)
 {
     if (packetData.size() < 4 + 4 + 4) {
@@ -193,6 +235,95 @@ bool SrtpConnection::unprotectReceiveControl(const ByteBuffer& packetData, ByteB
 }
 
 bool SrtpConnection::unprotectReceiveMedia(const ByteBuffer& packetData, ByteBuffer& output)
+{
+    output.resize(0);
+    output.reserve(packetData.size());
+
+    size_t outputSize = 0;
+    if (!unprotectReceiveMediaImpl(packetData, output.data(), outputSize)) {
+        return false;
+    }
+
+    output.resize(outputSize);
+    return true;
+}
+
+bool SrtpConnection::unprotectReceiveMedia(ByteBuffer& packetData)
+{
+    size_t outputSize = 0;
+    if (!unprotectReceiveMediaImpl(packetData, packetData.data(), outputSize)) {
+        return false;
+    }
+
+    packetData.resize(outputSize);
+    return true;
+}
+
+size_t SrtpConnection::unprotectReceiveMedia(ByteBuffer* const* packetList, size_t packetCount)
+{
+    mUnprotectItemList.clear();
+    mUnprotectStateList.clear();
+
+    for (size_t i = 0; i < packetCount; i += 1) {
+        auto& packetData = *packetList[i];
+
+        UnprotectState state = {};
+        uint32_t rolloverCount = 0;
+        if (!prepareUnprotectMedia(packetData, state.channelValue, state.sequenceNumber, rolloverCount)) {
+            packetData.resize(0);
+            continue;
+        }
+
+        state.packetIndex = i;
+        mUnprotectStateList.push_back(state);
+        mUnprotectItemList.push_back({ packetData.data(), packetData.size(), rolloverCount, packetData.data(), 0 });
+    }
+
+    mCrypto->unprotectReceiveMedia(mUnprotectItemList.data(), mUnprotectItemList.size());
+
+    size_t unprotectedCount = 0;
+    for (size_t i = 0; i < mUnprotectItemList.size(); i += 1) {
+        const auto& item = mUnprotectItemList[i];
+        const auto& state = mUnprotectStateList[i];
+        auto& packetData = *packetList[state.packetIndex];
+
+        // A packet can be repeated within the batch, the replay protection was checked before any were set
+        if (item.plainSize == 0) {
+            LOG(SRTC_LOG_E, "Error decrypting media");
+            packetData.resize(0);
+        } else if (!state.channelValue->replayProtection->canProceed(state.sequenceNumber) ||
+                   !finishUnprotectMedia(*state.channelValue, state.sequenceNumber, item.plainSize)) {
+            packetData.resize(0);
+        } else {
+            packetData.resize(item.plainSize);
+            unprotectedCount += 1;
+        }
+    }
+
+    return unprotectedCount;
+}
+
+bool SrtpConnection::unprotectReceiveMediaImpl(const ByteBuffer& packetData, uint8_t* output, size_t& outputSize)
+{
+    ChannelValue* channelValue = nullptr;
+    uint16_t sequenceNumber = 0;
+    uint32_t rolloverCount = 0;
+    if (!prepareUnprotectMedia(packetData, channelValue, sequenceNumber, rolloverCount)) {
+        return false;
+    }
+
+    if (!mCrypto->unprotectReceiveMedia(packetData.data(), packetData.size(), rolloverCount, output, outputSize)) {
+        LOG(SRTC_LOG_E, "Error decrypting media");
+        return false;
+    }
+
+    return finishUnprotectMedia(*channelValue, sequenceNumber, outputSize);
+}
+
+bool SrtpConnection::prepareUnprotectMedia(const ByteBuffer& packetData,
+                                           ChannelValue*& channelValue,
+                                           uint16_t& sequenceNumber,
+                                           uint32_t& rolloverCount)
 {
     if (packetData.size() < 4 + 4 + 4) {
         // 4 byte header
@@ -206,15 +337,14 @@ bool SrtpConnection::unprotectReceiveMedia(const ByteBuffer& packetData, ByteBuf
     const auto pt = ntohs(*reinterpret_cast<const uint16_t*>(packetData.data())) & 0x7Fu;
 
     const ChannelKey key = { ssrc, static_cast<uint8_t>(pt) };
-    auto& channelValue = ensureSrtpChannel(mSrtpInMap, key, std::numeric_limits<uint16_t>::max());
+    channelValue = &ensureSrtpChannel(mSrtpInMap, key, std::numeric_limits<uint16_t>::max());
 
-    uint16_t sequenceNumber;
     if (!getMediaSequenceNumber(packetData, sequenceNumber)) {
         LOG(SRTC_LOG_E, "Error getting sequence number from incoming RTP packet");
         return false;
     }
 
-    if (!channelValue.replayProtection->canProceed(sequenceNumber)) {
+    if (!channelValue->replayProtection->canProceed(sequenceNumber)) {
         LOG(SRTC_LOG_E,
             "Replay protection says we can't proceed with RTP packet ssrc = %" PRIu32 ", seq = %u",
             ssrc,
@@ -223,27 +353,26 @@ bool SrtpConnection::unprotectReceiveMedia(const ByteBuffer& packetData, ByteBuf
     }
 
     // Because of jitter, we may cross the rollover back and forth, only count once
-    auto rolloverCount = channelValue.rolloverCount;
-    if (!channelValue.lastSequence16) {
-        channelValue.lastSequence16 = sequenceNumber;
-    } else if (channelValue.lastSequence16 <= 0x1000u && sequenceNumber >= 0xF000u) {
+    rolloverCount = channelValue->rolloverCount;
+    if (!channelValue->lastSequence16) {
+        channelValue->lastSequence16 = sequenceNumber;
+    } else if (channelValue->lastSequence16 <= 0x1000u && sequenceNumber >= 0xF000u) {
         if (rolloverCount > 0) {
             rolloverCount -= 1;
         }
     } else {
-        if (channelValue.lastSequence16 >= 0xF000u && sequenceNumber <= 0x1000u) {
-            channelValue.rolloverCount += 1;
+        if (channelValue->lastSequence16 >= 0xF000u && sequenceNumber <= 0x1000u) {
+            channelValue->rolloverCount += 1;
             rolloverCount += 1;
         }
-        channelValue.lastSequence16 = sequenceNumber;
+        channelValue->lastSequence16 = sequenceNumber;
     }
 
-    if (!mCrypto->unprotectReceiveMedia(packetData, rolloverCount, output)) {
-        LOG(SRTC_LOG_E, "Error decrypting media");
-        return false;
-    }
+    return true;
+}
 
-    const auto outputSize = output.size();
+bool SrtpConnection::finishUnprotectMedia(ChannelValue& channelValue, uint16_t sequenceNumber, size_t outputSize)
+{
     if (outputSize < 4 + 4 + 4) {
         // 4 byte header
         // 4 byte timestamp
@@ -7,6 +7,7 @@
 // from this software without specific prior written permission.
 
 #include "srtc/srtp_crypto.h"
+#include "srtc/buffer_slice.h"
 #include "srtc/byte_buffer.h"
 #include "srtc/srtp_hmac_sha1.h"
 #include "srtc/srtp_openssl.h"
@@ -143,34 +144,149 @@ bool SrtpCrypto::protectSendMedia(const ByteBuffer& packet, uint32_t rolloverCou
 {
     encrypted.resize(0);
 
+    const auto packetData = packet.data();
+    const auto packetSize = packet.size();
+
+    // The header is not encrypted
+    const uint16_t header = htons(*reinterpret_cast<const uint16_t*>(packetData));
+    auto headerSize = 4u + 4 + 4;
+    if ((header & kRTP_ExtensionBit) != 0) {
+        const auto extensionSize = ntohs(*reinterpret_cast<const uint16_t*>(packetData + 14));
+        headerSize += 4;
+        headerSize += extensionSize * 4;
+
+        if (headerSize >= packetSize) {
+            // The header reaches the end of payload (empty payload) or extends past its end
+            return false;
+        }
+    }
+
+    ByteGather body;
+    body.add(packetData + headerSize, packetSize - headerSize);
+
+    encrypted.reserve(packetSize + getMediaProtectionOverhead());
+
+    size_t encryptedSize = 0;
+    if (!protectSendMediaImpl(packetData, headerSize, body, rolloverCount, encrypted.data(), encryptedSize)) {
+        return false;
+    }
+
+    encrypted.resize(encryptedSize);
+    return true;
+}
+
+bool SrtpCrypto::protectSendMedia(const ByteBuffer& header,
+                                  const ByteGather& body,
+                                  uint32_t rolloverCount,
+                                  ByteBuffer& encrypted)
+{
+    encrypted.resize(0);
+    encrypted.reserve(header.size() + body.totalSize() + getMediaProtectionOverhead());
+
+    size_t encryptedSize = 0;
+    if (!protectSendMedia(header, body, rolloverCount, encrypted.data(), encryptedSize)) {
+        return false;
+    }
+
+    encrypted.resize(encryptedSize);
+    return true;
+}
+
+bool SrtpCrypto::protectSendMedia(const ByteBuffer& header,
+                                  const ByteGather& body,
+                                  uint32_t rolloverCount,
+                                  uint8_t* encrypted,
+                                  size_t& encryptedSize)
+{
+    if (header.size() > 4u + 4 + 4 && body.totalSize() == 0) {
+        // Same as above, an extension with an empty payload
+        return false;
+    }
+
+    return protectSendMediaImpl(header.data(), header.size(), body, rolloverCount, encrypted, encryptedSize);
+}
+
+size_t SrtpCrypto::protectSendMedia(SrtpProtectItem* itemList, size_t itemCount)
+{
+    // The profile is looked at once per batch. OpenSSL doesn't pipeline AES-GCM or AES-CTR over multiple
+    // buffers, so the packets are still encrypted one by one, but with nothing else in between.
+    using Impl = bool (SrtpCrypto::*)(const uint8_t*, size_t, const ByteGather&, uint32_t, uint8_t*, size_t&);
+
+    Impl impl;
+    switch (mProfileId) {
+    case SRTP_AEAD_AES_256_GCM:
+    case SRTP_AEAD_AES_128_GCM:
+        impl = &SrtpCrypto::protectSendMediaGCM;
+        break;
+    case SRTP_AES128_CM_SHA1_80:
+    case SRTP_AES128_CM_SHA1_32:
+        impl = &SrtpCrypto::protectSendMediaCM;
+        break;
+    default:
+        assert(false);
+        return 0;
+    }
+
+    size_t protectedCount = 0;
+    for (size_t i = 0; i < itemCount; i += 1) {
+        auto& item = itemList[i];
+        const auto& header = *item.header;
+        const auto& body = *item.body;
+
+        item.encryptedSize = 0;
+        if (header.size() > 4u + 4 + 4 && body.totalSize() == 0) {
+            // An extension with an empty payload
+            continue;
+        }
+
+        if ((this->*impl)(header.data(), header.size(), body, item.rolloverCount, item.encrypted, item.encryptedSize)) {
+            protectedCount += 1;
+        } else {
+            item.encryptedSize = 0;
+        }
+    }
+
+    return protectedCount;
+}
+
+bool SrtpCrypto::protectSendMediaImpl(const uint8_t* headerData,
+                                      size_t headerSize,
+                                      const ByteGather& body,
+                                      uint32_t rolloverCount,
+                                      uint8_t* encrypted,
+                                      size_t& encryptedSize)
+{
     switch (mProfileId) {
     case SRTP_AEAD_AES_256_GCM:
     case SRTP_AEAD_AES_128_GCM:
-        return protectSendMediaGCM(packet, rolloverCount, encrypted);
+        return protectSendMediaGCM(headerData, headerSize, body, rolloverCount, encrypted, encryptedSize);
     case SRTP_AES128_CM_SHA1_80:
     case SRTP_AES128_CM_SHA1_32:
-        return protectSendMediaCM(packet, rolloverCount, encrypted);
+        return protectSendMediaCM(headerData, headerSize, body, rolloverCount, encrypted, encryptedSize);
     default:
         assert(false);
         return false;
     }
 }
 
-bool SrtpCrypto::protectSendMediaGCM(const ByteBuffer& packet, uint32_t rolloverCount, ByteBuffer& encrypted)
+bool SrtpCrypto::protectSendMediaGCM(const uint8_t* headerData,
+                                     size_t headerSize,
+                                     const ByteGather& body,
+                                     uint32_t rolloverCount,
+                                     uint8_t* encrypted,
+                                     size_t& encryptedSize)
 {
-    const auto ctx = mSendCipherCtx;
+    const auto ctx = mSendRtpCipherCtx;
     if (!ctx) {
         return false;
     }
 
     const size_t digestSize = kAESGCM_TagSize;
 
-    const auto packetData = packet.data();
-    const auto packetSize = packet.size();
+    const auto packetSize = headerSize + body.totalSize();
 
-    const uint16_t header = htons(*reinterpret_cast<const uint16_t*>(packetData));
-    const uint16_t sequence = ntohs(*reinterpret_cast<const uint16_t*>(packetData + 2));
-    const uint32_t ssrc = ntohl(*reinterpret_cast<const uint32_t*>(packetData + 8));
+    const uint16_t sequence = ntohs(*reinterpret_cast<const uint16_t*>(headerData + 2));
+    const uint32_t ssrc = ntohl(*reinterpret_cast<const uint32_t*>(headerData + 8));
 
     // https://datatracker.ietf.org/doc/html/rfc7714#section-8.1
     CryptoBytes iv;
@@ -182,51 +298,42 @@ bool SrtpCrypto::protectSendMediaGCM(const ByteBuffer& packet, uint32_t rollover
     iv ^= mSendRtp.salt;
 
     // https://datatracker.ietf.org/doc/html/rfc7714#section-7.1
-    const auto encryptedSize = packetSize + digestSize;
-
-    encrypted.reserve(encryptedSize);
-    const auto encryptedData = encrypted.data();
-
-    // The header is not encrypted
-    auto headerSize = 4u + 4 + 4;
-    if ((header & kRTP_ExtensionBit) != 0) {
-        const auto extensionSize = ntohs(*reinterpret_cast<const uint16_t*>(packetData + 14));
-        headerSize += 4;
-        headerSize += extensionSize * 4;
+    const auto outputSize = packetSize + digestSize;
+    const auto encryptedData = encrypted;
 
-        if (headerSize >= packetSize) {
-            // The header reaches the end of payload (empty payload) or extends past its end
-            return false;
-        }
+    // The header is not encrypted, and can already be in place
+    if (encryptedData != headerData) {
+        std::memcpy(encryptedData, headerData, headerSize);
     }
-    std::memcpy(encryptedData, packetData, headerSize);
 
     // Encryption
     int len = 0, total_len = 0;
     int final_ret = 0;
     uint8_t digest[kAESGCM_TagSize] = {};
 
-    // Set key and iv
-    if (!EVP_EncryptInit_ex(ctx, nullptr, nullptr, mSendRtp.key.data(), iv.data())) {
+    // Set iv, the key is already set
+    if (!EVP_EncryptInit_ex(ctx, nullptr, nullptr, nullptr, iv.data())) {
         goto fail;
     }
 
     // The header is AAD
-    if (!EVP_EncryptUpdate(ctx, nullptr, &len, packetData, static_cast<int>(headerSize))) {
+    if (!EVP_EncryptUpdate(ctx, nullptr, &len, headerData, static_cast<int>(headerSize))) {
         goto fail;
     }
 
-    // Encrypt the body
-    if (!EVP_EncryptUpdate(ctx,
-                           encryptedData + headerSize,
-                           &len,
-                           packetData + headerSize,
-                           static_cast<int>(packetSize - headerSize))) {
-        goto fail;
+    // Encrypt the body, piece by piece, into one output
+    for (size_t i = 0; i < body.count(); i += 1) {
+        if (!EVP_EncryptUpdate(ctx,
+                               encryptedData + headerSize + total_len,
+                               &len,
+                               body.data(i),
+                               static_cast<int>(body.size(i)))) {
+            goto fail;
+        }
+        total_len += len;
     }
-    total_len = len;
 
-    final_ret = EVP_EncryptFinal_ex(ctx, encryptedData + headerSize + len, &len);
+    final_ret = EVP_EncryptFinal_ex(ctx, encryptedData + headerSize + total_len, &len);
     if (final_ret > 0) {
         total_len += len;
     }
@@ -238,21 +345,26 @@ bool SrtpCrypto::protectSendMediaGCM(const ByteBuffer& packet, uint32_t rollover
     }
 
     // Copy it to after the data
-    std::memcpy(encryptedData + encryptedSize - digestSize, digest, kAESGCM_TagSize);
+    std::memcpy(encryptedData + outputSize - digestSize, digest, kAESGCM_TagSize);
 
 fail:
     if (final_ret > 0) {
-        assert(static_cast<size_t>(total_len) + headerSize + digestSize == encryptedSize);
+        assert(static_cast<size_t>(total_len) + headerSize + digestSize == outputSize);
         (void)total_len;
-        encrypted.resize(encryptedSize);
+        encryptedSize = outputSize;
         return true;
     }
     return false;
 }
 
-bool SrtpCrypto::protectSendMediaCM(const ByteBuffer& packet, uint32_t rolloverCount, ByteBuffer& encrypted)
+bool SrtpCrypto::protectSendMediaCM(const uint8_t* headerData,
+                                    size_t headerSize,
+                                    const ByteGather& body,
+                                    uint32_t rolloverCount,
+                                    uint8_t* encrypted,
+                                    size_t& encryptedSize)
 {
-    const auto ctx = mSendCipherCtx;
+    const auto ctx = mSendRtpCipherCtx;
     if (!ctx) {
         return false;
     }
@@ -270,12 +382,10 @@ bool SrtpCrypto::protectSendMediaCM(const ByteBuffer& packet, uint32_t rolloverC
         return false;
     }
 
-    const auto packetData = packet.data();
-    const auto packetSize = packet.size();
+    const auto packetSize = headerSize + body.totalSize();
 
-    const uint16_t header = htons(*reinterpret_cast<const uint16_t*>(packetData));
-    const uint16_t sequence = ntohs(*reinterpret_cast<const uint16_t*>(packetData + 2));
-    const uint32_t ssrc = ntohl(*reinterpret_cast<const uint32_t*>(packetData + 8));
+    const uint16_t sequence = ntohs(*reinterpret_cast<const uint16_t*>(headerData + 2));
+    const uint32_t ssrc = ntohl(*reinterpret_cast<const uint32_t*>(headerData + 8));
 
     // https://datatracker.ietf.org/doc/html/rfc3711#section-4.1.1
     CryptoBytes iv;
@@ -288,26 +398,14 @@ bool SrtpCrypto::protectSendMediaCM(const ByteBuffer& packet, uint32_t rolloverC
     iv ^= mSendRtp.salt;
 
     // https://datatracker.ietf.org/doc/html/rfc3711#section-3.1
-    const auto encryptedSize = packetSize + digestSize;
+    const auto outputSize = packetSize + digestSize;
+    const auto encryptedData = encrypted;
 
-    encrypted.reserve(encryptedSize);
-    const auto encryptedData = encrypted.data();
-
-    // The header is not encrypted
-    auto headerSize = 4u + 4 + 4;
-    if ((header & kRTP_ExtensionBit) != 0) {
-        const auto extensionSize = ntohs(*reinterpret_cast<const uint16_t*>(packetData + 14));
-        headerSize += 4;
-        headerSize += extensionSize * 4;
-
-        if (headerSize >= packetSize) {
-            // The header reaches the end of payload (empty payload) or extends past its end
-            return false;
-        }
+    // The header is not encrypted, and can already be in place
+    if (encryptedData != headerData) {
+        std::memcpy(encryptedData, headerData, headerSize);
     }
 
-    std::memcpy(encryptedData, packetData, headerSize);
-
     // We will need the trailer for the authentication tag
     const uint32_t trailer = htonl(rolloverCount);
 
@@ -316,42 +414,44 @@ bool SrtpCrypto::protectSendMediaCM(const ByteBuffer& packet, uint32_t rolloverC
     int final_ret = 0;
     uint8_t digest[20] = {};
 
-    // Set key and iv
-    if (!EVP_EncryptInit_ex(ctx, nullptr, nullptr, mSendRtp.key.data(), iv.data())) {
+    // Set iv, the key is already set
+    if (!EVP_EncryptInit_ex(ctx, nullptr, nullptr, nullptr, iv.data())) {
         goto fail;
     }
 
-    // Encrypt the body
-    if (!EVP_EncryptUpdate(ctx,
-                           encryptedData + headerSize,
-                           &len,
-                           packetData + headerSize,
-                           static_cast<int>(packetSize - headerSize))) {
-        goto fail;
+    // Encrypt the body, piece by piece, into one output
+    for (size_t i = 0; i < body.count(); i += 1) {
+        if (!EVP_EncryptUpdate(ctx,
+                               encryptedData + headerSize + total_len,
+                               &len,
+                               body.data(i),
+                               static_cast<int>(body.size(i)))) {
+            goto fail;
+        }
+        total_len += len;
     }
-    total_len = len;
 
-    final_ret = EVP_EncryptFinal_ex(ctx, encryptedData + headerSize + len, &len);
+    final_ret = EVP_EncryptFinal_ex(ctx, encryptedData + headerSize + total_len, &len);
     if (final_ret > 0) {
         total_len += len;
     }
 
     // Authentication tag, https://datatracker.ietf.org/doc/html/rfc3711#section-4.2
-    if (!mHmacSha1->reset(mSendRtp.auth.data(), mSendRtp.auth.size())) {
+    if (!mSendRtpHmac || !mSendRtpHmac->reset()) {
         final_ret = 0;
         goto fail;
     }
-    mHmacSha1->update(encryptedData, packetSize);
-    mHmacSha1->update(reinterpret_cast<const uint8_t*>(&trailer), sizeof(trailer));
-    mHmacSha1->final(digest);
+    mSendRtpHmac->update(encryptedData, packetSize);
+    mSendRtpHmac->update(reinterpret_cast<const uint8_t*>(&trailer), sizeof(trailer));
+    mSendRtpHmac->final(digest);
 
-    std::memcpy(encryptedData + encryptedSize - digestSize, digest, digestSize);
+    std::memcpy(encryptedData + outputSize - digestSize, digest, digestSize);
 
 fail:
     if (final_ret > 0) {
-        assert(static_cast<size_t>(total_len) + headerSize + digestSize == encryptedSize);
+        assert(static_cast<size_t>(total_len) + headerSize + digestSize == outputSize);
         (void)total_len;
-        encrypted.resize(encryptedSize);
+        encryptedSize = outputSize;
         return true;
     }
     return false;
@@ -360,30 +460,81 @@ fail:
 bool SrtpCrypto::unprotectReceiveMedia(const ByteBuffer& packet, uint32_t rolloverCount, ByteBuffer& plain)
 {
     plain.resize(0);
+    plain.reserve(packet.size());
+
+    size_t plainSize = 0;
+    if (!unprotectReceiveMedia(packet.data(), packet.size(), rolloverCount, plain.data(), plainSize)) {
+        return false;
+    }
+
+    plain.resize(plainSize);
+    return true;
+}
 
+bool SrtpCrypto::unprotectReceiveMedia(
+    const uint8_t* packet, size_t packetSize, uint32_t rolloverCount, uint8_t* plain, size_t& plainSize)
+{
     switch (mProfileId) {
     case SRTP_AEAD_AES_256_GCM:
     case SRTP_AEAD_AES_128_GCM:
-        return unprotectReceiveMediaGCM(packet, rolloverCount, plain);
+        return unprotectReceiveMediaGCM(packet, packetSize, rolloverCount, plain, plainSize);
     case SRTP_AES128_CM_SHA1_80:
     case SRTP_AES128_CM_SHA1_32:
-        return unprotectReceiveMediaCM(packet, rolloverCount, plain);
+        return unprotectReceiveMediaCM(packet, packetSize, rolloverCount, plain, plainSize);
     default:
         assert(false);
         return false;
     }
 }
 
-bool SrtpCrypto::unprotectReceiveMediaGCM(const ByteBuffer& packet, uint32_t rolloverCount, ByteBuffer& plain)
+size_t SrtpCrypto::unprotectReceiveMedia(SrtpUnprotectItem* itemList, size_t itemCount)
 {
-    const auto ctx = mReceiveCipherCtx;
+    // Same as for protecting
+    using Impl = bool (SrtpCrypto::*)(const uint8_t*, size_t, uint32_t, uint8_t*, size_t&);
+
+    Impl impl;
+    switch (mProfileId) {
+    case SRTP_AEAD_AES_256_GCM:
+    case SRTP_AEAD_AES_128_GCM:
+        impl = &SrtpCrypto::unprotectReceiveMediaGCM;
+        break;
+    case SRTP_AES128_CM_SHA1_80:
+    case SRTP_AES128_CM_SHA1_32:
+        impl = &SrtpCrypto::unprotectReceiveMediaCM;
+        break;
+    default:
+        assert(false);
+        return 0;
+    }
+
+    size_t unprotectedCount = 0;
+    for (size_t i = 0; i < itemCount; i += 1) {
+        auto& item = itemList[i];
+
+        item.plainSize = 0;
+        if ((this->*impl)(item.packet, item.packetSize, item.rolloverCount, item.plain, item.plainSize)) {
+            unprotectedCount += 1;
+        } else {
+            item.plainSize = 0;
+        }
+    }
+
+    return unprotectedCount;
+}
+
+bool SrtpCrypto::unprotectReceiveMediaGCM(const uint8_t* encryptedData,
+                                          size_t encryptedSize,
+                                          uint32_t rolloverCount,
+                                          uint8_t* plainData,
+                                          size_t& plainSize)
+{
+    const auto ctx = mReceiveRtpCipherCtx;
     if (!ctx) {
         return false;
     }
 
     const size_t digestSize = kAESGCM_TagSize;
 
-    const auto encryptedSize = packet.size();
     if (encryptedSize <= 4 + 4 + 4 + digestSize) {
         // 4 byte RTP header
         // 4 byte timestamp
@@ -393,8 +544,6 @@ bool SrtpCrypto::unprotectReceiveMediaGCM(const ByteBuffer& packet, uint32_t rol
         return false;
     }
 
-    const auto encryptedData = packet.data();
-
     const uint16_t header = htons(*reinterpret_cast<const uint16_t*>(encryptedData));
     const uint16_t sequence = ntohs(*reinterpret_cast<const uint16_t*>(encryptedData + 2));
     const uint32_t ssrc = ntohl(*reinterpret_cast<const uint32_t*>(encryptedData + 8));
@@ -409,10 +558,7 @@ bool SrtpCrypto::unprotectReceiveMediaGCM(const ByteBuffer& packet, uint32_t rol
     iv ^= mReceiveRtp.salt;
 
     // https://datatracker.ietf.org/doc/html/rfc7714#section-7.1
-    const auto plainSize = encryptedSize - digestSize;
-
-    plain.reserve(plainSize);
-    const auto plainData = plain.data();
+    const auto outputSize = encryptedSize - digestSize;
 
     // The header is not encrypted
     auto headerSize = 4u + 4 + 4;
@@ -430,14 +576,13 @@ bool SrtpCrypto::unprotectReceiveMediaGCM(const ByteBuffer& packet, uint32_t rol
             return false;
         }
     }
-    std::memcpy(plainData, encryptedData, headerSize);
 
     // Decryption
     int len = 0, plain_len = 0;
     int final_ret = 0;
 
-    // Set key and iv
-    if (!EVP_DecryptInit_ex(ctx, nullptr, nullptr, mReceiveRtp.key.data(), iv.data())) {
+    // Set iv, the key is already set
+    if (!EVP_DecryptInit_ex(ctx, nullptr, nullptr, nullptr, iv.data())) {
         goto fail;
     }
 
@@ -454,9 +599,11 @@ bool SrtpCrypto::unprotectReceiveMediaGCM(const ByteBuffer& packet, uint32_t rol
         goto fail;
     }
 
-    std::memcpy(plainData, encryptedData, headerSize);
+    if (plainData != encryptedData) {
+        std::memcpy(plainData, encryptedData, headerSize);
+    }
 
-    // Decrypt the body
+    // Decrypt the body, possibly in place
     if (!EVP_DecryptUpdate(ctx,
                            plainData + headerSize,
                            &len,
@@ -473,17 +620,21 @@ bool SrtpCrypto::unprotectReceiveMediaGCM(const ByteBuffer& packet, uint32_t rol
 
 fail:
     if (final_ret > 0) {
-        assert(plain_len + static_cast<int>(headerSize) == static_cast<int>(plainSize));
+        assert(plain_len + static_cast<int>(headerSize) == static_cast<int>(outputSize));
         (void)plain_len;
-        plain.resize(plainSize);
+        plainSize = outputSize;
         return true;
     }
     return false;
 }
 
-bool SrtpCrypto::unprotectReceiveMediaCM(const ByteBuffer& packet, uint32_t rolloverCount, ByteBuffer& plain)
+bool SrtpCrypto::unprotectReceiveMediaCM(const uint8_t* encryptedData,
+                                         size_t encryptedSize,
+                                         uint32_t rolloverCount,
+                                         uint8_t* plainData,
+                                         size_t& plainSize)
 {
-    const auto ctx = mReceiveCipherCtx;
+    const auto ctx = mReceiveRtpCipherCtx;
     if (!ctx) {
         return false;
     }
@@ -501,7 +652,6 @@ bool SrtpCrypto::unprotectReceiveMediaCM(const ByteBuffer& packet, uint32_t roll
         return false;
     }
 
-    const auto encryptedSize = packet.size();
     if (encryptedSize <= 4 + 4 + 4 + digestSize) {
         // 4 byte RTP header
         // 4 byte timestamp
@@ -511,8 +661,6 @@ bool SrtpCrypto::unprotectReceiveMediaCM(const ByteBuffer& packet, uint32_t roll
         return false;
     }
 
-    const auto encryptedData = packet.data();
-
     const uint16_t header = htons(*reinterpret_cast<const uint16_t*>(encryptedData));
     const uint16_t sequence = ntohs(*reinterpret_cast<const uint16_t*>(encryptedData + 2));
     const uint32_t ssrc = ntohl(*reinterpret_cast<const uint32_t*>(encryptedData + 8));
@@ -531,10 +679,7 @@ bool SrtpCrypto::unprotectReceiveMediaCM(const ByteBuffer& packet, uint32_t roll
     iv ^= mReceiveRtp.salt;
 
     // https://datatracker.ietf.org/doc/html/rfc7714#section-7.1
-    const auto plainSize = encryptedSize - digestSize;
-
-    plain.reserve(plainSize);
-    const auto plainData = plain.data();
+    const auto outputSize = encryptedSize - digestSize;
 
     // The header is not encrypted
     auto headerSize = 4u + 4 + 4;
@@ -553,21 +698,35 @@ bool SrtpCrypto::unprotectReceiveMediaCM(const ByteBuffer& packet, uint32_t roll
         }
     }
 
-    std::memcpy(plainData, encryptedData, headerSize);
-
-    // We will need the trailer for the authentication tag
+    // Verify the digest first, decrypting in place overwrites the data it's computed over
     const uint32_t trailer = htonl(rolloverCount);
 
+    if (!mReceiveRtpHmac || !mReceiveRtpHmac->reset()) {
+        return false;
+    }
+    mReceiveRtpHmac->update(encryptedData, digestPtr - encryptedData);
+    mReceiveRtpHmac->update(reinterpret_cast<const uint8_t*>(&trailer), sizeof(trailer));
+    mReceiveRtpHmac->final(digest);
+
+    if (CRYPTO_memcmp(digest, digestPtr, digestSize) != 0) {
+        // Digest validation failed
+        return false;
+    }
+
+    if (plainData != encryptedData) {
+        std::memcpy(plainData, encryptedData, headerSize);
+    }
+
     // Decryption
     int len = 0, plain_len = 0;
     int final_ret = 0;
 
-    // Set key and iv
-    if (!EVP_DecryptInit_ex(ctx, nullptr, nullptr, mReceiveRtp.key.data(), iv.data())) {
+    // Set iv, the key is already set
+    if (!EVP_DecryptInit_ex(ctx, nullptr, nullptr, nullptr, iv.data())) {
         goto fail;
     }
 
-    // Decrypt the body
+    // Decrypt the body, possibly in place
     if (!EVP_DecryptUpdate(ctx,
                            plainData + headerSize,
                            &len,
@@ -582,24 +741,11 @@ bool SrtpCrypto::unprotectReceiveMediaCM(const ByteBuffer& packet, uint32_t roll
         plain_len += len;
     }
 
-    // Verify the digest
-    if (!mHmacSha1->reset(mReceiveRtp.auth.data(), mReceiveRtp.auth.size())) {
-        return false;
-    }
-    mHmacSha1->update(encryptedData, digestPtr - encryptedData);
-    mHmacSha1->update(reinterpret_cast<const uint8_t*>(&trailer), sizeof(trailer));
-    mHmacSha1->final(digest);
-
-    if (CRYPTO_memcmp(digest, digestPtr, digestSize) != 0) {
-        // Digest validation failed
-        return false;
-    }
-
 fail:
     if (final_ret > 0) {
-        assert(plain_len + static_cast<int>(headerSize) == static_cast<int>(plainSize));
+        assert(plain_len + static_cast<int>(headerSize) == static_cast<int>(outputSize));
         (void)plain_len;
-        plain.resize(plainSize);
+        plainSize = outputSize;
         return true;
     }
     return false;
@@ -624,7 +770,7 @@ bool SrtpCrypto::protectSendControl(const ByteBuffer& packet, uint32_t seq, Byte
 
 bool SrtpCrypto::protectSendControlGCM(const ByteBuffer& packet, uint32_t seq, ByteBuffer& encrypted)
 {
-    const auto ctx = mSendCipherCtx;
+    const auto ctx = mSendRtcpCipherCtx;
     if (!ctx) {
         return false;
     }
@@ -663,8 +809,8 @@ bool SrtpCrypto::protectSendControlGCM(const ByteBuffer& packet, uint32_t seq, B
     int final_ret = 0;
     uint8_t digest[20] = {};
 
-    // Set key and iv
-    if (!EVP_EncryptInit_ex(ctx, nullptr, nullptr, mSendRtcp.key.data(), iv.data())) {
+    // Set iv, the key is already set
+    if (!EVP_EncryptInit_ex(ctx, nullptr, nullptr, nullptr, iv.data())) {
         goto fail;
     }
 
@@ -719,7 +865,7 @@ bool SrtpCrypto::protectSendControlCM(const ByteBuffer& packet, uint32_t seq, By
 {
     const size_t digestSize = 10; // for both SHA1_80 and SHA1_32
 
-    const auto ctx = mSendCipherCtx;
+    const auto ctx = mSendRtcpCipherCtx;
     if (!ctx) {
         return false;
     }
@@ -759,8 +905,8 @@ bool SrtpCrypto::protectSendControlCM(const ByteBuffer& packet, uint32_t seq, By
     int final_ret = 0;
     uint8_t digest[20] = {};
 
-    // Set key and iv
-    if (!EVP_EncryptInit_ex(ctx, nullptr, nullptr, mSendRtcp.key.data(), iv.data())) {
+    // Set iv, the key is already set
+    if (!EVP_EncryptInit_ex(ctx, nullptr, nullptr, nullptr, iv.data())) {
         goto fail;
     }
 
@@ -783,12 +929,12 @@ bool SrtpCrypto::protectSendControlCM(const ByteBuffer& packet, uint32_t seq, By
     std::memcpy(encryptedData + encryptedSize - trailerSize - digestSize, &trailer, trailerSize);
 
     // Authentication tag, https://datatracker.ietf.org/doc/html/rfc3711#section-4.2
-    if (!mHmacSha1->reset(mSendRtcp.auth.data(), mSendRtcp.auth.size())) {
+    if (!mSendRtcpHmac || !mSendRtcpHmac->reset()) {
         final_ret = 0;
         goto fail;
     }
-    mHmacSha1->update(encryptedData, packetSize + trailerSize);
-    mHmacSha1->final(digest);
+    mSendRtcpHmac->update(encryptedData, packetSize + trailerSize);
+    mSendRtcpHmac->final(digest);
 
     std::memcpy(encryptedData + encryptedSize - digestSize, digest, digestSize);
 
@@ -831,7 +977,7 @@ bool SrtpCrypto::unprotectReceiveControlGCM(const ByteBuffer& packet, ByteBuffer
         return false;
     }
 
-    const auto ctx = mReceiveCipherCtx;
+    const auto ctx = mReceiveRtcpCipherCtx;
     if (!ctx) {
         return false;
     }
@@ -865,8 +1011,8 @@ bool SrtpCrypto::unprotectReceiveControlGCM(const ByteBuffer& packet, ByteBuffer
     int len = 0, plain_len = 0;
     int final_ret = 0;
 
-    // Set key and iv
-    if (!EVP_DecryptInit_ex(ctx, nullptr, nullptr, mReceiveRtcp.key.data(), iv.data())) {
+    // Set iv, the key is already set
+    if (!EVP_DecryptInit_ex(ctx, nullptr, nullptr, nullptr, iv.data())) {
         goto fail;
     }
 
@@ -949,7 +1095,7 @@ bool SrtpCrypto::unprotectReceiveControlCM(const ByteBuffer& packet, ByteBuffer&
         return false;
     }
 
-    const auto ctx = mReceiveCipherCtx;
+    const auto ctx = mReceiveRtcpCipherCtx;
     if (!ctx) {
         return false;
     }
@@ -991,8 +1137,8 @@ bool SrtpCrypto::unprotectReceiveControlCM(const ByteBuffer& packet, ByteBuffer&
 
     // The main body
     if (isEncrypted) {
-        // Set key and iv
-        if (!EVP_DecryptInit_ex(ctx, nullptr, nullptr, mReceiveRtcp.key.data(), iv.data())) {
+        // Set iv, the key is already set
+        if (!EVP_DecryptInit_ex(ctx, nullptr, nullptr, nullptr, iv.data())) {
             goto fail;
         }
 
@@ -1020,11 +1166,11 @@ bool SrtpCrypto::unprotectReceiveControlCM(const ByteBuffer& packet, ByteBuffer&
     }
 
     // Verify the digest
-    if (!mHmacSha1->reset(mReceiveRtcp.auth.data(), mReceiveRtcp.auth.size())) {
+    if (!mReceiveRtcpHmac || !mReceiveRtcpHmac->reset()) {
         return false;
     }
-    mHmacSha1->update(encryptedData, digestPtr - encryptedData);
-    mHmacSha1->final(digest);
+    mReceiveRtcpHmac->update(encryptedData, digestPtr - encryptedData);
+    mReceiveRtcpHmac->final(digest);
 
     if (CRYPTO_memcmp(digest, digestPtr, digestSize) != 0) {
         // Digest validation failed
@@ -1055,30 +1201,23 @@ SrtpCrypto::SrtpCrypto(uint64_t profileId,
     , mReceiveRtp(receiveRtp)
     , mSendRtcp(sendRtcp)
     , mReceiveRtcp(receiveRtcp)
-    , mSendCipherCtx(nullptr)
-    , mReceiveCipherCtx(nullptr)
-    , mHmacSha1(std::make_shared<HmacSha1>())
+    , mSendRtpCipherCtx(createCipherCtx(sendRtp.key, true))
+    , mReceiveRtpCipherCtx(createCipherCtx(receiveRtp.key, false))
+    , mSendRtcpCipherCtx(createCipherCtx(sendRtcp.key, true))
+    , mReceiveRtcpCipherCtx(createCipherCtx(receiveRtcp.key, false))
+    , mSendRtpHmac(createHmac(sendRtp.auth))
+    , mReceiveRtpHmac(createHmac(receiveRtp.auth))
+    , mSendRtcpHmac(createHmac(sendRtcp.auth))
+    , mReceiveRtcpHmac(createHmac(receiveRtcp.auth))
 {
-    const auto sendCipher = createCipher();
-    if (sendCipher) {
-        mSendCipherCtx = EVP_CIPHER_CTX_new();
-        EVP_EncryptInit_ex(mSendCipherCtx, sendCipher, nullptr, nullptr, nullptr);
-    }
-
-    const auto receiveCipher = createCipher();
-    if (receiveCipher) {
-        mReceiveCipherCtx = EVP_CIPHER_CTX_new();
-        EVP_DecryptInit_ex(mReceiveCipherCtx, receiveCipher, nullptr, nullptr, nullptr);
-    }
 }
 
 SrtpCrypto::~SrtpCrypto()
 {
-    if (mSendCipherCtx) {
-        EVP_CIPHER_CTX_free(mSendCipherCtx);
-    }
-    if (mReceiveCipherCtx) {
-        EVP_CIPHER_CTX_free(mReceiveCipherCtx);
+    for (const auto ctx : { mSendRtpCipherCtx, mReceiveRtpCipherCtx, mSendRtcpCipherCtx, mReceiveRtcpCipherCtx }) {
+        if (ctx) {
+            EVP_CIPHER_CTX_free(ctx);
+        }
     }
 }
 
@@ -1097,4 +1236,45 @@ const EVP_CIPHER* SrtpCrypto::createCipher() const
     }
 }
 
+EVP_CIPHER_CTX* SrtpCrypto::createCipherCtx(const CryptoBytes& key, bool encrypt) const
+{
+    // The key expansion is done here, once
+    const auto cipher = createCipher();
+    if (!cipher) {
+        return nullptr;
+    }
+
+    const auto ctx = EVP_CIPHER_CTX_new();
+    if (!ctx) {
+        return nullptr;
+    }
+
+    const auto res = encrypt ? EVP_EncryptInit_ex(ctx, cipher, nullptr, key.data(), nullptr)
+                             : EVP_DecryptInit_ex(ctx, cipher, nullptr, key.data(), nullptr);
+    if (!res) {
+        EVP_CIPHER_CTX_free(ctx);
+        return nullptr;
+    }
+
+    return ctx;
+}
+
+std::shared_ptr<HmacSha1> SrtpCrypto::createHmac(const CryptoBytes& auth) const
+{
+    switch (mProfileId) {
+    case SRTP_AES128_CM_SHA1_80:
+    case SRTP_AES128_CM_SHA1_32:
+        break;
+    default:
+        // GCM has its own authentication
+        return nullptr;
+    }
+
+    const auto hmac = std::make_shared<HmacSha1>();
+    if (!hmac->reset(auth.data(), auth.size())) {
+        return nullptr;
+    }
+    return hmac;
+}
+
 } // namespace srtc
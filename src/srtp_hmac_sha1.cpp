@@ -60,6 +60,19 @@ bool HmacSha1::reset(const uint8_t* key, size_t keySize)
     return true;
 }
 
+bool HmacSha1::reset()
+{
+    if (!mCtx) {
+        return false;
+    }
+
+#if defined(OPENSSL_VERSION_MAJOR) && OPENSSL_VERSION_MAJOR >= 3
+    return EVP_MAC_init(mCtx, nullptr, 0, nullptr) == 1;
+#else
+    return HMAC_Init_ex(mCtx, nullptr, 0, nullptr, nullptr) == 1;
+#endif
+}
+
 void HmacSha1::update(const uint8_t* data, size_t size)
 {
 #if defined(OPENSSL_VERSION_MAJOR) && OPENSSL_VERSION_MAJOR >= 3
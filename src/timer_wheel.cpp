@@ -0,0 +1,306 @@
+#include "srtc/timer_wheel.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace
+{
+
+constexpr uint64_t kSlotMask = srtc::TimerWheel::kSlotCount - 1;
+
+unsigned int countTrailingZeros(uint64_t value)
+{
+    assert(value != 0);
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned int>(__builtin_ctzll(value));
+#else
+    unsigned int count = 0;
+    while ((value & 1) == 0) {
+        value >>= 1;
+        count += 1;
+    }
+    return count;
+#endif
+}
+
+uint64_t rotateRight(uint64_t value, unsigned int count)
+{
+    count &= 63;
+    return count == 0 ? value : (value >> count) | (value << (64 - count));
+}
+
+} // namespace
+
+namespace srtc
+{
+
+// ----- TimerNode
+
+TimerNode::TimerNode()
+    : mPrev(this)
+    , mNext(this)
+    , mList(nullptr)
+    , mExpires(0)
+{
+}
+
+TimerNode::~TimerNode()
+{
+    unlink();
+}
+
+bool TimerNode::isLinked() const
+{
+    return mList != nullptr;
+}
+
+void TimerNode::unlink()
+{
+    if (mList) {
+        mList->remove(this);
+    }
+}
+
+// ----- TimerList
+
+TimerList::TimerList()
+    : mSize(0)
+{
+}
+
+TimerList::~TimerList()
+{
+    while (popFront()) {
+    }
+}
+
+bool TimerList::isEmpty() const
+{
+    return mHead.mNext == &mHead;
+}
+
+size_t TimerList::size() const
+{
+    return mSize;
+}
+
+void TimerList::pushBack(TimerNode* node)
+{
+    node->unlink();
+
+    node->mPrev = mHead.mPrev;
+    node->mNext = &mHead;
+    mHead.mPrev->mNext = node;
+    mHead.mPrev = node;
+    node->mList = this;
+
+    mSize += 1;
+}
+
+TimerNode* TimerList::popFront()
+{
+    if (isEmpty()) {
+        return nullptr;
+    }
+
+    const auto node = mHead.mNext;
+    remove(node);
+    return node;
+}
+
+void TimerList::splice(TimerList& other)
+{
+    while (const auto node = other.popFront()) {
+        pushBack(node);
+    }
+}
+
+TimerNode* TimerList::first() const
+{
+    return isEmpty() ? nullptr : mHead.mNext;
+}
+
+TimerNode* TimerList::next(const TimerNode* node) const
+{
+    return node->mNext == &mHead ? nullptr : node->mNext;
+}
+
+void TimerList::remove(TimerNode* node)
+{
+    assert(node->mList == this);
+
+    node->mPrev->mNext = node->mNext;
+    node->mNext->mPrev = node->mPrev;
+    node->mPrev = node;
+    node->mNext = node;
+    node->mList = nullptr;
+
+    mSize -= 1;
+}
+
+// ----- TimerWheel
+
+TimerWheel::TimerWheel(uint64_t now)
+    : mCurrent(now)
+    , mOccupied{}
+{
+}
+
+TimerWheel::~TimerWheel()
+{
+    TimerList list;
+    takeAll(list);
+}
+
+bool TimerWheel::isEmpty() const
+{
+    for (unsigned int level = 0; level < kLevelCount; level += 1) {
+        auto bits = mOccupied[level];
+        while (bits != 0) {
+            const auto index = countTrailingZeros(bits);
+            bits &= bits - 1;
+
+            if (mSlotList[level][index].isEmpty()) {
+                mOccupied[level] &= ~(uint64_t{ 1 } << index);
+            } else {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+size_t TimerWheel::size() const
+{
+    size_t size = 0;
+    for (const auto& level : mSlotList) {
+        for (const auto& slot : level) {
+            size += slot.size();
+        }
+    }
+    return size;
+}
+
+uint64_t TimerWheel::getCurrent() const
+{
+    return mCurrent;
+}
+
+void TimerWheel::insert(TimerNode* node, uint64_t expires)
+{
+    expires = std::clamp(expires, mCurrent, mCurrent + kMaxTicks);
+
+    const auto delta = expires - mCurrent;
+
+    unsigned int level = 0;
+    while (level + 1 < kLevelCount && delta >= (uint64_t{ 1 } << ((level + 1) * kLevelBits))) {
+        level += 1;
+    }
+
+    const auto index = (expires >> (level * kLevelBits)) & kSlotMask;
+
+    node->mExpires = expires;
+    mSlotList[level][index].pushBack(node);
+    mOccupied[level] |= uint64_t{ 1 } << index;
+}
+
+void TimerWheel::advance(uint64_t now, TimerList& expired)
+{
+    if (now < mCurrent) {
+        return;
+    }
+
+    if (isEmpty()) {
+        mCurrent = now + 1;
+        return;
+    }
+
+    while (mCurrent <= now) {
+        const auto index = mCurrent & kSlotMask;
+
+        if (index == 0) {
+            // A full turn of the first level, bring timers down from the higher levels
+            for (unsigned int level = 1; level < kLevelCount; level += 1) {
+                cascade(level);
+                if (((mCurrent >> (level * kLevelBits)) & kSlotMask) != 0) {
+                    break;
+                }
+            }
+        }
+
+        if (mOccupied[0] == 0) {
+            // Nothing on the first level until the end of its turn
+            mCurrent = std::min((mCurrent | kSlotMask) + 1, now + 1);
+            continue;
+        }
+
+        auto& slot = mSlotList[0][index];
+        expired.splice(slot);
+        mOccupied[0] &= ~(uint64_t{ 1 } << index);
+
+        mCurrent += 1;
+    }
+}
+
+uint64_t TimerWheel::getNextExpiration() const
+{
+    auto result = std::numeric_limits<uint64_t>::max();
+
+    for (unsigned int level = 0; level < kLevelCount; level += 1) {
+        const auto shift = level * kLevelBits;
+
+        // Start at the current slot, unless it's on a higher level and was cascaded down already, then it can
+        // only have timers for the next turn
+        const auto isCascaded = level > 0 && (mCurrent & ((uint64_t{ 1 } << shift) - 1)) != 0;
+        const auto start = (mCurrent >> shift) + (isCascaded ? 1 : 0);
+
+        while (true) {
+            const auto bits = rotateRight(mOccupied[level], static_cast<unsigned int>(start & kSlotMask));
+            if (bits == 0) {
+                break;
+            }
+
+            const auto offset = countTrailingZeros(bits);
+            const auto index = (start + offset) & kSlotMask;
+            if (mSlotList[level][index].isEmpty()) {
+                mOccupied[level] &= ~(uint64_t{ 1 } << index);
+                continue;
+            }
+
+            result = std::min(result, (start + offset) << shift);
+            break;
+        }
+    }
+
+    return result;
+}
+
+void TimerWheel::takeAll(TimerList& list)
+{
+    for (unsigned int level = 0; level < kLevelCount; level += 1) {
+        for (auto& slot : mSlotList[level]) {
+            list.splice(slot);
+        }
+        mOccupied[level] = 0;
+    }
+}
+
+void TimerWheel::cascade(unsigned int level)
+{
+    const auto index = (mCurrent >> (level * kLevelBits)) & kSlotMask;
+    if ((mOccupied[level] & (uint64_t{ 1 } << index)) == 0) {
+        return;
+    }
+
+    TimerList list;
+    list.splice(mSlotList[level][index]);
+    mOccupied[level] &= ~(uint64_t{ 1 } << index);
+
+    while (const auto node = list.popFront()) {
+        insert(node, node->mExpires);
+    }
+}
+
+} // namespace srtc
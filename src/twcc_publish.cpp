@@ -101,7 +101,7 @@ PublishPacketHistory::~PublishPacketHistory()
 }
 
 void PublishPacketHistory::saveOutgoingPacket(uint16_t seq,
-                                              const std::shared_ptr<Track>& track,
+                                              const Track& track,
                                               size_t paddingSize,
                                               size_t payloadSize,
                                               size_t generatedSize,
@@ -134,7 +134,7 @@ void PublishPacketHistory::saveOutgoingPacket(uint16_t seq,
     curr->generated_size = static_cast<uint16_t>(generatedSize);
     curr->encrypted_size = static_cast<uint16_t>(encryptedSize);
     curr->sent_time_micros = getStableTimeMicros();
-    curr->media_type = track->getMediaType();
+    curr->media_type = track.getMediaType();
 }
 
 PublishPacket* PublishPacketHistory::get(uint16_t seq) const
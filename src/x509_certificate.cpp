@@ -25,7 +25,19 @@ struct X509CertificateImpl {
 	std::string fp256hex;
 };
 
+namespace
+{
+
+constexpr std::chrono::seconds kDefaultLifetime = std::chrono::hours(24 * 365);
+
+}
+
 X509Certificate::X509Certificate()
+	: X509Certificate(kDefaultLifetime)
+{
+}
+
+X509Certificate::X509Certificate(std::chrono::seconds lifetime)
 	: mImpl(new X509CertificateImpl{})
 {
 	constexpr auto curveId = NID_X9_62_prime256v1;
@@ -50,7 +62,7 @@ X509Certificate::X509Certificate()
 
 	ASN1_INTEGER_set(X509_get_serialNumber(mImpl->x509), 1);
 	X509_gmtime_adj(X509_get_notBefore(mImpl->x509), 0);
-	X509_gmtime_adj(X509_get_notAfter(mImpl->x509), 31536000L);
+	X509_gmtime_adj(X509_get_notAfter(mImpl->x509), static_cast<long>(lifetime.count()));
 
 	X509_set_pubkey(mImpl->x509, mImpl->pkey);
 
@@ -1,8 +1,11 @@
+#include "srtc/buffer_pool.h"
+#include "srtc/byte_buffer.h"
 #include "srtc/pool_allocator.h"
 
 #include <gtest/gtest.h>
 #include <vector>
 #include <cstring>
+#include <thread>
 
 namespace
 {
@@ -66,3 +69,42 @@ TEST(Allocator, Simple)
 
     ASSERT_EQ(itemList.size(), gItemCout);
 }
+
+TEST(Allocator, BufferPool)
+{
+    // On a new thread, so the pool starts empty
+    std::thread thread([] {
+        const uint8_t* first = nullptr;
+        {
+            srtc::ByteBuffer buf(1500);
+            ASSERT_EQ(1500u, buf.capacity());
+            first = buf.data();
+        }
+
+        auto stats = srtc::BufferPool::getStats();
+        ASSERT_EQ(0u, stats.hit_count);
+        ASSERT_EQ(1u, stats.miss_count);
+        ASSERT_EQ(2048u, stats.cached_bytes);
+
+        // Same size class, reused
+        srtc::ByteBuffer buf(1200);
+        ASSERT_EQ(first, buf.data());
+
+        // Grows within the size class without reallocating
+        buf.padding(0, 1200);
+        buf.padding(0, 800);
+        ASSERT_EQ(first, buf.data());
+        ASSERT_EQ(2000u, buf.size());
+        ASSERT_EQ(2048u, buf.capacity());
+
+        // Larger than the largest class
+        buf.padding(0, 100 * 1024);
+        ASSERT_EQ(100 * 1024u + 2000u, buf.size());
+
+        stats = srtc::BufferPool::getStats();
+        ASSERT_EQ(1u, stats.hit_count);
+        ASSERT_EQ(2u, stats.miss_count);
+        ASSERT_EQ(2048u, stats.cached_bytes);
+    });
+    thread.join();
+}
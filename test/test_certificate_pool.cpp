@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include "srtc/certificate_pool.h"
+#include "srtc/peer_connection.h"
+#include "srtc/sdp_offer.h"
+#include "srtc/x509_certificate.h"
+
+#include <openssl/ssl.h>
+
+// Certificates are shared until rotated, when enabled
+
+TEST(CertificatePool, Rotation)
+{
+    // Sharing is opt-in
+    ASSERT_EQ(0, srtc::CertificatePool::Config().rotation_interval.count());
+
+    const auto saved = srtc::CertificatePool::getConfig();
+    srtc::CertificatePool::clear();
+
+    srtc::CertificatePool::Config config;
+    config.rotation_interval = std::chrono::hours(1);
+    config.lifetime = std::chrono::hours(2);
+    srtc::CertificatePool::setConfig(config);
+
+    const auto before = srtc::CertificatePool::getStats();
+
+    const auto cert1 = srtc::CertificatePool::getCertificate();
+    const auto cert2 = srtc::CertificatePool::getCertificate();
+    ASSERT_NE(nullptr, cert1);
+    ASSERT_EQ(cert1, cert2);
+
+    const auto after = srtc::CertificatePool::getStats();
+    ASSERT_EQ(before.cert_created_count + 1, after.cert_created_count);
+    ASSERT_EQ(before.cert_reused_count + 1, after.cert_reused_count);
+    ASSERT_GE(after.setup_saved_micros, before.setup_saved_micros);
+
+    // No sharing
+    config.rotation_interval = std::chrono::seconds(0);
+    srtc::CertificatePool::setConfig(config);
+
+    const auto cert3 = srtc::CertificatePool::getCertificate();
+    const auto cert4 = srtc::CertificatePool::getCertificate();
+    ASSERT_NE(cert1, cert3);
+    ASSERT_NE(cert3, cert4);
+    ASSERT_NE(cert3->getSha256FingerprintHex(), cert4->getSha256FingerprintHex());
+
+    srtc::CertificatePool::setConfig(saved);
+    srtc::CertificatePool::clear();
+}
+
+// DTLS contexts are shared by certificate and role
+
+TEST(CertificatePool, DtlsContext)
+{
+    srtc::CertificatePool::clear();
+
+    const auto cert1 = std::make_shared<srtc::X509Certificate>();
+    const auto cert2 = std::make_shared<srtc::X509Certificate>();
+
+    const auto before = srtc::CertificatePool::getStats();
+
+    const auto server1 = srtc::CertificatePool::getDtlsContext(cert1, true);
+    const auto server2 = srtc::CertificatePool::getDtlsContext(cert1, true);
+    const auto client1 = srtc::CertificatePool::getDtlsContext(cert1, false);
+    const auto other = srtc::CertificatePool::getDtlsContext(cert2, true);
+
+    ASSERT_NE(nullptr, server1);
+    ASSERT_NE(nullptr, client1);
+    ASSERT_NE(nullptr, other);
+    ASSERT_EQ(server1, server2);
+    ASSERT_NE(server1, client1);
+    ASSERT_NE(server1, other);
+
+    const auto after = srtc::CertificatePool::getStats();
+    ASSERT_EQ(before.dtls_ctx_created_count + 3, after.dtls_ctx_created_count);
+    ASSERT_EQ(before.dtls_ctx_reused_count + 1, after.dtls_ctx_reused_count);
+
+    // The context is usable, and stays alive while referenced even after the pool drops it
+    const auto ssl = SSL_new(server1);
+    ASSERT_NE(nullptr, ssl);
+
+    SSL_CTX_free(server1);
+    SSL_CTX_free(server2);
+    SSL_CTX_free(client1);
+    SSL_CTX_free(other);
+
+    SSL_free(ssl);
+    srtc::CertificatePool::clear();
+}
+
+// A prepared connection's offer uses the certificate from prepare, also when certificates are not shared
+
+TEST(CertificatePool, Prepare)
+{
+    ASSERT_EQ(0, srtc::CertificatePool::getConfig().rotation_interval.count());
+
+    srtc::PubOfferConfig config;
+    config.cname = "test";
+    config.data_channel_config.data_channels = { "test" };
+
+    const auto pc = std::make_shared<srtc::PeerConnection>(srtc::Direction::Publish);
+    pc->prepare();
+
+    const auto before = srtc::CertificatePool::getStats();
+
+    const auto [offer1, error1] = pc->createPublishOffer(config, {});
+    ASSERT_TRUE(error1.isOk());
+    const auto [offer2, error2] = pc->createPublishOffer(config, {});
+    ASSERT_TRUE(error2.isOk());
+
+    const auto after = srtc::CertificatePool::getStats();
+    ASSERT_EQ(before.cert_created_count, after.cert_created_count);
+    ASSERT_EQ(before.dtls_ctx_created_count, after.dtls_ctx_created_count);
+    ASSERT_NE(nullptr, offer1->getCertificate());
+    ASSERT_EQ(offer1->getCertificate(), offer2->getCertificate());
+
+    pc->close();
+
+    // Not prepared
+    const auto other = std::make_shared<srtc::PeerConnection>(srtc::Direction::Publish);
+    const auto [offer3, error3] = other->createPublishOffer(config, {});
+    ASSERT_TRUE(error3.isOk());
+    ASSERT_EQ(after.cert_created_count + 1, srtc::CertificatePool::getStats().cert_created_count);
+    other->close();
+}
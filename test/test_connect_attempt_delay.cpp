@@ -0,0 +1,73 @@
+#include "srtc/connect_attempt_delay.h"
+
+#include <gtest/gtest.h>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+srtc::Host makeHost(int family)
+{
+    srtc::Host host = {};
+    host.addr.ss.ss_family = static_cast<sa_family_t>(family);
+    return host;
+}
+
+} // namespace
+
+// The default until there is an rtt, then twice the rtt, within limits
+
+TEST(ConnectAttemptDelay, Delay)
+{
+    const auto host4 = makeHost(AF_INET);
+    const auto host6 = makeHost(AF_INET6);
+
+    srtc::ConnectAttemptDelay delay;
+    ASSERT_EQ(std::chrono::milliseconds(100), delay.get(host4));
+    ASSERT_EQ(std::chrono::milliseconds(100), delay.get(host6));
+
+    // The first sample is taken as is, and the families are separate
+    delay.update(host4, 40.0f);
+    ASSERT_EQ(std::chrono::milliseconds(80), delay.get(host4));
+    ASSERT_EQ(std::chrono::milliseconds(100), delay.get(host6));
+
+    // Smoothed: 40 * 7 / 8 + 120 / 8 = 50
+    delay.update(host4, 120.0f);
+    ASSERT_EQ(std::chrono::milliseconds(100), delay.get(host4));
+
+    delay.update(host6, 5.0f);
+    ASSERT_EQ(std::chrono::milliseconds(25), delay.get(host6));
+
+    srtc::ConnectAttemptDelay slow;
+    slow.update(host4, 400.0f);
+    ASSERT_EQ(std::chrono::milliseconds(250), slow.get(host4));
+}
+
+// Concurrent updates with the same rtt from several threads keep it exact
+
+TEST(ConnectAttemptDelay, Concurrent)
+{
+    const auto host = makeHost(AF_INET);
+
+    srtc::ConnectAttemptDelay delay;
+    delay.update(host, 60.0f);
+
+    std::vector<std::thread> threadList;
+    for (size_t i = 0; i < 4; i += 1) {
+        threadList.emplace_back([&delay, host] {
+            for (size_t j = 0; j < 10000; j += 1) {
+                delay.update(host, 60.0f);
+            }
+        });
+    }
+    for (auto& thread : threadList) {
+        thread.join();
+    }
+
+    ASSERT_EQ(std::chrono::milliseconds(120), delay.get(host));
+}
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include "srtc/dtls_worker_pool.h"
+
+#include <atomic>
+#include <thread>
+
+// Jobs run on the workers, or are left to the caller when there are none
+
+TEST(DtlsWorkerPool, Post)
+{
+    srtc::DtlsWorkerPool::setThreadCount(0);
+    ASSERT_FALSE(srtc::DtlsWorkerPool::post([] {}));
+
+    srtc::DtlsWorkerPool::setThreadCount(2);
+    ASSERT_EQ(2u, srtc::DtlsWorkerPool::getThreadCount());
+
+    const auto callerId = std::this_thread::get_id();
+
+    std::atomic<int> doneCount = 0;
+    std::atomic<int> callerCount = 0;
+
+    for (int i = 0; i < 100; i += 1) {
+        ASSERT_TRUE(srtc::DtlsWorkerPool::post([&] {
+            if (std::this_thread::get_id() == callerId) {
+                callerCount += 1;
+            }
+            doneCount += 1;
+        }));
+    }
+
+    // Waits for the posted jobs
+    srtc::DtlsWorkerPool::setThreadCount(0);
+    ASSERT_EQ(100, doneCount);
+    ASSERT_EQ(0, callerCount);
+    ASSERT_EQ(0u, srtc::DtlsWorkerPool::getThreadCount());
+}
+
+// Setup latency goes into buckets by upper limit
+
+TEST(DtlsWorkerPool, Histogram)
+{
+    using std::chrono::milliseconds;
+
+    const auto before = srtc::DtlsWorkerPool::getStats();
+
+    srtc::DtlsWorkerPool::addSetupLatency(milliseconds(5));
+    srtc::DtlsWorkerPool::addSetupLatency(milliseconds(10));
+    srtc::DtlsWorkerPool::addSetupLatency(milliseconds(120));
+    srtc::DtlsWorkerPool::addSetupLatency(milliseconds(60000));
+
+    const auto after = srtc::DtlsWorkerPool::getStats();
+
+    ASSERT_EQ(before.setup_latency_histogram[0] + 1, after.setup_latency_histogram[0]);
+    ASSERT_EQ(before.setup_latency_histogram[1] + 1, after.setup_latency_histogram[1]);
+    ASSERT_EQ(before.setup_latency_histogram[4] + 1, after.setup_latency_histogram[4]);
+    ASSERT_EQ(before.setup_latency_histogram[9] + 1, after.setup_latency_histogram[9]);
+}
@@ -0,0 +1,233 @@
+#include "srtc/event_loop_group.h"
+#include "srtc/peer_connection.h"
+#include "srtc/sdp_answer.h"
+#include "srtc/sdp_offer.h"
+
+#include <gtest/gtest.h>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// A data channel only answer, with a host which receives our connectivity checks and never answers
+std::string makeAnswer(uint16_t port)
+{
+    std::string fingerprint;
+    for (int i = 0; i < 32; i += 1) {
+        fingerprint += i == 0 ? "AB" : ":AB";
+    }
+
+    std::string answer;
+    answer += "v=0\r\n";
+    answer += "o=- 1 1 IN IP4 127.0.0.1\r\n";
+    answer += "s=-\r\n";
+    answer += "t=0 0\r\n";
+    answer += "m=application 9 UDP/DTLS/SCTP webrtc-datachannel\r\n";
+    answer += "c=IN IP4 127.0.0.1\r\n";
+    answer += "a=mid:0\r\n";
+    answer += "a=ice-ufrag:test\r\n";
+    answer += "a=ice-pwd:testtesttesttesttesttest\r\n";
+    answer += "a=fingerprint:sha-256 " + fingerprint + "\r\n";
+    answer += "a=setup:passive\r\n";
+    answer += "a=sctp-port:5000\r\n";
+    if (port != 0) {
+        answer += "a=candidate:1 1 udp 2130706431 127.0.0.1 " + std::to_string(port) + " typ host\r\n";
+    }
+    return answer;
+}
+
+class Peer
+{
+public:
+    Peer()
+        : mHandle(socket(AF_INET, SOCK_DGRAM, 0))
+        , mPort(0)
+    {
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t addrLen = sizeof(addr);
+        if (bind(mHandle, reinterpret_cast<const sockaddr*>(&addr), addrLen) == 0 &&
+            getsockname(mHandle, reinterpret_cast<sockaddr*>(&addr), &addrLen) == 0) {
+            mPort = ntohs(addr.sin_port);
+        }
+    }
+
+    ~Peer()
+    {
+        close(mHandle);
+    }
+
+    [[nodiscard]] uint16_t getPort() const
+    {
+        return mPort;
+    }
+
+private:
+    const int mHandle;
+    uint16_t mPort;
+};
+
+srtc::PubOfferConfig makeOfferConfig(bool isIceLite)
+{
+    srtc::PubOfferConfig config;
+    config.cname = "test";
+    config.data_channel_config.data_channels = { "test" };
+    if (isIceLite) {
+        config.ice_lite_config.enable = true;
+        config.ice_lite_config.host_list = { "127.0.0.1" };
+    }
+    return config;
+}
+
+// Creates the offer, which assigns an ICE-lite connection to a thread
+std::shared_ptr<srtc::SdpOffer> createOffer(const std::shared_ptr<srtc::PeerConnection>& pc, bool isIceLite)
+{
+    const auto [offer, error] = pc->createPublishOffer(makeOfferConfig(isIceLite), {});
+    if (error.isError()) {
+        return nullptr;
+    }
+    if (pc->setOffer(offer).isError()) {
+        return nullptr;
+    }
+    return offer;
+}
+
+// Sets the answer, which assigns the connection to a thread unless it already is
+bool start(const std::shared_ptr<srtc::PeerConnection>& pc,
+           const std::shared_ptr<srtc::SdpOffer>& offer,
+           uint16_t port)
+{
+    const auto [answer, error] = pc->parsePublishAnswer(offer, makeAnswer(port), nullptr);
+    if (error.isError()) {
+        return false;
+    }
+    return pc->setAnswer(answer).isOk();
+}
+
+std::shared_ptr<srtc::PeerConnection> createStarted(const std::shared_ptr<srtc::EventLoopGroup>& group,
+                                                    uint16_t port)
+{
+    const auto pc = std::make_shared<srtc::PeerConnection>(srtc::Direction::Publish, group);
+    const auto offer = createOffer(pc, false);
+    if (!offer || !start(pc, offer, port)) {
+        pc->close();
+        return nullptr;
+    }
+    return pc;
+}
+
+} // namespace
+
+// Connections go to the least loaded thread, and stop counting once closed
+
+TEST(EventLoopGroup, LeastLoaded)
+{
+    Peer peer;
+    ASSERT_NE(0, peer.getPort());
+
+    const auto group = std::make_shared<srtc::EventLoopGroup>(2);
+    ASSERT_EQ(2u, group->getThreadCount());
+
+    std::vector<std::shared_ptr<srtc::PeerConnection>> list;
+    for (size_t i = 0; i < 4; i += 1) {
+        const auto pc = createStarted(group, peer.getPort());
+        ASSERT_TRUE(pc);
+        list.push_back(pc);
+    }
+    ASSERT_EQ(std::vector<size_t>({ 2, 2 }), group->getLoad());
+
+    // Taking turns: 0 and 2 are on the first thread, 1 and 3 on the second
+    list[0]->close();
+    list[2]->close();
+    ASSERT_EQ(std::vector<size_t>({ 0, 2 }), group->getLoad());
+
+    const auto pc = createStarted(group, peer.getPort());
+    ASSERT_TRUE(pc);
+    list.push_back(pc);
+    ASSERT_EQ(std::vector<size_t>({ 1, 2 }), group->getLoad());
+
+    for (const auto& item : list) {
+        item->close();
+    }
+    ASSERT_EQ(std::vector<size_t>({ 0, 0 }), group->getLoad());
+}
+
+// Closing waits for the group thread to stop running the connection, also when connections on the same
+// threads are being closed from several other threads at once
+
+TEST(EventLoopGroup, DetachFromOtherThreads)
+{
+    Peer peer;
+    ASSERT_NE(0, peer.getPort());
+
+    const auto group = std::make_shared<srtc::EventLoopGroup>(2);
+
+    for (size_t round = 0; round < 3; round += 1) {
+        std::vector<std::shared_ptr<srtc::PeerConnection>> list;
+        for (size_t i = 0; i < 8; i += 1) {
+            const auto pc = createStarted(group, peer.getPort());
+            ASSERT_TRUE(pc);
+            list.push_back(pc);
+        }
+        ASSERT_EQ(std::vector<size_t>({ 4, 4 }), group->getLoad());
+
+        std::vector<std::thread> threadList;
+        for (const auto& pc : list) {
+            threadList.emplace_back([pc] { pc->close(); });
+        }
+        for (auto& thread : threadList) {
+            thread.join();
+        }
+
+        ASSERT_EQ(std::vector<size_t>({ 0, 0 }), group->getLoad());
+    }
+}
+
+// An ICE-lite connection is assigned to a thread by its offer, setting the answer keeps it there, and
+// closing it without an answer releases the thread
+
+TEST(EventLoopGroup, Reserve)
+{
+    const auto group = std::make_shared<srtc::EventLoopGroup>(2, 0);
+    ASSERT_EQ(2u, group->getSharedPortList().size());
+
+    const auto pc1 = std::make_shared<srtc::PeerConnection>(srtc::Direction::Publish, group);
+    const auto offer1 = createOffer(pc1, true);
+    ASSERT_TRUE(offer1);
+    ASSERT_EQ(std::vector<size_t>({ 1, 0 }), group->getLoad());
+
+    // The same connection again is still one
+    ASSERT_TRUE(pc1->createPublishOffer(makeOfferConfig(true), {}).first);
+    ASSERT_EQ(std::vector<size_t>({ 1, 0 }), group->getLoad());
+
+    const auto pc2 = std::make_shared<srtc::PeerConnection>(srtc::Direction::Publish, group);
+    const auto offer2 = createOffer(pc2, true);
+    ASSERT_TRUE(offer2);
+    ASSERT_EQ(std::vector<size_t>({ 1, 1 }), group->getLoad());
+
+    const auto pc3 = std::make_shared<srtc::PeerConnection>(srtc::Direction::Publish, group);
+    ASSERT_TRUE(createOffer(pc3, true));
+    ASSERT_EQ(std::vector<size_t>({ 2, 1 }), group->getLoad());
+
+    // Never answered
+    pc3->close();
+    ASSERT_EQ(std::vector<size_t>({ 1, 1 }), group->getLoad());
+
+    // Already counted
+    ASSERT_TRUE(start(pc1, offer1, 0));
+    ASSERT_TRUE(start(pc2, offer2, 0));
+    ASSERT_EQ(std::vector<size_t>({ 1, 1 }), group->getLoad());
+
+    pc1->close();
+    pc2->close();
+    ASSERT_EQ(std::vector<size_t>({ 0, 0 }), group->getLoad());
+}
@@ -0,0 +1,79 @@
+#include "srtc/mpsc_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+TEST(MpscQueue, Simple)
+{
+    srtc::MpscQueue<std::unique_ptr<int>> queue(5);
+
+    // Rounded up to 8
+    for (int i = 0; i < 8; i += 1) {
+        ASSERT_TRUE(queue.push(std::make_unique<int>(i)));
+    }
+    ASSERT_FALSE(queue.push(std::make_unique<int>(8)));
+
+    std::unique_ptr<int> value;
+    for (int i = 0; i < 8; i += 1) {
+        ASSERT_TRUE(queue.pop(value));
+        ASSERT_EQ(i, *value);
+    }
+    ASSERT_FALSE(queue.pop(value));
+
+    // Wrap around
+    for (int i = 0; i < 100; i += 1) {
+        ASSERT_TRUE(queue.push(std::make_unique<int>(i)));
+        ASSERT_TRUE(queue.push(std::make_unique<int>(i + 1000)));
+        ASSERT_TRUE(queue.pop(value));
+        ASSERT_EQ(i, *value);
+        ASSERT_TRUE(queue.pop(value));
+        ASSERT_EQ(i + 1000, *value);
+    }
+
+    ASSERT_TRUE(queue.push(std::make_unique<int>(1)));
+    queue.clear();
+    ASSERT_FALSE(queue.pop(value));
+}
+
+TEST(MpscQueue, Threads)
+{
+    constexpr size_t kProducerCount = 4;
+    constexpr size_t kItemCount = 100000;
+
+    srtc::MpscQueue<size_t> queue(64);
+
+    std::vector<std::thread> threadList;
+    for (size_t p = 0; p < kProducerCount; p += 1) {
+        threadList.emplace_back([&queue, p] {
+            for (size_t i = 0; i < kItemCount; i += 1) {
+                auto value = p * kItemCount + i;
+                while (!queue.push(std::move(value))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Each producer's items come out in order
+    std::vector<size_t> nextList(kProducerCount, 0);
+    size_t received = 0;
+    while (received < kProducerCount * kItemCount) {
+        size_t value = 0;
+        if (queue.pop(value)) {
+            const auto p = value / kItemCount;
+            ASSERT_LT(p, kProducerCount);
+            ASSERT_EQ(nextList[p], value % kItemCount);
+            nextList[p] += 1;
+            received += 1;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    for (auto& thread : threadList) {
+        thread.join();
+    }
+}
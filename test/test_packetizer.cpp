@@ -8,6 +8,7 @@
 #include "srtc/packetizer_h264.h"
 #include "srtc/rtp_extension_source_simulcast.h"
 #include "srtc/rtp_extension_source_twcc.h"
+#include "srtc/rtp_packet_pool.h"
 #include "srtc/track.h"
 
 #include <cstring>
@@ -76,6 +77,7 @@ TEST(Packetizer, h264)
                                     .codec(srtc::Codec::H264, codecOptions)
                                     .build();
 
+    srtc::RtpPacketPool packetPool;
     const auto packetizer = std::make_shared<srtc::PacketizerH264>(trackPublish);
     const auto depacketizer = std::make_shared<srtc::DepacketizerH264>(trackSubscribe);
 
@@ -110,7 +112,8 @@ TEST(Packetizer, h264)
         }
 
         // Packetize
-        const auto packetList = packetizer->generate(extensionSourceList, 12u, pts_usec, sourceFrame);
+        const auto sharedFrame = std::make_shared<const srtc::ByteBuffer>(sourceFrame.copy());
+        const auto packetList = packetizer->generate(packetPool, extensionSourceList, 12u, pts_usec, sharedFrame);
 
         // Convert to jitter buffer entries
         std::vector<const srtc::JitterBufferItem*> jitterBufferItemList;
@@ -118,7 +121,7 @@ TEST(Packetizer, h264)
             const auto& packet = packetList[packetIndex];
             auto item = new srtc::JitterBufferItem();
 
-            item->payload = packet->getPayload().copy();
+            item->payload = packet->copyPayload();
             item->seq_ext = extendedSeq.extend(packet->getSequence());
             item->rtp_timestamp_ext = extendedRtpTime.extend(packet->getTimestamp());
             item->marker = packetIndex == packetList.size() - 1u;
@@ -142,4 +145,7 @@ TEST(Packetizer, h264)
             delete item;
         }
     }
+
+    // The packets went back to the pool
+    ASSERT_EQ(0u, packetPool.getLiveCount());
 }
@@ -0,0 +1,238 @@
+#include "srtc/certificate_pool.h"
+#include "srtc/ice_agent.h"
+#include "srtc/peer_connection.h"
+#include "srtc/sdp_answer.h"
+#include "srtc/sdp_offer.h"
+#include "srtc/x509_certificate.h"
+
+#include <gtest/gtest.h>
+
+#include <openssl/ssl.h>
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+
+namespace
+{
+
+constexpr auto kIceUFrag = "test";
+constexpr auto kIcePassword = "testtesttesttesttesttest";
+
+// A data channel only answer, we are the DTLS server, the connection is the client
+std::string makeAnswer(uint16_t port, const std::string& fingerprint)
+{
+    std::string answer;
+    answer += "v=0\r\n";
+    answer += "o=- 1 1 IN IP4 127.0.0.1\r\n";
+    answer += "s=-\r\n";
+    answer += "t=0 0\r\n";
+    answer += "m=application 9 UDP/DTLS/SCTP webrtc-datachannel\r\n";
+    answer += "c=IN IP4 127.0.0.1\r\n";
+    answer += "a=mid:0\r\n";
+    answer += std::string("a=ice-ufrag:") + kIceUFrag + "\r\n";
+    answer += std::string("a=ice-pwd:") + kIcePassword + "\r\n";
+    answer += "a=fingerprint:sha-256 " + fingerprint + "\r\n";
+    answer += "a=setup:passive\r\n";
+    answer += "a=sctp-port:5000\r\n";
+    answer += "a=candidate:1 1 udp 2130706431 127.0.0.1 " + std::to_string(port) + " typ host\r\n";
+    return answer;
+}
+
+bool isStun(const uint8_t* data, size_t size)
+{
+    const uint32_t cookie = htonl(srtc::IceAgent::kRfc5389Cookie);
+    return size > 20 && data[0] < 2 && std::memcmp(data + 4, &cookie, 4) == 0;
+}
+
+// A peer which answers connectivity checks and runs the DTLS server over the same socket
+class Peer
+{
+public:
+    Peer()
+        : mHandle(socket(AF_INET, SOCK_DGRAM, 0))
+        , mPort(0)
+        , mCert(std::make_shared<srtc::X509Certificate>())
+        , mCtx(srtc::CertificatePool::getDtlsContext(mCert, true))
+        , mSsl(nullptr)
+        , mIceAgent(std::make_shared<srtc::IceAgent>())
+    {
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t addrLen = sizeof(addr);
+        if (bind(mHandle, reinterpret_cast<const sockaddr*>(&addr), addrLen) == 0 &&
+            getsockname(mHandle, reinterpret_cast<sockaddr*>(&addr), &addrLen) == 0) {
+            mPort = ntohs(addr.sin_port);
+        }
+        fcntl(mHandle, F_SETFL, fcntl(mHandle, F_GETFL) | O_NONBLOCK);
+    }
+
+    ~Peer()
+    {
+        if (mSsl) {
+            SSL_free(mSsl);
+        }
+        if (mCtx) {
+            SSL_CTX_free(mCtx);
+        }
+        close(mHandle);
+    }
+
+    [[nodiscard]] uint16_t getPort() const
+    {
+        return mPort;
+    }
+
+    [[nodiscard]] std::string getFingerprint() const
+    {
+        return mCert->getSha256FingerprintHex();
+    }
+
+    // Handles what arrives within the timeout, returns true once the condition is met
+    template <typename Condition>
+    bool runUntil(std::chrono::milliseconds timeout, const Condition& condition)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!condition()) {
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= deadline) {
+                return false;
+            }
+
+            pollfd pfd = { mHandle, POLLIN, 0 };
+            if (poll(&pfd, 1, 10) > 0) {
+                receive();
+            } else if (mSsl) {
+                DTLSv1_handle_timeout(mSsl);
+            }
+        }
+        return true;
+    }
+
+    [[nodiscard]] bool isHandshakeDone() const
+    {
+        return mSsl && SSL_is_init_finished(mSsl);
+    }
+
+    [[nodiscard]] bool isCloseNotifyReceived() const
+    {
+        return mSsl && (SSL_get_shutdown(mSsl) & SSL_RECEIVED_SHUTDOWN) != 0;
+    }
+
+private:
+    void receive()
+    {
+        uint8_t buf[2048];
+        sockaddr_in addr = {};
+        socklen_t addrLen = sizeof(addr);
+        const auto r = recvfrom(mHandle, buf, sizeof(buf), MSG_PEEK, reinterpret_cast<sockaddr*>(&addr), &addrLen);
+        if (r <= 0) {
+            return;
+        }
+
+        if (isStun(buf, static_cast<size_t>(r))) {
+            // Consumes the datagram
+            recv(mHandle, buf, sizeof(buf), 0);
+            respondToStun(buf, static_cast<size_t>(r), addr);
+        } else if (!mSsl) {
+            // The first DTLS datagram, from now on we only talk to the connection
+            if (connect(mHandle, reinterpret_cast<const sockaddr*>(&addr), addrLen) != 0) {
+                return;
+            }
+            const auto bio = BIO_new_dgram(mHandle, BIO_NOCLOSE);
+            BIO_ctrl_set_connected(bio, &addr);
+            mSsl = SSL_new(mCtx);
+            SSL_set_bio(mSsl, bio, bio);
+            SSL_set_accept_state(mSsl);
+            SSL_do_handshake(mSsl);
+        } else if (!SSL_is_init_finished(mSsl)) {
+            SSL_do_handshake(mSsl);
+        } else {
+            // Data channel messages, which we ignore, and eventually the close_notify
+            uint8_t data[2048];
+            SSL_read(mSsl, data, sizeof(data));
+        }
+    }
+
+    void respondToStun(uint8_t* data, size_t size, const sockaddr_in& addr)
+    {
+        stun::StunMessage request = {};
+        request.buffer = data;
+        request.buffer_len = size;
+        if (stun::stun_message_get_class(&request) != stun::STUN_REQUEST) {
+            return;
+        }
+
+        uint8_t buf[512];
+        stun::StunMessage response = {};
+        mIceAgent->initResponse(&response, buf, sizeof(buf), &request);
+        stun::stun_message_append_xor_addr(&response,
+                                           stun::STUN_ATTRIBUTE_XOR_MAPPED_ADDRESS,
+                                           reinterpret_cast<const sockaddr_storage*>(&addr),
+                                           sizeof(addr));
+        mIceAgent->finishMessage(&response, std::nullopt, kIcePassword);
+
+        sendto(mHandle,
+               buf,
+               stun::stun_message_length(&response),
+               0,
+               reinterpret_cast<const sockaddr*>(&addr),
+               sizeof(addr));
+    }
+
+    const int mHandle;
+    uint16_t mPort;
+    const std::shared_ptr<srtc::X509Certificate> mCert;
+    SSL_CTX* const mCtx;
+    SSL* mSsl;
+    const std::shared_ptr<srtc::IceAgent> mIceAgent;
+};
+
+} // namespace
+
+// Closing a connection frees its candidate, whose DTLS close_notify still reaches the peer
+
+TEST(PeerCandidate, CloseNotify)
+{
+    Peer peer;
+    ASSERT_NE(0, peer.getPort());
+
+    const auto pc = std::make_shared<srtc::PeerConnection>(srtc::Direction::Publish);
+
+    std::atomic<bool> isConnected = false;
+    pc->setConnectionStateListener([&isConnected](srtc::PeerConnection::ConnectionState state) {
+        if (state == srtc::PeerConnection::ConnectionState::Connected) {
+            isConnected = true;
+        }
+    });
+
+    srtc::PubOfferConfig config;
+    config.cname = "test";
+    config.data_channel_config.data_channels = { "test" };
+
+    const auto [offer, offerError] = pc->createPublishOffer(config, {});
+    ASSERT_TRUE(offerError.isOk());
+    ASSERT_TRUE(pc->setOffer(offer).isOk());
+
+    const auto [answer, answerError] =
+        pc->parsePublishAnswer(offer, makeAnswer(peer.getPort(), peer.getFingerprint()), nullptr);
+    ASSERT_TRUE(answerError.isOk());
+    ASSERT_TRUE(pc->setAnswer(answer).isOk());
+
+    ASSERT_TRUE(peer.runUntil(std::chrono::seconds(5),
+                              [&peer, &isConnected] { return peer.isHandshakeDone() && isConnected; }));
+    ASSERT_FALSE(peer.isCloseNotifyReceived());
+
+    pc->close();
+
+    ASSERT_TRUE(peer.runUntil(std::chrono::seconds(1), [&peer] { return peer.isCloseNotifyReceived(); }));
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include "srtc/peer_connection.h"
+#include "srtc/peer_connection_pool.h"
+
+#include <chrono>
+#include <thread>
+
+namespace
+{
+
+bool waitForReady(const srtc::PeerConnectionPool& pool, size_t count)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (pool.getStats().ready_count >= count) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return false;
+}
+
+} // namespace
+
+// Connections are prepared in the background, and taken from the pool while there are any
+
+TEST(PeerConnectionPool, Acquire)
+{
+    srtc::PeerConnectionPool pool(srtc::Direction::Publish, 2);
+    ASSERT_TRUE(waitForReady(pool, 2));
+
+    const auto conn1 = pool.acquire();
+    const auto conn2 = pool.acquire();
+    ASSERT_NE(nullptr, conn1);
+    ASSERT_NE(nullptr, conn2);
+    ASSERT_NE(conn1, conn2);
+
+    auto stats = pool.getStats();
+    ASSERT_EQ(2u, stats.hit_count);
+    ASSERT_GE(stats.warm_up_count, 2u);
+
+    // Refilled after being taken from
+    ASSERT_TRUE(waitForReady(pool, 2));
+
+    stats = pool.getStats();
+    ASSERT_GE(stats.warm_up_count, 4u);
+    ASSERT_EQ(0u, stats.miss_count);
+
+    // A prepared connection which never got an answer closes cleanly
+    conn1->close();
+    conn2->close();
+}
+
+// An empty pool creates connections on the spot
+
+TEST(PeerConnectionPool, Miss)
+{
+    srtc::PeerConnectionPool pool(srtc::Direction::Subscribe, 0);
+
+    const auto conn = pool.acquire();
+    ASSERT_NE(nullptr, conn);
+
+    const auto stats = pool.getStats();
+    ASSERT_EQ(0u, stats.hit_count);
+    ASSERT_EQ(1u, stats.miss_count);
+    ASSERT_EQ(0u, stats.ready_count);
+}
@@ -1,8 +1,10 @@
 #include <gtest/gtest.h>
 
+#include "srtc/buffer_slice.h"
 #include "srtc/byte_buffer.h"
 #include "srtc/rtp_extension_builder.h"
 #include "srtc/rtp_packet.h"
+#include "srtc/rtp_packet_pool.h"
 #include "srtc/media.h"
 #include "srtc/track.h"
 #include "srtc/util.h"
@@ -202,3 +204,219 @@ TEST(RtpPacket, Serialize)
         }
     }
 }
+
+// A payload which refers to a slice of a shared frame
+
+TEST(RtpPacket, SerializeSlice)
+{
+    const auto kSSRC = 0x12345678u;
+    const auto kPayloadId = 96u;
+
+    const auto media = std::make_shared<srtc::Media>("0", srtc::MediaType::Video);
+    const auto track = std::make_shared<srtc::Track>(media,
+                                                     srtc::Direction::Subscribe,
+                                                     kSSRC,
+                                                     kPayloadId,
+                                                     0,
+                                                     0,
+                                                     srtc::Codec::H264,
+                                                     nullptr,
+                                                     nullptr,
+                                                     90000,
+                                                     false,
+                                                     false);
+
+    for (size_t i = 0; i < 1000; i += 1) {
+        const uint8_t padding = (i % 3) == 0 ? static_cast<uint8_t>(1 + randomU32() % 255) : 0;
+
+        const size_t frameSize = 1 + randomU32() % 2000;
+        srtc::ByteBuffer frameData(frameSize);
+        frameData.resize(frameSize);
+        RAND_bytes(frameData.data(), static_cast<int>(frameSize));
+        const auto frame = std::make_shared<const srtc::ByteBuffer>(std::move(frameData));
+
+        const size_t sliceOffset = randomU32() % frameSize;
+        const size_t sliceSize = randomU32() % (frameSize - sliceOffset + 1);
+        const srtc::BufferSlice slice = { frame, frame->data() + sliceOffset, sliceSize };
+
+        const uint8_t header[2] = { static_cast<uint8_t>(i), static_cast<uint8_t>(i >> 8) };
+
+        srtc::RtpExtensionBuilder builder;
+        builder.addU16Value(3, static_cast<uint16_t>(i));
+
+        const auto packet = std::make_shared<srtc::RtpPacket>(track,
+                                                              false,
+                                                              0,
+                                                              static_cast<uint16_t>(i),
+                                                              static_cast<uint32_t>(i),
+                                                              padding,
+                                                              builder.build(),
+                                                              srtc::ByteBuffer{ header, sizeof(header) },
+                                                              slice);
+        ASSERT_EQ(sizeof(header) + sliceSize, packet->getPayloadSize());
+
+        // The payload is the header followed by the slice
+        const auto payload = packet->copyPayload();
+        ASSERT_EQ(sizeof(header) + sliceSize, payload.size());
+        ASSERT_EQ(0, std::memcmp(payload.data(), header, sizeof(header)));
+        ASSERT_EQ(0, std::memcmp(payload.data() + sizeof(header), frame->data() + sliceOffset, sliceSize));
+
+        // The gathered packet is the same as the assembled one
+        const auto data = packet->generate();
+
+        srtc::ByteBuffer gatherHeader;
+        srtc::ByteGather gatherBody;
+        ASSERT_EQ(data.rollover, packet->generate(gatherHeader, gatherBody));
+        gatherBody.appendTo(gatherHeader);
+        ASSERT_EQ(data.buf, gatherHeader);
+
+        // And it parses back
+        const auto copy = srtc::RtpPacket::fromUdpPacket(track, data.buf);
+        ASSERT_TRUE(copy) << " iteration = " << i << std::endl;
+        ASSERT_EQ(payload, copy->getPayload());
+    }
+}
+
+// Parsing a received packet where it is
+
+TEST(RtpPacket, ParseView)
+{
+    const auto kSSRC = 0x12345678u;
+    const auto kPayloadId = 96u;
+
+    const auto media = std::make_shared<srtc::Media>("0", srtc::MediaType::Video);
+    const auto track = std::make_shared<srtc::Track>(media,
+                                                     srtc::Direction::Subscribe,
+                                                     kSSRC,
+                                                     kPayloadId,
+                                                     0,
+                                                     0,
+                                                     srtc::Codec::H264,
+                                                     nullptr,
+                                                     nullptr,
+                                                     90000,
+                                                     false,
+                                                     false);
+
+    for (size_t i = 0; i < 1000; i += 1) {
+        const uint8_t padding = (i % 5) == 0 ? static_cast<uint8_t>(1 + randomU32() % 255) : 0;
+        const bool marker = (i % 9) == 0;
+
+        srtc::RtpExtension extension;
+        if ((i % 2) == 0) {
+            srtc::RtpExtensionBuilder builder;
+            builder.addStringValue(1, "foo");
+            builder.addU16Value(3, static_cast<uint16_t>(i));
+            extension = builder.build();
+        }
+
+        const size_t payloadSize = randomU32() % 0x3FF;
+        srtc::ByteBuffer payload(payloadSize);
+        payload.resize(payloadSize);
+        RAND_bytes(payload.data(), static_cast<int>(payloadSize));
+
+        const auto packet = std::make_shared<srtc::RtpPacket>(track,
+                                                              marker,
+                                                              0,
+                                                              static_cast<uint16_t>(i),
+                                                              static_cast<uint32_t>(i * 3000),
+                                                              padding,
+                                                              extension.copy(),
+                                                              payload.copy());
+        const auto data = packet->generate();
+
+        srtc::RtpPacketView view;
+        ASSERT_TRUE(srtc::RtpPacketView::parse(data.buf.data(), data.buf.size(), view)) << " iteration = " << i;
+
+        ASSERT_EQ(kSSRC, view.ssrc);
+        ASSERT_EQ(kPayloadId, view.payloadId);
+        ASSERT_EQ(marker, view.marker);
+        ASSERT_EQ(static_cast<uint16_t>(i), view.sequence);
+        ASSERT_EQ(static_cast<uint32_t>(i * 3000), view.timestamp);
+
+        // The payload points into the packet, without the padding
+        ASSERT_EQ(payloadSize, view.payloadSize);
+        ASSERT_TRUE(view.payloadData >= data.buf.data() && view.payloadData <= data.buf.data() + data.buf.size());
+        ASSERT_EQ(0, std::memcmp(payload.data(), view.payloadData, payloadSize));
+
+        if (extension.empty()) {
+            ASSERT_EQ(0, view.extensionId);
+            ASSERT_FALSE(view.findExtension(3).has_value());
+            ASSERT_TRUE(view.copyExtension().empty());
+        } else {
+            const auto value = view.findExtension(3);
+            ASSERT_TRUE(value.has_value());
+            ASSERT_EQ(2u, value->size);
+
+            const auto copy = view.copyExtension();
+            ASSERT_EQ(extension.getId(), copy.getId());
+            ASSERT_EQ(extension.getData(), copy.getData());
+            ASSERT_EQ(static_cast<uint16_t>(i), copy.findU16(3).value());
+        }
+    }
+
+    // Truncated packets
+    const uint8_t header[8] = { 0x80, 96, 0, 1, 0, 0, 0, 1 };
+    srtc::RtpPacketView view;
+    ASSERT_FALSE(srtc::RtpPacketView::parse(header, sizeof(header), view));
+
+    const uint8_t badExtension[16] = { 0x90, 96, 0, 1, 0, 0, 0, 1, 0x12, 0x34, 0x56, 0x78, 0xBE, 0xDE, 0, 2 };
+    ASSERT_FALSE(srtc::RtpPacketView::parse(badExtension, sizeof(badExtension), view));
+}
+
+// Pooled packets, shared by non-atomic references
+
+TEST(RtpPacket, Pool)
+{
+    const auto media = std::make_shared<srtc::Media>("0", srtc::MediaType::Video);
+    const auto track = std::make_shared<srtc::Track>(media,
+                                                     srtc::Direction::Publish,
+                                                     0x12345678u,
+                                                     96,
+                                                     0,
+                                                     0,
+                                                     srtc::Codec::H264,
+                                                     nullptr,
+                                                     nullptr,
+                                                     90000,
+                                                     false,
+                                                     false);
+
+    srtc::RtpPacketPool pool;
+
+    auto packet = pool.make(track, false, 0, 1, 1000, 0, srtc::ByteBuffer{ 100 });
+    ASSERT_TRUE(packet);
+    ASSERT_EQ(track.get(), packet->getTrack());
+    ASSERT_EQ(1u, pool.getLiveCount());
+
+    // References keep the packet alive
+    srtc::RtpPacketPtr copy = packet;
+    srtc::RtpPacketPtr moved = std::move(packet);
+    ASSERT_FALSE(packet);
+    ASSERT_EQ(copy, moved);
+
+    moved.reset();
+    ASSERT_EQ(1u, pool.getLiveCount());
+    ASSERT_EQ(1u, copy->getSequence());
+
+    // The last one returns it to the pool, which reuses the memory
+    const auto ptr = copy.get();
+    {
+        const srtc::RtpPacketPtr last = copy;
+        copy.reset();
+        ASSERT_EQ(1u, pool.getLiveCount());
+    }
+    ASSERT_EQ(0u, pool.getLiveCount());
+
+    const auto reused = pool.make(track, true, 0, 2, 2000, 0, srtc::ByteBuffer{});
+    ASSERT_EQ(ptr, reused.get());
+    ASSERT_EQ(2u, reused->getSequence());
+    ASSERT_TRUE(reused->getMarker());
+
+    // Packets can also be on the heap
+    auto heap = srtc::RtpPacket::make(track, false, 0, 3, 3000, 0, srtc::ByteBuffer{});
+    ASSERT_EQ(3u, heap->getSequence());
+    heap = reused;
+    ASSERT_EQ(reused, heap);
+    ASSERT_EQ(1u, pool.getLiveCount());
+}
@@ -2,7 +2,10 @@
 
 #include "../src/sctp/sctp_crc32.h"
 
+#include <chrono>
 #include <cstring>
+#include <iostream>
+#include <vector>
 
 using namespace srtc::sctp;
 
@@ -109,3 +112,82 @@ TEST(TestSctpCrc32, ByteAtATimeConsistency)
         EXPECT_EQ(actual, expected) << "length " << len;
     }
 }
+
+// The implementation picked for this CPU matches the table version, for lengths and alignments which
+// go through all of its paths: alignment, interleaved streams, 8 byte words and the tail.
+
+TEST(TestSctpCrc32, HardwareVsTable)
+{
+    std::cout << "CRC-32c implementation: " << crc32c_implementation() << std::endl;
+
+    std::vector<uint8_t> buf(2048 + 8);
+    for (size_t i = 0; i < buf.size(); i++) {
+        buf[i] = static_cast<uint8_t>(i * 31 + (i >> 8) + 11);
+    }
+
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t len = 0; len <= 2048; len++) {
+            const uint8_t* data = buf.data() + offset;
+            const uint32_t expected = crc32c_update_table(0xFFFFFFFFu, data, len);
+            const uint32_t actual = crc32c_update(0xFFFFFFFFu, data, len);
+            ASSERT_EQ(actual, expected) << "offset " << offset << ", length " << len;
+        }
+    }
+
+    // And with the bit-by-bit reference
+    for (size_t len = 0; len <= 1200; len += 37) {
+        EXPECT_EQ(crc32c(buf.data() + 3, len), reference_crc32c(buf.data() + 3, len)) << "length " << len;
+    }
+}
+
+// Split points which fall inside the interleaved streams
+
+TEST(TestSctpCrc32, IncrementalSplitLarge)
+{
+    std::vector<uint8_t> buf(1500);
+    for (size_t i = 0; i < buf.size(); i++) {
+        buf[i] = static_cast<uint8_t>(i * 7 + 3);
+    }
+
+    const uint32_t expected = reference_crc32c(buf.data(), buf.size());
+
+    for (size_t split = 0; split <= buf.size(); split += 13) {
+        uint32_t crc = crc32c_update(0xFFFFFFFFu, buf.data(), split);
+        crc = crc32c_update(crc, buf.data() + split, buf.size() - split);
+        EXPECT_EQ(crc32c_finalize(crc), expected) << "split at " << split;
+    }
+}
+
+// Throughput of the table version and of the one picked for this CPU, printed but not checked
+
+TEST(TestSctpCrc32, Throughput)
+{
+    constexpr size_t kTotalBytes = 64 * 1024 * 1024;
+    const size_t sizeList[] = { 64, 1200, 64 * 1024 };
+
+    std::vector<uint8_t> buf(64 * 1024);
+    for (size_t i = 0; i < buf.size(); i++) {
+        buf[i] = static_cast<uint8_t>(i * 13 + 5);
+    }
+
+    const auto measure = [&buf](uint32_t (*update)(uint32_t, const uint8_t*, size_t), size_t size, uint32_t& sink) {
+        const auto count = kTotalBytes / size;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; i++) {
+            sink ^= update(0xFFFFFFFFu, buf.data(), size);
+        }
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return static_cast<double>(count * size) / elapsed / (1024.0 * 1024.0);
+    };
+
+    uint32_t sink = 0;
+    for (const auto size : sizeList) {
+        const auto table = measure(crc32c_update_table, size, sink);
+        const auto selected = measure(crc32c_update, size, sink);
+        std::cout << "CRC-32c " << size << " byte buffers: table " << static_cast<int>(table) << " MB/s, "
+                  << crc32c_implementation() << " " << static_cast<int>(selected) << " MB/s" << std::endl;
+    }
+
+    // Both computed the same values
+    EXPECT_EQ(sink, 0u);
+}
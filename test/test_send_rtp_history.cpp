@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+
+#include "srtc/byte_buffer.h"
+#include "srtc/media.h"
+#include "srtc/rtp_packet.h"
+#include "srtc/rtp_packet_pool.h"
+#include "srtc/send_rtp_history.h"
+#include "srtc/track.h"
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+namespace
+{
+
+std::shared_ptr<srtc::Track> makeTrack(uint32_t ssrc)
+{
+    const auto media = std::make_shared<srtc::Media>("0", srtc::MediaType::Video);
+    return std::make_shared<srtc::Track>(media,
+                                         srtc::Direction::Publish,
+                                         ssrc,
+                                         96,
+                                         0,
+                                         0,
+                                         srtc::Codec::H264,
+                                         nullptr,
+                                         nullptr,
+                                         90000,
+                                         true,
+                                         false);
+}
+
+} // namespace
+
+// Sizing from the time window and bitrate
+
+TEST(SendRtpHistory, Capacity)
+{
+    using std::chrono::milliseconds;
+
+    // One second at 8 Mbit/s is about 833 packets
+    ASSERT_EQ(1024u, srtc::SendRtpHistory::calculateCapacity(milliseconds(1000), 8000));
+    // Four times that
+    ASSERT_EQ(4096u, srtc::SendRtpHistory::calculateCapacity(milliseconds(2000), 16000));
+    // Never too small, and never more than half the sequence number space
+    ASSERT_EQ(64u, srtc::SendRtpHistory::calculateCapacity(milliseconds(0), 8000));
+    ASSERT_EQ(64u, srtc::SendRtpHistory::calculateCapacity(milliseconds(100), 100));
+    ASSERT_EQ(32768u, srtc::SendRtpHistory::calculateCapacity(milliseconds(60000), 100000));
+}
+
+// Saving and finding by sequence number
+
+TEST(SendRtpHistory, SaveFind)
+{
+    const auto track1 = makeTrack(0x1111);
+    const auto track2 = makeTrack(0x2222);
+
+    srtc::RtpPacketPool pool;
+    srtc::SendRtpHistory history(std::chrono::milliseconds(100), 100, false);
+    ASSERT_EQ(64u, history.getStats().capacity);
+
+    // Across the sequence number rollover
+    const uint16_t first = 65500;
+    for (uint16_t i = 0; i < 50; i += 1) {
+        const auto seq = static_cast<uint16_t>(first + i);
+        history.save(pool.make(track1, false, 0, seq, 0, 0, srtc::ByteBuffer{}));
+        history.save(pool.make(track2, false, 0, static_cast<uint16_t>(seq + 1000), 0, 0, srtc::ByteBuffer{}));
+    }
+
+    for (uint16_t i = 0; i < 50; i += 1) {
+        const auto seq = static_cast<uint16_t>(first + i);
+
+        const auto packet1 = history.find(0x1111, seq);
+        ASSERT_TRUE(packet1);
+        ASSERT_EQ(seq, packet1->getSequence());
+        ASSERT_EQ(0x1111u, packet1->getSSRC());
+
+        const auto packet2 = history.find(0x2222, static_cast<uint16_t>(seq + 1000));
+        ASSERT_TRUE(packet2);
+        ASSERT_EQ(0x2222u, packet2->getSSRC());
+    }
+
+    // Not saved, or an unknown SSRC
+    ASSERT_FALSE(history.find(0x1111, static_cast<uint16_t>(first + 50)));
+    ASSERT_FALSE(history.find(0x1111, static_cast<uint16_t>(first - 20)));
+    ASSERT_FALSE(history.find(0x3333, first));
+
+    auto stats = history.getStats();
+    ASSERT_EQ(100u, stats.saved_count);
+    ASSERT_EQ(100u, stats.found_count);
+    ASSERT_EQ(3u, stats.missed_count);
+    ASSERT_EQ(0u, stats.evicted_count);
+
+    // Wrapping around the ring replaces the oldest packets, which are still inside the time window
+    for (uint16_t i = 50; i < 100; i += 1) {
+        history.save(pool.make(track1, false, 0, static_cast<uint16_t>(first + i), 0, 0, srtc::ByteBuffer{}));
+    }
+
+    ASSERT_FALSE(history.find(0x1111, first));
+    ASSERT_TRUE(history.find(0x1111, static_cast<uint16_t>(first + 36)));
+    ASSERT_TRUE(history.find(0x1111, static_cast<uint16_t>(first + 99)));
+
+    stats = history.getStats();
+    ASSERT_EQ(36u, stats.evicted_count);
+    ASSERT_EQ(4u, stats.missed_count);
+
+    // Evicted packets went back to the pool
+    ASSERT_EQ(64u + 50u, pool.getLiveCount());
+}
+
+// Keeping the protected bytes
+
+TEST(SendRtpHistory, Protected)
+{
+    const auto track = makeTrack(0x1111);
+    const uint8_t data[] = { 1, 2, 3, 4, 5 };
+
+    srtc::RtpPacketPool pool;
+
+    // Not caching
+    {
+        srtc::SendRtpHistory history(std::chrono::milliseconds(100), 100, false);
+        ASSERT_FALSE(history.isCachingProtected());
+
+        history.save(pool.make(track, false, 0, 10, 0, 0, srtc::ByteBuffer{}));
+        history.saveProtected(0x1111, 10, data, sizeof(data));
+        ASSERT_EQ(nullptr, history.findProtected(0x1111, 10));
+        ASSERT_TRUE(history.find(0x1111, 10));
+    }
+
+    // Caching
+    srtc::SendRtpHistory history(std::chrono::milliseconds(100), 100, true);
+    ASSERT_TRUE(history.isCachingProtected());
+
+    history.save(pool.make(track, false, 0, 10, 0, 0, srtc::ByteBuffer{}));
+    history.save(pool.make(track, false, 0, 11, 0, 0, srtc::ByteBuffer{}));
+
+    // Only for packets which were saved
+    history.saveProtected(0x1111, 10, data, sizeof(data));
+    history.saveProtected(0x1111, 12, data, sizeof(data));
+    history.saveProtected(0x2222, 10, data, sizeof(data));
+
+    const auto cached = history.findProtected(0x1111, 10);
+    ASSERT_NE(nullptr, cached);
+    ASSERT_EQ(sizeof(data), cached->size());
+    ASSERT_EQ(0, std::memcmp(data, cached->data(), sizeof(data)));
+
+    ASSERT_EQ(nullptr, history.findProtected(0x1111, 11));
+    ASSERT_EQ(nullptr, history.findProtected(0x1111, 12));
+    ASSERT_EQ(nullptr, history.findProtected(0x2222, 10));
+
+    auto stats = history.getStats();
+    ASSERT_EQ(0u, stats.found_count);
+    ASSERT_EQ(1u, stats.protected_found_count);
+
+    // A NACK looks up the packet and then its protected bytes, which is found once
+    ASSERT_TRUE(history.find(0x1111, 10));
+    ASSERT_NE(nullptr, history.findProtected(0x1111, 10));
+
+    // And one without protected bytes is re-sent the usual way
+    ASSERT_TRUE(history.find(0x1111, 11));
+    ASSERT_EQ(nullptr, history.findProtected(0x1111, 11));
+
+    stats = history.getStats();
+    ASSERT_EQ(2u, stats.found_count);
+    ASSERT_EQ(2u, stats.protected_found_count);
+    ASSERT_EQ(0u, stats.missed_count);
+
+    // Replacing the packet in the slot drops what was cached for the old one
+    history.save(pool.make(track, false, 0, static_cast<uint16_t>(10 + 64), 0, 0, srtc::ByteBuffer{}));
+    ASSERT_EQ(nullptr, history.findProtected(0x1111, 10));
+    ASSERT_EQ(nullptr, history.findProtected(0x1111, static_cast<uint16_t>(10 + 64)));
+
+    stats = history.getStats();
+    ASSERT_EQ(2u, stats.found_count);
+    ASSERT_EQ(2u, stats.protected_found_count);
+}
@@ -0,0 +1,236 @@
+#include "srtc/event_loop.h"
+#include "srtc/shared_socket.h"
+#include "srtc/socket.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+srtc::anyaddr makeLoopback(uint16_t port)
+{
+    srtc::anyaddr addr = {};
+    addr.sin_ipv4.sin_family = AF_INET;
+    addr.sin_ipv4.sin_port = htons(port);
+    addr.sin_ipv4.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return addr;
+}
+
+// A STUN binding request with just the USERNAME attribute
+std::vector<uint8_t> makeStunRequest(const std::string& userName)
+{
+    const auto padded = (userName.size() + 3) & ~size_t{ 3 };
+
+    std::vector<uint8_t> buf(20 + 4 + padded);
+    buf[1] = 0x01;
+    buf[2] = static_cast<uint8_t>((4 + padded) >> 8);
+    buf[3] = static_cast<uint8_t>(4 + padded);
+    buf[4] = 0x21;
+    buf[5] = 0x12;
+    buf[6] = 0xA4;
+    buf[7] = 0x42;
+    for (size_t i = 8; i < 20; i += 1) {
+        buf[i] = static_cast<uint8_t>(i);
+    }
+
+    buf[21] = 0x06;
+    buf[22] = static_cast<uint8_t>(userName.size() >> 8);
+    buf[23] = static_cast<uint8_t>(userName.size());
+    std::memcpy(buf.data() + 24, userName.data(), userName.size());
+
+    return buf;
+}
+
+std::vector<void*> waitFor(const std::shared_ptr<srtc::EventLoop>& eventLoop,
+                           size_t count,
+                           const std::chrono::milliseconds& timeout = std::chrono::milliseconds(2000))
+{
+    std::vector<void*> result;
+    std::vector<void*> udataList;
+
+    const auto end = std::chrono::steady_clock::now() + timeout;
+    while (result.size() < count && std::chrono::steady_clock::now() < end) {
+        eventLoop->wait(udataList, std::chrono::milliseconds(10));
+        result.insert(result.end(), udataList.begin(), udataList.end());
+    }
+    return result;
+}
+
+std::string receiveString(const std::shared_ptr<srtc::Socket>& socket)
+{
+    std::vector<srtc::Socket::ReceivedData*> list;
+    socket->receive(list);
+
+    std::string result;
+    for (const auto data : list) {
+        result.append(reinterpret_cast<const char*>(data->buf.data()), data->buf.size());
+    }
+    socket->release(list.size());
+    return result;
+}
+
+} // namespace
+
+TEST(SharedSocket, Routing)
+{
+    const auto eventLoop = srtc::EventLoop::factory();
+    eventLoop->setSharedPort(0, false);
+
+    const auto sharedSocket = eventLoop->getSharedSocket();
+    const auto port = sharedSocket->getPort(AF_INET);
+    ASSERT_NE(0, port);
+
+    // The remote peers
+    constexpr size_t kPeerCount = 3;
+    std::shared_ptr<srtc::Socket> peerList[kPeerCount];
+    std::shared_ptr<srtc::Socket> endpointList[kPeerCount];
+    int udataList[kPeerCount];
+
+    for (size_t i = 0; i < kPeerCount; i += 1) {
+        peerList[i] = srtc::Socket::createBound(AF_INET, 0, false);
+        ASSERT_TRUE(peerList[i]);
+
+        const auto addr = makeLoopback(peerList[i]->getLocalPort());
+        endpointList[i] = eventLoop->createSocket(addr, "ufrag" + std::to_string(i));
+        ASSERT_TRUE(endpointList[i]->isEndpoint());
+        eventLoop->registerSocket(endpointList[i], &udataList[i]);
+    }
+
+    // Only one endpoint per remote address
+    ASSERT_FALSE(eventLoop->createSocket(makeLoopback(peerList[0]->getLocalPort()), "other")->isEndpoint());
+
+    // Endpoints send through the shared socket
+    for (size_t i = 0; i < kPeerCount; i += 1) {
+        ASSERT_EQ(2, endpointList[i]->send(("e" + std::to_string(i)).c_str(), 2));
+    }
+    for (size_t i = 0; i < kPeerCount; i += 1) {
+        const auto& peer = peerList[i];
+        std::string received;
+        const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (received.empty() && std::chrono::steady_clock::now() < end) {
+            received = receiveString(peer);
+        }
+        ASSERT_EQ("e" + std::to_string(i), received);
+    }
+
+    // Received datagrams are routed by address
+    const auto sharedAddr = makeLoopback(port);
+    for (size_t i = 0; i < kPeerCount; i += 1) {
+        ASSERT_EQ(2, sendto(peerList[i]->handle(), ("p" + std::to_string(i)).c_str(), 2, 0,
+                            reinterpret_cast<const sockaddr*>(&sharedAddr.sin_ipv4), sizeof(sharedAddr.sin_ipv4)));
+    }
+
+    const auto ready = waitFor(eventLoop, kPeerCount);
+    ASSERT_EQ(kPeerCount, ready.size());
+    for (size_t i = 0; i < kPeerCount; i += 1) {
+        ASSERT_EQ("p" + std::to_string(i), receiveString(endpointList[i]));
+    }
+
+    // A STUN request from an unknown address is routed by ufrag, but the address is not remembered
+    const auto stranger = srtc::Socket::createBound(AF_INET, 0, false);
+    const auto request = makeStunRequest("ufrag1:remote");
+    ASSERT_EQ(static_cast<ssize_t>(request.size()),
+              sendto(stranger->handle(), request.data(), request.size(), 0,
+                     reinterpret_cast<const sockaddr*>(&sharedAddr.sin_ipv4), sizeof(sharedAddr.sin_ipv4)));
+    ASSERT_EQ(1u, waitFor(eventLoop, 1).size());
+    ASSERT_EQ(request.size(), receiveString(endpointList[1]).size());
+
+    ASSERT_EQ(2, sendto(stranger->handle(), "s0", 2, 0,
+                        reinterpret_cast<const sockaddr*>(&sharedAddr.sin_ipv4), sizeof(sharedAddr.sin_ipv4)));
+    ASSERT_TRUE(waitFor(eventLoop, 1, std::chrono::milliseconds(200)).empty());
+
+    // Until the candidate has verified the request, and only for one endpoint
+    const auto strangerAddr = makeLoopback(stranger->getLocalPort());
+    ASSERT_TRUE(sharedSocket->addEndpointAddress(endpointList[1], strangerAddr));
+    ASSERT_FALSE(sharedSocket->addEndpointAddress(endpointList[0], strangerAddr));
+
+    ASSERT_EQ(2, sendto(stranger->handle(), "s1", 2, 0,
+                        reinterpret_cast<const sockaddr*>(&sharedAddr.sin_ipv4), sizeof(sharedAddr.sin_ipv4)));
+    const auto strangerReady = waitFor(eventLoop, 1);
+    ASSERT_EQ(1u, strangerReady.size());
+    ASSERT_EQ(&udataList[1], strangerReady[0]);
+    ASSERT_EQ("s1", receiveString(endpointList[1]));
+
+    // Removed endpoints don't receive
+    eventLoop->unregisterSocket(endpointList[2]);
+    ASSERT_EQ(2, sendto(peerList[2]->handle(), "xx", 2, 0,
+                        reinterpret_cast<const sockaddr*>(&sharedAddr.sin_ipv4), sizeof(sharedAddr.sin_ipv4)));
+    ASSERT_TRUE(waitFor(eventLoop, 1, std::chrono::milliseconds(200)).empty());
+
+    const auto stats = sharedSocket->getStats();
+    ASSERT_EQ(4u, stats.routed_by_address);
+    ASSERT_EQ(1u, stats.routed_by_ufrag);
+    ASSERT_EQ(2u, stats.dropped_unknown);
+    ASSERT_EQ(2u, stats.endpoint_count);
+
+    for (size_t i = 0; i < 2; i += 1) {
+        eventLoop->unregisterSocket(endpointList[i]);
+    }
+}
+
+// ICE-lite endpoints have no remote address, they're found by ufrag and then send to what they're told
+
+TEST(SharedSocket, Inbound)
+{
+    const auto eventLoop = srtc::EventLoop::factory();
+    eventLoop->setSharedPort(0, false);
+
+    const auto sharedSocket = eventLoop->getSharedSocket();
+    const auto sharedAddr = makeLoopback(sharedSocket->getPort(AF_INET));
+
+    // Many sessions, without the addresses colliding
+    constexpr size_t kSessionCount = 2;
+    std::shared_ptr<srtc::Socket> endpointList[kSessionCount];
+    int udataList[kSessionCount];
+
+    for (size_t i = 0; i < kSessionCount; i += 1) {
+        endpointList[i] = sharedSocket->createInboundEndpoint(AF_INET, "lite" + std::to_string(i));
+        ASSERT_TRUE(endpointList[i]);
+        ASSERT_TRUE(endpointList[i]->isEndpoint());
+        eventLoop->registerSocket(endpointList[i], &udataList[i]);
+    }
+    ASSERT_EQ(kSessionCount, sharedSocket->getStats().endpoint_count);
+
+    const auto peer = srtc::Socket::createBound(AF_INET, 0, false);
+    const auto request = makeStunRequest("lite1:remote");
+    ASSERT_EQ(static_cast<ssize_t>(request.size()),
+              sendto(peer->handle(), request.data(), request.size(), 0,
+                     reinterpret_cast<const sockaddr*>(&sharedAddr.sin_ipv4), sizeof(sharedAddr.sin_ipv4)));
+
+    const auto ready = waitFor(eventLoop, 1);
+    ASSERT_EQ(1u, ready.size());
+    ASSERT_EQ(&udataList[1], ready[0]);
+    ASSERT_EQ(request.size(), receiveString(endpointList[1]).size());
+
+    // Responds to where the check came from
+    const auto peerAddr = makeLoopback(peer->getLocalPort());
+    ASSERT_TRUE(sharedSocket->addEndpointAddress(endpointList[1], peerAddr));
+    endpointList[1]->setAddr(peerAddr);
+    ASSERT_EQ(2, endpointList[1]->send("r1", 2));
+
+    std::string received;
+    const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (received.empty() && std::chrono::steady_clock::now() < end) {
+        received = receiveString(peer);
+    }
+    ASSERT_EQ("r1", received);
+
+    // Addresses are limited, the oldest one goes, but not the one the endpoint sends to
+    for (uint16_t port = 1; port <= 8; port += 1) {
+        ASSERT_TRUE(sharedSocket->addEndpointAddress(endpointList[1], makeLoopback(port)));
+    }
+    ASSERT_EQ(1u, sharedSocket->getStats().addr_evicted);
+    ASSERT_FALSE(sharedSocket->addEndpointAddress(endpointList[0], peerAddr));
+    ASSERT_TRUE(sharedSocket->addEndpointAddress(endpointList[0], makeLoopback(1)));
+
+    for (size_t i = 0; i < kSessionCount; i += 1) {
+        eventLoop->unregisterSocket(endpointList[i]);
+    }
+    ASSERT_EQ(0u, sharedSocket->getStats().endpoint_count);
+}
@@ -0,0 +1,465 @@
+#include "srtc/socket.h"
+
+#include <gtest/gtest.h>
+
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+
+srtc::anyaddr makeLoopback(uint16_t port)
+{
+    srtc::anyaddr addr = {};
+    addr.sin_ipv4.sin_family = AF_INET;
+    addr.sin_ipv4.sin_port = htons(port);
+    addr.sin_ipv4.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return addr;
+}
+
+bool waitReadable(const std::shared_ptr<srtc::Socket>& socket,
+                  const std::chrono::milliseconds& timeout = std::chrono::milliseconds(2000))
+{
+    struct pollfd fd = {};
+    fd.fd = socket->handle();
+    fd.events = POLLIN;
+    return poll(&fd, 1, static_cast<int>(timeout.count())) == 1;
+}
+
+// A plain UDP socket on a loopback port, to send from an address the test knows
+int createPlainSocket(uint16_t& port)
+{
+    const auto fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    auto addr = makeLoopback(0);
+    socklen_t addrLen = sizeof(addr.sin_ipv4);
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&addr.sin_ipv4), addrLen) != 0 ||
+        getsockname(fd, reinterpret_cast<sockaddr*>(&addr.sin_ipv4), &addrLen) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    port = ntohs(addr.sin_ipv4.sin_port);
+    return fd;
+}
+
+bool sendPlain(int fd, uint16_t port, const std::vector<uint8_t>& data)
+{
+    const auto addr = makeLoopback(port);
+    const auto r = sendto(fd,
+                          data.data(),
+                          data.size(),
+                          0,
+                          reinterpret_cast<const sockaddr*>(&addr.sin_ipv4),
+                          sizeof(addr.sin_ipv4));
+    return r == static_cast<ssize_t>(data.size());
+}
+
+// The index goes into every byte, so that both order and boundaries can be checked
+std::vector<uint8_t> makePacket(size_t index, size_t size)
+{
+    return std::vector<uint8_t>(size, static_cast<uint8_t>(index));
+}
+
+bool isPacket(const srtc::Socket::ReceivedData* data, size_t index, size_t size)
+{
+    return data->buf.size() == size &&
+           std::all_of(data->buf.data(), data->buf.data() + size, [index](uint8_t b) {
+               return b == static_cast<uint8_t>(index);
+           });
+}
+
+// Receives the datagrams from first on, the list has the sizes by index. Returns the index after the last
+// one which was received and matched.
+size_t receiveInOrder(const std::shared_ptr<srtc::Socket>& socket, size_t first, const std::vector<size_t>& sizeList)
+{
+    auto index = first;
+    while (index < sizeList.size() && waitReadable(socket, std::chrono::milliseconds(500))) {
+        std::vector<srtc::Socket::ReceivedData*> list;
+        socket->receive(list);
+
+        for (const auto data : list) {
+            if (index >= sizeList.size() || !isPacket(data, index, sizeList[index])) {
+                socket->release(list.size());
+                return index;
+            }
+            index += 1;
+        }
+        socket->release(list.size());
+    }
+
+    return index;
+}
+
+} // namespace
+
+// The ring wraps around many times, while some slots stay reported and unreleased: they keep their data,
+// receive() only reports new datagrams and only into free slots, and release() frees the oldest first
+
+TEST(Socket, RingWrapAndRelease)
+{
+    const auto receiver = srtc::Socket::createBound(AF_INET, 0, false);
+    ASSERT_TRUE(receiver);
+
+    uint16_t senderPort = 0;
+    const auto sender = createPlainSocket(senderPort);
+    ASSERT_GE(sender, 0);
+
+    constexpr size_t kSlotCount = 32;
+    constexpr size_t kRoundCount = 12;
+    constexpr size_t kPerRound = 20;
+
+    const auto sizeOf = [](size_t index) { return 40 + index % 13; };
+
+    size_t sentCount = 0;
+    size_t receivedCount = 0;
+    std::vector<std::pair<srtc::Socket::ReceivedData*, size_t>> held;
+
+    for (size_t round = 0; round < kRoundCount; round += 1) {
+        for (size_t i = 0; i < kPerRound; i += 1) {
+            ASSERT_TRUE(sendPlain(sender, receiver->getLocalPort(), makePacket(sentCount, sizeOf(sentCount))));
+            sentCount += 1;
+        }
+        ASSERT_TRUE(waitReadable(receiver));
+
+        std::vector<srtc::Socket::ReceivedData*> list;
+        receiver->receive(list);
+        ASSERT_EQ(std::min(sentCount - receivedCount, kSlotCount - held.size()), list.size());
+
+        for (const auto data : list) {
+            ASSERT_TRUE(isPacket(data, receivedCount, sizeOf(receivedCount)));
+            held.emplace_back(data, receivedCount);
+            receivedCount += 1;
+        }
+
+        // Reported earlier and not released, so not overwritten
+        for (const auto& item : held) {
+            ASSERT_TRUE(isPacket(item.first, item.second, sizeOf(item.second)));
+        }
+
+        const auto releaseCount = round % 2 == 0 ? std::min<size_t>(12, held.size()) : held.size();
+        receiver->release(releaseCount);
+        held.erase(held.begin(), held.begin() + static_cast<std::ptrdiff_t>(releaseCount));
+    }
+
+    while (receivedCount < sentCount) {
+        std::vector<srtc::Socket::ReceivedData*> list;
+        receiver->receive(list);
+        ASSERT_FALSE(list.empty());
+
+        for (const auto data : list) {
+            ASSERT_TRUE(isPacket(data, receivedCount, sizeOf(receivedCount)));
+            receivedCount += 1;
+        }
+        receiver->release(held.size() + list.size());
+        held.clear();
+    }
+
+    close(sender);
+}
+
+// A socket created for a remote address only accepts datagrams from there, and the ones from elsewhere
+// don't leave gaps in the ring, also when they are more than the free slots in one batch
+
+TEST(Socket, AcceptFilter)
+{
+    uint16_t allowedPort = 0;
+    const auto allowed = createPlainSocket(allowedPort);
+    ASSERT_GE(allowed, 0);
+
+    uint16_t otherPort = 0;
+    const auto other = createPlainSocket(otherPort);
+    ASSERT_GE(other, 0);
+
+    // Sending binds it to a local port
+    const auto receiver = std::make_shared<srtc::Socket>(makeLoopback(allowedPort));
+    ASSERT_EQ(1, receiver->send(makePacket(0, 1).data(), 1));
+    const auto receiverPort = receiver->getLocalPort();
+    ASSERT_NE(0, receiverPort);
+
+    constexpr size_t kSlotCount = 32;
+
+    size_t allowedCount = 0;
+    for (size_t i = 0; i < kSlotCount * 2; i += 1) {
+        if (i % 3 == 1) {
+            ASSERT_TRUE(sendPlain(allowed, receiverPort, makePacket(allowedCount, 100)));
+            allowedCount += 1;
+        } else {
+            ASSERT_TRUE(sendPlain(other, receiverPort, makePacket(0xFF, 100)));
+        }
+    }
+    for (size_t i = allowedCount; i < kSlotCount + 4; i += 1) {
+        ASSERT_TRUE(sendPlain(allowed, receiverPort, makePacket(allowedCount, 100)));
+        allowedCount += 1;
+    }
+    ASSERT_TRUE(waitReadable(receiver));
+
+    size_t receivedCount = 0;
+    while (receivedCount < allowedCount) {
+        std::vector<srtc::Socket::ReceivedData*> list;
+        receiver->receive(list);
+        ASSERT_FALSE(list.empty());
+        ASSERT_LE(list.size(), kSlotCount);
+
+        for (const auto data : list) {
+            ASSERT_EQ(htons(allowedPort), data->addr.sin_ipv4.sin_port);
+            ASSERT_TRUE(isPacket(data, receivedCount, 100));
+            receivedCount += 1;
+        }
+        receiver->release(list.size());
+    }
+
+    std::vector<srtc::Socket::ReceivedData*> list;
+    receiver->receive(list);
+    ASSERT_TRUE(list.empty());
+
+    close(allowed);
+    close(other);
+}
+
+// More packets are queued than fit into one batch, the full batch goes out when the next one is queued,
+// and the rest with flush(), in order
+
+TEST(Socket, SendMoreThanBatch)
+{
+    const auto receiver = srtc::Socket::createBound(AF_INET, 0, false);
+    ASSERT_TRUE(receiver);
+    const auto sender = std::make_shared<srtc::Socket>(makeLoopback(receiver->getLocalPort()));
+
+    constexpr size_t kPacketCount = 100;
+
+    std::vector<size_t> sizeList;
+    for (size_t i = 0; i < kPacketCount; i += 1) {
+        sizeList.push_back(60 + i % 50);
+        sender->queue(makePacket(i, sizeList.back()).data(), sizeList.back());
+    }
+    sender->flush();
+
+    ASSERT_EQ(kPacketCount, receiveInOrder(receiver, 0, sizeList));
+
+    // A batch of 64 with one system call, and then the other 36 with one more
+    ASSERT_FLOAT_EQ(kPacketCount / 2.0f, sender->getPacketsPerSendCall());
+}
+
+// Reserving room which the queue doesn't have flushes what was queued before, and then the packets are
+// written in place and committed one by one
+
+TEST(Socket, ReserveAcrossFlush)
+{
+    const auto receiver = srtc::Socket::createBound(AF_INET, 0, false);
+    ASSERT_TRUE(receiver);
+    const auto sender = std::make_shared<srtc::Socket>(makeLoopback(receiver->getLocalPort()));
+
+    ASSERT_EQ(nullptr, sender->reserveQueued(64 * 1024 + 1));
+    ASSERT_EQ(nullptr, sender->reserveQueued(100, 65));
+
+    std::vector<size_t> sizeList;
+
+    // The packet count is over the limit
+    for (size_t i = 0; i < 60; i += 1) {
+        sizeList.push_back(100);
+        sender->queue(makePacket(i, 100).data(), 100);
+    }
+
+    auto ptr = sender->reserveQueued(8 * 100, 8);
+    ASSERT_NE(nullptr, ptr);
+    ASSERT_EQ(60u, receiveInOrder(receiver, 0, sizeList));
+
+    for (size_t i = 60; i < 68; i += 1) {
+        sizeList.push_back(100);
+        const auto packet = makePacket(i, 100);
+        std::memcpy(ptr, packet.data(), packet.size());
+        sender->commitQueued(packet.size());
+        ptr += packet.size();
+    }
+    sender->flush();
+    ASSERT_EQ(68u, receiveInOrder(receiver, 60, sizeList));
+
+    // The byte count is over the limit
+    for (size_t i = 68; i < 118; i += 1) {
+        sizeList.push_back(1300);
+        sender->queue(makePacket(i, 1300).data(), 1300);
+    }
+
+    ptr = sender->reserveQueued(1300);
+    ASSERT_NE(nullptr, ptr);
+    ASSERT_EQ(118u, receiveInOrder(receiver, 68, sizeList));
+
+    sizeList.push_back(1300);
+    const auto packet = makePacket(118, 1300);
+    std::memcpy(ptr, packet.data(), packet.size());
+    sender->commitQueued(packet.size());
+    sender->flush();
+    ASSERT_EQ(119u, receiveInOrder(receiver, 118, sizeList));
+}
+
+#if defined(__linux__) && defined(UDP_SEGMENT)
+
+// With GSO, runs of equal size packets go out as one message each, a shorter packet ends a run as its last
+// segment, and a longer one starts a new message. The receiver gets them back as separate datagrams.
+
+TEST(Socket, GsoRuns)
+{
+    const auto receiver = srtc::Socket::createBound(AF_INET, 0, false);
+    ASSERT_TRUE(receiver);
+    const auto sender = std::make_shared<srtc::Socket>(makeLoopback(receiver->getLocalPort()));
+    if (!sender->setGsoEnabled(true)) {
+        GTEST_SKIP() << "GSO is not supported";
+    }
+
+    // Three runs: 10 x 100 and 60, 5 x 200 and 50, 2 x 50, then 300 on its own
+    std::vector<size_t> sizeList;
+    sizeList.insert(sizeList.end(), 10, 100);
+    sizeList.push_back(60);
+    sizeList.insert(sizeList.end(), 5, 200);
+    sizeList.push_back(50);
+    sizeList.insert(sizeList.end(), 2, 50);
+    sizeList.push_back(300);
+
+    for (size_t i = 0; i < sizeList.size(); i += 1) {
+        sender->queue(makePacket(i, sizeList[i]).data(), sizeList[i]);
+    }
+    sender->flush();
+
+    ASSERT_EQ(sizeList.size(), receiveInOrder(receiver, 0, sizeList));
+
+    if (sender->getSegmentsPerGsoSend() == 0.0f) {
+        GTEST_SKIP() << "GSO was turned off";
+    }
+    ASSERT_FLOAT_EQ((11 + 6 + 2) / 3.0f, sender->getSegmentsPerGsoSend());
+    ASSERT_FLOAT_EQ(static_cast<float>(sizeList.size()), sender->getPacketsPerSendCall());
+}
+
+#endif
+
+#if defined(__linux__) && defined(UDP_SEGMENT) && defined(UDP_GRO)
+
+// A coalesced run of more datagrams than the ring has slots: the rest is kept for after the slots are
+// released, without the kernel socket being readable for them
+
+TEST(Socket, GroBurst)
+{
+    const auto receiver = srtc::Socket::createBound(AF_INET, 0, false);
+    ASSERT_TRUE(receiver);
+    if (!receiver->setGroEnabled(true, 0)) {
+        GTEST_SKIP() << "GRO is not supported";
+    }
+
+    constexpr size_t kSegmentCount = 40;
+    constexpr size_t kSegmentSize = 100;
+    constexpr size_t kLastSize = 60;
+
+    std::vector<uint8_t> burst((kSegmentCount - 1) * kSegmentSize + kLastSize);
+    for (size_t i = 0; i < burst.size(); i += 1) {
+        burst[i] = static_cast<uint8_t>(i / kSegmentSize);
+    }
+
+    // One GSO send, which loopback delivers as one coalesced buffer
+    const auto sender = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sender, 0);
+
+    auto receiverAddr = makeLoopback(receiver->getLocalPort());
+
+    struct iovec iov = {};
+    iov.iov_base = burst.data();
+    iov.iov_len = burst.size();
+
+    uint8_t control[CMSG_SPACE(sizeof(uint16_t))] = {};
+    struct msghdr hdr = {};
+    hdr.msg_name = &receiverAddr.sin_ipv4;
+    hdr.msg_namelen = sizeof(receiverAddr.sin_ipv4);
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = control;
+    hdr.msg_controllen = sizeof(control);
+
+    const auto cmsg = CMSG_FIRSTHDR(&hdr);
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    const uint16_t segmentSize = kSegmentSize;
+    std::memcpy(CMSG_DATA(cmsg), &segmentSize, sizeof(segmentSize));
+
+    const auto sent = sendmsg(sender, &hdr, 0);
+    close(sender);
+    if (sent < 0) {
+        GTEST_SKIP() << "GSO is not supported";
+    }
+    ASSERT_EQ(static_cast<ssize_t>(burst.size()), sent);
+
+    ASSERT_TRUE(waitReadable(receiver));
+
+    size_t receivedCount = 0;
+    const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (receivedCount < kSegmentCount && std::chrono::steady_clock::now() < end) {
+        std::vector<srtc::Socket::ReceivedData*> list;
+        receiver->receive(list);
+        ASSERT_LE(list.size(), 32u);
+
+        for (const auto data : list) {
+            const auto expectedSize = receivedCount == kSegmentCount - 1 ? kLastSize : kSegmentSize;
+            ASSERT_EQ(expectedSize, data->buf.size());
+            ASSERT_EQ(receivedCount, data->buf.data()[0]);
+            ASSERT_EQ(receivedCount, data->buf.data()[data->buf.size() - 1]);
+            receivedCount += 1;
+        }
+        receiver->release(list.size());
+
+        // Either still in the socket's buffer, or in the kernel and readable
+        if (receivedCount < kSegmentCount && !receiver->hasPendingReceive()) {
+            ASSERT_TRUE(waitReadable(receiver));
+        }
+    }
+
+    ASSERT_EQ(kSegmentCount, receivedCount);
+    ASSERT_FALSE(receiver->hasPendingReceive());
+}
+
+#endif
+
+// Datagrams larger than a receive slot are dropped, not truncated, and don't hold up the ones after them
+
+TEST(Socket, DropOversized)
+{
+    const auto receiver = srtc::Socket::createBound(AF_INET, 0, false);
+    ASSERT_TRUE(receiver);
+
+    uint16_t senderPort = 0;
+    const auto sender = createPlainSocket(senderPort);
+    ASSERT_GE(sender, 0);
+
+    // Larger than an MTU is fine, the last one is too large
+    const std::vector<size_t> sizeList = { 100, 3000, 16 * 1024, 20000, 100 };
+    for (size_t i = 0; i < sizeList.size(); i += 1) {
+        ASSERT_TRUE(sendPlain(sender, receiver->getLocalPort(), makePacket(i, sizeList[i])));
+    }
+
+    std::vector<size_t> indexList;
+    while (indexList.size() < 4 && waitReadable(receiver, std::chrono::milliseconds(500))) {
+        std::vector<srtc::Socket::ReceivedData*> list;
+        receiver->receive(list);
+        for (const auto data : list) {
+            const auto index = data->buf.front();
+            ASSERT_LT(index, sizeList.size());
+            ASSERT_TRUE(isPacket(data, index, sizeList[index]));
+            indexList.push_back(index);
+        }
+        receiver->release(list.size());
+    }
+
+    ASSERT_EQ(std::vector<size_t>({ 0, 1, 2, 4 }), indexList);
+
+    close(sender);
+}
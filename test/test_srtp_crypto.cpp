@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include "srtc/buffer_slice.h"
 #include "srtc/byte_buffer.h"
 #include "srtc/media.h"
 #include "srtc/rtcp_packet.h"
@@ -1011,3 +1012,102 @@ TEST(SrtpCrypto, RtcpReceiveMulti)
         srtp_dealloc(srtp);
     }
 }
+
+// Batches of media packets
+
+TEST(SrtpCrypto, MediaBatch)
+{
+    std::cout << "SrtpCrypto MediaBatch" << std::endl;
+
+    srtc::initOpenSSL();
+
+    static constexpr uint16_t kOpenSslProfileList[] = {
+        SRTP_AEAD_AES_256_GCM, SRTP_AEAD_AES_128_GCM, SRTP_AES128_CM_SHA1_80, SRTP_AES128_CM_SHA1_32
+    };
+
+    static constexpr size_t kBatchSize = 12;
+    static constexpr size_t kHeaderSize = 12;
+
+    for (const auto openSSlProfile : kOpenSslProfileList) {
+        const auto isGCM = openSSlProfile == SRTP_AEAD_AES_256_GCM || openSSlProfile == SRTP_AEAD_AES_128_GCM;
+        const size_t keySize = openSSlProfile == SRTP_AEAD_AES_256_GCM ? 32 : 16;
+        const size_t saltSize = isGCM ? 12 : 14;
+
+        uint8_t bufKey[32], bufSalt[32];
+        RAND_bytes(bufKey, sizeof(bufKey));
+        RAND_bytes(bufSalt, sizeof(bufSalt));
+
+        srtc::CryptoBytes masterKey, masterSalt;
+        masterKey.assign(bufKey, keySize);
+        masterSalt.assign(bufSalt, saltSize);
+
+        // Sending and receiving with the same keys
+        const auto [crypto, error] =
+            srtc::SrtpCrypto::create(openSSlProfile, masterKey, masterSalt, masterKey, masterSalt);
+        ASSERT_TRUE(crypto);
+
+        const auto overhead = crypto->getMediaProtectionOverhead();
+        const auto ssrc = randomU32();
+
+        // Packets of different sizes, the headers separate from the payloads
+        srtc::ByteBuffer headerList[kBatchSize];
+        srtc::ByteBuffer payloadList[kBatchSize];
+        srtc::ByteGather bodyList[kBatchSize];
+        srtc::ByteBuffer singleList[kBatchSize];
+        srtc::SrtpProtectItem protectList[kBatchSize];
+
+        srtc::ByteBuffer output(kBatchSize * (kHeaderSize + 1200 + overhead));
+        size_t offset = 0;
+
+        for (size_t i = 0; i < kBatchSize; i += 1) {
+            srtc::ByteWriter headerWriter(headerList[i]);
+            headerWriter.writeU8(0x80);
+            headerWriter.writeU8(96);
+            headerWriter.writeU16(static_cast<uint16_t>(1000 + i));
+            headerWriter.writeU32(randomU32());
+            headerWriter.writeU32(ssrc);
+
+            const auto payloadSize = 1 + randomU32() % 1200;
+            payloadList[i].resize(0);
+            payloadList[i].reserve(payloadSize);
+            payloadList[i].resize(payloadSize);
+            RAND_bytes(payloadList[i].data(), static_cast<int>(payloadSize));
+            bodyList[i].add(payloadList[i].data(), payloadSize);
+
+            // One by one, for comparing
+            ASSERT_TRUE(crypto->protectSendMedia(headerList[i], bodyList[i], 0, singleList[i]));
+
+            protectList[i] = { &headerList[i], &bodyList[i], 0, output.data() + offset, 0 };
+            offset += kHeaderSize + payloadSize + overhead;
+        }
+
+        // The batch is the same as one by one
+        ASSERT_EQ(kBatchSize, crypto->protectSendMedia(protectList, kBatchSize));
+        for (size_t i = 0; i < kBatchSize; i += 1) {
+            ASSERT_EQ(singleList[i].size(), protectList[i].encryptedSize);
+            ASSERT_EQ(std::memcmp(singleList[i].data(), protectList[i].encrypted, singleList[i].size()), 0);
+        }
+
+        // Unprotect in place, with one packet tampered with
+        protectList[3].encrypted[kHeaderSize] ^= 0x01;
+
+        srtc::SrtpUnprotectItem unprotectList[kBatchSize];
+        for (size_t i = 0; i < kBatchSize; i += 1) {
+            const auto& item = protectList[i];
+            unprotectList[i] = { item.encrypted, item.encryptedSize, 0, item.encrypted, 0 };
+        }
+
+        ASSERT_EQ(kBatchSize - 1, crypto->unprotectReceiveMedia(unprotectList, kBatchSize));
+        for (size_t i = 0; i < kBatchSize; i += 1) {
+            if (i == 3) {
+                ASSERT_EQ(0u, unprotectList[i].plainSize);
+                continue;
+            }
+
+            ASSERT_EQ(kHeaderSize + payloadList[i].size(), unprotectList[i].plainSize);
+            ASSERT_EQ(std::memcmp(headerList[i].data(), unprotectList[i].plain, kHeaderSize), 0);
+            ASSERT_EQ(
+                std::memcmp(payloadList[i].data(), unprotectList[i].plain + kHeaderSize, payloadList[i].size()), 0);
+        }
+    }
+}
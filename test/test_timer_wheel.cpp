@@ -0,0 +1,164 @@
+#include "srtc/scheduler.h"
+#include "srtc/timer_wheel.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct TestTimer : public srtc::TimerNode {
+    uint64_t expires = 0;
+};
+
+std::vector<TestTimer*> advance(srtc::TimerWheel& wheel, uint64_t now)
+{
+    srtc::TimerList expired;
+    wheel.advance(now, expired);
+
+    std::vector<TestTimer*> list;
+    while (const auto node = expired.popFront()) {
+        list.push_back(static_cast<TestTimer*>(node));
+    }
+    return list;
+}
+
+} // namespace
+
+TEST(TimerWheel, Simple)
+{
+    srtc::TimerWheel wheel(0);
+    ASSERT_TRUE(wheel.isEmpty());
+    ASSERT_EQ(std::numeric_limits<uint64_t>::max(), wheel.getNextExpiration());
+
+    TestTimer t1, t2, t3;
+    wheel.insert(&t1, 10);
+    wheel.insert(&t2, 5);
+    wheel.insert(&t3, 5000);
+    ASSERT_EQ(3u, wheel.size());
+    ASSERT_EQ(5u, wheel.getNextExpiration());
+
+    ASSERT_TRUE(advance(wheel, 4).empty());
+
+    auto list = advance(wheel, 10);
+    ASSERT_EQ(2u, list.size());
+    ASSERT_EQ(&t2, list[0]);
+    ASSERT_EQ(&t1, list[1]);
+
+    // On a higher level, so this is when it gets moved down rather than when it expires
+    ASSERT_LE(wheel.getNextExpiration(), 5000u);
+    ASSERT_GT(wheel.getNextExpiration(), 10u);
+
+    ASSERT_TRUE(advance(wheel, 4999).empty());
+    ASSERT_EQ(5000u, wheel.getNextExpiration());
+
+    list = advance(wheel, 5000);
+    ASSERT_EQ(1u, list.size());
+    ASSERT_EQ(&t3, list[0]);
+    ASSERT_TRUE(wheel.isEmpty());
+}
+
+TEST(TimerWheel, Unlink)
+{
+    srtc::TimerWheel wheel(100);
+
+    TestTimer t1, t2;
+    wheel.insert(&t1, 200);
+    wheel.insert(&t2, 200);
+    ASSERT_TRUE(t1.isLinked());
+
+    t1.unlink();
+    ASSERT_FALSE(t1.isLinked());
+    ASSERT_EQ(1u, wheel.size());
+
+    // In the past, expires right away
+    wheel.insert(&t1, 50);
+
+    auto list = advance(wheel, 100);
+    ASSERT_EQ(1u, list.size());
+    ASSERT_EQ(&t1, list[0]);
+
+    t2.unlink();
+    ASSERT_TRUE(wheel.isEmpty());
+    ASSERT_TRUE(advance(wheel, 1000).empty());
+}
+
+TEST(TimerWheel, Random)
+{
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<uint64_t> delay(0, 300000);
+
+    constexpr size_t kCount = 5000;
+    std::vector<TestTimer> timerList(kCount);
+
+    srtc::TimerWheel wheel(12345);
+    for (auto& timer : timerList) {
+        timer.expires = wheel.getCurrent() + delay(random);
+        wheel.insert(&timer, timer.expires);
+    }
+
+    size_t expiredCount = 0;
+    uint64_t now = wheel.getCurrent();
+    uint64_t last = 0;
+
+    while (!wheel.isEmpty()) {
+        const auto next = wheel.getNextExpiration();
+        ASSERT_GE(next, now);
+
+        // Never expire early, never late
+        now = next;
+        for (const auto timer : advance(wheel, now)) {
+            ASSERT_EQ(timer->expires, now);
+            ASSERT_GE(timer->expires, last);
+            last = timer->expires;
+            expiredCount += 1;
+        }
+    }
+
+    ASSERT_EQ(kCount, expiredCount);
+}
+
+TEST(LoopScheduler, Periodic)
+{
+    const auto scheduler = std::make_shared<srtc::LoopScheduler>();
+
+    int onceCount = 0;
+    int periodicCount = 0;
+
+    auto once = scheduler->submit(std::chrono::milliseconds(5), __FILE__, __LINE__, [&onceCount] { onceCount += 1; });
+    auto periodic = scheduler->submitPeriodic(
+        std::chrono::milliseconds(5), __FILE__, __LINE__, [&periodicCount] { periodicCount += 1; });
+
+    // Updating keeps the same task
+    const auto updated = once.lock()->update(std::chrono::milliseconds(10));
+    ASSERT_EQ(once.lock(), updated.lock());
+
+    const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(60);
+    while (std::chrono::steady_clock::now() < end) {
+        srtc::Deadline deadline(std::chrono::steady_clock::now(), std::chrono::milliseconds(100));
+        scheduler->updateDeadline(deadline);
+
+        const auto timeout = deadline.getTimeout();
+        ASSERT_LE(timeout, std::chrono::milliseconds(10));
+        std::this_thread::sleep_for(timeout);
+        scheduler->run();
+    }
+
+    ASSERT_EQ(1, onceCount);
+    ASSERT_TRUE(once.expired());
+
+    ASSERT_GE(periodicCount, 5);
+    ASSERT_FALSE(periodic.expired());
+
+    srtc::Task::cancelHelper(periodic);
+
+    const auto now = std::chrono::steady_clock::now();
+    srtc::Deadline deadline(now, std::chrono::milliseconds(100));
+    scheduler->updateDeadline(deadline);
+    ASSERT_EQ(now + std::chrono::milliseconds(100), deadline.getWhen());
+}
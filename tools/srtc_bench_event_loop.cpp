@@ -0,0 +1,311 @@
+#include "srtc/event_loop.h"
+#include "srtc/logging.h"
+#include "srtc/socket.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Compares event loop backends: a peer thread sends datagrams to sockets registered with the event loop,
+// the loop's thread echoes them back through the socket's send queue. We measure the echo rate and the CPU
+// time the loop's thread spends per packet.
+
+// Program options
+
+static size_t gSocketCount = 8;
+static size_t gPacketSize = 1200;
+static size_t gWindow = 64;
+static int gDurationSeconds = 5;
+static std::string gBackend = "both";
+
+namespace
+{
+
+constexpr int kSocketBufferSize = 4 * 1024 * 1024;
+constexpr auto kLostTimeout = std::chrono::milliseconds(50);
+
+struct Pair {
+    int peerHandle = -1;
+    srtc::anyaddr socketAddr = {};
+    std::shared_ptr<srtc::Socket> socket;
+
+    // Only used by the peer thread
+    size_t outstanding = 0;
+    std::chrono::steady_clock::time_point lastProgress;
+};
+
+struct Result {
+    uint64_t packetCount = 0;
+    uint64_t waitCount = 0;
+    double seconds = 0.0;
+    double cpuSeconds = 0.0;
+};
+
+double getThreadCpuSeconds()
+{
+    struct timespec ts = {};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+bool createPair(Pair& pair)
+{
+    pair.peerHandle = socket(AF_INET, SOCK_DGRAM, 0);
+    if (pair.peerHandle < 0) {
+        return false;
+    }
+
+    setsockopt(pair.peerHandle, SOL_SOCKET, SO_RCVBUF, &kSocketBufferSize, sizeof(kSocketBufferSize));
+    setsockopt(pair.peerHandle, SOL_SOCKET, SO_SNDBUF, &kSocketBufferSize, sizeof(kSocketBufferSize));
+
+    srtc::anyaddr peerAddr = {};
+    peerAddr.sin_ipv4.sin_family = AF_INET;
+    peerAddr.sin_ipv4.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t peerAddrLen = sizeof(peerAddr.sin_ipv4);
+    if (bind(pair.peerHandle, reinterpret_cast<struct sockaddr*>(&peerAddr.sin_ipv4), peerAddrLen) != 0 ||
+        getsockname(pair.peerHandle, reinterpret_cast<struct sockaddr*>(&peerAddr.sin_ipv4), &peerAddrLen) != 0) {
+        return false;
+    }
+
+    pair.socket = std::make_shared<srtc::Socket>(peerAddr);
+    setsockopt(pair.socket->handle(), SOL_SOCKET, SO_RCVBUF, &kSocketBufferSize, sizeof(kSocketBufferSize));
+    setsockopt(pair.socket->handle(), SOL_SOCKET, SO_SNDBUF, &kSocketBufferSize, sizeof(kSocketBufferSize));
+
+    // Sending binds the socket to an ephemeral port, which is where the peer will send to
+    const uint8_t probe = 0;
+    if (pair.socket->send(&probe, sizeof(probe)) != sizeof(probe)) {
+        return false;
+    }
+
+    socklen_t socketAddrLen = sizeof(pair.socketAddr.sin_ipv4);
+    if (getsockname(pair.socket->handle(), reinterpret_cast<struct sockaddr*>(&pair.socketAddr.sin_ipv4), &socketAddrLen) !=
+        0) {
+        return false;
+    }
+
+    uint8_t buf[16];
+    (void)recv(pair.peerHandle, buf, sizeof(buf), 0);
+
+    return true;
+}
+
+void peerThreadFunc(std::vector<Pair>* pairList, const std::atomic_bool* isStop)
+{
+    const std::vector<uint8_t> payload(gPacketSize, 0x5a);
+    std::vector<uint8_t> buf(gPacketSize + 64);
+
+    std::vector<struct pollfd> pollList(pairList->size());
+    for (size_t i = 0; i < pairList->size(); i += 1) {
+        pollList[i].fd = (*pairList)[i].peerHandle;
+        pollList[i].events = POLLIN;
+    }
+
+    while (!isStop->load()) {
+        const auto now = std::chrono::steady_clock::now();
+
+        for (auto& pair : *pairList) {
+            // Datagrams can be dropped, don't wait for them forever
+            if (pair.outstanding > 0 && now - pair.lastProgress > kLostTimeout) {
+                pair.outstanding = 0;
+            }
+
+            while (pair.outstanding < gWindow) {
+                const auto r = sendto(pair.peerHandle,
+                                      payload.data(),
+                                      payload.size(),
+                                      MSG_DONTWAIT,
+                                      reinterpret_cast<const struct sockaddr*>(&pair.socketAddr.sin_ipv4),
+                                      sizeof(pair.socketAddr.sin_ipv4));
+                if (r < 0) {
+                    break;
+                }
+                if (pair.outstanding == 0) {
+                    pair.lastProgress = now;
+                }
+                pair.outstanding += 1;
+            }
+        }
+
+        if (poll(pollList.data(), pollList.size(), 1) <= 0) {
+            continue;
+        }
+
+        for (size_t i = 0; i < pairList->size(); i += 1) {
+            if ((pollList[i].revents & POLLIN) == 0) {
+                continue;
+            }
+
+            auto& pair = (*pairList)[i];
+            while (recv(pair.peerHandle, buf.data(), buf.size(), MSG_DONTWAIT) > 0) {
+                if (pair.outstanding > 0) {
+                    pair.outstanding -= 1;
+                }
+                pair.lastProgress = std::chrono::steady_clock::now();
+            }
+        }
+    }
+}
+
+bool runBenchmark(srtc::EventLoop::Backend backend, Result& result)
+{
+    srtc::EventLoop::setBackend(backend);
+    const auto eventLoop = srtc::EventLoop::factory();
+
+    std::vector<Pair> pairList(gSocketCount);
+    for (auto& pair : pairList) {
+        if (!createPair(pair)) {
+            std::cerr << "Cannot create a socket pair: " << strerror(errno) << std::endl;
+            return false;
+        }
+        eventLoop->registerSocket(pair.socket, &pair);
+    }
+
+    std::atomic_bool isStop = false;
+    std::thread peerThread(peerThreadFunc, &pairList, &isStop);
+
+    std::vector<void*> udataList;
+    std::vector<srtc::Socket::ReceivedData*> receiveList;
+
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto endTime = startTime + std::chrono::seconds(gDurationSeconds);
+    const auto startCpu = getThreadCpuSeconds();
+
+    while (std::chrono::steady_clock::now() < endTime) {
+        eventLoop->wait(udataList, std::chrono::milliseconds(10));
+        result.waitCount += 1;
+
+        for (const auto udata : udataList) {
+            const auto pair = static_cast<Pair*>(udata);
+
+            pair->socket->receive(receiveList);
+            for (const auto item : receiveList) {
+                pair->socket->queue(item->buf);
+            }
+            pair->socket->release(receiveList.size());
+            pair->socket->flush();
+
+            result.packetCount += receiveList.size();
+            receiveList.clear();
+        }
+    }
+
+    result.cpuSeconds = getThreadCpuSeconds() - startCpu;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    isStop = true;
+    peerThread.join();
+
+    for (auto& pair : pairList) {
+        eventLoop->unregisterSocket(pair.socket);
+        close(pair.peerHandle);
+    }
+
+    return true;
+}
+
+void printResult(const char* name, const Result& result)
+{
+    const auto packetsPerSecond = static_cast<double>(result.packetCount) / result.seconds;
+    const auto cpuMicrosPerPacket =
+        result.packetCount == 0 ? 0.0 : result.cpuSeconds * 1e6 / static_cast<double>(result.packetCount);
+    const auto packetsPerWait =
+        result.waitCount == 0 ? 0.0 : static_cast<double>(result.packetCount) / static_cast<double>(result.waitCount);
+
+    std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(0)
+              << std::setw(12) << packetsPerSecond << " pkts/s" << std::setprecision(2) << std::setw(10)
+              << cpuMicrosPerPacket << " us cpu/pkt" << std::setprecision(1) << std::setw(10) << packetsPerWait
+              << " pkts/wait" << std::endl;
+}
+
+void printUsage(const char* programName)
+{
+    std::cout << "Usage: " << programName << " [options]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -b, --backend <name>   epoll, uring or both (default: " << gBackend << ")" << std::endl;
+    std::cout << "  -n, --sockets <count>  Number of sockets (default: " << gSocketCount << ")" << std::endl;
+    std::cout << "  -s, --size <bytes>     Packet size (default: " << gPacketSize << ")" << std::endl;
+    std::cout << "  -w, --window <count>   Packets in flight per socket (default: " << gWindow << ")" << std::endl;
+    std::cout << "  -d, --duration <secs>  Duration of each run (default: " << gDurationSeconds << ")" << std::endl;
+    std::cout << "  -v, --verbose          Verbose logging from the srtc library" << std::endl;
+    std::cout << "  -h, --help             Show this help message" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    using namespace srtc;
+
+    // Set logging to errors by default
+    setLogLevel(SRTC_LOG_W);
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "-v" || arg == "--verbose") {
+            srtc::setLogLevel(SRTC_LOG_V);
+        } else if (i + 1 >= argc) {
+            std::cerr << "Error: " << arg << " requires a value" << std::endl;
+            return 1;
+        } else if (arg == "-b" || arg == "--backend") {
+            gBackend = argv[++i];
+        } else if (arg == "-n" || arg == "--sockets") {
+            gSocketCount = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "-s" || arg == "--size") {
+            gPacketSize = std::clamp(std::strtoul(argv[++i], nullptr, 10), 1ul, 2000ul);
+        } else if (arg == "-w" || arg == "--window") {
+            gWindow = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "-d" || arg == "--duration") {
+            gDurationSeconds = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (gBackend != "epoll" && gBackend != "uring" && gBackend != "both") {
+        std::cerr << "Unknown backend: " << gBackend << std::endl;
+        return 1;
+    }
+
+    std::cout << "*** " << gSocketCount << " sockets, " << gPacketSize << " byte packets, window " << gWindow << ", "
+              << gDurationSeconds << " seconds per run" << std::endl;
+
+    if (gBackend == "epoll" || gBackend == "both") {
+        Result result;
+        if (!runBenchmark(EventLoop::Backend::Default, result)) {
+            return 1;
+        }
+        printResult("epoll", result);
+    }
+
+    if (gBackend == "uring" || gBackend == "both") {
+        Result result;
+        if (!runBenchmark(EventLoop::Backend::IoUring, result)) {
+            return 1;
+        }
+        printResult("io_uring", result);
+    }
+
+    return 0;
+}
@@ -0,0 +1,332 @@
+#include "srtc/buffer_slice.h"
+#include "srtc/byte_buffer.h"
+#include "srtc/logging.h"
+#include "srtc/srtp_crypto.h"
+#include "srtc/srtp_util.h"
+
+#include <openssl/srtp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <WinSock2.h>
+#else
+#include <arpa/inet.h>
+#endif
+
+// Measures the per-packet cost of SRTP and SRTCP protection and unprotection, for each of the profiles we
+// support, one packet per call and in batches. It runs on one thread, so packets per second are per core.
+// Run it on two builds to compare them.
+
+// Program options
+
+static size_t gPacketSize = 1200;
+static size_t gPacketCount = 200000;
+static size_t gBatchSize = 16;
+static std::string gProfile = "all";
+
+namespace
+{
+
+// Protected packets which are unprotected over and over
+constexpr size_t kRingSize = 256;
+
+constexpr uint32_t kSSRC = 0x12345678u;
+constexpr size_t kHeaderSize = 12;
+
+struct Profile {
+    const char* name;
+    uint64_t id;
+    size_t keySize;
+    size_t saltSize;
+};
+
+const Profile kProfileList[] = {
+    { "gcm256", SRTP_AEAD_AES_256_GCM, 32, 12 },
+    { "gcm128", SRTP_AEAD_AES_128_GCM, 16, 12 },
+    { "cm80", SRTP_AES128_CM_SHA1_80, 16, 14 },
+    { "cm32", SRTP_AES128_CM_SHA1_32, 16, 14 },
+};
+
+struct Result {
+    double protectNanos = 0.0;
+    double unprotectNanos = 0.0;
+};
+
+srtc::CryptoBytes makeBytes(size_t size, uint8_t seed)
+{
+    srtc::CryptoBytes bytes;
+    uint8_t buf[32] = {};
+    for (size_t i = 0; i < size; i += 1) {
+        buf[i] = static_cast<uint8_t>(seed + i * 7);
+    }
+    bytes.assign(buf, size);
+    return bytes;
+}
+
+void makeRtpPacket(uint16_t sequence, srtc::ByteBuffer& packet)
+{
+    packet.reserve(gPacketSize);
+    packet.resize(gPacketSize);
+    const auto data = packet.data();
+    std::memset(data, 0x5a, gPacketSize);
+
+    data[0] = 0x80;
+    data[1] = 96;
+    *reinterpret_cast<uint16_t*>(data + 2) = htons(sequence);
+    *reinterpret_cast<uint32_t*>(data + 4) = htonl(sequence * 3000u);
+    *reinterpret_cast<uint32_t*>(data + 8) = htonl(kSSRC);
+}
+
+void makeRtcpPacket(srtc::ByteBuffer& packet)
+{
+    // A receiver report with padding, the size doesn't matter to us
+    packet.reserve(gPacketSize);
+    packet.resize(gPacketSize & ~size_t(3));
+    const auto data = packet.data();
+    std::memset(data, 0x5a, packet.size());
+
+    data[0] = 0x80;
+    data[1] = 201;
+    *reinterpret_cast<uint16_t*>(data + 2) = htons(static_cast<uint16_t>(packet.size() / 4 - 1));
+    *reinterpret_cast<uint32_t*>(data + 4) = htonl(kSSRC);
+}
+
+double nanosPerPacket(std::chrono::steady_clock::time_point start, size_t count)
+{
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) /
+           static_cast<double>(count);
+}
+
+bool runBatchBenchmark(const Profile& profile,
+                       const std::shared_ptr<srtc::SrtpCrypto>& sender,
+                       const std::shared_ptr<srtc::SrtpCrypto>& receiver,
+                       Result& batch)
+{
+    // As the send pacer does it: separate headers, the payload from the frame
+    srtc::ByteBuffer packet;
+    makeRtpPacket(0, packet);
+
+    std::vector<srtc::ByteBuffer> headerList(gBatchSize);
+    const auto bodyList = std::make_unique<srtc::ByteGather[]>(gBatchSize);
+    std::vector<srtc::SrtpProtectItem> protectList(gBatchSize);
+
+    const auto overhead = sender->getMediaProtectionOverhead();
+    const auto stride = gPacketSize + overhead;
+    srtc::ByteBuffer output(stride * gBatchSize);
+
+    for (size_t i = 0; i < gBatchSize; i += 1) {
+        headerList[i].assign(packet.data(), kHeaderSize);
+        bodyList[i].add(packet.data() + kHeaderSize, gPacketSize - kHeaderSize);
+        protectList[i] = { &headerList[i], &bodyList[i], 0, output.data() + stride * i, 0 };
+    }
+
+    const auto batchCount = (gPacketCount + gBatchSize - 1) / gBatchSize;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t n = 0; n < batchCount; n += 1) {
+        for (size_t i = 0; i < gBatchSize; i += 1) {
+            const auto sequence = static_cast<uint16_t>(n * gBatchSize + i);
+            *reinterpret_cast<uint16_t*>(headerList[i].data() + 2) = htons(sequence);
+        }
+        if (sender->protectSendMedia(protectList.data(), gBatchSize) != gBatchSize) {
+            std::cerr << "Error protecting RTP batch for " << profile.name << std::endl;
+            return false;
+        }
+    }
+    batch.protectNanos = nanosPerPacket(start, batchCount * gBatchSize);
+
+    // The last batch, over and over
+    srtc::ByteBuffer plain(stride * gBatchSize);
+    std::vector<srtc::SrtpUnprotectItem> unprotectList(gBatchSize);
+    for (size_t i = 0; i < gBatchSize; i += 1) {
+        const auto& item = protectList[i];
+        unprotectList[i] = { item.encrypted, item.encryptedSize, 0, plain.data() + stride * i, 0 };
+    }
+
+    start = std::chrono::steady_clock::now();
+    for (size_t n = 0; n < batchCount; n += 1) {
+        if (receiver->unprotectReceiveMedia(unprotectList.data(), gBatchSize) != gBatchSize) {
+            std::cerr << "Error unprotecting RTP batch for " << profile.name << std::endl;
+            return false;
+        }
+    }
+    batch.unprotectNanos = nanosPerPacket(start, batchCount * gBatchSize);
+
+    return true;
+}
+
+bool runBenchmark(const Profile& profile, Result& media, Result& batch, Result& control)
+{
+    const auto key1 = makeBytes(profile.keySize, 1);
+    const auto salt1 = makeBytes(profile.saltSize, 2);
+    const auto key2 = makeBytes(profile.keySize, 3);
+    const auto salt2 = makeBytes(profile.saltSize, 4);
+
+    // The receiver's keys are the other way around
+    const auto [sender, senderError] = srtc::SrtpCrypto::create(profile.id, key1, salt1, key2, salt2);
+    const auto [receiver, receiverError] = srtc::SrtpCrypto::create(profile.id, key2, salt2, key1, salt1);
+    if (!sender || !receiver) {
+        std::cerr << "Error creating crypto for " << profile.name << std::endl;
+        return false;
+    }
+
+    srtc::ByteBuffer packet;
+    srtc::ByteBuffer encrypted;
+    srtc::ByteBuffer plain;
+
+    // RTP
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < gPacketCount; i += 1) {
+        makeRtpPacket(static_cast<uint16_t>(i), packet);
+        if (!sender->protectSendMedia(packet, 0, encrypted)) {
+            std::cerr << "Error protecting RTP for " << profile.name << std::endl;
+            return false;
+        }
+    }
+    media.protectNanos = nanosPerPacket(start, gPacketCount);
+
+    std::vector<srtc::ByteBuffer> ring(kRingSize);
+    for (size_t i = 0; i < kRingSize; i += 1) {
+        makeRtpPacket(static_cast<uint16_t>(i), packet);
+        if (!sender->protectSendMedia(packet, 0, ring[i])) {
+            return false;
+        }
+    }
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < gPacketCount; i += 1) {
+        if (!receiver->unprotectReceiveMedia(ring[i % kRingSize], 0, plain)) {
+            std::cerr << "Error unprotecting RTP for " << profile.name << std::endl;
+            return false;
+        }
+    }
+    media.unprotectNanos = nanosPerPacket(start, gPacketCount);
+
+    // RTP in batches
+    if (!runBatchBenchmark(profile, sender, receiver, batch)) {
+        return false;
+    }
+
+    // RTCP
+    makeRtcpPacket(packet);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < gPacketCount; i += 1) {
+        if (!sender->protectSendControl(packet, static_cast<uint32_t>(i + 1), encrypted)) {
+            std::cerr << "Error protecting RTCP for " << profile.name << std::endl;
+            return false;
+        }
+    }
+    control.protectNanos = nanosPerPacket(start, gPacketCount);
+
+    for (size_t i = 0; i < kRingSize; i += 1) {
+        if (!sender->protectSendControl(packet, static_cast<uint32_t>(i + 1), ring[i])) {
+            return false;
+        }
+    }
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < gPacketCount; i += 1) {
+        if (!receiver->unprotectReceiveControl(ring[i % kRingSize], plain)) {
+            std::cerr << "Error unprotecting RTCP for " << profile.name << std::endl;
+            return false;
+        }
+    }
+    control.unprotectNanos = nanosPerPacket(start, gPacketCount);
+
+    return true;
+}
+
+void printResult(const std::string& name, const Result& result)
+{
+    std::cout << std::left << std::setw(18) << name << std::right << std::fixed << std::setprecision(0)
+              << std::setw(8) << result.protectNanos << " ns/pkt" << std::setw(10) << 1e9 / result.protectNanos
+              << " pkts/s protect" << std::setw(8) << result.unprotectNanos << " ns/pkt" << std::setw(10)
+              << 1e9 / result.unprotectNanos << " pkts/s unprotect" << std::endl;
+}
+
+void printUsage(const char* programName)
+{
+    std::cout << "Usage: " << programName << " [options]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -p, --profile <name>   gcm256, gcm128, cm80, cm32 or all (default: " << gProfile << ")"
+              << std::endl;
+    std::cout << "  -s, --size <bytes>     Packet size (default: " << gPacketSize << ")" << std::endl;
+    std::cout << "  -n, --count <count>    Packets per run (default: " << gPacketCount << ")" << std::endl;
+    std::cout << "  -b, --batch <count>    Packets per batch (default: " << gBatchSize << ")" << std::endl;
+    std::cout << "  -v, --verbose          Verbose logging from the srtc library" << std::endl;
+    std::cout << "  -h, --help             Show this help message" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    using namespace srtc;
+
+    // Set logging to errors by default
+    setLogLevel(SRTC_LOG_W);
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "-v" || arg == "--verbose") {
+            srtc::setLogLevel(SRTC_LOG_V);
+        } else if (i + 1 >= argc) {
+            std::cerr << "Error: " << arg << " requires a value" << std::endl;
+            return 1;
+        } else if (arg == "-p" || arg == "--profile") {
+            gProfile = argv[++i];
+        } else if (arg == "-s" || arg == "--size") {
+            gPacketSize = std::clamp(std::strtoul(argv[++i], nullptr, 10), 32ul, 2000ul);
+        } else if (arg == "-n" || arg == "--count") {
+            gPacketCount = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "-b" || arg == "--batch") {
+            gBatchSize = std::clamp(std::strtoul(argv[++i], nullptr, 10), 1ul, 256ul);
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::cout << "*** " << gPacketSize << " byte packets, " << gPacketCount << " packets per run, batches of "
+              << gBatchSize << std::endl;
+
+    bool found = false;
+    for (const auto& profile : kProfileList) {
+        if (gProfile != "all" && gProfile != profile.name) {
+            continue;
+        }
+        found = true;
+
+        Result media, batch, control;
+        if (!runBenchmark(profile, media, batch, control)) {
+            return 1;
+        }
+        printResult(std::string(profile.name) + " rtp", media);
+        printResult(std::string(profile.name) + " rtp batch", batch);
+        printResult(std::string(profile.name) + " rtcp", control);
+    }
+
+    if (!found) {
+        std::cerr << "Unknown profile: " << gProfile << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -1,3 +1,4 @@
+#include "srtc/buffer_pool.h"
 #include "srtc/codec_h264.h"
 #include "srtc/logging.h"
 #include "srtc/peer_connection.h"
@@ -54,6 +55,7 @@ static bool gEnableBWE = false;
 static bool gLoopVideo = false;
 static bool gDataChannels = false;
 static bool gAbsCaptureTime = false;
+static bool gEnableGSO = false;
 
 // State
 
@@ -184,6 +186,7 @@ void printUsage(const char* programName)
     std::cout << "  -b, --bwe              Enable TWCC congestion control for bandwidth estimation" << std::endl;
     std::cout << "  -c, --datachannels     Enable data channels" << std::endl;
     std::cout << "  -a, --abs-capture-time Enable abs-capture-time" << std::endl;
+    std::cout << "  -g, --gso              Enable UDP segmentation offload (Linux)" << std::endl;
     std::cout << "  -h, --help             Show this help message" << std::endl;
 }
 
@@ -238,6 +241,8 @@ int main(int argc, char* argv[])
             gDataChannels = true;
         } else if (arg == "-a" || arg == "--abs-capture-time") {
             gAbsCaptureTime = true;
+        } else if (arg == "-g" || arg == "--gso") {
+            gEnableGSO = true;
         } else {
             std::cerr << "Unknown option: " << arg << std::endl;
             printUsage(argv[0]);
@@ -278,13 +283,21 @@ int main(int argc, char* argv[])
     const auto peerConnection = std::make_shared<PeerConnection>(Direction::Publish);
 
     peerConnection->setConnectionStateListener(
-        [ms0, &connectedReported, &connectionStateMutex, &connectionState, &connectionStateCond](
-            const PeerConnection::ConnectionState& state) {
+        [ms0, pc = peerConnection.get(), &connectedReported, &connectionStateMutex, &connectionState,
+         &connectionStateCond](const PeerConnection::ConnectionState& state) {
             if (state == PeerConnection::ConnectionState::Connected && !connectedReported) {
                 const auto ms1 = std::chrono::steady_clock::now();
                 const auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(ms1 - ms0).count();
                 std::cout << "*** PeerConnection state: " << connectionStateToString(state) << " in " << millis
                           << " millis" << std::endl;
+                for (const auto& event : pc->getConnectTimeline()) {
+                    std::cout << "***     " << std::setw(8) << event.time.count() / 1000.0f << " ms "
+                              << to_string(event.type) << " " << event.host;
+                    if (event.type == ConnectTimelineEvent::Type::StunResponseReceived) {
+                        std::cout << ", rtt " << event.rtt_ms << " ms";
+                    }
+                    std::cout << std::endl;
+                }
                 connectedReported = true;
             } else {
                 std::cout << "*** PeerConnection state: " << connectionStateToString(state) << std::endl;
@@ -304,12 +317,20 @@ int main(int argc, char* argv[])
         });
 
     peerConnection->setPublishConnectionStatsListener([](const PublishConnectionStats& stats) {
+        // Called on the network thread
+        const auto poolStats = BufferPool::getStats();
         std::cout << "*** PeerConnection stats: sent " << stats.frame_count << " frames, " << stats.packet_count
                   << " packets, " << stats.byte_count << " bytes, act " << std::setprecision(6)
                   << stats.bandwidth_actual_kbit_per_second << " kb/s, sugg " << std::setprecision(6)
                   << stats.bandwidth_suggested_kbit_per_second << " kb/s, " << std::setprecision(3)
                   << stats.packets_lost_percent << "% packet loss, " << std::setprecision(3) << stats.rtt_ms
-                  << " ms rtt" << std::endl;
+                  << " ms rtt, " << std::setprecision(3) << stats.packets_per_send_call << " packets per send, "
+                  << std::setprecision(3) << stats.segments_per_gso_send << " segments per gso send, "
+                  << poolStats.miss_count << " of " << poolStats.hit_count + poolStats.miss_count
+                  << " buffer allocations not pooled, " << stats.nack_history_miss_count << " nacks missed and "
+                  << stats.nack_history_evicted_count << " evicted from " << stats.nack_history_capacity
+                  << " packets of history, " << stats.nack_history_protected_count << " re-sent protected"
+                  << std::endl;
     });
 
     // Data channel listener
@@ -322,6 +343,7 @@ int main(int argc, char* argv[])
     offer_config.cname = "foo";
     offer_config.enable_rtx = true;
     offer_config.enable_bwe = gEnableBWE;
+    offer_config.enable_gso = gEnableGSO;
     offer_config.enable_abs_capture_time = gAbsCaptureTime;
     if (gDataChannels) {
         offer_config.data_channel_config.data_channels.emplace_back("foo");
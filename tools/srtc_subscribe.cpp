@@ -1,3 +1,4 @@
+#include "srtc/buffer_pool.h"
 #include "srtc/codec_h264.h"
 #include "srtc/encoded_frame.h"
 #include "srtc/logging.h"
@@ -39,6 +40,7 @@ static bool gQuiet = false;
 static bool gPrintSDP = false;
 static bool gPrintSenderReports = false;
 static bool gAbsCaptureTime = false;
+static bool gEnableGRO = false;
 static std::string gOutputAudioFilename;
 static std::string gOutputVideoFilename;
 
@@ -72,6 +74,7 @@ void printUsage(const char* programName)
     std::cout << "  -r, --sr               Print sender report information" << std::endl;
     std::cout << "  -s, --sdp              Print SDP offer and answer" << std::endl;
     std::cout << "  -a, --abs-capture-time Enable abs-capture-time" << std::endl;
+    std::cout << "  -g, --gro              Enable UDP receive offload (Linux)" << std::endl;
     std::cout << "  --oa <filename>        Save audio to a file (ogg format for opus)" << std::endl;
     std::cout << "  --ov <filename>        Save video to a file (h264 or webm format)" << std::endl;
     std::cout << "  -h, --help             Show this help message" << std::endl;
@@ -208,6 +211,8 @@ int main(int argc, char* argv[])
             gPrintSDP = true;
         } else if (arg == "-a" || arg == "--abs-capture-time") {
             gAbsCaptureTime = true;
+        } else if (arg == "-g" || arg == "--gro") {
+            gEnableGRO = true;
         } else if (arg == "--oa") {
             if (i + 1 < argc) {
                 gOutputAudioFilename = argv[++i];
@@ -283,10 +288,14 @@ int main(int argc, char* argv[])
         });
 
     peerConnection->setSubscribeConnectionStatsListener([](const SubscribeConnectionStats& stats) {
+        // Called on the network thread
+        const auto poolStats = BufferPool::getStats();
         std::cout << "*** PeerConnection stats: received " << stats.frame_count << " frames, " << stats.packet_count
                   << " packets, " << stats.byte_count << " bytes, " << std::setprecision(3)
                   << stats.packets_lost_percent << "% packet loss, " << std::setprecision(3) << stats.rtt_ms
-                  << " ms rtt" << std::endl;
+                  << " ms rtt, " << poolStats.miss_count << " of " << poolStats.hit_count + poolStats.miss_count
+                  << " buffer allocations not pooled"
+                  << std::endl;
     });
 
     if (gPrintSenderReports) {
@@ -298,6 +307,7 @@ int main(int argc, char* argv[])
     SubOfferConfig offerConfig = {};
     offerConfig.cname = "foo";
     offerConfig.enable_abs_capture_time = gAbsCaptureTime;
+    offerConfig.enable_gro = gEnableGRO;
 
     SubCodec videoCodecVP8 = {};
     videoCodecVP8.codec = Codec::VP8;